@@ -0,0 +1,189 @@
+#include "AIRacerController.hpp"
+#include <algorithm>
+#include <cmath>
+#include "Profiler.hpp"
+#include "Track.hpp"
+#include "VectorBatch.hpp"
+
+void RacingLine::Build(const Track& track) {
+    x.clear();
+    y.clear();
+    invCurvatureSq.clear();
+    const auto& edges = track.GetSpatialIndex().GetEdges();
+    size_t count = static_cast<size_t>(track.GetLapLength() / SPACING);
+    if (edges.empty() || count < MIN_POINTS) {
+        return;
+    }
+
+    // Centerline samples and their normals, walking the edges in driving order
+    std::vector<Vector2D> center(count);
+    std::vector<Vector2D> normal(count);
+    size_t edge = 0;
+    float edgeStart = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float distance = i * SPACING;
+        float edgeLength = (edges[edge].b - edges[edge].a).Length();
+        while (edge + 1 < edges.size() && edgeStart + edgeLength <= distance) {
+            edgeStart += edgeLength;
+            ++edge;
+            edgeLength = (edges[edge].b - edges[edge].a).Length();
+        }
+        Vector2D direction = edges[edge].b - edges[edge].a;
+        float t = edgeLength > 0.0f ? std::min(1.0f, (distance - edgeStart) / edgeLength) : 0.0f;
+        center[i] = edges[edge].a + direction * t;
+        direction = edgeLength > 0.0f ? direction * (1.0f / edgeLength) : Vector2D(1.0f, 0.0f);
+        // Same side as the baked terrain normals
+        normal[i] = Vector2D(-direction.y, direction.x);
+    }
+
+    // Pull every point towards the midpoint of its neighbours, moving only
+    // along its normal and staying inside the track. Coarse strides first,
+    // so whole corners straighten out without thousands of iterations.
+    float limit = std::max(0.0f, track.GetTrackWidth() * 0.5f - EDGE_MARGIN);
+    std::vector<float> offset(count, 0.0f);
+    auto point = [&](size_t i) { return center[i] + normal[i] * offset[i]; };
+    for (size_t stride : {16u, 8u, 4u, 2u, 1u}) {
+        for (int iteration = 0; iteration < RELAX_ITERATIONS_PER_STRIDE; ++iteration) {
+            for (size_t i = 0; i < count; ++i) {
+                Vector2D midpoint = (point((i + count - stride) % count) + point((i + stride) % count)) * 0.5f;
+                float move = (midpoint - point(i)).Dot(normal[i]) * RELAX_RATE;
+                offset[i] = std::max(-limit, std::min(limit, offset[i] + move));
+            }
+        }
+    }
+
+    x.resize(count);
+    y.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Vector2D p = point(i);
+        x[i] = p.x;
+        y[i] = p.y;
+    }
+
+    // Curvature from the circle through points two samples either side
+    invCurvatureSq.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Vector2D a = GetPoint((i + count - 2) % count);
+        Vector2D b = GetPoint(i);
+        Vector2D c = GetPoint((i + 2) % count);
+        float twiceArea = std::fabs((b - a).Cross(c - b));
+        float sides = (b - a).Length() * (c - b).Length() * (c - a).Length();
+        float radius = twiceArea > 0.0f ? std::min(MAX_INVERSE_CURVATURE, sides / (2.0f * twiceArea))
+                                        : MAX_INVERSE_CURVATURE;
+        invCurvatureSq[i] = radius * radius;
+    }
+}
+
+void AIRacerController::SetTrack(const Track* newTrack) {
+    track = newTrack;
+    if (track) {
+        line.Build(*track);
+        halfWidth = track->GetTrackWidth() * 0.5f;
+    } else {
+        line = RacingLine();
+    }
+}
+
+void AIRacerController::AddRacer(uint32_t bike, uint32_t slot, BikeType type, Difficulty difficulty) {
+    BikeStats stats = GetBikeStats(type);
+    int level = std::max(0, std::min(static_cast<int>(difficulty), static_cast<int>(Difficulty::EXTREME)));
+    bikes.push_back(bike);
+    slots.push_back(slot);
+    lookahead.push_back(LOOKAHEAD_POINTS[level]);
+    handlingSq.push_back(stats.handling * stats.handling);
+    maxSpeed.push_back(stats.maxSpeed);
+    brakeDistanceRate.push_back(2.0f * BRAKE_SHARE * stats.brakeForce / stats.mass * RacingLine::SPACING);
+}
+
+void AIRacerController::Clear() {
+    bikes.clear();
+    slots.clear();
+    lookahead.clear();
+    handlingSq.clear();
+    maxSpeed.clear();
+    brakeDistanceRate.clear();
+}
+
+void AIRacerController::Update(const BikeStateStore& states, const Context* context, BikeInputMask* outInputs) {
+    BIKE_PROFILE_ZONE("AIRacerController::Update");
+    size_t count = bikes.size();
+    if (!track || line.IsEmpty()) {
+        std::fill(outInputs, outInputs + count, BikeInputMask(0));
+        return;
+    }
+
+    positions.resize(count);
+    nearest.resize(count);
+    progress.resize(count);
+    normals.resize(count);
+    rotations.resize(count);
+    sinRotation.resize(count);
+    cosRotation.resize(count);
+    for (size_t r = 0; r < count; ++r) {
+        positions[r] = states.GetPosition(slots[r]);
+        rotations[r] = states.rotation[slots[r]];
+    }
+    track->GetNearestTrackPoints(positions.data(), count, nearest.data(), progress.data());
+    track->GetTrackNormalsAt(nearest.data(), count, normals.data());
+    VectorBatch::SinCos(rotations.data(), sinRotation.data(), cosRotation.data(), count);
+
+    size_t lineSize = line.Size();
+    for (size_t r = 0; r < count; ++r) {
+        Vector2D heading(cosRotation[r], sinRotation[r]);
+        float speed = states.GetVelocity(slots[r]).Dot(heading);
+        size_t index = line.IndexAt(progress[r]);
+        int depth = lookahead[r];
+
+        // Fastest speed from which every corner in reach can still be braked
+        // for; the tightest of them also decides boosts and power-ups
+        float topSpeedSq = maxSpeed[r] * maxSpeed[r];
+        float safeSpeedSq = topSpeedSq;
+        float tightest = line.GetInverseCurvatureSquared(index);
+        size_t ahead = index;
+        for (int j = 0; j < depth; ++j) {
+            float inverseCurvatureSq = line.GetInverseCurvatureSquared(ahead);
+            tightest = std::min(tightest, inverseCurvatureSq);
+            safeSpeedSq = std::min(safeSpeedSq, handlingSq[r] * inverseCurvatureSq + brakeDistanceRate[r] * j);
+            ahead = ahead + 1 < lineSize ? ahead + 1 : 0;
+        }
+        float safeSpeed = std::sqrt(safeSpeedSq);
+        bool straight = handlingSq[r] * tightest >= topSpeedSq;
+
+        // Off the track, head back for a point on it a little ahead;
+        // otherwise for the line point reached in STEER_TIME
+        Vector2D target;
+        if (std::fabs((positions[r] - nearest[r]).Dot(normals[r])) > halfWidth) {
+            target = nearest[r] + Vector2D(normals[r].y, -normals[r].x) * RECOVERY_AHEAD;
+        } else {
+            int steerPoints = static_cast<int>(std::fabs(speed) * STEER_TIME / RacingLine::SPACING);
+            steerPoints = std::max(MIN_STEER_POINTS, std::min(depth, steerPoints));
+            target = line.GetPoint((index + steerPoints) % lineSize);
+        }
+        Vector2D toTarget = target - positions[r];
+        float turn = heading.Cross(toTarget);
+        float deadzone = STEER_DEADZONE * toTarget.Length();
+
+        BikeInputMask input = 0;
+        if (turn > deadzone) {
+            input |= BikeInput::LEAN_RIGHT;
+        } else if (turn < -deadzone) {
+            input |= BikeInput::LEAN_LEFT;
+        } else if (heading.Dot(toTarget) < 0.0f) {
+            input |= BikeInput::LEAN_RIGHT; // target straight behind: pick a side
+        }
+        if (speed < safeSpeed) {
+            input |= BikeInput::ACCELERATE;
+        } else if (speed > safeSpeed * BRAKE_MARGIN) {
+            input |= BikeInput::BRAKE;
+        }
+        if (straight && speed > BOOST_SPEED_SHARE * maxSpeed[r]) {
+            input |= BikeInput::BOOST;
+        }
+        // Spend a power-up on a straight or on a rival just ahead rather than hold it
+        bool rivalClose = context[r].gapAhead > 0.0f && context[r].gapAhead < ATTACK_RANGE;
+        if (context[r].hasPowerUp && (straight || rivalClose)) {
+            input |= BikeInput::USE_POWER_UP;
+        }
+        outInputs[r] = input;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BikeInput.hpp"
+#include "BikePhysics.hpp"
+#include "BikeStateStore.hpp"
+#include "GameState.hpp"
+#include "Vector2D.hpp"
+
+class Track;
+
+// Racing line through a track: the centerline sampled every SPACING px of
+// lap distance, each point pushed sideways (within the track width) to
+// straighten the line through corners. Because samples are evenly spaced
+// in lap distance, the line point for a bike is its track progress divided
+// by SPACING, with no search.
+class RacingLine {
+public:
+    static constexpr float SPACING = 16.0f;
+
+    // Empty if the track has no geometry or a lap under MIN_POINTS samples
+    void Build(const Track& track);
+    size_t Size() const { return x.size(); }
+    bool IsEmpty() const { return x.empty(); }
+    size_t IndexAt(float progress) const {
+        size_t index = static_cast<size_t>(progress * (1.0f / SPACING));
+        return index < x.size() ? index : 0;
+    }
+    Vector2D GetPoint(size_t index) const { return Vector2D(x[index], y[index]); }
+    // 1 / curvature^2 (capped on straights), so a corner's speed limit for
+    // a yaw rate limit w is sqrt(w^2 * invCurvatureSq)
+    float GetInverseCurvatureSquared(size_t index) const { return invCurvatureSq[index]; }
+
+private:
+    static constexpr size_t MIN_POINTS = 32; // also bounds the coarsest relaxation stride
+    static constexpr int RELAX_ITERATIONS_PER_STRIDE = 24;
+    static constexpr float RELAX_RATE = 0.5f;
+    static constexpr float EDGE_MARGIN = 20.0f; // px kept from the track edge
+    static constexpr float MAX_INVERSE_CURVATURE = 1.0e4f; // 10000 px radius counts as straight
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> invCurvatureSq;
+};
+
+// Drives any number of AI bikes. Each tick, Update reads the bikes from the
+// BikeStateStore and decides the controls of all of them in one pass:
+// nearest track points and normals are looked up in two batched Track
+// queries, the sincos of every heading in one VectorBatch call, and the
+// decision loop then runs over flat per-racer arrays.
+//
+// Difficulty is how far ahead a racer plans. It steers for a point on the
+// racing line up to that far ahead, and brakes for the tightest corner
+// within that distance. Easy racers find corners late and run wide; extreme
+// racers brake in time and carry speed on the line.
+//
+// Decisions depend only on the simulation state, so they come out the same
+// when a tick is simulated again after a rollback.
+class AIRacerController {
+public:
+    // Everything a racer reads besides its bike state, one per racer
+    struct Context {
+        bool hasPowerUp;
+        float gapAhead; // track distance to the racer one place ahead, 0 for the leader
+    };
+
+    void SetTrack(const Track* track);
+    const RacingLine& GetRacingLine() const { return line; }
+
+    // bike is the caller's index for it, returned by GetBike; the slot is
+    // where its state lives in the BikeStateStore
+    void AddRacer(uint32_t bike, uint32_t slot, BikeType type, Difficulty difficulty);
+    void Clear();
+    size_t GetRacerCount() const { return bikes.size(); }
+    uint32_t GetBike(size_t racer) const { return bikes[racer]; }
+
+    // Controls for the next tick, one per racer; leaves them empty without a track
+    void Update(const BikeStateStore& states, const Context* context, BikeInputMask* outInputs);
+
+    // Racing line points looked ahead per difficulty (EASY..EXTREME)
+    static constexpr int LOOKAHEAD_POINTS[] = {4, 8, 16, 28};
+
+private:
+    static constexpr int MIN_STEER_POINTS = 2;
+    static constexpr float STEER_TIME = 0.25f;       // s of travel to the steering target
+    static constexpr float STEER_DEADZONE = 0.03f;   // sin of the heading error left alone
+    static constexpr float BRAKE_MARGIN = 1.05f;     // brake above this share of the safe speed
+    static constexpr float BRAKE_SHARE = 0.7f;       // share of the class braking planned on
+    static constexpr float BOOST_SPEED_SHARE = 0.6f; // boost on straights above this share of top speed
+    static constexpr float ATTACK_RANGE = 120.0f;    // px: use a power-up on a rival this close ahead
+    static constexpr float RECOVERY_AHEAD = 64.0f;   // px along the track when steering back onto it
+
+    const Track* track = nullptr;
+    RacingLine line;
+    float halfWidth = 0.0f;
+
+    // Per racer, fixed when added
+    std::vector<uint32_t> bikes;
+    std::vector<uint32_t> slots;
+    std::vector<int> lookahead;
+    std::vector<float> handlingSq;
+    std::vector<float> maxSpeed;
+    std::vector<float> brakeDistanceRate; // 2 * planned deceleration * SPACING
+
+    // Per tick scratch, reused
+    std::vector<Vector2D> positions;
+    std::vector<Vector2D> nearest;
+    std::vector<float> progress;
+    std::vector<Vector2D> normals;
+    std::vector<float> rotations;
+    std::vector<float> sinRotation;
+    std::vector<float> cosRotation;
+};
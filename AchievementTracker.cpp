@@ -0,0 +1,142 @@
+#include "AchievementTracker.hpp"
+#include <algorithm>
+
+AchievementTracker::AchievementTracker(std::vector<AchievementDefinition> definitionList)
+    : definitions(std::move(definitionList)) {
+    counterOf.resize(definitions.size());
+    for (uint32_t a = 0; a < definitions.size(); ++a) {
+        const AchievementDefinition& definition = definitions[a];
+        auto& table = predicates[static_cast<size_t>(definition.event)];
+        auto shared = std::find_if(table.begin(), table.end(), [&](const Predicate& predicate) {
+            return predicate.detailMask == definition.detailMask && predicate.minValue == definition.minValue &&
+                   predicate.maxValue == definition.maxValue &&
+                   counters[predicate.counter].measure == definition.measure;
+        });
+        if (shared == table.end()) {
+            uint32_t counter = static_cast<uint32_t>(counters.size());
+            counters.push_back({definition.measure, {}});
+            table.push_back({definition.detailMask, definition.minValue, definition.maxValue, counter});
+            shared = table.end() - 1;
+        }
+        counterOf[a] = shared->counter;
+        counters[shared->counter].achievements.push_back(a);
+    }
+    for (auto& counter : counters) {
+        std::stable_sort(counter.achievements.begin(), counter.achievements.end(),
+                         [this](uint32_t a, uint32_t b) { return definitions[a].target < definitions[b].target; });
+    }
+}
+
+uint32_t AchievementTracker::Find(const std::string& id) const {
+    for (uint32_t a = 0; a < definitions.size(); ++a) {
+        if (definitions[a].id == id) {
+            return a;
+        }
+    }
+    return NOT_FOUND;
+}
+
+void AchievementTracker::RestorePlayer(uint32_t player, const std::vector<float>& progress,
+                                       const std::vector<bool>& unlocked) {
+    if (player >= players.size()) {
+        players.resize(player + 1);
+    }
+    PlayerState& state = players[player];
+    state.active = true;
+    state.values.assign(counters.size(), 0.0f);
+    state.nextLocked.assign(counters.size(), 0);
+    state.counterDirty.assign(counters.size(), 0);
+    state.unlocked.assign(definitions.size(), 0);
+    state.reported.assign(definitions.size(), 0);
+
+    // Saved progress is a fraction of each target; the counter is the
+    // furthest any of its achievements got
+    for (uint32_t a = 0; a < definitions.size(); ++a) {
+        float saved = a < progress.size() ? progress[a] : 0.0f;
+        float& value = state.values[counterOf[a]];
+        value = std::max(value, saved * definitions[a].target);
+        state.unlocked[a] = a < unlocked.size() && unlocked[a];
+        state.reported[a] = state.unlocked[a];
+    }
+    for (uint32_t c = 0; c < counters.size(); ++c) {
+        UnlockReached(state, c);
+    }
+}
+
+void AchievementTracker::OnEvents(const GameEvent* events, size_t count) {
+    for (size_t e = 0; e < count; ++e) {
+        const GameEvent& event = events[e];
+        if (!HasPlayer(event.racer)) {
+            continue;
+        }
+        PlayerState& state = players[event.racer];
+        uint32_t detailBit = 1u << std::min<uint32_t>(event.detail, 31);
+        for (const Predicate& predicate : predicates[static_cast<size_t>(event.type)]) {
+            if (!(predicate.detailMask & detailBit) || event.value < predicate.minValue ||
+                event.value > predicate.maxValue) {
+                continue;
+            }
+            float& value = state.values[predicate.counter];
+            float before = value;
+            switch (counters[predicate.counter].measure) {
+            case AchievementMeasure::COUNT:
+                value += 1.0f;
+                break;
+            case AchievementMeasure::SUM:
+                value += event.value;
+                break;
+            case AchievementMeasure::MAX:
+                value = std::max(value, event.value);
+                break;
+            }
+            if (value != before) {
+                UnlockReached(state, predicate.counter);
+                MarkDirty(state, event.racer, predicate.counter);
+            }
+        }
+    }
+}
+
+void AchievementTracker::UnlockReached(PlayerState& state, uint32_t counter) {
+    // Achievements unlocked by hand ahead of their target are stepped over
+    const auto& list = counters[counter].achievements;
+    uint32_t& next = state.nextLocked[counter];
+    while (next < list.size() && (state.unlocked[list[next]] || state.values[counter] >= definitions[list[next]].target)) {
+        state.unlocked[list[next]] = 1;
+        ++next;
+    }
+}
+
+void AchievementTracker::MarkDirty(PlayerState& state, uint32_t player, uint32_t counter) {
+    if (!state.counterDirty[counter]) {
+        state.counterDirty[counter] = 1;
+        dirtyCounters.push_back({player, counter});
+    }
+}
+
+void AchievementTracker::Unlock(uint32_t player, uint32_t achievement) {
+    if (!HasPlayer(player) || achievement >= definitions.size()) {
+        return;
+    }
+    PlayerState& state = players[player];
+    state.unlocked[achievement] = 1;
+    UnlockReached(state, counterOf[achievement]);
+    MarkDirty(state, player, counterOf[achievement]);
+}
+
+void AchievementTracker::TakeChanges(std::vector<Change>& out) {
+    out.clear();
+    for (const auto& [player, counter] : dirtyCounters) {
+        PlayerState& state = players[player];
+        state.counterDirty[counter] = 0;
+        for (uint32_t a : counters[counter].achievements) {
+            if (state.reported[a]) {
+                continue;
+            }
+            float progress = state.unlocked[a] ? 1.0f : std::min(1.0f, state.values[counter] / definitions[a].target);
+            out.push_back({player, a, progress, state.unlocked[a] != 0});
+            state.reported[a] = state.unlocked[a];
+        }
+    }
+    dirtyCounters.clear();
+}
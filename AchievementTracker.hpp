@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "GameEvents.hpp"
+
+// How an achievement's counter grows from the events that pass its filter
+enum class AchievementMeasure : uint8_t {
+    COUNT, // one per event
+    SUM,   // event values added up
+    MAX    // largest event value
+};
+
+struct AchievementDefinition {
+    std::string id;
+    std::string name;
+    std::string description;
+    GameEventType event;
+    AchievementMeasure measure;
+    float target; // unlocked once the counter reaches it
+    // Filter: bit n admits events with detail n (details from 31 up share bit 31)
+    uint32_t detailMask = ~0u;
+    float minValue = -std::numeric_limits<float>::infinity();
+    float maxValue = std::numeric_limits<float>::infinity();
+};
+
+// Achievement progress driven by GameEvents instead of polling.
+//
+// The definitions are compiled once into a predicate table per event type.
+// Definitions with the same event, filter and measure share one counter,
+// so "10 laps", "100 laps" and "1000 laps" are one increment per lap, and
+// each counter keeps its achievements sorted by target with the index of
+// the next locked one, so checking for unlocks is one comparison. An event
+// costs one filter test per predicate on its type; achievements on other
+// events are never looked at.
+//
+// Changes collect per (player, counter) until TakeChanges, so the caller
+// decides how often progress is written out.
+class AchievementTracker {
+public:
+    static constexpr uint32_t NOT_FOUND = ~0u;
+
+    struct Change {
+        uint32_t player;
+        uint32_t achievement; // index into the definitions
+        float progress;       // 0..1
+        bool unlocked;
+    };
+
+    explicit AchievementTracker(std::vector<AchievementDefinition> definitions);
+
+    const std::vector<AchievementDefinition>& GetDefinitions() const { return definitions; }
+    uint32_t Find(const std::string& id) const;
+    bool Tracks(GameEventType type) const { return !predicates[static_cast<size_t>(type)].empty(); }
+    size_t GetCounterCount() const { return counters.size(); }
+
+    // Starts following a player (racer index) from saved progress, indexed
+    // like the definitions. Events for players not restored are ignored.
+    void RestorePlayer(uint32_t player, const std::vector<float>& progress, const std::vector<bool>& unlocked);
+    bool HasPlayer(uint32_t player) const { return player < players.size() && players[player].active; }
+
+    void OnEvents(const GameEvent* events, size_t count);
+    void Unlock(uint32_t player, uint32_t achievement);
+
+    bool HasChanges() const { return !dirtyCounters.empty(); }
+    // One change per achievement whose progress moved since the last call;
+    // achievements already reported as unlocked are left out
+    void TakeChanges(std::vector<Change>& out);
+
+private:
+    struct Predicate {
+        uint32_t detailMask;
+        float minValue;
+        float maxValue;
+        uint32_t counter;
+    };
+    struct Counter {
+        AchievementMeasure measure;
+        std::vector<uint32_t> achievements; // ascending target
+    };
+    struct PlayerState {
+        bool active = false;
+        std::vector<float> values;          // per counter
+        std::vector<uint32_t> nextLocked;   // per counter, into Counter::achievements
+        std::vector<uint8_t> counterDirty;  // per counter
+        std::vector<uint8_t> unlocked;      // per achievement
+        std::vector<uint8_t> reported;      // per achievement: unlock already handed out
+    };
+
+    void UnlockReached(PlayerState& state, uint32_t counter);
+    void MarkDirty(PlayerState& state, uint32_t player, uint32_t counter);
+
+    static constexpr size_t TYPE_COUNT = static_cast<size_t>(GameEventType::COUNT);
+    std::vector<AchievementDefinition> definitions;
+    std::array<std::vector<Predicate>, TYPE_COUNT> predicates;
+    std::vector<Counter> counters;
+    std::vector<uint32_t> counterOf; // per achievement
+    std::vector<PlayerState> players;
+    std::vector<std::pair<uint32_t, uint32_t>> dirtyCounters; // (player, counter)
+};
@@ -0,0 +1,101 @@
+#include "AllocationCounter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> totalAllocations(0);
+thread_local uint64_t threadAllocations = 0;
+
+}
+
+bool AllocationCounter::IsEnabled() {
+#ifdef BIKE_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t AllocationCounter::GetTotal() {
+    return totalAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::GetThreadTotal() {
+    return threadAllocations;
+}
+
+#ifdef BIKE_COUNT_ALLOCATIONS
+
+// Replacements for the global allocation functions. Every other form of
+// new/delete forwards to these, except the aligned ones, which get their own.
+namespace {
+
+void* CountedAllocate(std::size_t size) {
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations;
+    return std::malloc(size ? size : 1);
+}
+
+void* CountedAllocateAligned(std::size_t size, std::size_t alignment) {
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations;
+    size = size ? size : 1;
+    // std::pmr::new_delete_resource asks for alignof(T), which can be below
+    // what posix_memalign accepts
+    alignment = std::max(alignment, sizeof(void*));
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+#endif
+}
+
+void FreeAligned(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+}
+
+void* operator new(std::size_t size) {
+    if (void* memory = CountedAllocate(size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* memory = CountedAllocateAligned(size, static_cast<std::size_t>(alignment))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    FreeAligned(memory);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// Counts calls to global operator new when built with BIKE_COUNT_ALLOCATIONS
+// (the BIKE_RACE_COUNT_ALLOCATIONS CMake option). Sample a counter before
+// and after a frame to get the allocations made in it; a race in progress
+// should make none. Without the define every count stays 0.
+namespace AllocationCounter {
+
+bool IsEnabled();
+// Every thread in the process
+uint64_t GetTotal();
+// The calling thread only, e.g. one headless race among many
+uint64_t GetThreadTotal();
+
+}
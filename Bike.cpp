@@ -0,0 +1,202 @@
+#include "Bike.hpp"
+#include "Track.hpp"
+#include "VectorBatch.hpp"
+
+Bike::Bike(BikeType type, const std::string& name, BikeStateStore& states)
+    : states(&states), slot(states.Allocate()), type(type), name(name),
+      acceleration(0.0f), maxSpeed(0.0f), handling(0.0f), grip(0.0f), hasPowerUp(false),
+      heldPowerUp(PowerUpType::NITRO_BOOST), useHeld(false), powerUpUsed(false), usedPowerUp(PowerUpType::NITRO_BOOST),
+      input(0), keyBindings(BikeKeyBindings::Player1()), ghost(false),
+      isGrounded(true), airTime(0.0f), isStunned(false), stunDuration(0.0f), health(MAX_HEALTH),
+      currentLap(0), checkpointsPassed(0),
+      hasShield(false), hasNitro(false), nitroFuel(MAX_NITRO), powerUpDuration(0.0f),
+      mass(0.0f), wheelBase(0.0f), suspensionStiffness(0.0f), damping(0.0f),
+      engineForce(0.0f), brakeForce(0.0f), particles(nullptr), track(nullptr) {
+    InitializeBikeStats();
+}
+
+Bike::~Bike() {
+    states->Release(slot);
+}
+
+void Bike::InitializeBikeStats() {
+    BikeStats stats = GetBikeStats(type);
+    acceleration = stats.acceleration;
+    maxSpeed = stats.maxSpeed;
+    handling = stats.handling;
+    grip = stats.grip;
+    mass = stats.mass;
+    wheelBase = stats.wheelBase;
+    suspensionStiffness = stats.suspensionStiffness;
+    damping = stats.damping;
+    engineForce = stats.engineForce;
+    brakeForce = stats.brakeForce;
+}
+
+void Bike::ApplyPowerUp(PowerUpType type, float duration) {
+    switch (type) {
+    case PowerUpType::NITRO_BOOST:
+        nitroFuel = MAX_NITRO;
+        hasNitro = duration > 0.0f;
+        break;
+    case PowerUpType::SPEED_BURST:
+        hasNitro = duration > 0.0f;
+        break;
+    case PowerUpType::SHIELD:
+        hasShield = duration > 0.0f;
+        break;
+    default:
+        hasPowerUp = true;
+        heldPowerUp = type;
+        return;
+    }
+    powerUpDuration = duration;
+}
+
+void Bike::UsePowerUp() {
+    if (!hasPowerUp) {
+        return;
+    }
+    hasPowerUp = false;
+    if (heldPowerUp == PowerUpType::JUMP_BOOST) {
+        airTime = JUMP_AIR_TIME;
+        isGrounded = false;
+    }
+    powerUpUsed = true;
+    usedPowerUp = heldPowerUp;
+}
+
+bool Bike::TakeUsedPowerUp(PowerUpType& type) {
+    if (!powerUpUsed) {
+        return false;
+    }
+    powerUpUsed = false;
+    type = usedPowerUp;
+    return true;
+}
+
+bool Bike::TakeHit(float stunTime) {
+    if (hasShield) {
+        return false;
+    }
+    isStunned = true;
+    stunDuration = std::max(stunDuration, stunTime);
+    return true;
+}
+
+void Bike::Update(float deltaTime) {
+    if (powerUpDuration > 0.0f) {
+        powerUpDuration -= deltaTime;
+        if (powerUpDuration <= 0.0f) {
+            powerUpDuration = 0.0f;
+            hasNitro = false;
+            hasShield = false;
+        }
+    }
+    if (isStunned) {
+        stunDuration -= STUN_RECOVERY_RATE * deltaTime;
+        if (stunDuration <= 0.0f) {
+            isStunned = false;
+            stunDuration = 0.0f;
+        }
+    }
+    health = std::min(MAX_HEALTH, health + HEALTH_RECOVERY_RATE * deltaTime);
+    if (airTime > 0.0f) {
+        airTime = std::max(0.0f, airTime - deltaTime);
+        isGrounded = airTime == 0.0f;
+    }
+
+    // Power-ups fire on the press, not while the key is held
+    bool usePressed = (input & BikeInput::USE_POWER_UP) != 0;
+    if (usePressed && !useHeld && !isStunned) {
+        UsePowerUp();
+    }
+    useHeld = usePressed;
+
+    // A stunned rider has no control; boosting burns fuel unless a nitro
+    // power-up is active
+    const BikeInputMask driving = BikeInput::ACCELERATE | BikeInput::BRAKE | BikeInput::LEAN_LEFT |
+                                  BikeInput::LEAN_RIGHT | BikeInput::BOOST;
+    BikeInputMask controls = isStunned ? 0 : (input & driving);
+    if ((controls & BikeInput::BOOST) && !hasNitro) {
+        if (nitroFuel > 0.0f) {
+            nitroFuel = std::max(0.0f, nitroFuel - NITRO_CONSUMPTION_RATE * deltaTime);
+        } else {
+            controls &= ~BikeInput::BOOST;
+        }
+    }
+    if (controls & BikeInput::BOOST) {
+        EmitParticles(ParticleEmitters::NITRO, 1);
+    }
+    states->controls[slot] = controls;
+
+    // Grip is the mean of the surface under the front and rear contact
+    // patches, so a bike half off the track is half slowed
+    float traction = 1.0f;
+    if (track && isGrounded) {
+        float rotation = GetRotation();
+        float sinRot, cosRot;
+        VectorBatch::SinCos(&rotation, &sinRot, &cosRot, 1);
+        Vector2D position = GetPosition();
+        Vector2D halfBase(cosRot * wheelBase * 0.5f, sinRot * wheelBase * 0.5f);
+        traction = 0.5f * (track->GetFrictionAt(position + halfBase) + track->GetFrictionAt(position - halfBase));
+
+        // Loose ground sprays from the rear wheel once the bike is moving
+        if (particles && GetVelocity().LengthSquared() > TERRAIN_SPRAY_SPEED * TERRAIN_SPRAY_SPEED) {
+            switch (track->GetTerrainAt(position - halfBase)) {
+            case TerrainType::DIRT:
+            case TerrainType::SAND:
+            case TerrainType::GRAVEL:
+            case TerrainType::SNOW:
+                EmitParticles(ParticleEmitters::DUST, 1);
+                break;
+            case TerrainType::MUD:
+            case TerrainType::WATER:
+                EmitParticles(ParticleEmitters::MUD, 1);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    states->friction[slot] = traction;
+}
+
+void Bike::HandleInput(const Uint8* keystate) {
+    ApplyInput(keyBindings.Sample(keystate));
+}
+
+void Bike::EmitParticles(ParticleEmitterId emitter, int count) {
+    if (!particles) {
+        return;
+    }
+    // Spray backwards from the rear wheel
+    float rotation = GetRotation();
+    Vector2D rear = GetPosition() - Vector2D::FromAngle(rotation) * (wheelBase * 0.5f);
+    particleBursts.push_back({emitter, rear, rotation + 3.14159265f, count, GetVelocity() * 0.5f});
+}
+
+void Bike::FlushParticles() {
+    for (const auto& burst : particleBursts) {
+        particles->Emit(burst.emitter, burst.position, burst.direction, burst.count, burst.velocity);
+    }
+    particleBursts.clear();
+}
+
+SDL_Rect Bike::GetCollisionBox() const {
+    Vector2D position = GetPosition();
+    return {static_cast<int>(position.x - SPRITE_WIDTH * 0.5f), static_cast<int>(position.y - SPRITE_HEIGHT * 0.5f),
+            static_cast<int>(SPRITE_WIDTH), static_cast<int>(SPRITE_HEIGHT)};
+}
+
+void Bike::Render(RenderQueue& queue, float interpolation) {
+    Vector2D position = GetInterpolatedPosition(interpolation);
+    SDL_FRect dest = {position.x - SPRITE_WIDTH * 0.5f, position.y - SPRITE_HEIGHT * 0.5f,
+                      SPRITE_WIDTH, SPRITE_HEIGHT};
+    // Stunned bikes flash red through the vertex colour instead of a second texture
+    SDL_Color tint = isStunned ? SDL_Color{255, 96, 96, 255} : SDL_Color{255, 255, 255, 255};
+    if (ghost) {
+        tint.a = 96;
+    }
+    queue.Submit(sprite, dest, GetInterpolatedRotation(interpolation), RenderLayer::BIKES, tint);
+}
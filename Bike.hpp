@@ -1,57 +1,179 @@
 #pragma once
 #include <SDL2/SDL.h>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 #include "Vector2D.hpp"
+#include "BikeStateStore.hpp"
+#include "BikeInput.hpp"
+#include "BikePhysics.hpp"
+#include "ParticleSystem.hpp"
+#include "RenderQueue.hpp"
+#include "PhysicsWorld.hpp"
+#include "PowerUp.hpp"
 
-enum class BikeType {
-    SPEED,
-    ALL_ROUNDER,
-    OFF_ROAD
-};
+class Track;
 
+// Bike is a handle: its hot kinematic state (position, velocity, rotation,
+// suspension travel) lives in a shared BikeStateStore, the rest stays here.
+// Update() advances timers and fuel and writes the controls for this step;
+// BikePhysics then applies the forces to batches of same-class bikes and
+// BikeStateStore::Integrate moves them.
 class Bike {
 public:
-    Bike(BikeType type, const std::string& name);
+    Bike(BikeType type, const std::string& name, BikeStateStore& states);
     ~Bike();
 
+    Bike(const Bike&) = delete;
+    Bike& operator=(const Bike&) = delete;
+
     void Update(float deltaTime);
-    void Render(SDL_Renderer* renderer);
+    void Render(RenderQueue& queue, float interpolation = 1.0f);
+    // Samples the keyboard through this bike's bindings and applies the result
     void HandleInput(const Uint8* keystate);
+    // The only way input reaches the simulation, so logs and the network can drive it
+    void ApplyInput(BikeInputMask mask) { input = mask; }
     void ApplyForce(const Vector2D& force);
+    // Spends the held power-up; Update calls it when USE_POWER_UP is pressed.
+    // A jump takes effect here. Missiles and oil reach other racers and the
+    // track, so the game applies them (and publishes POWER_UP_USED for every
+    // kind) in bike order through TakeUsedPowerUp.
     void UsePowerUp();
+    bool TakeUsedPowerUp(PowerUpType& type);
+    // Nitro, speed burst and shield last for duration seconds (0 ends them);
+    // the other kinds are held until used
+    void ApplyPowerUp(PowerUpType type, float duration);
+    // A missile hit stuns the rider unless a shield takes it; false if it did
+    bool TakeHit(float stunTime);
+    SDL_Rect GetCollisionBox() const;
+    // Sprite-sized box turned with the bike, for the narrow phase
+    OrientedBox GetOrientedBox() const {
+        return OrientedBox::FromRotation(GetPosition(), SPRITE_WIDTH * 0.5f, SPRITE_HEIGHT * 0.5f, GetRotation());
+    }
+    // Disc swept against obstacles each step, as wide as the bike's body
+    float GetSweepRadius() const { return SPRITE_HEIGHT * 0.5f; }
+    // Serial stage after the parallel bike updates
+    void FlushParticles();
+    // Drops queued bursts instead, for ticks that are being re-simulated
+    void ClearParticles() { particleBursts.clear(); }
+
+    // Simulation state outside the BikeStateStore, for rollback snapshots
+    struct SimState {
+        BikeInputMask input;
+        bool hasPowerUp;
+        PowerUpType heldPowerUp;
+        bool useHeld;
+        float airTime;
+        bool isGrounded;
+        bool isStunned;
+        bool hasShield;
+        bool hasNitro;
+        float stunDuration;
+        float health;
+        float nitroFuel;
+        float powerUpDuration;
+        int currentLap;
+        int checkpointsPassed;
+    };
+    SimState GetSimState() const {
+        return {input, hasPowerUp, heldPowerUp, useHeld, airTime, isGrounded, isStunned, hasShield, hasNitro,
+                stunDuration, health, nitroFuel, powerUpDuration, currentLap, checkpointsPassed};
+    }
+    void SetSimState(const SimState& state) {
+        input = state.input;
+        hasPowerUp = state.hasPowerUp;
+        heldPowerUp = state.heldPowerUp;
+        useHeld = state.useHeld;
+        airTime = state.airTime;
+        isGrounded = state.isGrounded;
+        isStunned = state.isStunned;
+        hasShield = state.hasShield;
+        hasNitro = state.hasNitro;
+        stunDuration = state.stunDuration;
+        health = state.health;
+        nitroFuel = state.nitroFuel;
+        powerUpDuration = state.powerUpDuration;
+        currentLap = state.currentLap;
+        checkpointsPassed = state.checkpointsPassed;
+    }
     
     // Getters
-    Vector2D GetPosition() const { return position; }
-    Vector2D GetVelocity() const { return velocity; }
-    float GetRotation() const { return rotation; }
+    Vector2D GetPosition() const { return states->GetPosition(slot); }
+    Vector2D GetVelocity() const { return states->GetVelocity(slot); }
+    Vector2D GetPreviousPosition() const { return states->GetPreviousPosition(slot); }
+    float GetRotation() const { return states->rotation[slot]; }
+    float GetSuspensionTravel() const { return states->suspensionTravel[slot]; }
     bool HasPowerUp() const { return hasPowerUp; }
+    // In the air after a jump: no grip from the surface, and obstacles pass underneath
+    bool IsAirborne() const { return airTime > 0.0f; }
+    bool IsStunned() const { return isStunned; }
+    BikeType GetType() const { return type; }
+    const std::string& GetName() const { return name; }
+    int GetCurrentLap() const { return currentLap; }
+    uint32_t GetStateSlot() const { return slot; }
+    void SetParticleSystem(ParticleSystem* system) { particles = system; }
+    // Update samples the surface friction under both wheels from this track
+    void SetTrack(const Track* raceTrack) { track = raceTrack; }
+    void SetSprite(const AtlasRegion& region) { sprite = region; }
+    void SetKeyBindings(const BikeKeyBindings& bindings) { keyBindings = bindings; }
+    const BikeKeyBindings& GetKeyBindings() const { return keyBindings; }
+    BikeInputMask GetInput() const { return input; }
+    // Ghosts replay a recorded lap and are drawn translucent
+    void SetGhost(bool isGhost) { ghost = isGhost; }
     
     // Setters
-    void SetPosition(const Vector2D& pos) { position = pos; }
-    void SetVelocity(const Vector2D& vel) { velocity = vel; }
-    void SetRotation(float rot) { rotation = rot; }
+    void SetPosition(const Vector2D& pos) { states->SetPosition(slot, pos); }
+    void SetVelocity(const Vector2D& vel) { states->SetVelocity(slot, vel); }
+    void SetRotation(float rot) { states->rotation[slot] = rot; }
+    // Laps are counted by the race ranking and copied here every tick
+    void SetCurrentLap(int lap) { currentLap = lap; }
+
+    // Interpolation between fixed simulation steps
+    void SavePreviousState() {
+        states->previousX[slot] = states->positionX[slot];
+        states->previousY[slot] = states->positionY[slot];
+        states->previousRotation[slot] = states->rotation[slot];
+    }
+    Vector2D GetInterpolatedPosition(float alpha) const {
+        return Vector2D::Lerp(states->GetPreviousPosition(slot), GetPosition(), alpha);
+    }
+    float GetInterpolatedRotation(float alpha) const {
+        // Blend along the shortest arc so a wrap at +/-PI does not spin the sprite
+        float previousRotation = states->previousRotation[slot];
+        float delta = std::remainder(states->rotation[slot] - previousRotation, 6.28318531f);
+        return previousRotation + delta * std::max(0.0f, std::min(1.0f, alpha));
+    }
 
 private:
+    BikeStateStore* states;
+    uint32_t slot;
     BikeType type;
     std::string name;
-    Vector2D position;
-    Vector2D velocity;
-    float rotation;
     float acceleration;
     float maxSpeed;
     float handling;
     float grip;
     bool hasPowerUp;
+    PowerUpType heldPowerUp;
+    // USE_POWER_UP was down last tick, so holding the key spends one power-up
+    bool useHeld;
+    // Set by UsePowerUp until the game takes it in the serial stage
+    bool powerUpUsed;
+    PowerUpType usedPowerUp;
+    BikeInputMask input;
+    BikeKeyBindings keyBindings;
+    bool ghost;
     
-    // Bike characteristics based on type
+    // Bike characteristics based on type, copied from BikeTraits
     void InitializeBikeStats();
     
     // Physics
-    void ApplyPhysics(float deltaTime);
     void HandleCollisions();
     
     // Bike state
     bool isGrounded;
+    float airTime;
     bool isStunned;
     float stunDuration;
     float health;
@@ -67,24 +189,40 @@ private:
     // Physics properties
     float mass;
     float wheelBase;
-    float suspensionTravel;
     float suspensionStiffness;
     float damping;
     float engineForce;
     float brakeForce;
     
-    // Constants
-    const float GRAVITY = 9.81f;
-    const float DRAG_COEFFICIENT = 0.3f;
-    const float MAX_HEALTH = 100.0f;
-    const float MAX_NITRO = 100.0f;
-    const float NITRO_CONSUMPTION_RATE = 25.0f;
-    const float STUN_RECOVERY_RATE = 1.0f;
-    const float HEALTH_RECOVERY_RATE = 5.0f;
+    // Constants (shared, not stored per bike)
+    static constexpr float GRAVITY = 9.81f;
+    static constexpr float MAX_HEALTH = 100.0f;
+    static constexpr float MAX_NITRO = 100.0f;
+    static constexpr float NITRO_CONSUMPTION_RATE = 25.0f;
+    static constexpr float STUN_RECOVERY_RATE = 1.0f;
+    static constexpr float HEALTH_RECOVERY_RATE = 5.0f;
+    static constexpr float SPRITE_WIDTH = 60.0f;
+    static constexpr float SPRITE_HEIGHT = 30.0f;
+    static constexpr float TERRAIN_SPRAY_SPEED = 60.0f; // px/s before loose ground kicks up
+    static constexpr float JUMP_AIR_TIME = 0.6f;        // seconds off the ground
+    
+    // Atlas region drawn for this bike; a flat-coloured quad until one is set
+    AtlasRegion sprite;
     
-    // Particle system
-    void EmitParticles(const std::string& type);
-    void UpdateParticles(float deltaTime);
+    // Particle system (shared; particles are updated by the system itself).
+    // Bikes update in parallel, so bursts are queued here and handed to the
+    // system in bike order by FlushParticles.
+    struct ParticleBurst {
+        ParticleEmitterId emitter;
+        Vector2D position;
+        float direction;
+        int count;
+        Vector2D velocity;
+    };
+    ParticleSystem* particles;
+    const Track* track;
+    std::vector<ParticleBurst> particleBursts;
+    void EmitParticles(ParticleEmitterId emitter, int count);
     
     // Sound effects
     void PlayEngineSound();
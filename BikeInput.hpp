@@ -0,0 +1,67 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <bitset>
+#include <cstdint>
+
+// Everything a bike reads from the controls on one tick, as a bitmask.
+// This is what gets recorded, replayed and sent over the network.
+using BikeInputMask = uint16_t;
+
+struct BikeInput {
+    static constexpr BikeInputMask ACCELERATE = 1 << 0;
+    static constexpr BikeInputMask BRAKE = 1 << 1;
+    static constexpr BikeInputMask LEAN_LEFT = 1 << 2;
+    static constexpr BikeInputMask LEAN_RIGHT = 1 << 3;
+    static constexpr BikeInputMask BOOST = 1 << 4;
+    static constexpr BikeInputMask USE_POWER_UP = 1 << 5;
+    static constexpr BikeInputMask LOOK_BEHIND = 1 << 6;
+    static constexpr BikeInputMask RESET = 1 << 7;
+};
+
+// Keyboard layout for one player (see the controls table in the README)
+struct BikeKeyBindings {
+    SDL_Scancode accelerate;
+    SDL_Scancode brake;
+    SDL_Scancode leanLeft;
+    SDL_Scancode leanRight;
+    SDL_Scancode boost;
+    SDL_Scancode usePowerUp;
+    SDL_Scancode lookBehind;
+    SDL_Scancode reset;
+
+    static BikeKeyBindings Player1() {
+        return {SDL_SCANCODE_W, SDL_SCANCODE_S, SDL_SCANCODE_A, SDL_SCANCODE_D,
+                SDL_SCANCODE_LSHIFT, SDL_SCANCODE_SPACE, SDL_SCANCODE_Q, SDL_SCANCODE_R};
+    }
+    static BikeKeyBindings Player2() {
+        return {SDL_SCANCODE_UP, SDL_SCANCODE_DOWN, SDL_SCANCODE_LEFT, SDL_SCANCODE_RIGHT,
+                SDL_SCANCODE_RCTRL, SDL_SCANCODE_RCTRL, SDL_SCANCODE_RSHIFT, SDL_SCANCODE_BACKSPACE};
+    }
+
+    BikeInputMask Sample(const Uint8* keystate) const {
+        BikeInputMask mask = 0;
+        mask |= keystate[accelerate] ? BikeInput::ACCELERATE : 0;
+        mask |= keystate[brake] ? BikeInput::BRAKE : 0;
+        mask |= keystate[leanLeft] ? BikeInput::LEAN_LEFT : 0;
+        mask |= keystate[leanRight] ? BikeInput::LEAN_RIGHT : 0;
+        mask |= keystate[boost] ? BikeInput::BOOST : 0;
+        mask |= keystate[usePowerUp] ? BikeInput::USE_POWER_UP : 0;
+        mask |= keystate[lookBehind] ? BikeInput::LOOK_BEHIND : 0;
+        mask |= keystate[reset] ? BikeInput::RESET : 0;
+        return mask;
+    }
+
+    // Same, from a scancode-indexed bitset (see InputSnapshot)
+    BikeInputMask Sample(const std::bitset<SDL_NUM_SCANCODES>& keys) const {
+        BikeInputMask mask = 0;
+        mask |= keys.test(accelerate) ? BikeInput::ACCELERATE : 0;
+        mask |= keys.test(brake) ? BikeInput::BRAKE : 0;
+        mask |= keys.test(leanLeft) ? BikeInput::LEAN_LEFT : 0;
+        mask |= keys.test(leanRight) ? BikeInput::LEAN_RIGHT : 0;
+        mask |= keys.test(boost) ? BikeInput::BOOST : 0;
+        mask |= keys.test(usePowerUp) ? BikeInput::USE_POWER_UP : 0;
+        mask |= keys.test(lookBehind) ? BikeInput::LOOK_BEHIND : 0;
+        mask |= keys.test(reset) ? BikeInput::RESET : 0;
+        return mask;
+    }
+};
@@ -0,0 +1,135 @@
+#include "BikePhysics.hpp"
+#include <algorithm>
+#include <cmath>
+#include "BikeInput.hpp"
+#include "VectorBatch.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define BIKE_PHYSICS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// Bikes are gathered from their slots a block at a time so the sincos and
+// the force loop run over contiguous arrays
+constexpr size_t BLOCK = 64;
+constexpr float TWO_PI = 6.28318531f;
+constexpr float INVERSE_TWO_PI = 1.0f / TWO_PI;
+
+// 0 or 1 from arithmetic rather than a comparison, so the compiler has no
+// condition to turn back into a branch
+float Bit(uint16_t controls, BikeInputMask bit) {
+    return static_cast<float>(static_cast<int32_t>(controls & bit)) * (1.0f / bit);
+}
+
+// std::min and std::max on floats are compares the optimizer may thread
+// into branches; minss and maxss are single instructions. Argument order
+// matches std::min/std::max, so both paths give the same result.
+#if defined(BIKE_PHYSICS_SSE)
+float Min(float a, float b) {
+    return _mm_cvtss_f32(_mm_min_ss(_mm_set_ss(b), _mm_set_ss(a)));
+}
+float Max(float a, float b) {
+    return _mm_cvtss_f32(_mm_max_ss(_mm_set_ss(b), _mm_set_ss(a)));
+}
+#else
+float Min(float a, float b) {
+    return std::min(a, b);
+}
+float Max(float a, float b) {
+    return std::max(a, b);
+}
+#endif
+
+}
+
+template <BikeType Type>
+void BikePhysics::Step(BikeStateStore& states, const uint32_t* slots, size_t count, float deltaTime) {
+    constexpr BikeStats stats = BikeTraits<Type>::STATS;
+    constexpr float brakeDeceleration = stats.brakeForce / stats.mass;
+    constexpr float dragPerMass = DRAG_COEFFICIENT / stats.mass;
+    constexpr float inverseWheelBase = 1.0f / stats.wheelBase;
+    constexpr float travelPerAcceleration = stats.mass / stats.suspensionStiffness;
+    const float gripPerStep = stats.grip * deltaTime;
+    const float settle = Min(1.0f, stats.damping * deltaTime);
+
+    alignas(64) float velX[BLOCK];
+    alignas(64) float velY[BLOCK];
+    alignas(64) float rot[BLOCK];
+    alignas(64) float travel[BLOCK];
+    alignas(64) float sinRot[BLOCK];
+    alignas(64) float cosRot[BLOCK];
+    alignas(64) float traction[BLOCK];
+    alignas(64) uint16_t control[BLOCK];
+    for (size_t first = 0; first < count; first += BLOCK) {
+        size_t n = std::min(BLOCK, count - first);
+        const uint32_t* block = slots + first;
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t slot = block[i];
+            velX[i] = states.velocityX[slot];
+            velY[i] = states.velocityY[slot];
+            rot[i] = states.rotation[slot];
+            travel[i] = states.suspensionTravel[slot];
+            control[i] = states.controls[slot];
+            traction[i] = states.friction[slot];
+        }
+        VectorBatch::SinCos(rot, sinRot, cosRot, n);
+
+        for (size_t i = 0; i < n; ++i) {
+            float throttle = Bit(control[i], BikeInput::ACCELERATE);
+            float brake = Bit(control[i], BikeInput::BRAKE);
+            float lean = Bit(control[i], BikeInput::LEAN_RIGHT) - Bit(control[i], BikeInput::LEAN_LEFT);
+            float boost = Bit(control[i], BikeInput::BOOST);
+
+            // Split the velocity along and across the heading
+            float headingX = cosRot[i];
+            float headingY = sinRot[i];
+            float forward = velX[i] * headingX + velY[i] * headingY;
+            float slip = velY[i] * headingX - velX[i] * headingY;
+
+            // Slippery ground limits both how hard the wheel can push and
+            // how much sideways slide the tyres take out
+            float drive = throttle * stats.acceleration * (1.0f + boost * NITRO_ACCELERATION_BONUS) * traction[i];
+            forward += drive * deltaTime;
+            // Brakes and drag pull the speed towards zero but never reverse it
+            float resist = brake * brakeDeceleration + dragPerMass * forward * forward;
+            float cap = stats.maxSpeed * (1.0f + boost * NITRO_SPEED_BONUS);
+            float speed = Min(cap, Max(0.0f, std::fabs(forward) - resist * deltaTime));
+            forward = std::copysign(speed, forward);
+            slip *= Max(0.0f, 1.0f - gripPerStep * traction[i]);
+            velX[i] = headingX * forward - headingY * slip;
+            velY[i] = headingY * forward + headingX * slip;
+
+            // Yaw rate follows the wheelbase at low speed, up to the class limit;
+            // the angle is kept within one turn so the sincos stays accurate
+            float angle = rot[i] + lean * Min(stats.handling, speed * inverseWheelBase) * deltaTime;
+            rot[i] = angle - TWO_PI * static_cast<float>(static_cast<int32_t>(angle * INVERSE_TWO_PI));
+
+            // The rider squats under throttle and dives under braking
+            float load = (brake * brakeDeceleration - drive) * travelPerAcceleration;
+            load = Max(-MAX_SUSPENSION_TRAVEL, Min(MAX_SUSPENSION_TRAVEL, load));
+            travel[i] += (load - travel[i]) * settle;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t slot = block[i];
+            states.velocityX[slot] = velX[i];
+            states.velocityY[slot] = velY[i];
+            states.rotation[slot] = rot[i];
+            states.suspensionTravel[slot] = travel[i];
+        }
+    }
+}
+
+template void BikePhysics::Step<BikeType::SPEED>(BikeStateStore&, const uint32_t*, size_t, float);
+template void BikePhysics::Step<BikeType::ALL_ROUNDER>(BikeStateStore&, const uint32_t*, size_t, float);
+template void BikePhysics::Step<BikeType::OFF_ROAD>(BikeStateStore&, const uint32_t*, size_t, float);
+
+void BikePhysics::Step(BikeType type, BikeStateStore& states, const uint32_t* slots, size_t count, float deltaTime) {
+    switch (type) {
+    case BikeType::SPEED: Step<BikeType::SPEED>(states, slots, count, deltaTime); return;
+    case BikeType::OFF_ROAD: Step<BikeType::OFF_ROAD>(states, slots, count, deltaTime); return;
+    default: Step<BikeType::ALL_ROUNDER>(states, slots, count, deltaTime); return;
+    }
+}
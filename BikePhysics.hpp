@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "BikeStateStore.hpp"
+
+enum class BikeType {
+    SPEED,
+    ALL_ROUNDER,
+    OFF_ROAD
+};
+
+constexpr size_t BIKE_TYPE_COUNT = 3;
+
+// Tuning of one bike class. Distances are pixels, mass is kilograms and
+// forces are kg px/s^2, so force / mass is an acceleration in px/s^2.
+struct BikeStats {
+    float acceleration;        // px/s^2 at full throttle
+    float maxSpeed;            // px/s
+    float handling;            // top yaw rate, rad/s
+    float grip;                // share of sideways slip removed per second
+    float mass;
+    float wheelBase;           // px; sets the yaw rate at low speed
+    float suspensionStiffness; // force per px of travel
+    float damping;             // travel settling rate, 1/s
+    float engineForce;
+    float brakeForce;
+};
+
+// The bike classes are fixed at compile time, so the physics step is
+// instantiated once per class with every parameter a constant
+template <BikeType Type>
+struct BikeTraits;
+
+template <>
+struct BikeTraits<BikeType::SPEED> {
+    static constexpr BikeStats STATS = {520.0f, 480.0f, 2.6f, 5.0f, 180.0f, 42.0f, 14000.0f, 12.0f,
+                                        520.0f * 180.0f, 900.0f * 180.0f};
+};
+
+template <>
+struct BikeTraits<BikeType::ALL_ROUNDER> {
+    static constexpr BikeStats STATS = {440.0f, 400.0f, 3.2f, 7.0f, 220.0f, 38.0f, 16000.0f, 10.0f,
+                                        440.0f * 220.0f, 1000.0f * 220.0f};
+};
+
+template <>
+struct BikeTraits<BikeType::OFF_ROAD> {
+    static constexpr BikeStats STATS = {380.0f, 340.0f, 3.6f, 9.0f, 260.0f, 36.0f, 11000.0f, 8.0f,
+                                        380.0f * 260.0f, 1100.0f * 260.0f};
+};
+
+// Runtime lookup for code that holds a BikeType value; unknown types get
+// the all-rounder
+constexpr BikeStats GetBikeStats(BikeType type) {
+    switch (type) {
+    case BikeType::SPEED: return BikeTraits<BikeType::SPEED>::STATS;
+    case BikeType::OFF_ROAD: return BikeTraits<BikeType::OFF_ROAD>::STATS;
+    default: return BikeTraits<BikeType::ALL_ROUNDER>::STATS;
+    }
+}
+
+// Forces for one fixed step, applied to the velocity, rotation and
+// suspension travel in a BikeStateStore. Drive and grip are scaled by the
+// surface friction stored per slot. Positions are integrated afterwards by
+// BikeStateStore::Integrate.
+//
+// A call takes a batch of slots that all hold the same class of bike and
+// switches on the type once; the loop over the batch runs with the class
+// constants folded in and the controls turned into 0/1 factors, so it has
+// no branches. Sines and cosines come from VectorBatch::SinCos, which keeps
+// the step bit-identical across machines.
+class BikePhysics {
+public:
+    // Nitro on top of the class values
+    static constexpr float NITRO_ACCELERATION_BONUS = 0.5f;
+    static constexpr float NITRO_SPEED_BONUS = 0.2f;
+    static constexpr float DRAG_COEFFICIENT = 0.3f;
+    static constexpr float MAX_SUSPENSION_TRAVEL = 10.0f;
+
+    static void Step(BikeType type, BikeStateStore& states, const uint32_t* slots, size_t count, float deltaTime);
+
+    template <BikeType Type>
+    static void Step(BikeStateStore& states, const uint32_t* slots, size_t count, float deltaTime);
+};
@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "Vector2D.hpp"
+#include "VectorBatch.hpp"
+
+// Allocator handing out cache-line aligned storage so SoA arrays start on
+// a fresh line and can be streamed with aligned vector loads
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* ptr, size_t) {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Structure-of-arrays storage for the hot kinematic state of every bike.
+// Bikes keep only a slot index into this store; physics passes iterate the
+// arrays directly instead of chasing one heap object per bike.
+class BikeStateStore {
+public:
+    static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+    explicit BikeStateStore(size_t initialCapacity = 64) {
+        Reserve(initialCapacity);
+    }
+
+    BikeStateStore(const BikeStateStore&) = delete;
+    BikeStateStore& operator=(const BikeStateStore&) = delete;
+
+    void Reserve(size_t capacity) {
+        positionX.reserve(capacity);
+        positionY.reserve(capacity);
+        velocityX.reserve(capacity);
+        velocityY.reserve(capacity);
+        rotation.reserve(capacity);
+        suspensionTravel.reserve(capacity);
+        previousX.reserve(capacity);
+        previousY.reserve(capacity);
+        previousRotation.reserve(capacity);
+        controls.reserve(capacity);
+        friction.reserve(capacity);
+        alive.reserve(capacity);
+    }
+
+    uint32_t Allocate() {
+        if (!freeSlots.empty()) {
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            Reset(slot);
+            alive[slot] = 1;
+            return slot;
+        }
+        positionX.push_back(0.0f);
+        positionY.push_back(0.0f);
+        velocityX.push_back(0.0f);
+        velocityY.push_back(0.0f);
+        rotation.push_back(0.0f);
+        suspensionTravel.push_back(0.0f);
+        previousX.push_back(0.0f);
+        previousY.push_back(0.0f);
+        previousRotation.push_back(0.0f);
+        controls.push_back(0);
+        friction.push_back(1.0f);
+        alive.push_back(1);
+        return static_cast<uint32_t>(positionX.size() - 1);
+    }
+
+    void Release(uint32_t slot) {
+        if (slot < alive.size() && alive[slot]) {
+            // Released slots keep zero velocity so bulk passes leave them untouched
+            Reset(slot);
+            alive[slot] = 0;
+            freeSlots.push_back(slot);
+        }
+    }
+
+    size_t Size() const { return positionX.size(); }
+    size_t LiveCount() const { return positionX.size() - freeSlots.size(); }
+    bool IsAlive(uint32_t slot) const { return slot < alive.size() && alive[slot] != 0; }
+
+    // Per-slot accessors used by the Bike handle
+    Vector2D GetPosition(uint32_t slot) const { return Vector2D(positionX[slot], positionY[slot]); }
+    Vector2D GetVelocity(uint32_t slot) const { return Vector2D(velocityX[slot], velocityY[slot]); }
+    Vector2D GetPreviousPosition(uint32_t slot) const { return Vector2D(previousX[slot], previousY[slot]); }
+    void SetPosition(uint32_t slot, const Vector2D& pos) { positionX[slot] = pos.x; positionY[slot] = pos.y; }
+    void SetVelocity(uint32_t slot, const Vector2D& vel) { velocityX[slot] = vel.x; velocityY[slot] = vel.y; }
+
+    // Bulk passes over every slot
+    void SavePreviousState() {
+        size_t count = Size();
+        if (count == 0) {
+            return;
+        }
+        std::memcpy(previousX.data(), positionX.data(), count * sizeof(float));
+        std::memcpy(previousY.data(), positionY.data(), count * sizeof(float));
+        std::memcpy(previousRotation.data(), rotation.data(), count * sizeof(float));
+    }
+
+    void Integrate(float deltaTime) {
+        VectorBatch::Integrate(positionX.data(), positionY.data(),
+                               velocityX.data(), velocityY.data(), Size(), deltaTime);
+    }
+
+    // Order of the arrays in a saved state: field f of slot i is at
+    // f * Size() + i. The previous* fields only feed interpolation and are
+    // rebuilt by the next step, so they are not saved.
+    enum SavedField : size_t {
+        SAVED_POSITION_X,
+        SAVED_POSITION_Y,
+        SAVED_VELOCITY_X,
+        SAVED_VELOCITY_Y,
+        SAVED_ROTATION,
+        SAVED_SUSPENSION,
+        SAVED_FIELD_COUNT
+    };
+
+    void SaveState(std::vector<float>& out) const {
+        size_t count = Size();
+        out.resize(count * SAVED_FIELD_COUNT);
+        const AlignedVector<float>* fields[] = {&positionX, &positionY, &velocityX, &velocityY,
+                                                &rotation, &suspensionTravel};
+        for (size_t f = 0; f < SAVED_FIELD_COUNT; ++f) {
+            std::memcpy(out.data() + f * count, fields[f]->data(), count * sizeof(float));
+        }
+    }
+
+    // Expects a state saved from a store with the same slots
+    void LoadState(const std::vector<float>& in) {
+        size_t count = Size();
+        if (in.size() != count * SAVED_FIELD_COUNT) {
+            return;
+        }
+        AlignedVector<float>* fields[] = {&positionX, &positionY, &velocityX, &velocityY,
+                                          &rotation, &suspensionTravel};
+        for (size_t f = 0; f < SAVED_FIELD_COUNT; ++f) {
+            std::memcpy(fields[f]->data(), in.data() + f * count, count * sizeof(float));
+        }
+    }
+
+    // FNV-1a over the simulated fields; equal hashes mean bit-identical state
+    uint64_t Hash() const {
+        uint64_t hash = 14695981039346656037ull;
+        const AlignedVector<float>* fields[] = {&positionX, &positionY, &velocityX, &velocityY,
+                                                &rotation, &suspensionTravel};
+        for (const auto* field : fields) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(field->data());
+            for (size_t i = 0; i < field->size() * sizeof(float); ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    // Hot kinematic fields, one contiguous aligned array each
+    AlignedVector<float> positionX;
+    AlignedVector<float> positionY;
+    AlignedVector<float> velocityX;
+    AlignedVector<float> velocityY;
+    AlignedVector<float> rotation;
+    AlignedVector<float> suspensionTravel;
+    AlignedVector<float> previousX;
+    AlignedVector<float> previousY;
+    AlignedVector<float> previousRotation;
+    // BikeInputMask bits the physics step acts on, after stun and nitro
+    // fuel are taken into account; written by Bike::Update every step, so
+    // not saved either
+    AlignedVector<uint16_t> controls;
+    // Surface friction under the wheels (1 on asphalt), sampled from the
+    // track by Bike::Update alongside the controls
+    AlignedVector<float> friction;
+
+private:
+    void Reset(uint32_t slot) {
+        positionX[slot] = positionY[slot] = 0.0f;
+        velocityX[slot] = velocityY[slot] = 0.0f;
+        rotation[slot] = suspensionTravel[slot] = 0.0f;
+        previousX[slot] = previousY[slot] = previousRotation[slot] = 0.0f;
+        controls[slot] = 0;
+        friction[slot] = 1.0f;
+    }
+
+    AlignedVector<uint8_t> alive;
+    std::vector<uint32_t> freeSlots;
+};
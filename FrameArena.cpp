@@ -0,0 +1,67 @@
+#include "FrameArena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+FrameArena::FrameArena(size_t blockSize) : blockSize(blockSize) {
+    blocks.reserve(8);
+    AddBlock(blockSize);
+}
+
+FrameArena::~FrameArena() {
+    FreeBlocks();
+}
+
+size_t FrameArena::GetCapacity() const {
+    size_t capacity = 0;
+    for (const auto& block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void FrameArena::Reset() {
+    size_t bytes = GetBytesUsed();
+    if (bytes > highWater) {
+        highWater = bytes;
+    }
+    if (blocks.size() > 1) {
+        // Consolidate so the next frame of the same size fits in one block
+        size_t capacity = GetCapacity();
+        FreeBlocks();
+        AddBlock(capacity);
+    }
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        size_t start = static_cast<size_t>(((base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base);
+        if (start + bytes <= block.size) {
+            offset = start + bytes;
+            return block.data + start;
+        }
+        used += offset;
+        offset = 0;
+        if (current + 1 == blocks.size()) {
+            AddBlock(std::max(blockSize, bytes + alignment));
+        }
+        ++current;
+    }
+}
+
+void FrameArena::AddBlock(size_t minimumSize) {
+    size_t size = std::max(blockSize, minimumSize);
+    blocks.push_back({static_cast<unsigned char*>(::operator new(size)), size});
+}
+
+void FrameArena::FreeBlocks() {
+    for (const auto& block : blocks) {
+        ::operator delete(block.data);
+    }
+    blocks.clear();
+}
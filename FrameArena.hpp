@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that lives for one tick or one frame: contact
+// lists, pickup lists, debug text. Allocation is a pointer bump, deallocate
+// is a no-op and Reset() rewinds everything at once. After a frame that
+// needed more than one block, Reset() replaces them with a single block as
+// big as all of them, so steady-state frames never touch the heap.
+//
+// It is a std::pmr::memory_resource, so std::pmr containers can use it:
+//   std::pmr::vector<Contact> contacts(&frameArena);
+// Not thread-safe: at most one thread (or job) may use it at a time.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Everything allocated since the last reset becomes invalid
+    void Reset();
+
+    size_t GetBytesUsed() const { return used + offset; }
+    size_t GetCapacity() const;
+    // Most bytes used between two resets
+    size_t GetHighWater() const { return highWater; }
+
+private:
+    struct Block {
+        unsigned char* data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void AddBlock(size_t minimumSize);
+    void FreeBlocks();
+
+    std::vector<Block> blocks;
+    size_t current = 0; // block being bumped
+    size_t offset = 0;  // bytes used in the current block
+    size_t used = 0;    // bytes used in the blocks before it
+    size_t highWater = 0;
+    size_t blockSize;
+};
@@ -0,0 +1,957 @@
+#include "Game.hpp"
+#include "ParticleSystem.hpp"
+#include "NetworkManager.hpp"
+#include "Profiler.hpp"
+#include "AllocationCounter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char* const RACE_SCENE = "race";
+const char* const BIKE_IMAGES[BIKE_TYPE_COUNT] = {
+    "assets/textures/bike_speed.png", "assets/textures/bike_all_rounder.png", "assets/textures/bike_off_road.png"};
+const char* const POWER_UP_IMAGES[POWER_UP_TYPE_COUNT] = {
+    "assets/textures/powerup_nitro.png", "assets/textures/powerup_shield.png",
+    "assets/textures/powerup_speed_burst.png", "assets/textures/powerup_jump.png",
+    "assets/textures/powerup_missile.png", "assets/textures/powerup_oil_slick.png"};
+const char* const GAME_FONT = "assets/fonts/game.ttf";
+const int GAME_FONT_SIZE = 16;
+const char* const PROFILE_TRACE_FILE = "trace.json";
+
+}
+
+Game::Game()
+    : accumulator(0.0f), simulationTick(0), frameTime(0.0f), fps(0.0f), physicsUpdateTime(0.0f),
+      renderTime(0.0f), window(nullptr), renderer(nullptr), isRunning(false), headless(false),
+      backgroundMusic(nullptr) {}
+
+Game::~Game() {
+    Cleanup();
+}
+
+bool Game::Initialize() {
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER | SDL_INIT_EVENTS) < 0) {
+        SDL_Log("SDL initialization failed: %s", SDL_GetError());
+        return false;
+    }
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        SDL_Log("SDL_image initialization failed: %s", IMG_GetError());
+        return false;
+    }
+    if (TTF_Init() < 0) {
+        SDL_Log("SDL_ttf initialization failed: %s", TTF_GetError());
+        return false;
+    }
+    // Without an audio device the game still runs, just silent
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+        SDL_Log("Audio unavailable: %s", SDL_GetError());
+    }
+
+    window = SDL_CreateWindow(WINDOW_TITLE.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                              SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+    if (!window) {
+        SDL_Log("Window creation failed: %s", SDL_GetError());
+        return false;
+    }
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!renderer) {
+        SDL_Log("Renderer creation failed: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    // Particles are cosmetic, so only windowed games pay for the pool
+    particleSystem = std::make_unique<ParticleSystem>();
+    for (auto& bike : bikes) {
+        bike->SetParticleSystem(particleSystem.get());
+    }
+    LoadResources();
+
+    headless = false;
+    accumulator = 0.0f;
+    simulationTick = 0;
+    isRunning = true;
+    return true;
+}
+
+void Game::Cleanup() {
+    // Everything released is reset too, so this runs again safely from ~Game
+    StopNetworkSession();
+    ghostGame.reset();
+    UnloadScene();
+    pendingResources.clear();
+    pendingScene.clear();
+    gameFont = ResourceHandle();
+    resources.UnloadAll();
+    spriteAtlas.Destroy();
+    if (debugTextTexture) {
+        SDL_DestroyTexture(debugTextTexture);
+        debugTextTexture = nullptr;
+    }
+    for (auto* textures : {&bikeTextures, &trackTextures, &powerUpTextures}) {
+        for (SDL_Texture* texture : *textures) {
+            SDL_DestroyTexture(texture);
+        }
+        textures->clear();
+    }
+    for (Mix_Chunk* sound : soundEffects) {
+        Mix_FreeChunk(sound);
+    }
+    soundEffects.clear();
+    if (backgroundMusic) {
+        Mix_FreeMusic(backgroundMusic);
+        backgroundMusic = nullptr;
+    }
+    if (renderer) {
+        SDL_DestroyRenderer(renderer);
+        renderer = nullptr;
+    }
+    // Only a game that opened a window initialised SDL
+    if (window) {
+        SDL_DestroyWindow(window);
+        window = nullptr;
+        Mix_CloseAudio();
+        Mix_Quit();
+        TTF_Quit();
+        IMG_Quit();
+        SDL_Quit();
+    }
+    isRunning = false;
+}
+
+void Game::Run() {
+    const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    Uint64 previousCounter = SDL_GetPerformanceCounter();
+    accumulator = 0.0f;
+
+    // Never try to catch up more than MAX_FRAME_SKIP steps in one frame,
+    // otherwise a long frame makes the next one longer (spiral of death)
+    const float maxFrameTime = FIXED_TIMESTEP * MAX_FRAME_SKIP;
+
+    // Only the windowed game owns the player's profile
+    currentState.OpenSaves();
+    currentState.ConnectEvents(events);
+
+    while (isRunning) {
+        Uint64 currentCounter = SDL_GetPerformanceCounter();
+        float elapsed = static_cast<float>((currentCounter - previousCounter) / frequency);
+        previousCounter = currentCounter;
+
+        frameTime = elapsed;
+        accumulator += std::min(elapsed, maxFrameTime);
+
+        {
+            BIKE_PROFILE_ZONE("HandleEvents");
+            HandleEvents();
+        }
+
+        Uint64 physicsStart = SDL_GetPerformanceCounter();
+        int steps = 0;
+        while (accumulator >= FIXED_TIMESTEP && steps < MAX_FRAME_SKIP) {
+            ApplyLocalInput();
+            if (networkManager && networkManager->IsActive()) {
+                // Stalls (returns false) while the peer is too far behind
+                networkManager->AdvanceTick(BikeKeyBindings::Player1().Sample(inputFrame.ActiveKeys()));
+            } else {
+                Step();
+            }
+            accumulator -= FIXED_TIMESTEP;
+            ++steps;
+        }
+        // Drop whatever is left after hitting the cap instead of carrying the debt over
+        if (steps == MAX_FRAME_SKIP) {
+            accumulator = std::min(accumulator, FIXED_TIMESTEP);
+        }
+        physicsUpdateTime = static_cast<float>((SDL_GetPerformanceCounter() - physicsStart) / frequency);
+
+        currentState.UpdateStats();
+        UpdateSceneTransition();
+
+        Uint64 renderStart = SDL_GetPerformanceCounter();
+        Render(accumulator / FIXED_TIMESTEP);
+        renderTime = static_cast<float>((SDL_GetPerformanceCounter() - renderStart) / frequency);
+
+        UpdatePerformanceMetrics();
+    }
+    currentState.SaveProgress();
+    currentState.FlushSaves();
+}
+
+bool Game::InitializeHeadless() {
+    // No SDL_Init, window, renderer or mixer: the simulation only touches
+    // plain data, so many headless games can run side by side on threads
+    headless = true;
+    window = nullptr;
+    renderer = nullptr;
+    backgroundMusic = nullptr;
+    accumulator = 0.0f;
+    simulationTick = 0;
+    isRunning = true;
+    return true;
+}
+
+void Game::HandleEvents() {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        if (event.type == SDL_QUIT) {
+            isRunning = false;
+        } else if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+            // F3: profiler overlay and frame stats, F4: trace of the recent frames
+            if (event.key.keysym.scancode == SDL_SCANCODE_F3) {
+                debug.showProfiler = !debug.showProfiler;
+                debug.showFPS = debug.showProfiler;
+            } else if (event.key.keysym.scancode == SDL_SCANCODE_F4) {
+                if (ExportProfile(PROFILE_TRACE_FILE)) {
+                    SDL_Log("Profile written to %s", PROFILE_TRACE_FILE);
+                } else {
+                    SDL_Log("Could not write %s; the profiler only records with BIKE_ENABLE_PROFILER", PROFILE_TRACE_FILE);
+                }
+            }
+        }
+    }
+    // Keyboard state is current now that the queue is drained
+    inputSampler.Sample();
+}
+
+void Game::ApplyLocalInput() {
+    inputSampler.BuildFrame(inputFrame);
+    if (inputFrame.snapshotCount == 0 || replaying) {
+        return;
+    }
+    simulatedInputTimestamp = inputFrame.current.timestampNs;
+    InputSnapshot::KeySet keys = inputFrame.ActiveKeys();
+    for (size_t i = 0; i < std::min(localPlayers, bikes.size()); ++i) {
+        bikes[i]->ApplyInput(bikes[i]->GetKeyBindings().Sample(keys));
+    }
+}
+
+void Game::Step() {
+    // Inputs for tick N are fixed before tick N is simulated
+    if (!replaying) {
+        DriveAIRacers();
+    }
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        if (replaying) {
+            bikes[i]->ApplyInput(replayPlayer.GetInput(i, simulationTick));
+        }
+        if (recording) {
+            inputLog.Record(i, simulationTick, bikes[i]->GetInput());
+        }
+    }
+
+    SavePreviousState();
+    Update(FIXED_TIMESTEP);
+    ++simulationTick;
+    PublishRaceEvents();
+    // Ticks simulated again after a rollback published their events the first time
+    if (resimulating) {
+        events.Clear();
+    } else {
+        events.Dispatch();
+    }
+
+    if (recording) {
+        inputLog.SetTickCount(simulationTick);
+        if (simulationTick % inputLog.GetChecksumInterval() == 0) {
+            inputLog.RecordChecksum(simulationTick, GetStateHash());
+        }
+    }
+    if (replaying && desyncTick == NO_DESYNC) {
+        uint64_t expected = 0;
+        if (!replayPlayer.VerifyChecksum(simulationTick, GetStateHash(), expected)) {
+            desyncTick = simulationTick;
+            SDL_Log("Replay desync at tick %llu", static_cast<unsigned long long>(simulationTick));
+        }
+    }
+    if (ghostGame && !ghostGame->IsReplayFinished() && !resimulating) {
+        ghostGame->Step();
+    }
+    frameArena.Reset();
+}
+
+void Game::LoadTrack(const std::string& filename) {
+    trackFile = filename;
+    currentTrack = std::make_unique<Track>(filename);
+    currentTrack->Load(filename);
+    currentTrack->SetRandomSeeds(randomSeeds.weather, randomSeeds.obstacles);
+    if (!physicsWorld) {
+        physicsWorld = std::make_unique<PhysicsWorld>();
+    }
+    const Track* track = currentTrack.get();
+    physicsWorld->SetProgressAxis([track](const Vector2D& position) { return track->GetProgress(position); },
+                                  track->GetLapLength());
+    physicsWorld->SetStaticGeometry(&track->GetSpatialIndex());
+    // One power-up per spawn point, of a kind drawn from the power-up seed
+    powerUps.clear();
+    for (const Vector2D& spawn : track->GetPowerUpSpawnPoints()) {
+        PowerUpType type = static_cast<PowerUpType>(powerUpRandom.NextInt(POWER_UP_TYPE_COUNT));
+        powerUps.emplace_back(type, spawn);
+        powerUps.back().SetSprite(powerUpSprites[static_cast<size_t>(type)]);
+    }
+    aiRacers.SetTrack(track);
+    for (auto& bike : bikes) {
+        bike->SetTrack(track);
+    }
+}
+
+void Game::LoadResources() {
+    // Every bike and power-up sprite shares one atlas, so each layer is a
+    // single draw call. The images and the font stream in on the resource
+    // workers; until the race scene is resident sprites are flat quads.
+    if (!spriteAtlas.Create(renderer, SPRITE_ATLAS_SIZE, SPRITE_ATLAS_SIZE)) {
+        SDL_Log("Sprite atlas creation failed: %s", SDL_GetError());
+        return;
+    }
+    std::vector<ResourceRequest>& manifest = sceneManifests[RACE_SCENE];
+    manifest.clear();
+    for (const char* path : BIKE_IMAGES) {
+        manifest.push_back({path, ResourceType::IMAGE});
+    }
+    for (const char* path : POWER_UP_IMAGES) {
+        manifest.push_back({path, ResourceType::IMAGE});
+    }
+    manifest.push_back({GAME_FONT, ResourceType::FONT, GAME_FONT_SIZE});
+    TransitionToScene(RACE_SCENE);
+}
+
+void Game::ApplySceneResources(const std::vector<ResourceRequest>& manifest) {
+    // sceneResources holds one handle per manifest entry, in order
+    for (size_t i = 0; i < manifest.size(); ++i) {
+        const ResourceRequest& request = manifest[i];
+        const ResourceHandle& handle = sceneResources[i];
+        AtlasRegion region;
+        if (request.type == ResourceType::IMAGE && handle.GetSurface() &&
+            !spriteAtlas.FindRegion(request.path, region) && !spriteAtlas.AddImage(request.path, handle.GetSurface())) {
+            SDL_Log("Sprite atlas is full, %s left out", request.path.c_str());
+        } else if (request.type == ResourceType::FONT && handle.GetFont()) {
+            gameFont = handle;
+        }
+    }
+    // A missing image leaves that sprite a flat quad
+    for (size_t i = 0; i < BIKE_TYPE_COUNT; ++i) {
+        spriteAtlas.FindRegion(BIKE_IMAGES[i], bikeSprites[i]);
+    }
+    for (size_t i = 0; i < POWER_UP_TYPE_COUNT; ++i) {
+        spriteAtlas.FindRegion(POWER_UP_IMAGES[i], powerUpSprites[i]);
+    }
+    for (auto& bike : bikes) {
+        bike->SetSprite(bikeSprites[static_cast<size_t>(bike->GetType())]);
+    }
+    for (auto& powerUp : powerUps) {
+        powerUp.SetSprite(powerUpSprites[static_cast<size_t>(powerUp.GetType())]);
+    }
+}
+
+void Game::SetRandomSeeds(const RandomSeeds& seeds) {
+    randomSeeds = seeds;
+    powerUpRandom.Seed(seeds.powerUps);
+    if (currentTrack) {
+        currentTrack->SetRandomSeeds(seeds.weather, seeds.obstacles);
+    }
+}
+
+bool Game::StartRecording() {
+    // A log only reproduces a session when it covers it from the first tick,
+    // and a rollback session rewrites ticks after they were recorded
+    if (simulationTick != 0 || (networkManager && networkManager->IsActive())) {
+        return false;
+    }
+    std::vector<InputLog::BikeEntry> entries;
+    for (const auto& bike : bikes) {
+        entries.push_back({bike->GetType(), bike->GetName()});
+    }
+    inputLog.Begin(trackFile, randomSeeds, entries);
+    recording = true;
+    return true;
+}
+
+void Game::StopRecording() {
+    recording = false;
+}
+
+bool Game::StartReplay(const InputLog& log) {
+    if (simulationTick != 0 || !bikes.empty()) {
+        return false;
+    }
+    replayLog = log;
+    SetRandomSeeds(replayLog.GetSeeds());
+    LoadTrack(replayLog.GetTrackFile());
+    for (const auto& entry : replayLog.GetBikes()) {
+        AddBike(entry.type, entry.name);
+    }
+    replayPlayer = InputLogPlayer(&replayLog);
+    replaying = true;
+    desyncTick = NO_DESYNC;
+    return true;
+}
+
+bool Game::AddGhost(const InputLog& run) {
+    // A separate headless game, so the ghost never collides with anything
+    ghostGame = std::make_unique<Game>();
+    ghostGame->InitializeHeadless();
+    if (!ghostGame->StartReplay(run)) {
+        ghostGame.reset();
+        return false;
+    }
+    for (auto& bike : ghostGame->bikes) {
+        bike->SetGhost(true);
+    }
+    return true;
+}
+
+void Game::SaveSnapshot(Snapshot& snapshot) const {
+    snapshot.tick = simulationTick;
+    snapshot.hash = GetStateHash();
+    bikeStates.SaveState(snapshot.bikeStates);
+    snapshot.bikes.resize(bikes.size());
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        snapshot.bikes[i] = bikes[i]->GetSimState();
+    }
+    snapshot.powerUps.resize(powerUps.size());
+    for (size_t i = 0; i < powerUps.size(); ++i) {
+        snapshot.powerUps[i] = powerUps[i].GetSimState();
+    }
+    snapshot.powerUpRandom = powerUpRandom.GetState();
+    if (currentTrack) {
+        currentTrack->SaveDynamicState(snapshot.track);
+    }
+    snapshot.ranking = ranking;
+    snapshot.racerEvents = racerEvents;
+}
+
+void Game::LoadSnapshot(const Snapshot& snapshot) {
+    if (snapshot.bikes.size() != bikes.size()) {
+        SDL_Log("Snapshot has %zu bikes, game has %zu", snapshot.bikes.size(), bikes.size());
+        return;
+    }
+    simulationTick = snapshot.tick;
+    bikeStates.LoadState(snapshot.bikeStates);
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        bikes[i]->SetSimState(snapshot.bikes[i]);
+    }
+    while (powerUps.size() > snapshot.powerUps.size()) {
+        powerUps.pop_back();
+    }
+    for (size_t i = 0; i < powerUps.size(); ++i) {
+        powerUps[i].SetSimState(snapshot.powerUps[i]);
+    }
+    powerUpRandom.SetState(snapshot.powerUpRandom);
+    if (currentTrack) {
+        currentTrack->LoadDynamicState(snapshot.track);
+    }
+    ranking = snapshot.ranking;
+    racerEvents = snapshot.racerEvents;
+}
+
+bool Game::StartNetworkSession(PacketTransport& transport, uint32_t localPlayer,
+                               std::function<uint64_t()> clockMs) {
+    if (simulationTick != 0 || bikes.size() != NetworkManager::PLAYER_COUNT || recording || replaying) {
+        SDL_Log("Network sessions need a fresh two-bike game");
+        return false;
+    }
+    if (!networkManager) {
+        networkManager = std::make_unique<NetworkManager>(*this);
+    }
+    return networkManager->Start(transport, localPlayer, std::move(clockMs));
+}
+
+void Game::StopNetworkSession() {
+    if (networkManager) {
+        networkManager->Stop();
+    }
+}
+
+void Game::AddBike(BikeType type, const std::string& name) {
+    bikes.push_back(std::make_unique<Bike>(type, name, bikeStates));
+    if (currentTrack) {
+        bikes.back()->SetPosition(currentTrack->GetStartPosition(static_cast<int>(bikes.size() - 1)));
+    }
+    // Player 1 layout for even bikes, player 2 layout for odd ones
+    bikes.back()->SetKeyBindings(bikes.size() % 2 == 1 ? BikeKeyBindings::Player1() : BikeKeyBindings::Player2());
+    bikes.back()->SetParticleSystem(particleSystem.get());
+    bikes.back()->SetTrack(currentTrack.get());
+    bikes.back()->SetSprite(bikeSprites[static_cast<size_t>(type)]);
+    bikes.back()->SavePreviousState();
+    ranking.AddRacer();
+    racerEvents.emplace_back();
+}
+
+void Game::AddAIRacer(BikeType type, const std::string& name, Difficulty difficulty) {
+    AddBike(type, name);
+    aiRacers.AddRacer(static_cast<uint32_t>(bikes.size() - 1), bikes.back()->GetStateSlot(), type, difficulty);
+}
+
+void Game::DriveAIRacers() {
+    size_t count = aiRacers.GetRacerCount();
+    if (count == 0) {
+        return;
+    }
+    aiContext.resize(count);
+    aiInputs.resize(count);
+    for (size_t r = 0; r < count; ++r) {
+        uint32_t bike = aiRacers.GetBike(r);
+        aiContext[r] = {bikes[bike]->HasPowerUp(), ranking.GetGapAhead(bike)};
+    }
+    aiRacers.Update(bikeStates, aiContext.data(), aiInputs.data());
+    for (size_t r = 0; r < count; ++r) {
+        bikes[aiRacers.GetBike(r)]->ApplyInput(aiInputs[r]);
+    }
+}
+
+void Game::ApplyBikeInput(size_t bikeIndex, const Uint8* keystate) {
+    if (bikeIndex < bikes.size()) {
+        bikes[bikeIndex]->HandleInput(keystate);
+    }
+}
+
+void Game::ApplyBikeInput(size_t bikeIndex, BikeInputMask mask) {
+    if (bikeIndex < bikes.size()) {
+        bikes[bikeIndex]->ApplyInput(mask);
+    }
+}
+
+bool Game::IsRaceFinished(int laps) const {
+    if (bikes.empty()) {
+        return false;
+    }
+    for (const auto& bike : bikes) {
+        if (bike->GetCurrentLap() < laps) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Game::PublishRaceEvents() {
+    bool laps = events.HasSubscribers(GameEventType::LAP_COMPLETED);
+    bool speeds = events.HasSubscribers(GameEventType::TOP_SPEED);
+    for (uint32_t i = 0; i < bikes.size(); ++i) {
+        const Bike& bike = *bikes[i];
+        RacerEvents& racer = racerEvents[i];
+        // Only a new highest lap counts, so reversing over the line and
+        // crossing it again is not a lap. From a grid spot behind the line
+        // the first crossing starts the race and the lap clock.
+        int lap = ranking.GetLap(i);
+        if (lap > racer.lap) {
+            if (laps && ranking.GetLapsCompleted(i) > 0) {
+                float lapTime = (simulationTick - racer.lapStartTick) * FIXED_TIMESTEP;
+                events.Publish({GameEventType::LAP_COMPLETED, i, ranking.GetRank(i), lapTime});
+            }
+            racer.lap = lap;
+            racer.lapStartTick = simulationTick;
+        }
+
+        // One event per TOP_SPEED_EVENT_STEP of new record, not one per tick
+        float speed = bike.GetVelocity().Length();
+        if (speed >= racer.nextTopSpeed) {
+            if (speeds) {
+                events.Publish({GameEventType::TOP_SPEED, i, 0, speed});
+            }
+            racer.nextTopSpeed = (std::floor(speed / TOP_SPEED_EVENT_STEP) + 1.0f) * TOP_SPEED_EVENT_STEP;
+        }
+    }
+}
+
+void Game::SavePreviousState() {
+    bikeStates.SavePreviousState();
+    for (auto& powerUp : powerUps) {
+        powerUp.SavePreviousState();
+    }
+}
+
+void Game::Update(float deltaTime) {
+    BIKE_PROFILE_ZONE("Update");
+    // Always called with FIXED_TIMESTEP so identical inputs give identical results
+    if (!headless && !jobSystem) {
+        jobSystem = std::make_unique<JobSystem>();
+    }
+    if (updateGraph.IsEmpty() || graphBikeCount != bikes.size()) {
+        BuildUpdateGraph();
+    }
+    stepDeltaTime = deltaTime;
+    // Serial, before the bike jobs read the terrain around them
+    if (currentTrack) {
+        for (const auto& bike : bikes) {
+            currentTrack->BakeTerrainAround(bike->GetPosition(), TERRAIN_BAKE_RADIUS);
+        }
+    }
+    updateGraph.Run(jobSystem.get());
+}
+
+void Game::BuildUpdateGraph() {
+    // Every job writes only state it owns, and anything shared (particles,
+    // power-ups, track) is touched in a single job, so the result does not
+    // depend on how jobs land on workers
+    updateGraph.Clear();
+    graphBikeCount = bikes.size();
+
+    std::vector<JobGraph::NodeId> bikeJobs;
+    for (size_t first = 0; first < bikes.size(); first += BIKES_PER_JOB) {
+        size_t last = std::min(bikes.size(), first + BIKES_PER_JOB);
+        bikeJobs.push_back(updateGraph.Add("Bikes", [this, first, last] {
+            for (size_t i = first; i < last; ++i) {
+                bikes[i]->Update(stepDeltaTime);
+            }
+        }));
+    }
+
+    // Forces run per bike class so each batch uses the physics step built
+    // for that class; a bike's slot is only touched by its own batch
+    for (auto& slots : physicsSlots) {
+        slots.clear();
+    }
+    for (const auto& bike : bikes) {
+        // Unknown types run as all-rounders, as in GetBikeStats
+        size_t type = static_cast<size_t>(bike->GetType());
+        if (type >= BIKE_TYPE_COUNT) {
+            type = static_cast<size_t>(BikeType::ALL_ROUNDER);
+        }
+        physicsSlots[type].push_back(bike->GetStateSlot());
+    }
+    std::vector<JobGraph::NodeId> physicsJobs;
+    for (size_t type = 0; type < BIKE_TYPE_COUNT; ++type) {
+        const std::vector<uint32_t>& slots = physicsSlots[type];
+        for (size_t first = 0; first < slots.size(); first += PHYSICS_BIKES_PER_JOB) {
+            size_t count = std::min(slots.size() - first, PHYSICS_BIKES_PER_JOB);
+            JobGraph::NodeId job = updateGraph.Add("BikePhysics", [this, type, first, count] {
+                BikePhysics::Step(static_cast<BikeType>(type), bikeStates, physicsSlots[type].data() + first, count,
+                                  stepDeltaTime);
+            });
+            for (JobGraph::NodeId bikeJob : bikeJobs) {
+                updateGraph.Depend(bikeJob, job);
+            }
+            physicsJobs.push_back(job);
+        }
+    }
+
+    JobGraph::NodeId integrate = updateGraph.Add("Integrate", [this] { bikeStates.Integrate(stepDeltaTime); });
+    for (JobGraph::NodeId job : physicsJobs) {
+        updateGraph.Depend(job, integrate);
+    }
+    JobGraph::NodeId collisions = updateGraph.Add("Collisions", [this] { ResolveCollisions(); });
+    updateGraph.Depend(integrate, collisions);
+
+    JobGraph::NodeId powerUpJob = updateGraph.Add("PowerUps", [this] {
+        for (auto& powerUp : powerUps) {
+            powerUp.Update(stepDeltaTime);
+        }
+    });
+    JobGraph::NodeId trackJob = updateGraph.Add("Track", [this] {
+        if (currentTrack) {
+            currentTrack->Update(stepDeltaTime);
+        }
+    });
+    JobGraph::NodeId particleJob = updateGraph.Add("Particles", [this] {
+        if (particleSystem && !headless && !resimulating) {
+            particleSystem->Update(stepDeltaTime);
+        }
+    });
+    JobGraph::NodeId rankingJob = updateGraph.Add("Ranking", [this] {
+        if (!currentTrack) {
+            return;
+        }
+        for (size_t i = 0; i < bikes.size(); ++i) {
+            ranking.UpdateRacer(static_cast<uint32_t>(i), *currentTrack, bikes[i]->GetPosition());
+            bikes[i]->SetCurrentLap(ranking.GetLapsCompleted(static_cast<uint32_t>(i)));
+        }
+        ranking.UpdateOrder();
+    });
+    updateGraph.Depend(collisions, powerUpJob);
+    updateGraph.Depend(collisions, trackJob);
+    updateGraph.Depend(collisions, particleJob);
+    updateGraph.Depend(collisions, rankingJob);
+}
+
+void Game::SyncPhysicsBodies() {
+    if (!physicsWorld) {
+        physicsWorld = std::make_unique<PhysicsWorld>();
+    }
+    while (bikeBodies.size() < bikes.size()) {
+        bikeBodies.push_back(physicsWorld->AddBody(PhysicsWorld::BodyType::BIKE, static_cast<uint32_t>(bikeBodies.size())));
+    }
+    while (powerUpBodies.size() < powerUps.size()) {
+        powerUpBodies.push_back(physicsWorld->AddBody(PhysicsWorld::BodyType::POWER_UP, static_cast<uint32_t>(powerUpBodies.size())));
+    }
+    // A rollback can drop power-ups spawned after the restored tick
+    for (size_t i = powerUps.size(); i < powerUpBodies.size(); ++i) {
+        physicsWorld->SetEnabled(powerUpBodies[i], false);
+    }
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        physicsWorld->SetBox(bikeBodies[i], bikes[i]->GetOrientedBox());
+    }
+    for (size_t i = 0; i < powerUps.size(); ++i) {
+        SDL_Rect rect = powerUps[i].GetCollisionBox();
+        Vector2D center(rect.x + rect.w * 0.5f, rect.y + rect.h * 0.5f);
+        physicsWorld->SetBox(powerUpBodies[i], OrientedBox::FromRotation(center, rect.w * 0.5f, rect.h * 0.5f, 0.0f));
+        physicsWorld->SetEnabled(powerUpBodies[i], !powerUps[i].IsCollected());
+    }
+}
+
+void Game::SweepBikes() {
+    // Each bike's whole step, from the position before integration to the
+    // one after, is checked in one sweep, so fast bikes need no substeps
+    for (uint32_t i = 0; i < bikes.size(); ++i) {
+        Bike* bike = bikes[i].get();
+        if (bike->IsAirborne()) {
+            continue; // jumped clear of the obstacles
+        }
+        Vector2D from = bike->GetPreviousPosition();
+        Vector2D to = bike->GetPosition();
+        PhysicsWorld::SweepHit hit;
+        if (!physicsWorld->Sweep(from, to, bike->GetSweepRadius(), hit)) {
+            continue;
+        }
+        // Stop just short of the surface and bounce off it; the rest of the
+        // step's motion is dropped
+        bike->SetPosition(from + (to - from) * hit.time + hit.normal * SWEEP_SKIN);
+        Vector2D velocity = bike->GetVelocity();
+        float approach = velocity.Dot(hit.normal);
+        if (approach < 0.0f) {
+            bike->SetVelocity(velocity - hit.normal * (approach * (1.0f + OBSTACLE_RESTITUTION)));
+            events.Publish({GameEventType::COLLISION, i, COLLISION_OBSTACLE, -approach});
+            // Sparks fly off the contact point, more for harder hits
+            if (particleSystem && !resimulating) {
+                Vector2D contact = bike->GetPosition() - hit.normal * bike->GetSweepRadius();
+                int count = std::min(MAX_IMPACT_SPARKS, 4 + static_cast<int>(-approach * SPARKS_PER_SPEED));
+                particleSystem->Emit(ParticleEmitters::SPARKS, contact, hit.normal.Angle(), count);
+            }
+        }
+    }
+}
+
+void Game::ApplyUsedPowerUps() {
+    for (uint32_t i = 0; i < bikes.size(); ++i) {
+        Bike* bike = bikes[i].get();
+        PowerUpType type;
+        if (!bike->TakeUsedPowerUp(type)) {
+            continue;
+        }
+        if (type == PowerUpType::MISSILE) {
+            // Homes in on the racer one place ahead; the leader's goes nowhere
+            uint32_t rank = ranking.GetRank(i);
+            if (rank > 0) {
+                bikes[ranking.GetOrder()[rank - 1]]->TakeHit(MISSILE_STUN_TIME);
+            }
+        } else if (type == PowerUpType::OIL_SLICK && currentTrack) {
+            float rotation = bike->GetRotation();
+            Vector2D behind(-std::cos(rotation) * OIL_SLICK_BEHIND, -std::sin(rotation) * OIL_SLICK_BEHIND);
+            currentTrack->AddOilSlick(bike->GetPosition() + behind, OIL_SLICK_RADIUS, OIL_SLICK_LIFETIME);
+        }
+        events.Publish({GameEventType::POWER_UP_USED, i, static_cast<uint32_t>(type), 0.0f});
+    }
+}
+
+void Game::ResolveCollisions() {
+    // Bike order, so pickups and particle bursts are the same on every run
+    for (auto& bike : bikes) {
+        if (resimulating) {
+            bike->ClearParticles();
+        } else {
+            bike->FlushParticles();
+        }
+    }
+
+    ApplyUsedPowerUps();
+    SyncPhysicsBodies();
+    SweepBikes();
+    std::pmr::vector<PhysicsWorld::Contact> contacts(&frameArena);
+    contacts.reserve(bikes.size() * 2);
+    physicsWorld->Step(contacts);
+
+    // Contacts come sorted by body id; pickups are re-sorted by bike then
+    // power-up so the lowest bike index wins a contested pickup
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> pickups(&frameArena);
+    for (const auto& contact : contacts) {
+        PhysicsWorld::BodyType typeA = physicsWorld->GetType(contact.a);
+        PhysicsWorld::BodyType typeB = physicsWorld->GetType(contact.b);
+        uint32_t ownerA = physicsWorld->GetOwner(contact.a);
+        uint32_t ownerB = physicsWorld->GetOwner(contact.b);
+        if (typeA == PhysicsWorld::BodyType::POWER_UP) {
+            pickups.push_back({ownerB, ownerA});
+        } else if (typeB == PhysicsWorld::BodyType::POWER_UP) {
+            pickups.push_back({ownerA, ownerB});
+        } else {
+            // Equal masses: split the overlap and damp the closing speed along the normal
+            Bike& first = *bikes[ownerA];
+            Bike& second = *bikes[ownerB];
+            Vector2D push = contact.normal * (contact.depth * 0.5f);
+            first.SetPosition(first.GetPosition() - push);
+            second.SetPosition(second.GetPosition() + push);
+            float closing = (first.GetVelocity() - second.GetVelocity()).Dot(contact.normal);
+            if (closing > 0.0f) {
+                Vector2D impulse = contact.normal * (closing * (1.0f + BIKE_RESTITUTION) * 0.5f);
+                first.SetVelocity(first.GetVelocity() - impulse);
+                second.SetVelocity(second.GetVelocity() + impulse);
+                events.Publish({GameEventType::COLLISION, ownerA, COLLISION_BIKE, closing});
+                events.Publish({GameEventType::COLLISION, ownerB, COLLISION_BIKE, closing});
+            }
+        }
+    }
+    std::sort(pickups.begin(), pickups.end());
+    for (const auto& pickup : pickups) {
+        PowerUp& powerUp = powerUps[pickup.second];
+        if (!powerUp.IsCollected()) {
+            powerUp.Collect();
+            powerUp.ApplyEffect(bikes[pickup.first].get());
+            if (PowerUp::IsHeld(powerUp.GetType())) {
+                continue; // published when it is used
+            }
+            events.Publish({GameEventType::POWER_UP_USED, pickup.first, static_cast<uint32_t>(powerUp.GetType()), 0.0f});
+        }
+    }
+}
+
+void Game::UpdatePerformanceMetrics() {
+    // Smoothed so the readout does not flicker every frame
+    if (frameTime > 0.0f) {
+        float instantFps = 1.0f / frameTime;
+        fps = fps > 0.0f ? fps * 0.9f + instantFps * 0.1f : instantFps;
+    }
+    BIKE_PROFILE_FRAME(frameTime);
+
+    uint64_t allocations = AllocationCounter::GetTotal();
+    frameAllocations = allocations - allocationsAtFrameStart;
+    allocationsAtFrameStart = allocations;
+}
+
+bool Game::ExportProfile(const std::string& path) const {
+#ifdef BIKE_ENABLE_PROFILER
+    return Profiler::Get().ExportChromeTrace(path);
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void Game::TransitionToScene(const std::string& sceneName) {
+    // Stream the next scene in the background; the switch happens once it is
+    // resident. The handles pin it meanwhile, or the budget could evict what
+    // has loaded before the rest arrives and the switch would never come.
+    auto manifest = sceneManifests.find(sceneName);
+    pendingResources.clear();
+    if (manifest != sceneManifests.end()) {
+        pendingResources = resources.Prefetch(manifest->second, ResourcePriority::PRELOAD);
+    }
+    pendingScene = sceneName;
+}
+
+void Game::LoadScene(const std::string& sceneName) {
+    currentScene = sceneName;
+    auto manifest = sceneManifests.find(sceneName);
+    if (manifest == sceneManifests.end()) {
+        return;
+    }
+    // Already resident after the prefetch; the handles only pin them
+    sceneResources.reserve(manifest->second.size());
+    for (const auto& request : manifest->second) {
+        sceneResources.push_back(resources.Request(request, ResourcePriority::IMMEDIATE));
+    }
+    ApplySceneResources(manifest->second);
+}
+
+void Game::UnloadScene() {
+    // Released resources stay cached until the budget evicts them, so
+    // anything the next scene shares is not loaded twice
+    sceneResources.clear();
+    currentScene.clear();
+}
+
+void Game::UpdateSceneTransition() {
+    if (pendingScene.empty()) {
+        return;
+    }
+    auto manifest = sceneManifests.find(pendingScene);
+    if (manifest == sceneManifests.end() || resources.IsLoaded(manifest->second)) {
+        UnloadScene();
+        LoadScene(pendingScene);
+        pendingScene.clear();
+        pendingResources.clear();
+    }
+}
+
+void Game::Render(float interpolation) {
+    if (headless) {
+        return;
+    }
+    BIKE_PROFILE_ZONE("Render");
+
+    resources.PumpUploads(renderer, MAX_TEXTURE_UPLOADS_PER_FRAME);
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    // The queue sorts by layer and texture, so objects can submit in any order
+    if (currentTrack) {
+        currentTrack->Render(renderQueue);
+    }
+    for (auto& powerUp : powerUps) {
+        if (!powerUp.IsCollected()) {
+            powerUp.Render(renderQueue, interpolation);
+        }
+    }
+    for (auto& bike : bikes) {
+        bike->Render(renderQueue, interpolation);
+    }
+    if (ghostGame) {
+        for (auto& bike : ghostGame->bikes) {
+            bike->Render(renderQueue, interpolation);
+        }
+    }
+    if (particleSystem) {
+        particleSystem->Render(renderQueue);
+    }
+#ifdef BIKE_ENABLE_PROFILER
+    if (debug.showProfiler) {
+        Profiler::Get().DrawOverlay(renderQueue, 10.0f, SCREEN_HEIGHT - 130.0f, 480.0f, 120.0f);
+    }
+#endif
+    renderQueue.Flush(renderer);
+
+    if (debug.showFPS) {
+        RenderDebugInfo();
+    }
+
+    SDL_RenderPresent(renderer);
+    if (simulatedInputTimestamp != 0) {
+        inputLatency = (InputSampler::Now() - simulatedInputTimestamp) * 1e-9f;
+    }
+    resources.EndFrame();
+    frameArena.Reset();
+}
+
+void Game::RenderDebugInfo() {
+    TTF_Font* font = gameFont.GetFont();
+    if (!font) {
+        return;
+    }
+    // The text is rebuilt a few times a second and only re-rendered when it
+    // changed, so a frame normally just copies the cached texture
+    debugTextAge += frameTime;
+    if (!debugTextTexture || debugTextAge >= DEBUG_TEXT_INTERVAL) {
+        debugTextAge = 0.0f;
+        char line[sizeof(debugText)];
+        std::snprintf(line, sizeof(line),
+                      "%.0f fps  sim %.2f ms  render %.2f ms  input %.1f ms  %d draws  %llu allocs%s",
+                      fps, physicsUpdateTime * 1000.0f, renderTime * 1000.0f, inputLatency * 1000.0f,
+                      renderQueue.GetStats().drawCalls, static_cast<unsigned long long>(frameAllocations),
+                      AllocationCounter::IsEnabled() ? "" : " (not counted)");
+        if (!debugTextTexture || std::strcmp(line, debugText) != 0) {
+            std::memcpy(debugText, line, sizeof(line));
+            SDL_Surface* surface = TTF_RenderUTF8_Blended(font, debugText, {255, 255, 255, 255});
+            if (surface) {
+                if (debugTextTexture) {
+                    SDL_DestroyTexture(debugTextTexture);
+                }
+                debugTextTexture = SDL_CreateTextureFromSurface(renderer, surface);
+                debugTextRect = {10, 10, surface->w, surface->h};
+                SDL_FreeSurface(surface);
+            }
+        }
+    }
+    if (debugTextTexture) {
+        SDL_RenderCopy(renderer, debugTextTexture, nullptr, &debugTextRect);
+    }
+}
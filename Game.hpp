@@ -3,20 +3,31 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
+#include <array>
+#include <functional>
+#include <map>
 #include <memory>
 #include <vector>
 #include <string>
 #include "GameState.hpp"
+#include "GameEvents.hpp"
 #include "Bike.hpp"
 #include "Track.hpp"
 #include "PowerUp.hpp"
+#include "ResourceStreamer.hpp"
+#include "RenderQueue.hpp"
+#include "InputLog.hpp"
+#include "Random.hpp"
+#include "JobSystem.hpp"
+#include "PhysicsWorld.hpp"
+#include "RaceRanking.hpp"
+#include "AIRacerController.hpp"
+#include "FrameArena.hpp"
+#include "InputSampler.hpp"
 
 class ParticleSystem;
-class SoundManager;
-class UIManager;
 class NetworkManager;
-class PhysicsWorld;
-class Camera;
+class PacketTransport;
 
 class Game {
 public:
@@ -24,81 +35,252 @@ public:
     ~Game();
     
     bool Initialize();
+    bool InitializeHeadless();
     void Run();
     void Cleanup();
     
+    // Simulation control, usable without a window (headless races, tools)
+    void Step();
+    void LoadTrack(const std::string& filename);
+    void AddBike(BikeType type, const std::string& name);
+    // A bike driven by the AI; its input is decided at the start of every Step
+    void AddAIRacer(BikeType type, const std::string& name, Difficulty difficulty);
+    void ApplyBikeInput(size_t bikeIndex, const Uint8* keystate);
+    void ApplyBikeInput(size_t bikeIndex, BikeInputMask mask);
+    bool IsRaceFinished(int laps) const;
+    bool IsHeadless() const { return headless; }
+    Uint64 GetSimulationTick() const { return simulationTick; }
+    float GetFixedTimestep() const { return FIXED_TIMESTEP; }
+    size_t GetBikeCount() const { return bikes.size(); }
+    const Bike& GetBike(size_t index) const { return *bikes[index]; }
+    uint64_t GetStateHash() const { return bikeStates.Hash(); }
+    
+    // Deterministic record and replay. Recording must start before the first
+    // step; replay expects a fresh game and rebuilds track and bikes from the log.
+    void SetRandomSeeds(const RandomSeeds& seeds);
+    bool StartRecording();
+    void StopRecording();
+    bool IsRecording() const { return recording; }
+    const InputLog& GetInputLog() const { return inputLog; }
+    bool StartReplay(const InputLog& log);
+    bool IsReplayFinished() const { return !replaying || replayPlayer.IsFinished(simulationTick); }
+    // First tick whose state hash differed from the recording, or NO_DESYNC
+    uint64_t GetDesyncTick() const { return desyncTick; }
+    static constexpr uint64_t NO_DESYNC = ~0ull;
+    
+    // Per-racer marks for lap and top speed events, kept in snapshots
+    struct RacerEvents {
+        int lap = 0;
+        uint64_t lapStartTick = 0;
+        float nextTopSpeed = TOP_SPEED_EVENT_STEP;
+    };
+    
+    // Everything the simulation reads, for rollback. Buffers are sized by the
+    // first save and reused after that, so saving every tick stays cheap.
+    // Snapshots only restore into the game (and bike set) that saved them.
+    struct Snapshot {
+        uint64_t tick = 0;
+        uint64_t hash = 0;
+        std::vector<float> bikeStates;
+        std::vector<Bike::SimState> bikes;
+        std::vector<PowerUp::SimState> powerUps;
+        uint64_t powerUpRandom = 0;
+        Track::DynamicState track;
+        RaceRanking ranking;
+        std::vector<RacerEvents> racerEvents;
+    };
+    void SaveSnapshot(Snapshot& snapshot) const;
+    void LoadSnapshot(const Snapshot& snapshot);
+    // While set, Step skips particles and other presentation-only work
+    void SetResimulating(bool value) { resimulating = value; }
+    
+    // Two-player rollback session: localPlayer's bike follows this machine's
+    // input, the other bike the peer's. Must start before the first step.
+    // clockMs timestamps packets; without one the steady clock is used.
+    bool StartNetworkSession(PacketTransport& transport, uint32_t localPlayer,
+                             std::function<uint64_t()> clockMs = nullptr);
+    void StopNetworkSession();
+    
+    // TIME_TRIAL ghost: replays a saved run (e.g. the best one, truncated at
+    // the end of its best lap) next to the player without interacting
+    bool AddGhost(const InputLog& run);
+    void ClearGhost() { ghostGame.reset(); }
+    
     // Subsystem access
     ParticleSystem* GetParticleSystem() { return particleSystem.get(); }
-    SoundManager* GetSoundManager() { return soundManager.get(); }
-    UIManager* GetUIManager() { return uiManager.get(); }
+    const RenderStats& GetRenderStats() const { return renderQueue.GetStats(); }
+    // Chrome trace JSON of recent profiler zones; false when the profiler is compiled out
+    bool ExportProfile(const std::string& path) const;
     NetworkManager* GetNetworkManager() { return networkManager.get(); }
     PhysicsWorld* GetPhysicsWorld() { return physicsWorld.get(); }
-    Camera* GetCamera() { return camera.get(); }
+    const Track* GetTrack() const { return currentTrack.get(); }
+    // Standings, updated every tick; racer indices are bike indices
+    const RaceRanking& GetRanking() const { return ranking; }
+    // Laps, pickups, collisions and speed records, delivered after each step
+    GameEventBus& GetEvents() { return events; }
+    // Heap allocations during the last frame; 0 unless built with BIKE_COUNT_ALLOCATIONS
+    uint64_t GetFrameAllocations() const { return frameAllocations; }
+    // Time from sampling the input the last presented frame simulated to presenting it
+    float GetInputLatency() const { return inputLatency; }
 
 private:
     // Core game loop
     void HandleEvents();
     void Update(float deltaTime);
-    void Render();
+    void Render(float interpolation);
     void LoadResources();
     
+    // Update runs as a job graph: bike chunks in parallel, then integration
+    // and collisions, then power-ups, track, particles and ranking in parallel.
+    // Headless games run the same graph serially on their own thread.
+    void BuildUpdateGraph();
+    void ResolveCollisions();
+    std::unique_ptr<JobSystem> jobSystem;
+    JobGraph updateGraph;
+    size_t graphBikeCount = 0;
+    float stepDeltaTime = 0.0f;
+    static constexpr size_t BIKES_PER_JOB = 8;
+    // Bike slots grouped by BikeType for the physics batches
+    std::array<std::vector<uint32_t>, BIKE_TYPE_COUNT> physicsSlots;
+    static constexpr size_t PHYSICS_BIKES_PER_JOB = 64;
+    // Terrain is baked this far around each bike, past its wheels and a step's travel
+    static constexpr float TERRAIN_BAKE_RADIUS = 160.0f;
+    
+    // Collision bodies, indexed like bikes and powerUps
+    void SyncPhysicsBodies();
+    void SweepBikes();
+    // Missiles and oil spent in this step's bike updates, in bike order
+    void ApplyUsedPowerUps();
+    std::vector<PhysicsWorld::BodyId> bikeBodies;
+    std::vector<PhysicsWorld::BodyId> powerUpBodies;
+    static constexpr float BIKE_RESTITUTION = 0.3f;
+    static constexpr float OBSTACLE_RESTITUTION = 0.2f;
+    static constexpr float SWEEP_SKIN = 0.5f;
+    static constexpr float MISSILE_STUN_TIME = 1.5f;
+    static constexpr float OIL_SLICK_RADIUS = 40.0f;
+    static constexpr float OIL_SLICK_LIFETIME = 8.0f; // seconds
+    static constexpr float OIL_SLICK_BEHIND = 50.0f;  // px behind the rider
+    static constexpr int MAX_IMPACT_SPARKS = 24;
+    static constexpr float SPARKS_PER_SPEED = 0.05f; // extra sparks per px/s of impact
+    
+    // Fixed-step simulation
+    void SavePreviousState();
+    float accumulator;
+    Uint64 simulationTick;
+    
+    // Record/replay state
+    std::string trackFile;
+    RandomSeeds randomSeeds;
+    Random powerUpRandom;
+    InputLog inputLog;
+    bool recording = false;
+    InputLog replayLog;
+    InputLogPlayer replayPlayer;
+    bool replaying = false;
+    uint64_t desyncTick = NO_DESYNC;
+    std::unique_ptr<Game> ghostGame;
+    bool resimulating = false;
+    
     // Game systems
     std::unique_ptr<ParticleSystem> particleSystem;
-    std::unique_ptr<SoundManager> soundManager;
-    std::unique_ptr<UIManager> uiManager;
     std::unique_ptr<NetworkManager> networkManager;
     std::unique_ptr<PhysicsWorld> physicsWorld;
-    std::unique_ptr<Camera> camera;
     
     // Performance monitoring
     float frameTime;
     float fps;
     float physicsUpdateTime;
     float renderTime;
+    uint64_t frameAllocations = 0;
+    uint64_t allocationsAtFrameStart = 0;
+    
+    // Scratch for one tick (reset at the end of Step) or one rendered frame
+    // (reset at the end of Render); never hold on to anything allocated here
+    FrameArena frameArena;
     
     void UpdatePerformanceMetrics();
     void RenderDebugInfo();
+    // Cached readout texture, re-rendered only when the text changes
+    static constexpr float DEBUG_TEXT_INTERVAL = 0.25f;
+    char debugText[160] = {};
+    SDL_Texture* debugTextTexture = nullptr;
+    SDL_Rect debugTextRect = {0, 0, 0, 0};
+    float debugTextAge = 0.0f;
     
     // Scene management
     void LoadScene(const std::string& sceneName);
     void UnloadScene();
     void TransitionToScene(const std::string& sceneName);
     
-    // Resource management
-    struct ResourceManager {
-        std::map<std::string, SDL_Texture*> textures;
-        std::map<std::string, Mix_Chunk*> sounds;
-        std::map<std::string, Mix_Music*> music;
-        std::map<std::string, TTF_Font*> fonts;
-        void UnloadAll();
-    } resources;
-    
-    // Input handling
-    struct InputState {
-        std::map<SDL_Keycode, bool> keyStates;
-        std::map<Uint8, bool> mouseStates;
-        int mouseX, mouseY;
-        void Update();
-    } input;
+    void UpdateSceneTransition();
+    std::string pendingScene;
+    std::string currentScene;
+    // Handles to the current and the pending scene's manifests, which keep
+    // them from eviction
+    std::vector<ResourceHandle> sceneResources;
+    std::vector<ResourceHandle> pendingResources;
+    // Packs the scene's images into the sprite atlas and picks up its font
+    void ApplySceneResources(const std::vector<ResourceRequest>& manifest);
+    
+    // Resource management: decoded on worker threads, uploaded on the render thread
+    ResourceStreamer resources;
+    std::map<std::string, std::vector<ResourceRequest>> sceneManifests;
+    const int MAX_TEXTURE_UPLOADS_PER_FRAME = 4;
+    
+    // Input handling: snapshots are sampled with the events and drained
+    // once per fixed step; the first localPlayers bikes follow the keyboard
+    void ApplyLocalInput();
+    InputSampler inputSampler;
+    InputFrame inputFrame;
+    size_t localPlayers = 2;
+    float inputLatency = 0.0f; // newest simulated snapshot to present, seconds
+    uint64_t simulatedInputTimestamp = 0;
     
     SDL_Window* window;
     SDL_Renderer* renderer;
     bool isRunning;
+    bool headless;
     GameState currentState;
+    // After currentState: its handlers point into it
+    GameEventBus events;
+    
+    // Lap and top speed events fire when a racer passes its best so far.
+    // The marks are part of the snapshot, so a rollback restores them too.
+    void PublishRaceEvents();
+    std::vector<RacerEvents> racerEvents;
+    static constexpr float TOP_SPEED_EVENT_STEP = 10.0f;
     
+    // AI racers decide their input from the state of the tick about to run
+    void DriveAIRacers();
+    AIRacerController aiRacers;
+    std::vector<AIRacerController::Context> aiContext;
+    std::vector<BikeInputMask> aiInputs;
+    
+    // Declared before bikes so it outlives the handles that point into it
+    BikeStateStore bikeStates;
     std::vector<std::unique_ptr<Bike>> bikes;
     std::unique_ptr<Track> currentTrack;
     std::vector<PowerUp> powerUps;
+    RaceRanking ranking;
     
     // Audio
     Mix_Music* backgroundMusic;
     std::vector<Mix_Chunk*> soundEffects;
     
+    // Everything on screen goes through the queue; sprites share one atlas
+    RenderQueue renderQueue;
+    TextureAtlas spriteAtlas;
+    static constexpr int SPRITE_ATLAS_SIZE = 1024;
+    // Regions for each BikeType and PowerUpType; flat quads until loaded
+    AtlasRegion bikeSprites[BIKE_TYPE_COUNT];
+    AtlasRegion powerUpSprites[POWER_UP_TYPE_COUNT];
+    
     // Resources
     std::vector<SDL_Texture*> bikeTextures;
     std::vector<SDL_Texture*> trackTextures;
     std::vector<SDL_Texture*> powerUpTextures;
-    TTF_Font* gameFont;
+    // Null font until the race scene has streamed in
+    ResourceHandle gameFont;
     
     // Configuration
     const int SCREEN_WIDTH = 1280;
@@ -114,6 +296,7 @@ private:
         bool showColliders = false;
         bool showParticles = false;
         bool showPhysicsDebug = false;
+        bool showProfiler = false;
         bool enableCheats = false;
     } debug;
 };
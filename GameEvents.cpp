@@ -0,0 +1,38 @@
+#include "GameEvents.hpp"
+#include <algorithm>
+
+GameEventBus::SubscriptionId GameEventBus::Subscribe(GameEventType type, Handler handler) {
+    SubscriptionId id = nextId++;
+    handlers[Index(type)].push_back({id, std::move(handler)});
+    return id;
+}
+
+void GameEventBus::Unsubscribe(SubscriptionId id) {
+    for (size_t type = 0; type < TYPE_COUNT; ++type) {
+        auto& list = handlers[type];
+        list.erase(std::remove_if(list.begin(), list.end(), [id](const Subscription& s) { return s.id == id; }),
+                   list.end());
+        if (list.empty()) {
+            queues[type].clear();
+        }
+    }
+}
+
+void GameEventBus::Dispatch() {
+    for (size_t type = 0; type < TYPE_COUNT; ++type) {
+        auto& queue = queues[type];
+        if (queue.empty()) {
+            continue;
+        }
+        for (const auto& subscription : handlers[type]) {
+            subscription.handler(queue.data(), queue.size());
+        }
+        queue.clear();
+    }
+}
+
+void GameEventBus::Clear() {
+    for (auto& queue : queues) {
+        queue.clear();
+    }
+}
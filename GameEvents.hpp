@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+enum class GameEventType : uint8_t {
+    LAP_COMPLETED, // value: lap time in seconds, detail: race position (0 = leading)
+    POWER_UP_USED, // detail: PowerUpType
+    COLLISION,     // value: closing speed, detail: CollisionKind
+    TOP_SPEED,     // value: the racer's new best speed this race
+    COUNT
+};
+
+enum CollisionKind : uint32_t {
+    COLLISION_BIKE,
+    COLLISION_OBSTACLE
+};
+
+struct GameEvent {
+    GameEventType type;
+    uint32_t racer; // bike index
+    uint32_t detail;
+    float value;
+};
+
+// Gameplay events for achievements, stats, sound and UI.
+//
+// The simulation publishes events as they happen during a tick; Dispatch
+// hands them out after the tick, one batch per event type, to the handlers
+// subscribed to that type. Types nobody listens to are dropped at Publish,
+// so an event costs a branch unless something wants it. Publish is not
+// thread-safe: the simulation publishes from one job at a time.
+class GameEventBus {
+public:
+    using Handler = std::function<void(const GameEvent* events, size_t count)>;
+    using SubscriptionId = uint32_t;
+
+    SubscriptionId Subscribe(GameEventType type, Handler handler);
+    void Unsubscribe(SubscriptionId id);
+    bool HasSubscribers(GameEventType type) const { return !handlers[Index(type)].empty(); }
+
+    void Publish(const GameEvent& event) {
+        size_t index = Index(event.type);
+        if (!handlers[index].empty()) {
+            queues[index].push_back(event);
+        }
+    }
+    // Delivers and clears everything published since the last call; handlers
+    // must not publish
+    void Dispatch();
+    // Drops queued events (re-simulated ticks already published theirs)
+    void Clear();
+
+private:
+    static size_t Index(GameEventType type) { return static_cast<size_t>(type); }
+
+    struct Subscription {
+        SubscriptionId id;
+        Handler handler;
+    };
+    static constexpr size_t TYPE_COUNT = static_cast<size_t>(GameEventType::COUNT);
+    std::array<std::vector<GameEvent>, TYPE_COUNT> queues;
+    std::array<std::vector<Subscription>, TYPE_COUNT> handlers;
+    SubscriptionId nextId = 1;
+};
@@ -0,0 +1,456 @@
+#include "GameState.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+uint64_t HashRecord(const std::vector<uint8_t>& record) {
+    uint64_t hash = 1469598103934665603ull; // FNV-1a
+    for (uint8_t byte : record) {
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string PlayerKey(size_t playerId, const char* record) {
+    return "player/" + std::to_string(playerId) + "/" + record;
+}
+
+// Track names come first with their length, so no name can run into the bike
+std::string BoardKey(const std::string& track, const std::string& bike) {
+    return "board/" + std::to_string(track.size()) + "/" + track + "/" + bike;
+}
+
+std::vector<AchievementDefinition> DefaultAchievements() {
+    const uint32_t BIKE_ONLY = 1u << COLLISION_BIKE;
+    const uint32_t NITRO_ONLY = 1u << 0; // PowerUpType::NITRO_BOOST
+    return {
+        {"first_lap", "Off the Line", "Complete a lap", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 1.0f},
+        {"laps_100", "Regular", "Complete 100 laps", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 100.0f},
+        {"laps_1000", "Lifer", "Complete 1000 laps", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 1000.0f},
+        {"lap_leader_10", "Front Runner", "Complete 10 laps in the lead", GameEventType::LAP_COMPLETED,
+         AchievementMeasure::COUNT, 10.0f, 1u << 0},
+        {"fast_lap", "Quick Lap", "Complete a lap in under 60 seconds", GameEventType::LAP_COMPLETED,
+         AchievementMeasure::COUNT, 1.0f, ~0u, 0.0f, 60.0f},
+        {"power_ups_50", "Collector", "Use 50 power-ups", GameEventType::POWER_UP_USED, AchievementMeasure::COUNT, 50.0f},
+        {"nitro_25", "Nitro Junkie", "Use 25 nitro boosts", GameEventType::POWER_UP_USED, AchievementMeasure::COUNT,
+         25.0f, NITRO_ONLY},
+        {"trades_paint", "Trading Paint", "Bump into other riders 100 times", GameEventType::COLLISION,
+         AchievementMeasure::COUNT, 100.0f, BIKE_ONLY},
+        {"big_hit", "Big Hit", "Hit anything at 200 or more", GameEventType::COLLISION, AchievementMeasure::MAX,
+         200.0f},
+        {"speed_300", "Flat Out", "Reach a speed of 300", GameEventType::TOP_SPEED, AchievementMeasure::MAX, 300.0f},
+        {"speed_450", "Redline", "Reach a speed of 450", GameEventType::TOP_SPEED, AchievementMeasure::MAX, 450.0f},
+    };
+}
+
+void WriteAchievements(SaveWriter& writer, const std::vector<Achievement>& achievements) {
+    writer.Varint(achievements.size());
+    for (const auto& achievement : achievements) {
+        writer.String(achievement.id);
+        writer.String(achievement.name);
+        writer.String(achievement.description);
+        writer.Bool(achievement.unlocked);
+        writer.F32(achievement.progress);
+        writer.String(achievement.unlockDate);
+    }
+}
+
+void ReadAchievements(SaveReader& reader, std::vector<Achievement>& achievements) {
+    uint64_t count = reader.Varint();
+    achievements.clear();
+    // Every entry left takes at least a byte, so a corrupt count stops early
+    for (uint64_t i = 0; i < count && reader.Plausible(count - i); ++i) {
+        Achievement achievement;
+        achievement.id = reader.String();
+        achievement.name = reader.String();
+        achievement.description = reader.String();
+        achievement.unlocked = reader.Bool();
+        achievement.progress = reader.F32();
+        achievement.unlockDate = reader.String();
+        achievements.push_back(achievement);
+    }
+}
+
+}
+
+GameState::GameState()
+    : currentState(State::MENU), playerCount(1), currentRace(0), totalRaces(0),
+      settings{false, {1280, 720}, 1.0f, 1.0f, {}, true, 2}, achievementTracker(DefaultAchievements()) {
+}
+
+bool GameState::OpenSaves() {
+    if (progressStore.IsOpen()) {
+        return true;
+    }
+    std::string error;
+    bool opened = true;
+    if (!progressStore.Open(SAVE_FILE, error)) {
+        std::cerr << "Failed to open save file: " << error << std::endl;
+        opened = false;
+    }
+    if (!settingsStore.Open(SETTINGS_FILE, error)) {
+        std::cerr << "Failed to open settings file: " << error << std::endl;
+        opened = false;
+    }
+    if (!leaderboardStore.Open(LEADERBOARD_FILE, error)) {
+        std::cerr << "Failed to open leaderboard file: " << error << std::endl;
+        opened = false;
+    }
+    LoadSettings();
+    LoadProgress();
+    return opened;
+}
+
+void GameState::ChangeState(State newState) {
+    // The end of a race is a natural point to write out what it changed
+    if (currentState == State::RACE && newState != State::PAUSE) {
+        UpdateStats();
+        SaveProgress();
+    }
+    currentState = newState;
+}
+
+GameState::~GameState() {
+    // The stores write out whatever is still queued as they close
+}
+
+void GameState::SaveProgress() {
+    unsavedAchievementChanges = 0;
+    SerializeData();
+}
+
+void GameState::LoadProgress() {
+    DeserializeData();
+}
+
+bool GameState::FlushSaves() {
+    bool progressSaved = progressStore.Flush();
+    bool settingsSaved = settingsStore.Flush();
+    bool leaderboardSaved = leaderboardStore.Flush();
+    return progressSaved && settingsSaved && leaderboardSaved;
+}
+
+void GameState::StoreRecord(SaveStore& store, const std::string& key, std::vector<uint8_t> record) {
+    uint64_t hash = HashRecord(record);
+    auto saved = savedRecordHashes.find(key);
+    if (!store.IsOpen() || (saved != savedRecordHashes.end() && saved->second == hash)) {
+        return;
+    }
+    savedRecordHashes[key] = hash;
+    store.Put(key, std::move(record));
+}
+
+bool GameState::LoadRecord(SaveStore& store, const std::string& key, std::vector<uint8_t>& record) {
+    if (!store.IsOpen() || !store.Get(key, record)) {
+        return false;
+    }
+    if (record.empty() || record[0] > RECORD_VERSION) {
+        std::cerr << "Skipping save record " << key << " with unknown version" << std::endl;
+        return false;
+    }
+    // What is on disk now; saving the same bytes again would be a no-op
+    savedRecordHashes[key] = HashRecord(record);
+    return true;
+}
+
+void GameState::SaveSettings() {
+    std::vector<uint8_t> record;
+    SaveWriter writer(record);
+    writer.U8(RECORD_VERSION);
+    writer.Bool(settings.fullscreen);
+    writer.I32(settings.resolution[0]);
+    writer.I32(settings.resolution[1]);
+    writer.F32(settings.musicVolume);
+    writer.F32(settings.sfxVolume);
+    writer.Varint(settings.controls.size());
+    for (const auto& [action, key] : settings.controls) {
+        writer.String(action);
+        writer.I32(key);
+    }
+    writer.Bool(settings.vsync);
+    writer.I32(settings.graphicsQuality);
+    StoreRecord(settingsStore, "settings", std::move(record));
+}
+
+void GameState::LoadSettings() {
+    std::vector<uint8_t> record;
+    if (!LoadRecord(settingsStore, "settings", record)) {
+        return;
+    }
+    SaveReader reader(record);
+    reader.U8();
+    GameSettings loaded = settings;
+    loaded.fullscreen = reader.Bool();
+    loaded.resolution[0] = reader.I32();
+    loaded.resolution[1] = reader.I32();
+    loaded.musicVolume = reader.F32();
+    loaded.sfxVolume = reader.F32();
+    uint64_t controlCount = reader.Varint();
+    loaded.controls.clear();
+    for (uint64_t i = 0; i < controlCount && reader.Plausible(controlCount - i); ++i) {
+        std::string action = reader.String();
+        loaded.controls[action] = reader.I32();
+    }
+    loaded.vsync = reader.Bool();
+    loaded.graphicsQuality = reader.I32();
+    if (reader.Failed()) {
+        std::cerr << "Settings record is damaged, keeping defaults" << std::endl;
+        return;
+    }
+    settings = loaded;
+}
+
+// One record per player and per kind of data, so a race that only changed
+// one player's coins rewrites that record and nothing else
+void GameState::SerializeData() {
+    std::vector<uint8_t> record;
+    SaveWriter writer(record);
+    writer.U8(RECORD_VERSION);
+    writer.I32(playerCount);
+    writer.Varint(playerStats.size());
+    for (const auto& stats : playerStats) {
+        writer.I32(stats.points);
+        writer.F32(stats.bestTime);
+        writer.I32(stats.wins);
+        writer.String(stats.name);
+    }
+    writer.Varint(playersProgress.size());
+    StoreRecord(progressStore, "players", std::move(record));
+
+    record.clear();
+    writer.U8(RECORD_VERSION);
+    writer.I32(currentRace);
+    writer.I32(totalRaces);
+    writer.Strings(trackOrder);
+    StoreRecord(progressStore, "championship", std::move(record));
+
+    for (size_t i = 0; i < playersProgress.size(); ++i) {
+        const PlayerProgress& progress = playersProgress[i];
+        record.clear();
+        writer.U8(RECORD_VERSION);
+        writer.I32(progress.level);
+        writer.I32(progress.experience);
+        writer.I32(progress.coins);
+        writer.Strings(progress.unlockedBikes);
+        writer.Strings(progress.unlockedTracks);
+        writer.Varint(progress.bikeCustomizations.size());
+        for (const auto& [bike, customization] : progress.bikeCustomizations) {
+            writer.String(bike);
+            writer.String(customization.paintJob);
+            writer.String(customization.decals);
+            writer.Strings(customization.upgrades);
+            writer.F32(customization.performance);
+        }
+        StoreRecord(progressStore, PlayerKey(i, "progress"), std::move(record));
+
+        // Never loaded means never changed; the saved copy is still current
+        if (progress.achievementsLoaded) {
+            record.clear();
+            writer.U8(RECORD_VERSION);
+            WriteAchievements(writer, progress.achievements);
+            StoreRecord(progressStore, PlayerKey(i, "achievements"), std::move(record));
+        }
+    }
+
+    // Drop the records of players that were removed
+    for (const auto& key : progressStore.GetKeys("player/")) {
+        if (std::stoul(key.substr(7)) >= playersProgress.size()) {
+            progressStore.Erase(key);
+            savedRecordHashes.erase(key);
+        }
+    }
+
+    // Boards track their own changes, so only those are encoded at all
+    globalLeaderboard.SaveDirtyBoards([this](const std::string& track, const std::string& bike,
+                                             std::vector<uint8_t> board) {
+        if (leaderboardStore.IsOpen()) {
+            leaderboardStore.Put(BoardKey(track, bike), std::move(board));
+        }
+    });
+}
+
+void GameState::DeserializeData() {
+    std::vector<uint8_t> record;
+    if (LoadRecord(progressStore, "players", record)) {
+        SaveReader reader(record);
+        reader.U8();
+        int loadedPlayerCount = reader.I32();
+        std::vector<PlayerStats> loadedStats;
+        uint64_t statsCount = reader.Varint();
+        for (uint64_t i = 0; i < statsCount && reader.Plausible(statsCount - i); ++i) {
+            PlayerStats stats;
+            stats.points = reader.I32();
+            stats.bestTime = reader.F32();
+            stats.wins = reader.I32();
+            stats.name = reader.String();
+            loadedStats.push_back(stats);
+        }
+        uint64_t progressCount = reader.Varint();
+        // Progress lives in its own records, so the count is only sanity checked
+        if (reader.Failed() || progressCount > MAX_SAVED_PLAYERS) {
+            std::cerr << "Player record is damaged, keeping defaults" << std::endl;
+        } else {
+            playerCount = loadedPlayerCount;
+            playerStats = std::move(loadedStats);
+            playersProgress.assign(progressCount, PlayerProgress());
+        }
+    }
+
+    if (LoadRecord(progressStore, "championship", record)) {
+        SaveReader reader(record);
+        reader.U8();
+        int race = reader.I32();
+        int races = reader.I32();
+        std::vector<std::string> order = reader.Strings();
+        if (!reader.Failed()) {
+            currentRace = race;
+            totalRaces = races;
+            trackOrder = std::move(order);
+        }
+    }
+
+    for (size_t i = 0; i < playersProgress.size(); ++i) {
+        PlayerProgress& progress = playersProgress[i];
+        // Achievements stay on disk until GetAchievements asks for them
+        progress.achievementsLoaded = !progressStore.Contains(PlayerKey(i, "achievements"));
+        if (!LoadRecord(progressStore, PlayerKey(i, "progress"), record)) {
+            continue;
+        }
+        SaveReader reader(record);
+        reader.U8();
+        progress.level = reader.I32();
+        progress.experience = reader.I32();
+        progress.coins = reader.I32();
+        progress.unlockedBikes = reader.Strings();
+        progress.unlockedTracks = reader.Strings();
+        uint64_t customizationCount = reader.Varint();
+        progress.bikeCustomizations.clear();
+        for (uint64_t c = 0; c < customizationCount && reader.Plausible(customizationCount - c); ++c) {
+            std::string bike = reader.String();
+            BikeCustomization& customization = progress.bikeCustomizations[bike];
+            customization.paintJob = reader.String();
+            customization.decals = reader.String();
+            customization.upgrades = reader.Strings();
+            customization.performance = reader.F32();
+        }
+        if (reader.Failed()) {
+            std::cerr << "Progress record for player " << i << " is damaged" << std::endl;
+        }
+    }
+
+    globalLeaderboard.Clear();
+    for (const auto& key : leaderboardStore.GetKeys("board/")) {
+        std::string error;
+        if (leaderboardStore.Get(key, record) && !globalLeaderboard.LoadBoard(record, error)) {
+            std::cerr << "Skipping leaderboard: " << error << std::endl;
+        }
+    }
+}
+
+void GameState::ConnectEvents(GameEventBus& bus) {
+    for (size_t type = 0; type < static_cast<size_t>(GameEventType::COUNT); ++type) {
+        GameEventType eventType = static_cast<GameEventType>(type);
+        if (achievementTracker.Tracks(eventType)) {
+            bus.Subscribe(eventType, [this](const GameEvent* events, size_t count) { OnGameEvents(events, count); });
+        }
+    }
+}
+
+void GameState::OnGameEvents(const GameEvent* events, size_t count) {
+    // A player's saved achievements are read the first time they earn progress
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t racer = events[i].racer;
+        if (racer < static_cast<uint32_t>(playerCount) && !achievementTracker.HasPlayer(racer)) {
+            RestoreAchievements(racer);
+        }
+    }
+    achievementTracker.OnEvents(events, count);
+}
+
+void GameState::RestoreAchievements(uint32_t playerId) {
+    if (playerId >= playersProgress.size()) {
+        playersProgress.resize(playerId + 1);
+    }
+    const auto& definitions = achievementTracker.GetDefinitions();
+    GetAchievements(playerId);
+    std::vector<Achievement>& saved = playersProgress[playerId].achievements;
+
+    std::vector<Achievement> ordered;
+    std::vector<float> progress;
+    std::vector<bool> unlocked;
+    for (const auto& definition : definitions) {
+        auto found = std::find_if(saved.begin(), saved.end(), [&](const Achievement& a) { return a.id == definition.id; });
+        Achievement achievement = found != saved.end() ? *found : Achievement{definition.id, "", "", false, 0.0f, ""};
+        achievement.name = definition.name;
+        achievement.description = definition.description;
+        progress.push_back(achievement.progress);
+        unlocked.push_back(achievement.unlocked);
+        ordered.push_back(achievement);
+    }
+    // Keep achievements from elsewhere (retired ones, tournaments) after the tracked ones
+    for (const auto& achievement : saved) {
+        if (achievementTracker.Find(achievement.id) == AchievementTracker::NOT_FOUND) {
+            ordered.push_back(achievement);
+        }
+    }
+    saved = std::move(ordered);
+    achievementTracker.RestorePlayer(playerId, progress, unlocked);
+}
+
+void GameState::UnlockAchievement(int playerId, const std::string& achievementId) {
+    uint32_t achievement = achievementTracker.Find(achievementId);
+    if (playerId < 0 || playerId >= playerCount || achievement == AchievementTracker::NOT_FOUND) {
+        return;
+    }
+    if (!achievementTracker.HasPlayer(playerId)) {
+        RestoreAchievements(playerId);
+    }
+    achievementTracker.Unlock(playerId, achievement);
+}
+
+void GameState::UpdateStats() {
+    if (!achievementTracker.HasChanges()) {
+        return;
+    }
+    achievementTracker.TakeChanges(achievementChanges);
+    bool unlockedAny = false;
+    for (const auto& change : achievementChanges) {
+        Achievement& achievement = playersProgress[change.player].achievements[change.achievement];
+        achievement.progress = change.progress;
+        if (change.unlocked && !achievement.unlocked) {
+            achievement.unlocked = true;
+            char date[16];
+            std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%d", std::localtime(&now));
+            achievement.unlockDate = date;
+            unlockedAny = true;
+        }
+    }
+    unsavedAchievementChanges += achievementChanges.size();
+    if (unlockedAny || unsavedAchievementChanges >= ACHIEVEMENT_SAVE_BATCH) {
+        SaveProgress();
+    }
+}
+
+void GameState::UpdateLeaderboard(const LeaderboardEntry& entry) {
+    globalLeaderboard.Submit({entry.playerName, entry.trackName, entry.bikeType, entry.time, entry.date});
+}
+
+const std::vector<Achievement>& GameState::GetAchievements(int playerId) {
+    PlayerProgress& progress = playersProgress.at(playerId);
+    if (!progress.achievementsLoaded) {
+        progress.achievementsLoaded = true;
+        std::vector<uint8_t> record;
+        if (LoadRecord(progressStore, PlayerKey(playerId, "achievements"), record)) {
+            SaveReader reader(record);
+            reader.U8();
+            ReadAchievements(reader, progress.achievements);
+            if (reader.Failed()) {
+                std::cerr << "Achievement record for player " << playerId << " is damaged" << std::endl;
+            }
+        }
+    }
+    return progress.achievements;
+}
@@ -1,6 +1,12 @@
 #pragma once
+#include <cstdint>
+#include <map>
 #include <vector>
 #include <string>
+#include "AchievementTracker.hpp"
+#include "GameEvents.hpp"
+#include "LeaderboardStore.hpp"
+#include "SaveStore.hpp"
 
 enum class State {
     MENU,
@@ -56,14 +62,30 @@ public:
     ~GameState();
 
     void ChangeState(State newState);
+    // Applies achievement progress from the events since the last call and
+    // saves in batches; call once per frame
     void UpdateStats();
+    // Opens the save files and loads settings and progress. Only the game
+    // that owns the player's profile calls this; headless games (ghosts,
+    // tools) never touch the save files.
+    bool OpenSaves();
+    // Feeds achievements from the game's events; bike i is player i. The
+    // bus must not outlive this GameState.
+    void ConnectEvents(GameEventBus& bus);
+    // Queues changed records for the save worker; never waits on the disk
     void SaveProgress();
+    // Reads everything except achievements, which load on first use
     void LoadProgress();
+    // Blocks until every queued save is on disk (on quit, before a profile switch)
+    bool FlushSaves();
     
     // Getters
     State GetCurrentState() const { return currentState; }
     int GetPlayerCount() const { return playerCount; }
     const std::vector<PlayerStats>& GetPlayerStats() const { return playerStats; }
+    const std::vector<Achievement>& GetAchievements(int playerId);
+    // Best times per track and bike, with ranks and top-K queries
+    const LeaderboardStore& GetLeaderboard() const { return globalLeaderboard; }
     
     // Setters
     void SetPlayerCount(int count) { playerCount = count; }
@@ -81,13 +103,14 @@ private:
     
     // Player progression
     struct PlayerProgress {
-        int level;
-        int experience;
-        int coins;
+        int level = 1;
+        int experience = 0;
+        int coins = 0;
         std::vector<std::string> unlockedBikes;
         std::vector<std::string> unlockedTracks;
         std::vector<Achievement> achievements;
         std::map<std::string, BikeCustomization> bikeCustomizations;
+        bool achievementsLoaded = true; // false until read from the save
     };
     std::vector<PlayerProgress> playersProgress;
 
@@ -110,7 +133,7 @@ private:
         std::string bikeType;
         std::string date;
     };
-    std::vector<LeaderboardEntry> globalLeaderboard;
+    LeaderboardStore globalLeaderboard;
 
     // Settings
     struct GameSettings {
@@ -138,4 +161,25 @@ private:
     const std::string SAVE_FILE = "game_progress.sav";
     const std::string SETTINGS_FILE = "game_settings.cfg";
     const std::string LEADERBOARD_FILE = "leaderboard.dat";
+    static constexpr uint8_t RECORD_VERSION = 1;
+    static constexpr uint64_t MAX_SAVED_PLAYERS = 256;
+
+    // Puts a record unless it matches what was last written under that key
+    void StoreRecord(SaveStore& store, const std::string& key, std::vector<uint8_t> record);
+    bool LoadRecord(SaveStore& store, const std::string& key, std::vector<uint8_t>& record);
+
+    SaveStore progressStore;
+    SaveStore settingsStore;
+    SaveStore leaderboardStore;
+    std::map<std::string, uint64_t> savedRecordHashes;
+
+    // Achievements: a player's list is put in definition order when the
+    // tracker first sees them, so tracker indices are list indices
+    void OnGameEvents(const GameEvent* events, size_t count);
+    void RestoreAchievements(uint32_t playerId);
+    AchievementTracker achievementTracker;
+    std::vector<AchievementTracker::Change> achievementChanges;
+    size_t unsavedAchievementChanges = 0;
+    // Progress is saved after this many changes, unlocks straight away
+    static constexpr size_t ACHIEVEMENT_SAVE_BATCH = 64;
 };
@@ -0,0 +1,104 @@
+#include "HeadlessRunner.hpp"
+#include "Game.hpp"
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+BatchRaceRunner::BatchRaceRunner(unsigned threadCount)
+    : threadCount(threadCount), elapsedSeconds(0.0), racesCompleted(0), totalTicks(0) {
+    if (this->threadCount == 0) {
+        this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+std::vector<RaceResult> BatchRaceRunner::Run(const std::vector<RaceConfig>& races,
+                                             const InputScript& script) {
+    std::vector<RaceResult> results(races.size());
+    std::atomic<size_t> nextRace{0};
+    auto start = std::chrono::steady_clock::now();
+
+    // Each worker pulls the next race index; races are independent Game instances
+    auto worker = [&]() {
+        for (;;) {
+            size_t index = nextRace.fetch_add(1, std::memory_order_relaxed);
+            if (index >= races.size()) {
+                return;
+            }
+            results[index] = RunRace(races[index], script);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    unsigned spawned = std::min<unsigned>(threadCount, static_cast<unsigned>(races.size()));
+    for (unsigned i = 1; i < spawned; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    racesCompleted = races.size();
+    totalTicks = 0;
+    for (const auto& result : results) {
+        totalTicks += result.ticks;
+    }
+    return results;
+}
+
+double BatchRaceRunner::GetRacesPerSecond() const {
+    return elapsedSeconds > 0.0 ? racesCompleted / elapsedSeconds : 0.0;
+}
+
+void BatchRaceRunner::FullThrottleScript(const RaceConfig& race, uint64_t tick,
+                                         size_t bikeIndex, Uint8* keystate) {
+    (void)race;
+    (void)tick;
+    // Player 1 layout for even bikes, player 2 layout for odd ones
+    keystate[bikeIndex % 2 == 0 ? SDL_SCANCODE_W : SDL_SCANCODE_UP] = 1;
+}
+
+RaceResult BatchRaceRunner::RunRace(const RaceConfig& race, const InputScript& script) {
+    Game game;
+    game.InitializeHeadless();
+    game.SetRandomSeeds(RandomSeeds::FromSeed(race.seed));
+    game.LoadTrack(race.trackFile);
+    for (size_t i = 0; i < race.bikes.size(); ++i) {
+        if (race.aiDrivers) {
+            game.AddAIRacer(race.bikes[i], "Racer " + std::to_string(i + 1), race.aiDifficulty);
+        } else {
+            game.AddBike(race.bikes[i], "Racer " + std::to_string(i + 1));
+        }
+    }
+
+    std::vector<Uint8> keystate(SDL_NUM_SCANCODES);
+    // Races run one per thread, so the thread's count is this race's count
+    uint64_t allocationsAfterWarmup = 0;
+    bool warm = false;
+    while (game.GetSimulationTick() < race.maxTicks && !game.IsRaceFinished(race.laps)) {
+        if (!warm && game.GetSimulationTick() >= race.warmupTicks) {
+            allocationsAfterWarmup = AllocationCounter::GetThreadTotal();
+            warm = true;
+        }
+        for (size_t i = 0; i < game.GetBikeCount() && !race.aiDrivers; ++i) {
+            std::fill(keystate.begin(), keystate.end(), 0);
+            script(race, game.GetSimulationTick(), i, keystate.data());
+            game.ApplyBikeInput(i, keystate.data());
+        }
+        game.Step();
+    }
+
+    RaceResult result;
+    result.steadyStateAllocations = warm ? AllocationCounter::GetThreadTotal() - allocationsAfterWarmup : 0;
+    result.seed = race.seed;
+    result.ticks = game.GetSimulationTick();
+    result.finished = game.IsRaceFinished(race.laps);
+    for (size_t i = 0; i < game.GetBikeCount(); ++i) {
+        result.lapsCompleted.push_back(game.GetBike(i).GetCurrentLap());
+        result.finalPositions.push_back(game.GetBike(i).GetPosition());
+    }
+    result.standings = game.GetRanking().GetOrder();
+    return result;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Bike.hpp"
+#include "GameState.hpp"
+
+// Description of one race to simulate without a window
+struct RaceConfig {
+    std::string trackFile;
+    std::vector<BikeType> bikes;
+    // Bikes are driven by AIRacerController instead of the input script
+    bool aiDrivers = false;
+    Difficulty aiDifficulty = Difficulty::MEDIUM;
+    int laps = 3;
+    uint64_t maxTicks = 60 * 60 * 10; // 10 minutes at 60 Hz
+    // Containers and arenas reach their working size in this many ticks
+    uint64_t warmupTicks = 120;
+    uint32_t seed = 0;
+};
+
+struct RaceResult {
+    uint32_t seed;
+    uint64_t ticks;
+    bool finished;
+    std::vector<int> lapsCompleted;
+    std::vector<Vector2D> finalPositions;
+    std::vector<uint32_t> standings; // bike indices, winner first
+    // Heap allocations after the race's warmupTicks; should be 0
+    uint64_t steadyStateAllocations = 0;
+};
+
+// Fills keystate (SDL_NUM_SCANCODES entries, already zeroed) for one bike on one tick
+using InputScript = std::function<void(const RaceConfig& race, uint64_t tick,
+                                       size_t bikeIndex, Uint8* keystate)>;
+
+// Runs many headless races in parallel on a fixed pool of worker threads
+class BatchRaceRunner {
+public:
+    explicit BatchRaceRunner(unsigned threadCount = 0);
+
+    std::vector<RaceResult> Run(const std::vector<RaceConfig>& races, const InputScript& script);
+
+    unsigned GetThreadCount() const { return threadCount; }
+    double GetElapsedSeconds() const { return elapsedSeconds; }
+    double GetRacesPerSecond() const;
+    uint64_t GetTotalTicks() const { return totalTicks; }
+
+    // Default script: full throttle, steering toward nothing in particular
+    static void FullThrottleScript(const RaceConfig& race, uint64_t tick,
+                                   size_t bikeIndex, Uint8* keystate);
+
+private:
+    static RaceResult RunRace(const RaceConfig& race, const InputScript& script);
+
+    unsigned threadCount;
+    double elapsedSeconds;
+    size_t racesCompleted;
+    uint64_t totalTicks;
+};
@@ -0,0 +1,307 @@
+#include "InputLog.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char MAGIC[4] = {'B', 'K', 'R', 'P'};
+
+void WriteVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void WriteFixed(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void WriteString(std::vector<uint8_t>& out, const std::string& text) {
+    WriteVarint(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+// Bounds-checked reader; any overrun latches the failed flag
+struct Reader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+    uint64_t Varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (offset >= size) {
+                failed = true;
+                return 0;
+            }
+            uint8_t byte = data[offset++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    uint64_t Fixed(int bytes) {
+        if (size - offset < static_cast<size_t>(bytes)) {
+            failed = true;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(data[offset++]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::string String() {
+        uint64_t length = Varint();
+        if (failed || length > size - offset) {
+            failed = true;
+            return std::string();
+        }
+        std::string text(reinterpret_cast<const char*>(data + offset), static_cast<size_t>(length));
+        offset += static_cast<size_t>(length);
+        return text;
+    }
+
+    // Guards count fields so a corrupt file cannot trigger a huge allocation
+    bool Plausible(uint64_t count) {
+        failed = failed || count > size - offset;
+        return !failed;
+    }
+};
+
+}
+
+void InputLog::Clear() {
+    trackFile.clear();
+    seeds = RandomSeeds();
+    bikes.clear();
+    changes.clear();
+    checksums.clear();
+    tickCount = 0;
+}
+
+void InputLog::Begin(const std::string& trackFile, const RandomSeeds& seeds,
+                     const std::vector<BikeEntry>& bikes) {
+    Clear();
+    this->trackFile = trackFile;
+    this->seeds = seeds;
+    this->bikes = bikes;
+    changes.resize(bikes.size());
+}
+
+void InputLog::Record(size_t bikeIndex, uint64_t tick, BikeInputMask mask) {
+    if (bikeIndex >= changes.size()) {
+        return;
+    }
+    auto& bikeChanges = changes[bikeIndex];
+    BikeInputMask previous = bikeChanges.empty() ? 0 : bikeChanges.back().mask;
+    if (mask == previous) {
+        return;
+    }
+    // Input sampled twice in one tick: the last sample wins
+    if (!bikeChanges.empty() && bikeChanges.back().tick == tick) {
+        bikeChanges.back().mask = mask;
+        BikeInputMask before = bikeChanges.size() > 1 ? bikeChanges[bikeChanges.size() - 2].mask : 0;
+        if (before == mask) {
+            bikeChanges.pop_back();
+        }
+        return;
+    }
+    bikeChanges.push_back({tick, mask});
+    tickCount = std::max(tickCount, tick + 1);
+}
+
+void InputLog::RecordChecksum(uint64_t tick, uint64_t hash) {
+    checksums.push_back({tick, hash});
+}
+
+InputLog InputLog::Truncate(uint64_t endTick) const {
+    InputLog copy;
+    copy.Begin(trackFile, seeds, bikes);
+    copy.checksumInterval = checksumInterval;
+    for (size_t b = 0; b < changes.size(); ++b) {
+        for (const auto& change : changes[b]) {
+            if (change.tick < endTick) {
+                copy.changes[b].push_back(change);
+            }
+        }
+    }
+    for (const auto& checksum : checksums) {
+        if (checksum.tick <= endTick) {
+            copy.checksums.push_back(checksum);
+        }
+    }
+    copy.tickCount = std::min(tickCount, endTick);
+    return copy;
+}
+
+void InputLog::Encode(std::vector<uint8_t>& out) const {
+    out.insert(out.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    WriteFixed(out, VERSION, 4);
+    WriteFixed(out, seeds.weather, 8);
+    WriteFixed(out, seeds.obstacles, 8);
+    WriteFixed(out, seeds.powerUps, 8);
+    WriteString(out, trackFile);
+    WriteVarint(out, bikes.size());
+    for (const auto& bike : bikes) {
+        out.push_back(static_cast<uint8_t>(bike.type));
+        WriteString(out, bike.name);
+    }
+    WriteVarint(out, tickCount);
+    WriteVarint(out, checksumInterval);
+
+    WriteVarint(out, checksums.size());
+    uint64_t previousTick = 0;
+    for (const auto& checksum : checksums) {
+        WriteVarint(out, checksum.tick - previousTick);
+        WriteFixed(out, checksum.hash, 8);
+        previousTick = checksum.tick;
+    }
+
+    // Tick deltas are small and XOR deltas touch one or two bits, so most
+    // changes fit in two bytes
+    for (const auto& bikeChanges : changes) {
+        WriteVarint(out, bikeChanges.size());
+        uint64_t lastTick = 0;
+        BikeInputMask lastMask = 0;
+        for (const auto& change : bikeChanges) {
+            WriteVarint(out, change.tick - lastTick);
+            WriteVarint(out, static_cast<BikeInputMask>(change.mask ^ lastMask));
+            lastTick = change.tick;
+            lastMask = change.mask;
+        }
+    }
+}
+
+bool InputLog::Decode(const uint8_t* data, size_t size, std::string& error) {
+    Clear();
+    if (size < sizeof(MAGIC) + 4 || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "not an input log";
+        return false;
+    }
+    Reader reader{data, size, sizeof(MAGIC)};
+    uint32_t version = static_cast<uint32_t>(reader.Fixed(4));
+    if (version != VERSION) {
+        error = "unsupported input log version " + std::to_string(version);
+        return false;
+    }
+    seeds.weather = reader.Fixed(8);
+    seeds.obstacles = reader.Fixed(8);
+    seeds.powerUps = reader.Fixed(8);
+    trackFile = reader.String();
+
+    uint64_t bikeCount = reader.Varint();
+    if (!reader.Plausible(bikeCount)) {
+        error = "truncated input log";
+        return false;
+    }
+    for (uint64_t b = 0; b < bikeCount && !reader.failed; ++b) {
+        BikeEntry bike;
+        uint64_t type = reader.Fixed(1);
+        if (type >= BIKE_TYPE_COUNT) {
+            error = "unknown bike type in input log";
+            return false;
+        }
+        bike.type = static_cast<BikeType>(type);
+        bike.name = reader.String();
+        bikes.push_back(bike);
+    }
+    tickCount = reader.Varint();
+    checksumInterval = static_cast<uint32_t>(reader.Varint());
+
+    uint64_t checksumCount = reader.Varint();
+    uint64_t tick = 0;
+    if (reader.Plausible(checksumCount)) {
+        for (uint64_t i = 0; i < checksumCount && !reader.failed; ++i) {
+            tick += reader.Varint();
+            uint64_t hash = reader.Fixed(8);
+            checksums.push_back({tick, hash});
+        }
+    }
+
+    changes.resize(bikes.size());
+    for (auto& bikeChanges : changes) {
+        uint64_t changeCount = reader.Varint();
+        if (!reader.Plausible(changeCount)) {
+            break;
+        }
+        tick = 0;
+        BikeInputMask mask = 0;
+        for (uint64_t i = 0; i < changeCount && !reader.failed; ++i) {
+            tick += reader.Varint();
+            mask ^= static_cast<BikeInputMask>(reader.Varint());
+            bikeChanges.push_back({tick, mask});
+        }
+    }
+
+    if (reader.failed) {
+        error = "truncated input log";
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool InputLog::Save(const std::string& path, std::string& error) const {
+    std::vector<uint8_t> bytes;
+    Encode(bytes);
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool InputLog::Load(const std::string& path, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return Decode(bytes.data(), bytes.size(), error);
+}
+
+InputLogPlayer::InputLogPlayer(const InputLog* log)
+    : log(log), cursors(log ? log->GetBikes().size() : 0, 0), current(cursors.size(), 0) {}
+
+BikeInputMask InputLogPlayer::GetInput(size_t bikeIndex, uint64_t tick) {
+    if (!log || bikeIndex >= cursors.size()) {
+        return 0;
+    }
+    const auto& changes = log->GetChanges(bikeIndex);
+    size_t& cursor = cursors[bikeIndex];
+    while (cursor < changes.size() && changes[cursor].tick <= tick) {
+        current[bikeIndex] = changes[cursor].mask;
+        ++cursor;
+    }
+    return current[bikeIndex];
+}
+
+bool InputLogPlayer::VerifyChecksum(uint64_t tick, uint64_t hash, uint64_t& expected) {
+    if (!log) {
+        return true;
+    }
+    const auto& checksums = log->GetChecksums();
+    while (checksumCursor < checksums.size() && checksums[checksumCursor].tick < tick) {
+        ++checksumCursor;
+    }
+    if (checksumCursor < checksums.size() && checksums[checksumCursor].tick == tick) {
+        expected = checksums[checksumCursor].hash;
+        return expected == hash;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Bike.hpp"
+#include "BikeInput.hpp"
+#include "Random.hpp"
+
+// Per-tick input of every bike in a session plus what is needed to rebuild
+// the session (track, bikes, RNG seeds), so the simulation can be re-run
+// bit-exactly. Only changes are stored: a rider holding the throttle for a
+// minute costs one entry, not 3600.
+//
+// File layout (.bkrp), little-endian, integers as LEB128 varints unless noted:
+//   "BKRP" | version u32 | seeds 3 x u64 | track file | bike count
+//   per bike: type u8, name | tick count | checksum interval
+//   checksum count, then per checksum: tick delta, hash u64
+//   per bike: change count, then per change: tick delta, mask XOR previous mask
+// Strings are a varint length followed by the bytes.
+class InputLog {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t DEFAULT_CHECKSUM_INTERVAL = 60;
+
+    struct BikeEntry {
+        BikeType type;
+        std::string name;
+    };
+
+    struct InputChange {
+        uint64_t tick;
+        BikeInputMask mask;
+    };
+
+    struct Checksum {
+        uint64_t tick;
+        uint64_t hash;
+    };
+
+    void Clear();
+    void Begin(const std::string& trackFile, const RandomSeeds& seeds, const std::vector<BikeEntry>& bikes);
+
+    // Recording: inputs are applied before the tick is simulated
+    void Record(size_t bikeIndex, uint64_t tick, BikeInputMask mask);
+    void RecordChecksum(uint64_t tick, uint64_t hash);
+    void SetTickCount(uint64_t ticks) { tickCount = ticks; }
+
+    // Copy of ticks [0, endTick), e.g. everything up to the end of a lap
+    InputLog Truncate(uint64_t endTick) const;
+
+    bool Save(const std::string& path, std::string& error) const;
+    bool Load(const std::string& path, std::string& error);
+    void Encode(std::vector<uint8_t>& out) const;
+    bool Decode(const uint8_t* data, size_t size, std::string& error);
+
+    const std::string& GetTrackFile() const { return trackFile; }
+    const RandomSeeds& GetSeeds() const { return seeds; }
+    const std::vector<BikeEntry>& GetBikes() const { return bikes; }
+    const std::vector<InputChange>& GetChanges(size_t bikeIndex) const { return changes[bikeIndex]; }
+    const std::vector<Checksum>& GetChecksums() const { return checksums; }
+    uint64_t GetTickCount() const { return tickCount; }
+    uint32_t GetChecksumInterval() const { return checksumInterval; }
+    void SetChecksumInterval(uint32_t ticks) { checksumInterval = ticks; }
+
+private:
+    std::string trackFile;
+    RandomSeeds seeds;
+    std::vector<BikeEntry> bikes;
+    std::vector<std::vector<InputChange>> changes;
+    std::vector<Checksum> checksums;
+    uint64_t tickCount = 0;
+    uint32_t checksumInterval = DEFAULT_CHECKSUM_INTERVAL;
+};
+
+// Sequential playback of an InputLog; ticks must be read in increasing order
+class InputLogPlayer {
+public:
+    InputLogPlayer() = default;
+    explicit InputLogPlayer(const InputLog* log);
+
+    BikeInputMask GetInput(size_t bikeIndex, uint64_t tick);
+    // Returns false and the expected hash when the state does not match the recording
+    bool VerifyChecksum(uint64_t tick, uint64_t hash, uint64_t& expected);
+    bool IsFinished(uint64_t tick) const { return !log || tick >= log->GetTickCount(); }
+    const InputLog* GetLog() const { return log; }
+
+private:
+    const InputLog* log = nullptr;
+    std::vector<size_t> cursors;
+    std::vector<BikeInputMask> current;
+    size_t checksumCursor = 0;
+};
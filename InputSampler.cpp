@@ -0,0 +1,47 @@
+#include "InputSampler.hpp"
+#include <chrono>
+
+uint64_t InputSampler::Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void InputSampler::Sample() {
+    InputSnapshot snapshot;
+    snapshot.timestampNs = Now();
+    int keyCount = 0;
+    const Uint8* keystate = SDL_GetKeyboardState(&keyCount);
+    for (int key = 0; key < keyCount && key < SDL_NUM_SCANCODES; ++key) {
+        if (keystate[key]) {
+            snapshot.keys.set(key);
+        }
+    }
+    snapshot.mouseButtons = SDL_GetMouseState(&snapshot.mouseX, &snapshot.mouseY);
+    Submit(snapshot);
+}
+
+void InputSampler::Submit(InputSnapshot snapshot) {
+    snapshot.sequence = nextSequence++;
+    if (snapshot.timestampNs == 0) {
+        snapshot.timestampNs = Now();
+    }
+    if (!queue.Push(snapshot)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void InputSampler::BuildFrame(InputFrame& frame) {
+    frame.pressed.reset();
+    frame.released.reset();
+    frame.snapshotCount = 0;
+    // Edges are taken between consecutive snapshots, in sequence order, so
+    // the frame depends only on the snapshots and not on when they were drained
+    InputSnapshot snapshot;
+    while (queue.Pop(snapshot)) {
+        frame.pressed |= snapshot.keys & ~lastConsumed.keys;
+        frame.released |= lastConsumed.keys & ~snapshot.keys;
+        lastConsumed = snapshot;
+        ++frame.snapshotCount;
+    }
+    frame.current = lastConsumed;
+}
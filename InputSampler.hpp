@@ -0,0 +1,65 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include "SpscQueue.hpp"
+
+// Keyboard and mouse state at one instant. Keys are a flat bitset indexed by
+// scancode, so a query is one bit test and the whole key set is 64 bytes.
+struct InputSnapshot {
+    using KeySet = std::bitset<SDL_NUM_SCANCODES>;
+
+    uint64_t timestampNs = 0; // steady clock
+    uint32_t sequence = 0;
+    uint32_t mouseButtons = 0; // SDL_BUTTON() masks
+    int mouseX = 0;
+    int mouseY = 0;
+    KeySet keys;
+
+    bool IsKeyDown(SDL_Scancode key) const { return keys.test(key); }
+};
+
+// What one simulation tick sees: the held state from the newest snapshot,
+// plus every key that went down or up in any snapshot since the last tick,
+// so a tap shorter than a tick still reaches the simulation
+struct InputFrame {
+    InputSnapshot current;
+    InputSnapshot::KeySet pressed;
+    InputSnapshot::KeySet released;
+    uint32_t snapshotCount = 0;
+
+    bool IsKeyDown(SDL_Scancode key) const { return current.keys.test(key); }
+    bool WasKeyPressed(SDL_Scancode key) const { return pressed.test(key); }
+    // Held now or tapped since the last tick
+    InputSnapshot::KeySet ActiveKeys() const { return current.keys | pressed; }
+};
+
+// Hands input snapshots from the thread that samples them to the
+// simulation through a lock-free SPSC queue. SDL only updates keyboard and
+// mouse state on the thread that pumps events, so that thread is the
+// producer; the consumer drains the queue once per fixed step.
+class InputSampler {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 64;
+
+    // Producer: snapshot of SDL's current keyboard and mouse state
+    void Sample();
+    // Producer: snapshot from another source (scripts, tools); stamps
+    // sequence, and the time when none is set
+    void Submit(InputSnapshot snapshot);
+
+    // Consumer: drains everything queued since the last call
+    void BuildFrame(InputFrame& frame);
+
+    // Snapshots lost because the consumer fell QUEUE_CAPACITY behind
+    uint64_t GetDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    static uint64_t Now();
+
+private:
+    SpscQueue<InputSnapshot, QUEUE_CAPACITY> queue;
+    uint32_t nextSequence = 0;        // producer only
+    InputSnapshot lastConsumed;       // consumer only
+    std::atomic<uint64_t> dropped{0};
+};
@@ -0,0 +1,187 @@
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+
+namespace {
+
+// Queue index of the current thread; unset threads use the owner's queue
+thread_local int currentWorker = -1;
+
+}
+
+JobSystem::JobSystem(unsigned workerCount) : queuedJobs(0), stopping(false) {
+    if (workerCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    for (unsigned i = 0; i <= workerCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned JobSystem::CurrentQueue() const {
+    return currentWorker >= 0 ? static_cast<unsigned>(currentWorker) : static_cast<unsigned>(queues.size() - 1);
+}
+
+void JobSystem::Submit(std::function<void()> work, std::atomic<int>* counter) {
+    WorkQueue& queue = *queues[CurrentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({std::move(work), counter});
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    // Taking the lock orders this against a worker about to sleep, so the wakeup is not lost
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool JobSystem::PopOwn(unsigned index, Job& job) {
+    WorkQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) {
+        return false;
+    }
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::Steal(unsigned thief, Job& job) {
+    size_t count = queues.size();
+    for (size_t offset = 1; offset < count; ++offset) {
+        WorkQueue& queue = *queues[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::TryRunJob(unsigned index) {
+    Job job;
+    if (!PopOwn(index, job) && !Steal(index, job)) {
+        return false;
+    }
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job.work();
+    if (job.counter) {
+        job.counter->fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return true;
+}
+
+void JobSystem::WorkerLoop(unsigned index) {
+    currentWorker = static_cast<int>(index);
+    for (;;) {
+        if (TryRunJob(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::Wait(const std::atomic<int>& counter) {
+    unsigned index = CurrentQueue();
+    while (counter.load(std::memory_order_acquire) > 0) {
+        if (!TryRunJob(index)) {
+            // Remaining jobs are running elsewhere
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain,
+                            const std::function<void(size_t begin, size_t end)>& work) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    if (count <= grain) {
+        work(0, count);
+        return;
+    }
+    std::atomic<int> remaining(0);
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = std::min(count, begin + grain);
+        remaining.fetch_add(1, std::memory_order_relaxed);
+        Submit([&work, begin, end] { work(begin, end); }, &remaining);
+    }
+    Wait(remaining);
+}
+
+JobGraph::NodeId JobGraph::Add(const char* name, std::function<void()> work) {
+    auto node = std::make_unique<Node>();
+    node->name = name;
+    node->work = std::move(work);
+    nodes.push_back(std::move(node));
+    return nodes.size() - 1;
+}
+
+void JobGraph::Depend(NodeId before, NodeId after) {
+    if (before >= after || after >= nodes.size()) {
+        return; // would break the serial insertion-order fallback
+    }
+    nodes[before]->dependents.push_back(after);
+    ++nodes[after]->dependencyCount;
+}
+
+void JobGraph::Launch(JobSystem& jobs, NodeId id, std::atomic<int>& remaining) {
+    jobs.Submit([this, &jobs, id, &remaining] {
+        Node& node = *nodes[id];
+        {
+            BIKE_PROFILE_ZONE(node.name);
+            node.work();
+        }
+        // The last dependency to finish launches each dependent
+        for (NodeId dependent : node.dependents) {
+            if (nodes[dependent]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Launch(jobs, dependent, remaining);
+            }
+        }
+    }, &remaining);
+}
+
+void JobGraph::Run(JobSystem* jobs) {
+    if (!jobs) {
+        for (auto& node : nodes) {
+            BIKE_PROFILE_ZONE(node->name);
+            node->work();
+        }
+        return;
+    }
+
+    // Every node is counted up front so the wait cannot finish early
+    std::atomic<int> remaining(static_cast<int>(nodes.size()));
+    for (auto& node : nodes) {
+        node->pending.store(node->dependencyCount, std::memory_order_relaxed);
+    }
+    for (NodeId id = 0; id < nodes.size(); ++id) {
+        if (nodes[id]->dependencyCount == 0) {
+            Launch(*jobs, id, remaining);
+        }
+    }
+    jobs->Wait(remaining);
+}
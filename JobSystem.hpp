@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing scheduler. Each worker owns a deque: it pushes and pops its
+// own jobs at the back (newest first, cache-warm), idle workers steal from
+// the front of other deques (oldest first, usually the biggest chunks).
+// The thread that owns the JobSystem (the game thread) has a deque too and
+// runs jobs while it waits, so it is never idle during a parallel stage.
+// Submit is safe from the owning thread and from jobs running on the
+// workers (each pushes to its own locked deque; JobGraph launches
+// dependents this way). Wait and ParallelFor are for the owning thread only.
+class JobSystem {
+public:
+    // 0 workers means one per hardware thread, minus the calling thread
+    explicit JobSystem(unsigned workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // counter is decremented once the job has run; callers wait on it
+    void Submit(std::function<void()> work, std::atomic<int>* counter);
+    // Runs queued jobs on the calling thread until counter reaches zero
+    void Wait(const std::atomic<int>& counter);
+
+    // Splits [0, count) into chunks of at least grain items and blocks until
+    // all have run. Chunk boundaries depend only on count and grain, never on
+    // timing, so per-item work stays deterministic.
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& work);
+
+    unsigned GetWorkerCount() const { return static_cast<unsigned>(threads.size()); }
+
+private:
+    struct Job {
+        std::function<void()> work;
+        std::atomic<int>* counter;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void WorkerLoop(unsigned index);
+    bool TryRunJob(unsigned index);
+    bool PopOwn(unsigned index, Job& job);
+    bool Steal(unsigned thief, Job& job);
+    unsigned CurrentQueue() const;
+
+    // One queue per worker plus the last one for the owning thread
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> queuedJobs;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+// Static dependency graph of jobs, built once and run every tick. Nodes
+// must be added in an order where each dependency comes first, so running
+// the graph without a JobSystem (headless games) is a plain loop in
+// insertion order and gives the same results as the parallel run.
+class JobGraph {
+public:
+    using NodeId = size_t;
+
+    NodeId Add(const char* name, std::function<void()> work);
+    // after runs only once before has finished; before must be added first
+    void Depend(NodeId before, NodeId after);
+    void Clear() { nodes.clear(); }
+    bool IsEmpty() const { return nodes.empty(); }
+
+    // Blocks until every node has run; jobs may be null to run serially
+    void Run(JobSystem* jobs);
+
+private:
+    struct Node {
+        const char* name;
+        std::function<void()> work;
+        std::vector<NodeId> dependents;
+        int dependencyCount = 0;
+        std::atomic<int> pending{0};
+    };
+
+    void Launch(JobSystem& jobs, NodeId id, std::atomic<int>& remaining);
+
+    std::vector<std::unique_ptr<Node>> nodes;
+};
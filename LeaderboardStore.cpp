@@ -0,0 +1,448 @@
+#include "LeaderboardStore.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "SaveStore.hpp"
+
+namespace {
+
+uint32_t FloatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float BitsToFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+// --- StringInterner ---
+
+uint32_t StringInterner::Intern(std::string_view text) {
+    auto found = ids.find(text);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.emplace_back(text);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+uint32_t StringInterner::Find(std::string_view text) const {
+    auto found = ids.find(text);
+    return found != ids.end() ? found->second : NOT_FOUND;
+}
+
+// --- LeaderboardStore ---
+
+bool LeaderboardStore::ValidTime(float time) {
+    return time > 0.0f && std::isfinite(time);
+}
+
+void LeaderboardStore::Clear() {
+    strings = StringInterner();
+    boards.clear();
+    boardIndex.clear();
+    nextSequence = 0;
+}
+
+const LeaderboardStore::Board* LeaderboardStore::FindBoard(const std::string& track, const std::string& bike) const {
+    uint32_t trackId = strings.Find(track);
+    uint32_t bikeId = strings.Find(bike);
+    if (trackId == StringInterner::NOT_FOUND || bikeId == StringInterner::NOT_FOUND) {
+        return nullptr;
+    }
+    auto found = boardIndex.find(BoardKey(trackId, bikeId));
+    return found != boardIndex.end() ? &boards[found->second] : nullptr;
+}
+
+uint32_t LeaderboardStore::FindOrAddBoard(uint32_t track, uint32_t bike) {
+    auto [found, inserted] = boardIndex.try_emplace(BoardKey(track, bike), static_cast<uint32_t>(boards.size()));
+    if (inserted) {
+        boards.emplace_back();
+        boards.back().track = track;
+        boards.back().bike = bike;
+    }
+    return found->second;
+}
+
+bool LeaderboardStore::Submit(const LeaderboardRun& run) {
+    if (!ValidTime(run.time)) {
+        return false;
+    }
+    uint32_t player = strings.Intern(run.player);
+    uint32_t date = strings.Intern(run.date);
+    Board& board = boards[FindOrAddBoard(strings.Intern(run.track), strings.Intern(run.bike))];
+    auto found = board.byPlayer.find(player);
+    if (found != board.byPlayer.end()) {
+        if (board.nodes[found->second].time <= run.time) {
+            return false;
+        }
+        Erase(board, found->second);
+    }
+    board.byPlayer[player] = Insert(board, run.time, player, date);
+    board.dirty = true;
+    return true;
+}
+
+void LeaderboardStore::Import(const std::vector<LeaderboardRun>& runs) {
+    struct Incoming {
+        uint32_t board;
+        uint32_t order;
+        Entry entry;
+    };
+    std::vector<Incoming> incoming;
+    incoming.reserve(runs.size());
+    for (const auto& run : runs) {
+        if (!ValidTime(run.time)) {
+            continue;
+        }
+        uint32_t player = strings.Intern(run.player);
+        uint32_t date = strings.Intern(run.date);
+        uint32_t board = FindOrAddBoard(strings.Intern(run.track), strings.Intern(run.bike));
+        incoming.push_back({board, static_cast<uint32_t>(incoming.size()), {player, run.time, date}});
+    }
+    std::sort(incoming.begin(), incoming.end(), [](const Incoming& a, const Incoming& b) {
+        if (a.board != b.board) {
+            return a.board < b.board;
+        }
+        return a.entry.time != b.entry.time ? a.entry.time < b.entry.time : a.order < b.order;
+    });
+
+    // Merge each board's current entries with its new runs; the first time
+    // seen for a player is their best. Current entries win ties, as they
+    // were submitted first.
+    std::vector<uint32_t> seenOnBoard(strings.GetCount(), NIL);
+    std::vector<Entry> current;
+    std::vector<Entry> merged;
+    for (size_t begin = 0; begin < incoming.size();) {
+        uint32_t boardId = incoming[begin].board;
+        size_t end = begin;
+        while (end < incoming.size() && incoming[end].board == boardId) {
+            ++end;
+        }
+        Board& board = boards[boardId];
+        InOrder(board, current);
+        merged.clear();
+        merged.reserve(current.size() + (end - begin));
+        auto keep = [&](const Entry& entry) {
+            if (seenOnBoard[entry.player] != boardId) {
+                seenOnBoard[entry.player] = boardId;
+                merged.push_back(entry);
+            }
+        };
+        size_t existing = 0;
+        for (size_t i = begin; i < end; ++i) {
+            while (existing < current.size() && current[existing].time <= incoming[i].entry.time) {
+                keep(current[existing++]);
+            }
+            keep(incoming[i].entry);
+        }
+        while (existing < current.size()) {
+            keep(current[existing++]);
+        }
+        Build(board, merged);
+        board.dirty = true;
+        begin = end;
+    }
+}
+
+uint32_t LeaderboardStore::GetRank(const Board& board, const Node& target) const {
+    uint32_t rank = 0;
+    uint32_t node = board.root;
+    while (node != NIL) {
+        const Node& current = board.nodes[node];
+        if (Before(current, target.time, target.sequence)) {
+            rank += Size(board, current.left) + 1;
+            node = current.right;
+        } else {
+            node = current.left;
+        }
+    }
+    return rank;
+}
+
+uint32_t LeaderboardStore::GetRank(const std::string& track, const std::string& bike, const std::string& player) const {
+    const Board* board = FindBoard(track, bike);
+    uint32_t playerId = strings.Find(player);
+    if (!board || playerId == StringInterner::NOT_FOUND) {
+        return NOT_RANKED;
+    }
+    auto found = board->byPlayer.find(playerId);
+    return found != board->byPlayer.end() ? GetRank(*board, board->nodes[found->second]) : NOT_RANKED;
+}
+
+bool LeaderboardStore::GetBest(const std::string& track, const std::string& bike, const std::string& player,
+                               Entry& entry) const {
+    const Board* board = FindBoard(track, bike);
+    uint32_t playerId = strings.Find(player);
+    if (!board || playerId == StringInterner::NOT_FOUND) {
+        return false;
+    }
+    auto found = board->byPlayer.find(playerId);
+    if (found == board->byPlayer.end()) {
+        return false;
+    }
+    const Node& node = board->nodes[found->second];
+    entry = {node.player, node.time, node.date};
+    return true;
+}
+
+void LeaderboardStore::GetRange(const std::string& track, const std::string& bike, size_t first, size_t count,
+                                std::vector<Entry>& out) const {
+    out.clear();
+    const Board* board = FindBoard(track, bike);
+    if (board) {
+        size_t skip = first;
+        size_t remaining = count;
+        Collect(*board, board->root, skip, remaining, out);
+    }
+}
+
+size_t LeaderboardStore::GetEntryCount(const std::string& track, const std::string& bike) const {
+    const Board* board = FindBoard(track, bike);
+    return board ? Size(*board, board->root) : 0;
+}
+
+void LeaderboardStore::Pull(Board& board, uint32_t node) {
+    Node& current = board.nodes[node];
+    current.size = Size(board, current.left) + Size(board, current.right) + 1;
+}
+
+uint32_t LeaderboardStore::Merge(Board& board, uint32_t left, uint32_t right) {
+    if (left == NIL) {
+        return right;
+    }
+    if (right == NIL) {
+        return left;
+    }
+    if (board.nodes[left].priority > board.nodes[right].priority) {
+        uint32_t child = Merge(board, board.nodes[left].right, right);
+        board.nodes[left].right = child;
+        Pull(board, left);
+        return left;
+    }
+    uint32_t child = Merge(board, left, board.nodes[right].left);
+    board.nodes[right].left = child;
+    Pull(board, right);
+    return right;
+}
+
+void LeaderboardStore::Split(Board& board, uint32_t node, float time, uint32_t sequence, uint32_t& left,
+                             uint32_t& right) {
+    if (node == NIL) {
+        left = NIL;
+        right = NIL;
+        return;
+    }
+    Node& current = board.nodes[node];
+    if (Before(current, time, sequence)) {
+        Split(board, current.right, time, sequence, current.right, right);
+        left = node;
+    } else {
+        Split(board, current.left, time, sequence, left, current.left);
+        right = node;
+    }
+    Pull(board, node);
+}
+
+uint32_t LeaderboardStore::Insert(Board& board, float time, uint32_t player, uint32_t date) {
+    uint32_t node;
+    if (!board.freeNodes.empty()) {
+        node = board.freeNodes.back();
+        board.freeNodes.pop_back();
+    } else {
+        node = static_cast<uint32_t>(board.nodes.size());
+        board.nodes.emplace_back();
+    }
+    uint32_t sequence = nextSequence++;
+    board.nodes[node] = {time, player, date, sequence, static_cast<uint32_t>(priorities.Next() >> 32), NIL, NIL, 1};
+    uint32_t left;
+    uint32_t right;
+    Split(board, board.root, time, sequence, left, right);
+    board.root = Merge(board, Merge(board, left, node), right);
+    return node;
+}
+
+void LeaderboardStore::Erase(Board& board, uint32_t node) {
+    // Sequences are unique, so (time, sequence + 1) splits just this node off
+    const Node& target = board.nodes[node];
+    float time = target.time;
+    uint32_t sequence = target.sequence;
+    uint32_t left;
+    uint32_t middle;
+    uint32_t right;
+    Split(board, board.root, time, sequence, left, right);
+    Split(board, right, time, sequence + 1, middle, right);
+    board.root = Merge(board, left, right);
+    board.freeNodes.push_back(node);
+}
+
+void LeaderboardStore::Collect(const Board& board, uint32_t node, size_t& skip, size_t& remaining,
+                               std::vector<Entry>& out) const {
+    if (node == NIL || remaining == 0) {
+        return;
+    }
+    const Node& current = board.nodes[node];
+    size_t leftSize = Size(board, current.left);
+    if (skip >= leftSize) {
+        skip -= leftSize;
+    } else {
+        Collect(board, current.left, skip, remaining, out);
+    }
+    if (remaining == 0) {
+        return;
+    }
+    if (skip > 0) {
+        --skip;
+    } else {
+        out.push_back({current.player, current.time, current.date});
+        --remaining;
+    }
+    Collect(board, current.right, skip, remaining, out);
+}
+
+void LeaderboardStore::Build(Board& board, const std::vector<Entry>& sorted) {
+    uint32_t count = static_cast<uint32_t>(sorted.size());
+    board.nodes.resize(count);
+    board.freeNodes.clear();
+    board.byPlayer.clear();
+    board.byPlayer.reserve(count);
+
+    // Cartesian tree over the sorted entries: a stack holds the right spine,
+    // and a node's subtree spans from just after the previous higher
+    // priority to just before the next one, which gives its size directly
+    std::vector<uint32_t> spine;
+    for (uint32_t i = 0; i < count; ++i) {
+        Node& node = board.nodes[i];
+        node = {sorted[i].time, sorted[i].player, sorted[i].date, nextSequence++,
+                static_cast<uint32_t>(priorities.Next() >> 32), NIL, NIL, 0};
+        uint32_t last = NIL;
+        while (!spine.empty() && board.nodes[spine.back()].priority < node.priority) {
+            last = spine.back();
+            spine.pop_back();
+            board.nodes[last].size = i - board.nodes[last].size;
+        }
+        node.left = last;
+        node.size = spine.empty() ? 0 : spine.back() + 1; // first index of the subtree, for now
+        if (!spine.empty()) {
+            board.nodes[spine.back()].right = i;
+        }
+        spine.push_back(i);
+        board.byPlayer[node.player] = i;
+    }
+    for (uint32_t node : spine) {
+        board.nodes[node].size = count - board.nodes[node].size;
+    }
+    board.root = spine.empty() ? NIL : spine.front();
+}
+
+void LeaderboardStore::InOrder(const Board& board, std::vector<Entry>& out) const {
+    out.clear();
+    out.reserve(Size(board, board.root));
+    std::vector<uint32_t> stack;
+    uint32_t node = board.root;
+    while (node != NIL || !stack.empty()) {
+        while (node != NIL) {
+            stack.push_back(node);
+            node = board.nodes[node].left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        const Node& current = board.nodes[node];
+        out.push_back({current.player, current.time, current.date});
+        node = current.right;
+    }
+}
+
+void LeaderboardStore::SaveDirtyBoards(const std::function<void(const std::string& track, const std::string& bike,
+                                                                std::vector<uint8_t> record)>& save) {
+    std::vector<Entry> entries;
+    std::unordered_map<uint32_t, uint32_t> dateSlots;
+    for (Board& board : boards) {
+        if (!board.dirty) {
+            continue;
+        }
+        board.dirty = false;
+        InOrder(board, entries);
+
+        std::vector<uint8_t> record;
+        SaveWriter writer(record);
+        writer.U8(FORMAT_VERSION);
+        writer.String(strings.Get(board.track));
+        writer.String(strings.Get(board.bike));
+        writer.Varint(entries.size());
+
+        // Runs tend to share a handful of dates
+        dateSlots.clear();
+        std::vector<uint32_t> dates;
+        for (const auto& entry : entries) {
+            if (dateSlots.try_emplace(entry.date, static_cast<uint32_t>(dates.size())).second) {
+                dates.push_back(entry.date);
+            }
+        }
+        writer.Varint(dates.size());
+        for (uint32_t date : dates) {
+            writer.String(strings.Get(date));
+        }
+
+        uint32_t previousBits = 0;
+        for (const auto& entry : entries) {
+            uint32_t bits = FloatBits(entry.time);
+            writer.Varint(bits - previousBits);
+            previousBits = bits;
+            writer.String(strings.Get(entry.player));
+            writer.Varint(dateSlots[entry.date]);
+        }
+        save(strings.Get(board.track), strings.Get(board.bike), std::move(record));
+    }
+}
+
+bool LeaderboardStore::LoadBoard(const std::vector<uint8_t>& record, std::string& error) {
+    SaveReader reader(record);
+    if (reader.U8() != FORMAT_VERSION) {
+        error = "unsupported leaderboard version";
+        return false;
+    }
+    std::string track = reader.String();
+    std::string bike = reader.String();
+    uint64_t count = reader.Varint();
+    std::vector<std::string> dateNames = reader.Strings();
+    if (!reader.Plausible(count)) {
+        error = "truncated leaderboard for " + track;
+        return false;
+    }
+
+    std::vector<uint32_t> dates;
+    for (const auto& date : dateNames) {
+        dates.push_back(strings.Intern(date));
+    }
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<size_t>(count));
+    uint32_t bits = 0;
+    for (uint64_t i = 0; i < count && !reader.Failed(); ++i) {
+        bits += static_cast<uint32_t>(reader.Varint());
+        float time = BitsToFloat(bits);
+        uint32_t player = strings.Intern(reader.String());
+        uint64_t date = reader.Varint();
+        if (date >= dates.size() || !ValidTime(time)) {
+            error = "damaged leaderboard for " + track;
+            return false;
+        }
+        entries.push_back({player, time, dates[date]});
+    }
+    if (reader.Failed()) {
+        error = "truncated leaderboard for " + track;
+        return false;
+    }
+
+    Board& board = boards[FindOrAddBoard(strings.Intern(track), strings.Intern(bike))];
+    Build(board, entries);
+    board.dirty = false;
+    return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Random.hpp"
+
+// Gives every distinct string a small stable id, so boards store players,
+// tracks, bikes and dates as integers and compare them without touching text
+class StringInterner {
+public:
+    static constexpr uint32_t NOT_FOUND = ~0u;
+
+    uint32_t Intern(std::string_view text);
+    uint32_t Find(std::string_view text) const;
+    const std::string& Get(uint32_t id) const { return names[id]; }
+    size_t GetCount() const { return names.size(); }
+
+private:
+    std::deque<std::string> names; // deque: the views in ids must not move
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// One finished run, as submitted or imported
+struct LeaderboardRun {
+    std::string player;
+    std::string track;
+    std::string bike;
+    float time;
+    std::string date;
+};
+
+// Best times per (track, bike), one entry per player.
+//
+// Each board is an order-statistic treap over (time, submission order)
+// stored in a flat node array, with a player -> node map beside it. Submit,
+// GetRank and the first entry of GetRange are O(log n); a range of k
+// entries costs O(log n + k). Imports sort the new runs once and rebuild
+// each touched board from the merged sorted run in linear time, so millions
+// of tournament results load without millions of tree insertions.
+//
+// Boards are saved as sorted runs: entries in rank order with each time
+// stored as the varint difference of its float bits to the previous one
+// (times are positive, so their bit patterns ascend too) and dates as
+// indices into a small per-board table. Loading a run rebuilds the board
+// without sorting. Only boards changed since the last save are written.
+class LeaderboardStore {
+public:
+    static constexpr uint32_t NOT_RANKED = ~0u;
+    static constexpr uint8_t FORMAT_VERSION = 1;
+
+    // Interned entry; names resolve through GetName
+    struct Entry {
+        uint32_t player;
+        float time;
+        uint32_t date;
+    };
+
+    // Keeps the run if it beats the player's best on that board; false for
+    // slower runs and for times that are not positive and finite
+    bool Submit(const LeaderboardRun& run);
+    // Same rules as Submit for every run; faster for large batches
+    void Import(const std::vector<LeaderboardRun>& runs);
+    void Clear();
+
+    // 0 for the fastest player, NOT_RANKED if the player has no time there
+    uint32_t GetRank(const std::string& track, const std::string& bike, const std::string& player) const;
+    bool GetBest(const std::string& track, const std::string& bike, const std::string& player, Entry& entry) const;
+    // Entries ranked [first, first + count), fastest first
+    void GetRange(const std::string& track, const std::string& bike, size_t first, size_t count,
+                  std::vector<Entry>& out) const;
+    void GetTop(const std::string& track, const std::string& bike, size_t count, std::vector<Entry>& out) const {
+        GetRange(track, bike, 0, count, out);
+    }
+    size_t GetEntryCount(const std::string& track, const std::string& bike) const;
+    size_t GetBoardCount() const { return boards.size(); }
+    const std::string& GetName(uint32_t id) const { return strings.Get(id); }
+
+    // Hands each board changed since the last call to save as one record;
+    // records start with FORMAT_VERSION
+    void SaveDirtyBoards(const std::function<void(const std::string& track, const std::string& bike,
+                                                  std::vector<uint8_t> record)>& save);
+    // Replaces the board stored in the record
+    bool LoadBoard(const std::vector<uint8_t>& record, std::string& error);
+
+private:
+    static constexpr uint32_t NIL = ~0u;
+
+    struct Node {
+        float time;
+        uint32_t player;
+        uint32_t date;
+        uint32_t sequence; // submission order; the earlier of equal times ranks first
+        uint32_t priority;
+        uint32_t left;
+        uint32_t right;
+        uint32_t size;
+    };
+
+    struct Board {
+        uint32_t track;
+        uint32_t bike;
+        uint32_t root = NIL;
+        std::vector<Node> nodes;
+        std::vector<uint32_t> freeNodes;
+        std::unordered_map<uint32_t, uint32_t> byPlayer;
+        bool dirty = false;
+    };
+
+    static uint64_t BoardKey(uint32_t track, uint32_t bike) { return (static_cast<uint64_t>(track) << 32) | bike; }
+    static bool Before(const Node& a, float time, uint32_t sequence) {
+        return a.time != time ? a.time < time : a.sequence < sequence;
+    }
+    static bool ValidTime(float time);
+
+    const Board* FindBoard(const std::string& track, const std::string& bike) const;
+    uint32_t FindOrAddBoard(uint32_t track, uint32_t bike);
+    uint32_t GetRank(const Board& board, const Node& node) const;
+
+    // Treap primitives over one board's node array
+    uint32_t Size(const Board& board, uint32_t node) const { return node == NIL ? 0 : board.nodes[node].size; }
+    void Pull(Board& board, uint32_t node);
+    uint32_t Merge(Board& board, uint32_t left, uint32_t right);
+    // Splits off the nodes ordered before (time, sequence) into left
+    void Split(Board& board, uint32_t node, float time, uint32_t sequence, uint32_t& left, uint32_t& right);
+    uint32_t Insert(Board& board, float time, uint32_t player, uint32_t date);
+    void Erase(Board& board, uint32_t node);
+    // In-order walk that skips whole subtrees before the range
+    void Collect(const Board& board, uint32_t node, size_t& skip, size_t& remaining, std::vector<Entry>& out) const;
+    // Rebuilds a board from entries already in rank order
+    void Build(Board& board, const std::vector<Entry>& sorted);
+    void InOrder(const Board& board, std::vector<Entry>& out) const;
+
+    StringInterner strings;
+    std::vector<Board> boards;
+    std::unordered_map<uint64_t, uint32_t> boardIndex;
+    Random priorities{0x1eadb0a2d};
+    uint32_t nextSequence = 0;
+};
@@ -0,0 +1,549 @@
+#include "NetworkManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <SDL2/SDL.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Packet layout, little-endian:
+//   u32 magic, u8 version, u8 flags, u16 echo delay (ms)
+//   u64 sender tick, u64 ack (first remote tick we are missing)
+//   u32 timestamp (ms), u32 echoed peer timestamp, i8 frame advantage
+//   u64 checksum tick, u64 checksum hash
+//   u64 first input tick, u16 count, count x u16 input masks
+const size_t HEADER_SIZE = 4 + 1 + 1 + 2 + 8 + 8 + 4 + 4 + 1 + 8 + 8 + 8 + 2;
+const uint8_t FLAG_ECHO = 1 << 0;
+const uint8_t FLAG_CHECKSUM = 1 << 1;
+
+// Advantage over the peer (ticks, halved difference of both sides' view)
+// that makes the side ahead skip a tick, and the ticks between such skips
+const float TIME_SYNC_THRESHOLD = 1.0f;
+const uint32_t TIME_SYNC_COOLDOWN = 30;
+const float SMOOTHING = 0.1f;
+
+class PacketWriter {
+public:
+    explicit PacketWriter(uint8_t* data) : data(data) {}
+    void U8(uint8_t value) { data[size++] = value; }
+    void U16(uint16_t value) { Bytes(value, 2); }
+    void U32(uint32_t value) { Bytes(value, 4); }
+    void U64(uint64_t value) { Bytes(value, 8); }
+    size_t Size() const { return size; }
+
+private:
+    void Bytes(uint64_t value, int count) {
+        for (int i = 0; i < count; ++i) {
+            data[size++] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    uint8_t* data;
+    size_t size = 0;
+};
+
+class PacketReader {
+public:
+    PacketReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+    uint8_t U8() { return static_cast<uint8_t>(Bytes(1)); }
+    uint16_t U16() { return static_cast<uint16_t>(Bytes(2)); }
+    uint32_t U32() { return static_cast<uint32_t>(Bytes(4)); }
+    uint64_t U64() { return Bytes(8); }
+    size_t Remaining() const { return size - offset; }
+
+private:
+    uint64_t Bytes(int count) {
+        uint64_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value |= static_cast<uint64_t>(data[offset++]) << (8 * i);
+        }
+        return value;
+    }
+
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+};
+
+}
+
+// --- UdpTransport ---
+
+UdpTransport::~UdpTransport() {
+    Close();
+}
+
+bool UdpTransport::Open(uint16_t localPort, const std::string& remoteHost, uint16_t port, std::string& error) {
+    Close();
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        error = "WSAStartup failed";
+        return false;
+    }
+#endif
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(remoteHost.c_str(), nullptr, &hints, &resolved) != 0 || !resolved) {
+        error = "Cannot resolve " + remoteHost;
+        return false;
+    }
+    remoteAddress = reinterpret_cast<sockaddr_in*>(resolved->ai_addr)->sin_addr.s_addr;
+    remotePort = htons(port);
+    freeaddrinfo(resolved);
+
+    auto handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    if (handle == INVALID_SOCKET) {
+#else
+    if (handle < 0) {
+#endif
+        error = "Cannot create socket";
+        return false;
+    }
+    socketHandle = static_cast<intptr_t>(handle);
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(localPort);
+    if (bind(handle, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        error = "Cannot bind port " + std::to_string(localPort);
+        Close();
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    bool ok = ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+#else
+    bool ok = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    if (!ok) {
+        error = "Cannot make socket non-blocking";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void UdpTransport::Close() {
+    if (socketHandle < 0) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(socketHandle));
+    WSACleanup();
+#else
+    close(static_cast<int>(socketHandle));
+#endif
+    socketHandle = -1;
+}
+
+bool UdpTransport::Send(const uint8_t* data, size_t size) {
+    if (socketHandle < 0) {
+        return false;
+    }
+    sockaddr_in remote{};
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = remoteAddress;
+    remote.sin_port = remotePort;
+#ifdef _WIN32
+    int sent = sendto(static_cast<SOCKET>(socketHandle), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+                      reinterpret_cast<sockaddr*>(&remote), sizeof(remote));
+#else
+    ssize_t sent = sendto(static_cast<int>(socketHandle), data, size, 0, reinterpret_cast<sockaddr*>(&remote), sizeof(remote));
+#endif
+    return sent == static_cast<decltype(sent)>(size);
+}
+
+size_t UdpTransport::Receive(uint8_t* buffer, size_t capacity) {
+    if (socketHandle < 0) {
+        return 0;
+    }
+    // Anything not from the peer is dropped
+    for (;;) {
+        sockaddr_in sender{};
+        socklen_t senderSize = sizeof(sender);
+#ifdef _WIN32
+        int received = recvfrom(static_cast<SOCKET>(socketHandle), reinterpret_cast<char*>(buffer), static_cast<int>(capacity), 0,
+                                reinterpret_cast<sockaddr*>(&sender), &senderSize);
+#else
+        ssize_t received = recvfrom(static_cast<int>(socketHandle), buffer, capacity, 0,
+                                    reinterpret_cast<sockaddr*>(&sender), &senderSize);
+#endif
+        if (received <= 0) {
+            return 0;
+        }
+        if (sender.sin_addr.s_addr == remoteAddress && sender.sin_port == remotePort) {
+            return static_cast<size_t>(received);
+        }
+    }
+}
+
+// --- LoopbackTransport ---
+
+void LoopbackTransport::Connect(LoopbackTransport& a, LoopbackTransport& b) {
+    a.peer = &b;
+    b.peer = &a;
+}
+
+bool LoopbackTransport::Send(const uint8_t* data, size_t size) {
+    if (!peer) {
+        return false;
+    }
+    peer->inbox.emplace_back(data, data + size);
+    return true;
+}
+
+size_t LoopbackTransport::Receive(uint8_t* buffer, size_t capacity) {
+    if (inbox.empty()) {
+        return 0;
+    }
+    size_t size = std::min(capacity, inbox.front().size());
+    std::memcpy(buffer, inbox.front().data(), size);
+    inbox.pop_front();
+    return size;
+}
+
+// --- LatencyTransport ---
+
+LatencyTransport::LatencyTransport(PacketTransport& inner, Clock clock, uint32_t delayMs, uint32_t jitterMs,
+                                   float lossRate, uint64_t seed)
+    : inner(inner), clock(std::move(clock)), delayMs(delayMs), jitterMs(jitterMs), lossRate(lossRate), random(seed) {
+}
+
+bool LatencyTransport::Send(const uint8_t* data, size_t size) {
+    Pump();
+    if (size > MAX_PACKET_SIZE) {
+        return false;
+    }
+    if (random.NextFloat() < lossRate) {
+        return true; // lost on the wire, which the sender cannot tell
+    }
+    Pending packet;
+    packet.deliverAt = clock() + delayMs + random.NextInt(jitterMs + 1);
+    packet.size = size;
+    std::memcpy(packet.data.data(), data, size);
+    // Keep the queue ordered by delivery time; jitter may reorder packets
+    auto position = std::upper_bound(pending.begin(), pending.end(), packet.deliverAt,
+                                     [](uint64_t time, const Pending& other) { return time < other.deliverAt; });
+    pending.insert(position, packet);
+    return true;
+}
+
+size_t LatencyTransport::Receive(uint8_t* buffer, size_t capacity) {
+    Pump();
+    return inner.Receive(buffer, capacity);
+}
+
+void LatencyTransport::Pump() {
+    uint64_t now = clock();
+    while (!pending.empty() && pending.front().deliverAt <= now) {
+        inner.Send(pending.front().data.data(), pending.front().size);
+        pending.pop_front();
+    }
+}
+
+// --- NetworkManager ---
+
+NetworkManager::NetworkManager(Game& game) : game(game) {
+}
+
+bool NetworkManager::Start(PacketTransport& sessionTransport, uint32_t player, LatencyTransport::Clock sessionClock) {
+    if (player >= PLAYER_COUNT) {
+        SDL_Log("Invalid local player %u", player);
+        return false;
+    }
+    transport = &sessionTransport;
+    clock = std::move(sessionClock);
+    localPlayer = player;
+    remotePlayer = 1 - player;
+
+    // Inputs for the first INPUT_DELAY_TICKS ticks are empty on both sides
+    currentTick = game.GetSimulationTick();
+    localQueued = currentTick + INPUT_DELAY_TICKS;
+    remoteReceived = currentTick + INPUT_DELAY_TICKS;
+    peerAck = currentTick;
+    rollbackFrom = NO_TICK;
+    localInputs.fill(0);
+    remoteInputs.fill(0);
+    predictedInputs.fill(0);
+    peerTick = 0;
+    lastPeerTimestamp = 0;
+    lastPeerTimestampAt = 0;
+    hasPeerTimestamp = false;
+    syncCooldown = 0;
+    localChecksums.fill(Checksum());
+    latestChecksum = Checksum();
+    peerChecksum = Checksum();
+    desyncTick = NO_DESYNC;
+    stats = NetworkStats();
+    return true;
+}
+
+void NetworkManager::Stop() {
+    transport = nullptr;
+}
+
+bool NetworkManager::AdvanceTick(BikeInputMask localInput) {
+    if (!transport) {
+        return false;
+    }
+    ReceivePackets();
+    if (rollbackFrom != NO_TICK) {
+        Rollback();
+    }
+    RecordChecksums();
+
+    if (syncCooldown > 0) {
+        --syncCooldown;
+    }
+    // Hard limit: no snapshot to roll back to past MAX_PREDICTION_TICKS.
+    // Soft limit: the side running ahead gives up a tick now and then, so
+    // neither peer has to do all the rolling back.
+    bool tooFarAhead = currentTick >= remoteReceived + MAX_PREDICTION_TICKS;
+    bool aheadOfPeer = syncCooldown == 0 &&
+                       (stats.frameAdvantage - peerAdvantage) * 0.5f > TIME_SYNC_THRESHOLD;
+    if (tooFarAhead || aheadOfPeer) {
+        if (aheadOfPeer) {
+            syncCooldown = TIME_SYNC_COOLDOWN;
+        }
+        ++stats.stalls;
+        SendInputs();
+        return false;
+    }
+
+    localInputs[localQueued % INPUT_RING] = localInput;
+    ++localQueued;
+    SimulateTick(currentTick);
+    ++currentTick;
+    ++stats.ticks;
+    SendInputs();
+    return true;
+}
+
+void NetworkManager::Poll() {
+    if (!transport) {
+        return;
+    }
+    ReceivePackets();
+    SendInputs();
+}
+
+bool NetworkManager::GetConfirmedChecksum(uint64_t& tick, uint64_t& hash) const {
+    if (latestChecksum.tick == NO_TICK) {
+        return false;
+    }
+    tick = latestChecksum.tick;
+    hash = latestChecksum.hash;
+    return true;
+}
+
+void NetworkManager::ReceivePackets() {
+    for (;;) {
+        size_t size = transport->Receive(packetBuffer.data(), packetBuffer.size());
+        if (size == 0) {
+            break;
+        }
+        ++stats.packetsReceived;
+        stats.bytesReceived += size;
+        HandlePacket(packetBuffer.data(), size);
+    }
+}
+
+void NetworkManager::HandlePacket(const uint8_t* data, size_t size) {
+    if (size < HEADER_SIZE) {
+        return;
+    }
+    PacketReader reader(data, size);
+    if (reader.U32() != PROTOCOL_MAGIC || reader.U8() != PROTOCOL_VERSION) {
+        return;
+    }
+    uint8_t flags = reader.U8();
+    uint16_t echoDelay = reader.U16();
+    uint64_t senderTick = reader.U64();
+    uint64_t ack = reader.U64();
+    uint32_t timestamp = reader.U32();
+    uint32_t echo = reader.U32();
+    int8_t advantage = static_cast<int8_t>(reader.U8());
+    Checksum checksum;
+    checksum.tick = reader.U64();
+    checksum.hash = reader.U64();
+    uint64_t firstTick = reader.U64();
+    uint16_t count = reader.U16();
+    if (reader.Remaining() < count * sizeof(BikeInputMask)) {
+        return;
+    }
+
+    uint32_t now = NowMs();
+    if (flags & FLAG_ECHO) {
+        // The peer held our timestamp for echoDelay before replying
+        float rtt = static_cast<float>(static_cast<int32_t>(now - echo - echoDelay));
+        if (rtt >= 0.0f) {
+            stats.rttMs = stats.rttMs == 0.0f ? rtt : stats.rttMs + (rtt - stats.rttMs) * SMOOTHING;
+        }
+    }
+    // Packets can arrive out of order; only newer ones move the peer's clock
+    if (!hasPeerTimestamp || senderTick >= peerTick) {
+        peerTick = senderTick;
+        lastPeerTimestamp = timestamp;
+        lastPeerTimestampAt = now;
+        hasPeerTimestamp = true;
+        peerAdvantage = advantage;
+        // Where the peer is by now, given the packet took half a round trip
+        float tickMs = game.GetFixedTimestep() * 1000.0f;
+        float peerNow = static_cast<float>(senderTick) + stats.rttMs * 0.5f / tickMs;
+        float localAdvantage = static_cast<float>(currentTick) - peerNow;
+        stats.frameAdvantage += (localAdvantage - stats.frameAdvantage) * SMOOTHING;
+    }
+    peerAck = std::max(peerAck, ack);
+
+    for (uint16_t i = 0; i < count; ++i) {
+        uint64_t tick = firstTick + i;
+        BikeInputMask input = reader.U16();
+        // Only the next missing tick is taken; anything after a gap comes
+        // again in the next packet, since it resends all unacknowledged input
+        if (tick != remoteReceived || tick >= currentTick + INPUT_RING / 2) {
+            continue;
+        }
+        remoteInputs[tick % INPUT_RING] = input;
+        if (tick < currentTick && input != predictedInputs[tick % INPUT_RING]) {
+            ++stats.mispredictions;
+            rollbackFrom = std::min(rollbackFrom, tick);
+        }
+        ++remoteReceived;
+    }
+
+    if ((flags & FLAG_CHECKSUM) && (peerChecksum.tick == NO_TICK || checksum.tick > peerChecksum.tick)) {
+        peerChecksum = checksum;
+        CompareChecksum(localChecksums[(checksum.tick / CHECKSUM_INTERVAL) % CHECKSUM_HISTORY], peerChecksum);
+    }
+}
+
+void NetworkManager::SendInputs() {
+    uint64_t first = std::max(peerAck, localQueued > INPUT_RING ? localQueued - INPUT_RING : 0);
+    uint16_t count = static_cast<uint16_t>(std::min<uint64_t>(localQueued - first, MAX_INPUTS_PER_PACKET));
+    uint32_t now = NowMs();
+
+    PacketWriter writer(packetBuffer.data());
+    writer.U32(PROTOCOL_MAGIC);
+    writer.U8(PROTOCOL_VERSION);
+    writer.U8((hasPeerTimestamp ? FLAG_ECHO : 0) | (latestChecksum.tick != NO_TICK ? FLAG_CHECKSUM : 0));
+    writer.U16(static_cast<uint16_t>(std::min<uint32_t>(now - lastPeerTimestampAt, 0xffff)));
+    writer.U64(currentTick);
+    writer.U64(remoteReceived);
+    writer.U32(now);
+    writer.U32(lastPeerTimestamp);
+    writer.U8(static_cast<uint8_t>(static_cast<int8_t>(std::clamp(stats.frameAdvantage, -127.0f, 127.0f))));
+    writer.U64(latestChecksum.tick);
+    writer.U64(latestChecksum.hash);
+    writer.U64(first);
+    writer.U16(count);
+    for (uint16_t i = 0; i < count; ++i) {
+        writer.U16(localInputs[(first + i) % INPUT_RING]);
+    }
+
+    if (transport->Send(packetBuffer.data(), writer.Size())) {
+        ++stats.packetsSent;
+        stats.bytesSent += writer.Size();
+    }
+}
+
+void NetworkManager::Rollback() {
+    uint64_t from = rollbackFrom;
+    rollbackFrom = NO_TICK;
+    const Game::Snapshot& snapshot = snapshots[from % SNAPSHOT_COUNT];
+    if (from >= currentTick || snapshot.tick != from) {
+        // Cannot happen while the prediction limit stays below the ring size
+        SDL_Log("No snapshot to roll back to tick %llu", static_cast<unsigned long long>(from));
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    game.LoadSnapshot(snapshot);
+    game.SetResimulating(true);
+    for (uint64_t tick = from; tick < currentTick; ++tick) {
+        SimulateTick(tick);
+    }
+    game.SetResimulating(false);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t depth = static_cast<uint32_t>(currentTick - from);
+    ++stats.rollbacks;
+    stats.resimulatedTicks += depth;
+    stats.lastRollbackDepth = depth;
+    stats.maxRollbackDepth = std::max(stats.maxRollbackDepth, depth);
+    stats.lastResimMs = ms;
+    stats.maxResimMs = std::max(stats.maxResimMs, ms);
+    stats.totalResimMs += ms;
+    if (ms > game.GetFixedTimestep() * 1000.0) {
+        ++stats.resimOverBudget;
+    }
+}
+
+void NetworkManager::SimulateTick(uint64_t tick) {
+    game.SaveSnapshot(snapshots[tick % SNAPSHOT_COUNT]);
+    BikeInputMask remote = RemoteInput(tick);
+    if (tick >= remoteReceived) {
+        predictedInputs[tick % INPUT_RING] = remote;
+    }
+    game.ApplyBikeInput(localPlayer, localInputs[tick % INPUT_RING]);
+    game.ApplyBikeInput(remotePlayer, remote);
+    game.Step();
+}
+
+BikeInputMask NetworkManager::RemoteInput(uint64_t tick) const {
+    // Riders mostly hold their controls, so the best guess for a missing
+    // tick is the last input that arrived
+    uint64_t source = std::min(tick, remoteReceived - 1);
+    return remoteInputs[source % INPUT_RING];
+}
+
+void NetworkManager::RecordChecksums() {
+    // A tick's state is final once both players' inputs before it are known
+    uint64_t next = latestChecksum.tick == NO_TICK ? CHECKSUM_INTERVAL : latestChecksum.tick + CHECKSUM_INTERVAL;
+    for (; next < currentTick && next <= remoteReceived; next += CHECKSUM_INTERVAL) {
+        const Game::Snapshot& snapshot = snapshots[next % SNAPSHOT_COUNT];
+        if (snapshot.tick != next) {
+            continue;
+        }
+        Checksum& entry = localChecksums[(next / CHECKSUM_INTERVAL) % CHECKSUM_HISTORY];
+        entry.tick = next;
+        entry.hash = snapshot.hash;
+        latestChecksum = entry;
+        CompareChecksum(entry, peerChecksum);
+    }
+}
+
+void NetworkManager::CompareChecksum(const Checksum& local, const Checksum& remote) {
+    if (local.tick == NO_TICK || local.tick != remote.tick || desyncTick != NO_DESYNC) {
+        return;
+    }
+    if (local.hash != remote.hash) {
+        desyncTick = local.tick;
+        SDL_Log("Network desync at tick %llu", static_cast<unsigned long long>(desyncTick));
+    }
+}
+
+uint32_t NetworkManager::NowMs() const {
+    if (clock) {
+        return static_cast<uint32_t>(clock());
+    }
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
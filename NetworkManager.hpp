@@ -0,0 +1,209 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include "BikeInput.hpp"
+#include "Game.hpp"
+#include "Random.hpp"
+
+// Unreliable datagrams: packets may be lost, duplicated or reordered.
+// Receive returns the packet size, or 0 when nothing is waiting.
+class PacketTransport {
+public:
+    static constexpr size_t MAX_PACKET_SIZE = 512;
+
+    virtual ~PacketTransport() = default;
+    virtual bool Send(const uint8_t* data, size_t size) = 0;
+    virtual size_t Receive(uint8_t* buffer, size_t capacity) = 0;
+};
+
+// Non-blocking UDP socket bound to a local port and talking to one peer
+class UdpTransport : public PacketTransport {
+public:
+    ~UdpTransport() override;
+
+    bool Open(uint16_t localPort, const std::string& remoteHost, uint16_t remotePort, std::string& error);
+    void Close();
+    bool IsOpen() const { return socketHandle >= 0; }
+
+    bool Send(const uint8_t* data, size_t size) override;
+    size_t Receive(uint8_t* buffer, size_t capacity) override;
+
+private:
+    // Raw handle and address so the header does not pull in socket headers
+    intptr_t socketHandle = -1;
+    uint32_t remoteAddress = 0; // network byte order
+    uint16_t remotePort = 0;    // network byte order
+};
+
+// In-process pair, for tests and tools that do not want real sockets
+class LoopbackTransport : public PacketTransport {
+public:
+    static void Connect(LoopbackTransport& a, LoopbackTransport& b);
+
+    bool Send(const uint8_t* data, size_t size) override;
+    size_t Receive(uint8_t* buffer, size_t capacity) override;
+
+private:
+    LoopbackTransport* peer = nullptr;
+    std::deque<std::vector<uint8_t>> inbox;
+};
+
+// Holds outgoing packets back to simulate a link: a one-way delay with
+// jitter, plus random loss. Time comes from the given clock, so a harness
+// can run peers on a virtual clock faster than real time.
+class LatencyTransport : public PacketTransport {
+public:
+    using Clock = std::function<uint64_t()>; // milliseconds
+
+    LatencyTransport(PacketTransport& inner, Clock clock, uint32_t delayMs, uint32_t jitterMs,
+                     float lossRate, uint64_t seed);
+
+    bool Send(const uint8_t* data, size_t size) override;
+    size_t Receive(uint8_t* buffer, size_t capacity) override;
+    // Forwards every packet whose delivery time has passed
+    void Pump();
+
+private:
+    struct Pending {
+        uint64_t deliverAt;
+        size_t size;
+        std::array<uint8_t, MAX_PACKET_SIZE> data;
+    };
+
+    PacketTransport& inner;
+    Clock clock;
+    uint32_t delayMs;
+    uint32_t jitterMs;
+    float lossRate;
+    Random random;
+    std::deque<Pending> pending;
+};
+
+struct NetworkStats {
+    uint64_t ticks = 0;             // ticks advanced (not counting re-simulation)
+    uint64_t stalls = 0;            // ticks spent waiting for the peer
+    uint64_t rollbacks = 0;
+    uint64_t mispredictions = 0;    // remote inputs that differed from the prediction
+    uint64_t resimulatedTicks = 0;
+    uint32_t lastRollbackDepth = 0;
+    uint32_t maxRollbackDepth = 0;
+    double lastResimMs = 0.0;
+    double maxResimMs = 0.0;
+    double totalResimMs = 0.0;
+    uint64_t resimOverBudget = 0;   // rollbacks that took longer than one tick
+    float rttMs = 0.0f;             // smoothed round trip
+    float frameAdvantage = 0.0f;    // smoothed; positive when we are ahead of the peer
+    uint64_t packetsSent = 0;
+    uint64_t packetsReceived = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+
+    double AverageRollbackDepth() const { return rollbacks ? static_cast<double>(resimulatedTicks) / rollbacks : 0.0; }
+    double AverageResimMs() const { return rollbacks ? totalResimMs / rollbacks : 0.0; }
+};
+
+// Peer-to-peer rollback netcode for two riders.
+//
+// Each tick the local input is sent for INPUT_DELAY_TICKS ahead, and the
+// game steps straight away using the peer's last known input as the guess
+// for any tick its input has not arrived for. Every tick's state is saved
+// to a ring of snapshots first. When the peer's real input for an already
+// simulated tick turns out different from the guess, the game restores the
+// snapshot of that tick and re-simulates up to the present with the right
+// inputs, skipping particles and other presentation work. The local tick
+// never runs more than MAX_PREDICTION_TICKS past the peer's confirmed input,
+// so a rollback is bounded by the snapshot ring and by the frame budget.
+//
+// Every packet carries all local inputs the peer has not acknowledged, so a
+// lost packet is covered by the next one. Peers exchange a state hash every
+// CHECKSUM_INTERVAL confirmed ticks to catch desyncs.
+class NetworkManager {
+public:
+    static constexpr uint32_t PLAYER_COUNT = 2;
+    static constexpr uint32_t INPUT_DELAY_TICKS = 2;
+    static constexpr uint32_t MAX_PREDICTION_TICKS = 10;
+    static constexpr uint32_t SNAPSHOT_COUNT = 16; // > MAX_PREDICTION_TICKS, power of two
+    static constexpr uint32_t INPUT_RING = 128;    // power of two
+    static constexpr uint32_t MAX_INPUTS_PER_PACKET = 64;
+    static constexpr uint32_t CHECKSUM_INTERVAL = 30;
+    static constexpr uint64_t NO_DESYNC = Game::NO_DESYNC;
+
+    explicit NetworkManager(Game& game);
+
+    // The clock (milliseconds) timestamps packets for the RTT estimate;
+    // without one the steady clock is used
+    bool Start(PacketTransport& transport, uint32_t localPlayer, LatencyTransport::Clock clock = nullptr);
+    void Stop();
+    bool IsActive() const { return transport != nullptr; }
+
+    // One fixed step: reads packets, rolls back if a guess was wrong, then
+    // simulates the next tick. Returns false when it stalled instead.
+    bool AdvanceTick(BikeInputMask localInput);
+    // Sends without advancing, e.g. while a stalled frame waits
+    void Poll();
+
+    uint64_t GetCurrentTick() const { return currentTick; }
+    // Ticks whose inputs from both players are known
+    uint64_t GetConfirmedTick() const { return remoteReceived; }
+    // Newest state hash both players' inputs are final for; false before the first
+    bool GetConfirmedChecksum(uint64_t& tick, uint64_t& hash) const;
+    uint64_t GetDesyncTick() const { return desyncTick; }
+    const NetworkStats& GetStats() const { return stats; }
+
+private:
+    static constexpr uint32_t PROTOCOL_MAGIC = 0x424b4e54; // "BKNT"
+    static constexpr uint8_t PROTOCOL_VERSION = 1;
+    static constexpr uint32_t CHECKSUM_HISTORY = 8;
+    static constexpr uint64_t NO_TICK = ~0ull;
+
+    struct Checksum {
+        uint64_t tick = NO_TICK;
+        uint64_t hash = 0;
+    };
+
+    void ReceivePackets();
+    void HandlePacket(const uint8_t* data, size_t size);
+    void SendInputs();
+    void Rollback();
+    void SimulateTick(uint64_t tick);
+    void RecordChecksums();
+    void CompareChecksum(const Checksum& local, const Checksum& remote);
+    BikeInputMask RemoteInput(uint64_t tick) const;
+    uint32_t NowMs() const;
+
+    Game& game;
+    PacketTransport* transport = nullptr;
+    LatencyTransport::Clock clock;
+    uint32_t localPlayer = 0;
+    uint32_t remotePlayer = 1;
+
+    uint64_t currentTick = 0;
+    uint64_t localQueued = 0;   // local inputs are known for ticks below this
+    uint64_t remoteReceived = 0; // remote inputs are known for ticks below this
+    uint64_t peerAck = 0;       // the peer has our inputs for ticks below this
+    uint64_t rollbackFrom = NO_TICK;
+    std::array<BikeInputMask, INPUT_RING> localInputs{};
+    std::array<BikeInputMask, INPUT_RING> remoteInputs{};
+    std::array<BikeInputMask, INPUT_RING> predictedInputs{};
+    std::array<Game::Snapshot, SNAPSHOT_COUNT> snapshots;
+
+    uint64_t peerTick = 0;
+    uint32_t lastPeerTimestamp = 0;   // echoed back for the RTT estimate
+    uint32_t lastPeerTimestampAt = 0; // our clock when it arrived
+    bool hasPeerTimestamp = false;
+    float peerAdvantage = 0.0f;
+    uint32_t syncCooldown = 0;
+
+    std::array<Checksum, CHECKSUM_HISTORY> localChecksums;
+    Checksum latestChecksum;
+    Checksum peerChecksum;
+    uint64_t desyncTick = NO_DESYNC;
+
+    NetworkStats stats;
+    std::array<uint8_t, PacketTransport::MAX_PACKET_SIZE> packetBuffer{};
+};
@@ -0,0 +1,157 @@
+#include "ParticleSystem.hpp"
+#include "Profiler.hpp"
+#include "VectorBatch.hpp"
+#include <algorithm>
+
+ParticleSystem::ParticleSystem(size_t capacity)
+    : capacity(std::max<size_t>(capacity, 1)), liveCount(0), overwriteCursor(0), randomState(0x9E3779B9u) {
+    positionX.resize(this->capacity);
+    positionY.resize(this->capacity);
+    velocityX.resize(this->capacity);
+    velocityY.resize(this->capacity);
+    age.resize(this->capacity);
+    lifetime.resize(this->capacity);
+    drag.resize(this->capacity);
+    gravity.resize(this->capacity);
+    size.resize(this->capacity);
+    emitterOf.resize(this->capacity);
+
+    // Must match the ids in ParticleEmitters
+    RegisterEmitter({"dust", {170, 150, 120, 200}, {170, 150, 120, 0}, 0.8f, 0.3f, 40.0f, 20.0f, 0.6f, 6.0f, 1.5f, -10.0f});
+    RegisterEmitter({"mud", {90, 60, 30, 255}, {70, 45, 20, 0}, 0.6f, 0.2f, 90.0f, 30.0f, 0.4f, 5.0f, 0.5f, 300.0f});
+    RegisterEmitter({"sparks", {255, 230, 120, 255}, {255, 80, 0, 0}, 0.35f, 0.15f, 220.0f, 80.0f, 1.2f, 2.5f, 2.0f, 150.0f});
+    RegisterEmitter({"nitro", {120, 200, 255, 255}, {40, 60, 255, 0}, 0.4f, 0.1f, 160.0f, 40.0f, 0.15f, 8.0f, 3.0f, 0.0f});
+}
+
+ParticleEmitterId ParticleSystem::RegisterEmitter(const ParticleEmitterDesc& desc) {
+    emitters.push_back(desc);
+    return static_cast<ParticleEmitterId>(emitters.size() - 1);
+}
+
+bool ParticleSystem::FindEmitter(const std::string& name, ParticleEmitterId& id) const {
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        if (emitters[i].name == name) {
+            id = static_cast<ParticleEmitterId>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+float ParticleSystem::NextRandom() {
+    // xorshift32: cheap, and particles are cosmetic so quality barely matters
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (randomState >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+void ParticleSystem::Emit(ParticleEmitterId emitter, const Vector2D& position, float direction, int count,
+                          const Vector2D& inheritVelocity) {
+    if (emitter >= emitters.size()) {
+        return;
+    }
+    const ParticleEmitterDesc& desc = emitters[emitter];
+    for (int n = 0; n < count; ++n) {
+        size_t i;
+        if (liveCount < capacity) {
+            i = liveCount++;
+        } else {
+            i = overwriteCursor;
+            overwriteCursor = (overwriteCursor + 1) % capacity;
+        }
+
+        float angle = direction + desc.spread * NextRandom();
+        float speed = desc.speed + desc.speedJitter * NextRandom();
+        float s, c;
+        Vector2D::SinCos(angle, s, c);
+        positionX[i] = position.x;
+        positionY[i] = position.y;
+        velocityX[i] = c * speed + inheritVelocity.x;
+        velocityY[i] = s * speed + inheritVelocity.y;
+        age[i] = 0.0f;
+        lifetime[i] = std::max(0.01f, desc.lifetime + desc.lifetimeJitter * NextRandom());
+        drag[i] = desc.drag;
+        gravity[i] = desc.gravity;
+        size[i] = desc.size;
+        emitterOf[i] = emitter;
+    }
+}
+
+void ParticleSystem::Update(float deltaTime) {
+    BIKE_PROFILE_ZONE("ParticleSystem::Update");
+    if (liveCount == 0) {
+        return;
+    }
+    VectorBatch::Integrate(positionX.data(), positionY.data(), velocityX.data(), velocityY.data(),
+                           liveCount, deltaTime);
+
+    // Plain loops over contiguous floats; the compiler vectorizes these
+    float* vx = velocityX.data();
+    float* vy = velocityY.data();
+    float* ages = age.data();
+    const float* drags = drag.data();
+    const float* gravities = gravity.data();
+    for (size_t i = 0; i < liveCount; ++i) {
+        float damping = std::max(0.0f, 1.0f - drags[i] * deltaTime);
+        vx[i] = vx[i] * damping;
+        vy[i] = vy[i] * damping + gravities[i] * deltaTime;
+        ages[i] = ages[i] + deltaTime;
+    }
+
+    // Swap-remove expired particles so the live range stays packed whatever
+    // order lifetimes run out in
+    for (size_t i = 0; i < liveCount;) {
+        if (age[i] >= lifetime[i]) {
+            MoveParticle(--liveCount, i);
+        } else {
+            ++i;
+        }
+    }
+    overwriteCursor = overwriteCursor < liveCount ? overwriteCursor : 0;
+}
+
+void ParticleSystem::MoveParticle(size_t from, size_t to) {
+    positionX[to] = positionX[from];
+    positionY[to] = positionY[from];
+    velocityX[to] = velocityX[from];
+    velocityY[to] = velocityY[from];
+    age[to] = age[from];
+    lifetime[to] = lifetime[from];
+    drag[to] = drag[from];
+    gravity[to] = gravity[from];
+    size[to] = size[from];
+    emitterOf[to] = emitterOf[from];
+}
+
+void ParticleSystem::Render(RenderQueue& queue, SDL_Texture* texture) {
+    if (liveCount == 0) {
+        return;
+    }
+    // Quads are written straight into the queue's vertex buffer
+    SDL_Vertex* quad = queue.BeginQuads(texture, RenderLayer::PARTICLES, static_cast<int>(liveCount));
+    for (size_t i = 0; i < liveCount; ++i) {
+        const ParticleEmitterDesc& desc = emitters[emitterOf[i]];
+        float t = age[i] / lifetime[i];
+        SDL_Color color = {
+            static_cast<Uint8>(desc.startColor.r + (desc.endColor.r - desc.startColor.r) * t),
+            static_cast<Uint8>(desc.startColor.g + (desc.endColor.g - desc.startColor.g) * t),
+            static_cast<Uint8>(desc.startColor.b + (desc.endColor.b - desc.startColor.b) * t),
+            static_cast<Uint8>(desc.startColor.a + (desc.endColor.a - desc.startColor.a) * t)
+        };
+        float half = size[i] * 0.5f;
+        float x = positionX[i];
+        float y = positionY[i];
+        quad[0] = {{x - half, y - half}, color, {0.0f, 0.0f}};
+        quad[1] = {{x + half, y - half}, color, {1.0f, 0.0f}};
+        quad[2] = {{x + half, y + half}, color, {1.0f, 1.0f}};
+        quad[3] = {{x - half, y + half}, color, {0.0f, 1.0f}};
+        quad += 4;
+    }
+    queue.EndQuads(static_cast<int>(liveCount));
+}
+
+void ParticleSystem::Clear() {
+    liveCount = 0;
+    overwriteCursor = 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BikeStateStore.hpp"
+#include "RenderQueue.hpp"
+#include "Vector2D.hpp"
+
+// Emitters are interned once at load time; emitting only passes this id
+using ParticleEmitterId = uint16_t;
+
+// Built-in emitters, registered by the ParticleSystem constructor in this order
+struct ParticleEmitters {
+    static constexpr ParticleEmitterId DUST = 0;
+    static constexpr ParticleEmitterId MUD = 1;
+    static constexpr ParticleEmitterId SPARKS = 2;
+    static constexpr ParticleEmitterId NITRO = 3;
+};
+
+struct ParticleEmitterDesc {
+    std::string name;
+    SDL_Color startColor;
+    SDL_Color endColor;
+    float lifetime;
+    float lifetimeJitter;
+    float speed;
+    float speedJitter;
+    float spread;   // cone half-angle in radians
+    float size;
+    float drag;     // fraction of velocity lost per second
+    float gravity;
+};
+
+// Preallocated structure-of-arrays particle pool. Live particles are packed
+// at the front of fixed-capacity arrays: new ones are appended, and expired
+// ones are replaced by the last live particle, so capacity is never held by
+// dead particles and emitting never allocates. When the pool is full, new
+// particles overwrite slots in turn. Updates are bulk passes over the live
+// range, and rendering writes every particle into the render queue as a
+// single batch.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity = 131072);
+
+    ParticleEmitterId RegisterEmitter(const ParticleEmitterDesc& desc);
+    // Looks up an emitter by name; meant for load time, not the emit path
+    bool FindEmitter(const std::string& name, ParticleEmitterId& id) const;
+
+    void Emit(ParticleEmitterId emitter, const Vector2D& position, float direction, int count,
+              const Vector2D& inheritVelocity = Vector2D());
+    void Update(float deltaTime);
+    void Render(RenderQueue& queue, SDL_Texture* texture = nullptr);
+    void Clear();
+
+    size_t GetLiveCount() const { return liveCount; }
+    size_t GetCapacity() const { return capacity; }
+
+private:
+    float NextRandom(); // uniform in [-1, 1]
+    // Copies particle from into slot to
+    void MoveParticle(size_t from, size_t to);
+
+    size_t capacity;
+    size_t liveCount;       // particles in [0, liveCount)
+    size_t overwriteCursor; // next slot replaced while the pool is full
+    uint32_t randomState;
+
+    AlignedVector<float> positionX;
+    AlignedVector<float> positionY;
+    AlignedVector<float> velocityX;
+    AlignedVector<float> velocityY;
+    AlignedVector<float> age;
+    AlignedVector<float> lifetime;
+    AlignedVector<float> drag;
+    AlignedVector<float> gravity;
+    AlignedVector<float> size;
+    std::vector<ParticleEmitterId> emitterOf;
+
+    std::vector<ParticleEmitterDesc> emitters;
+};
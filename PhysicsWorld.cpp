@@ -0,0 +1,219 @@
+#include "PhysicsWorld.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cfloat>
+
+bool OrientedBox::Overlaps(const OrientedBox& other, Vector2D* normal, float* depth) const {
+    const Vector2D axes[4] = {axisX, axisY, other.axisX, other.axisY};
+    Vector2D offset = other.center - center;
+    float bestDepth = FLT_MAX;
+    Vector2D bestAxis;
+    for (const Vector2D& axis : axes) {
+        float radiusA = halfX * std::fabs(axisX.Dot(axis)) + halfY * std::fabs(axisY.Dot(axis));
+        float radiusB = other.halfX * std::fabs(other.axisX.Dot(axis)) + other.halfY * std::fabs(other.axisY.Dot(axis));
+        float distance = offset.Dot(axis);
+        float overlap = radiusA + radiusB - std::fabs(distance);
+        if (overlap <= 0.0f) {
+            return false;
+        }
+        if (overlap < bestDepth) {
+            bestDepth = overlap;
+            bestAxis = distance < 0.0f ? axis * -1.0f : axis;
+        }
+    }
+    if (normal) {
+        *normal = bestAxis;
+    }
+    if (depth) {
+        *depth = bestDepth;
+    }
+    return true;
+}
+
+void PhysicsWorld::SetProgressAxis(ProgressFunction progress, float lapLength) {
+    progressAxis = std::move(progress);
+    this->lapLength = lapLength;
+}
+
+PhysicsWorld::BodyId PhysicsWorld::AddBody(BodyType type, uint32_t owner) {
+    Body body;
+    body.type = type;
+    body.owner = owner;
+    bodies.push_back(body);
+    BodyId id = static_cast<BodyId>(bodies.size() - 1);
+    // New bodies start at the end; the next Step sorts them into place
+    order.push_back(id);
+    return id;
+}
+
+void PhysicsWorld::Clear() {
+    bodies.clear();
+    order.clear();
+    stats = Stats();
+}
+
+bool PhysicsWorld::Sweep(const Vector2D& from, const Vector2D& to, float radius, SweepHit& hit) {
+    if (!staticGeometry) {
+        return false;
+    }
+    ++pendingSweeps;
+    sweepCandidates.clear();
+    staticGeometry->QueryObstacles(std::min(from.x, to.x) - radius, std::min(from.y, to.y) - radius,
+                                   std::max(from.x, to.x) + radius, std::max(from.y, to.y) + radius,
+                                   sweepCandidates);
+    const auto& obstacles = staticGeometry->GetObstacles();
+    Vector2D motion = to - from;
+    hit.time = 1.0f;
+    hit.obstacle = -1;
+
+    // Slab test of the disc centre against each box grown by the radius. The
+    // grown box has square corners where the true shape is rounded, so a hit
+    // near a corner can come slightly early; that never lets a bike through.
+    for (uint32_t index : sweepCandidates) {
+        const SDL_Rect& rect = obstacles[index];
+        float minBound[2] = {rect.x - radius, rect.y - radius};
+        float maxBound[2] = {rect.x + rect.w + radius, rect.y + rect.h + radius};
+        float start[2] = {from.x, from.y};
+        float delta[2] = {motion.x, motion.y};
+        float enter = -FLT_MAX;
+        float exit = FLT_MAX;
+        int enterAxis = -1;
+        bool missed = false;
+        for (int axis = 0; axis < 2 && !missed; ++axis) {
+            if (delta[axis] == 0.0f) {
+                missed = start[axis] < minBound[axis] || start[axis] > maxBound[axis];
+                continue;
+            }
+            float inverse = 1.0f / delta[axis];
+            float nearTime = (minBound[axis] - start[axis]) * inverse;
+            float farTime = (maxBound[axis] - start[axis]) * inverse;
+            if (nearTime > farTime) {
+                std::swap(nearTime, farTime);
+            }
+            if (nearTime > enter) {
+                enter = nearTime;
+                enterAxis = axis;
+            }
+            exit = std::min(exit, farTime);
+            missed = enter > exit;
+        }
+        if (missed || enterAxis < 0 || enter < 0.0f || enter >= hit.time) {
+            continue;
+        }
+        hit.time = enter;
+        hit.obstacle = static_cast<int>(index);
+        hit.normal = enterAxis == 0 ? Vector2D(delta[0] > 0.0f ? -1.0f : 1.0f, 0.0f)
+                                    : Vector2D(0.0f, delta[1] > 0.0f ? -1.0f : 1.0f);
+    }
+    if (hit.obstacle < 0) {
+        return false;
+    }
+    ++pendingSweepHits;
+    return true;
+}
+
+void PhysicsWorld::Step(std::pmr::vector<Contact>& contacts) {
+    BIKE_PROFILE_ZONE("PhysicsWorld::Step");
+    contacts.clear();
+    stats = Stats();
+    // Sweeps run before Step each tick and are reported with it
+    stats.sweeps = pendingSweeps;
+    stats.sweepHits = pendingSweepHits;
+    pendingSweeps = 0;
+    pendingSweepHits = 0;
+
+    size_t enabledCount = 0;
+    for (auto& body : bodies) {
+        if (!body.enabled) {
+            // Sorts to the end, where the sweep stops before reaching it
+            body.minProgress = FLT_MAX;
+            body.maxProgress = FLT_MAX;
+            continue;
+        }
+        ++enabledCount;
+        float center = progressAxis ? progressAxis(body.box.center) : body.box.center.x;
+        if (lapLength > 0.0f) {
+            center = std::fmod(center, lapLength);
+            if (center < 0.0f) {
+                center += lapLength;
+            }
+        }
+        float extent = body.box.BoundingRadius() * intervalSlack;
+        body.minProgress = center - extent;
+        body.maxProgress = center + extent;
+    }
+    stats.bodies = enabledCount;
+    stats.possiblePairs = static_cast<uint64_t>(enabledCount) * (enabledCount > 0 ? enabledCount - 1 : 0) / 2;
+
+    // Insertion sort: the order from the last step is almost right already
+    for (size_t i = 1; i < order.size(); ++i) {
+        BodyId id = order[i];
+        float key = bodies[id].minProgress;
+        size_t j = i;
+        while (j > 0 && bodies[order[j - 1]].minProgress > key) {
+            order[j] = order[j - 1];
+            --j;
+            ++stats.sortSwaps;
+        }
+        order[j] = id;
+    }
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Body& body = bodies[order[i]];
+        if (!body.enabled) {
+            break;
+        }
+        for (size_t k = i + 1; k < order.size() && bodies[order[k]].minProgress <= body.maxProgress; ++k) {
+            TestPair(order[i], order[k], contacts);
+        }
+    }
+
+    // Bodies near the finish line also overlap bodies just past the start
+    if (lapLength > 0.0f && !order.empty()) {
+        float firstMin = bodies[order.front()].minProgress;
+        for (size_t i = 0; i < order.size(); ++i) {
+            const Body& late = bodies[order[i]];
+            if (!late.enabled) {
+                break;
+            }
+            float wrappedMax = late.maxProgress - lapLength;
+            if (wrappedMax < firstMin) {
+                continue;
+            }
+            for (size_t k = 0; k < order.size() && bodies[order[k]].minProgress <= wrappedMax; ++k) {
+                const Body& early = bodies[order[k]];
+                bool sweptAlready = early.minProgress <= late.maxProgress && late.minProgress <= early.maxProgress;
+                if (k != i && !sweptAlready && late.minProgress - lapLength <= early.maxProgress) {
+                    TestPair(order[i], order[k], contacts);
+                }
+            }
+        }
+    }
+
+    std::sort(contacts.begin(), contacts.end(), [](const Contact& x, const Contact& y) {
+        return x.a != y.a ? x.a < y.a : x.b < y.b;
+    });
+    // On very short laps a pair can be found from both ends of the wrap
+    contacts.erase(std::unique(contacts.begin(), contacts.end(), [](const Contact& x, const Contact& y) {
+        return x.a == y.a && x.b == y.b;
+    }), contacts.end());
+    stats.contacts = contacts.size();
+}
+
+void PhysicsWorld::TestPair(BodyId a, BodyId b, std::pmr::vector<Contact>& contacts) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    const Body& first = bodies[a];
+    const Body& second = bodies[b];
+    if (first.type == BodyType::POWER_UP && second.type == BodyType::POWER_UP) {
+        return;
+    }
+    ++stats.candidatePairs;
+    Contact contact;
+    if (first.box.Overlaps(second.box, &contact.normal, &contact.depth)) {
+        contact.a = a;
+        contact.b = b;
+        contacts.push_back(contact);
+    }
+}
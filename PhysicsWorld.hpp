@@ -0,0 +1,132 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <vector>
+#include "Vector2D.hpp"
+#include "TrackSpatialIndex.hpp"
+
+// Box with arbitrary rotation: centre, unit axes and half extents along them
+struct OrientedBox {
+    Vector2D center;
+    Vector2D axisX;
+    Vector2D axisY;
+    float halfX = 0.0f;
+    float halfY = 0.0f;
+
+    static OrientedBox FromRotation(const Vector2D& center, float halfX, float halfY, float rotation) {
+        OrientedBox box;
+        box.center = center;
+        box.axisX = Vector2D::FromAngle(rotation);
+        box.axisY = Vector2D(-box.axisX.y, box.axisX.x);
+        box.halfX = halfX;
+        box.halfY = halfY;
+        return box;
+    }
+
+    // Radius of the circle that encloses the box
+    float BoundingRadius() const { return std::sqrt(halfX * halfX + halfY * halfY); }
+
+    // Separating axis test over the four face normals. On overlap, normal
+    // points from this box towards other and depth is the penetration.
+    bool Overlaps(const OrientedBox& other, Vector2D* normal = nullptr, float* depth = nullptr) const;
+};
+
+// Broad and narrow phase for everything that moves: bikes and power-ups.
+//
+// Broad phase is sweep-and-prune along the track's progress axis (distance
+// along the centerline). Racers are spread out along the lap, not across it,
+// so intervals on that axis overlap only for bikes that are actually near
+// each other. The body order is kept between steps and re-sorted with an
+// insertion sort; bikes rarely overtake in a single tick, so that is close
+// to linear. Candidate pairs then get an oriented box test.
+//
+// Static track geometry is handled by Sweep: a disc is swept along the
+// whole step and stopped at the first obstacle it would touch, so a bike on
+// nitro cannot pass through a thin barrier between two fixed steps.
+class PhysicsWorld {
+public:
+    using BodyId = uint32_t;
+    using ProgressFunction = std::function<float(const Vector2D&)>;
+
+    enum class BodyType : uint8_t {
+        BIKE,
+        POWER_UP
+    };
+
+    struct Contact {
+        BodyId a;
+        BodyId b;
+        Vector2D normal; // from a towards b
+        float depth;
+    };
+
+    struct SweepHit {
+        float time;      // fraction of the motion before contact, in [0, 1]
+        Vector2D normal; // surface normal, facing the mover
+        int obstacle;    // index into the spatial index's obstacles
+    };
+
+    struct Stats {
+        size_t bodies = 0;
+        uint64_t possiblePairs = 0;  // n(n-1)/2 over enabled bodies
+        uint64_t candidatePairs = 0; // pairs that reached the narrow phase
+        uint64_t contacts = 0;
+        uint64_t sortSwaps = 0;      // insertion sort work this step
+        uint64_t sweeps = 0;
+        uint64_t sweepHits = 0;
+        uint64_t SkippedPairs() const { return possiblePairs - candidatePairs; }
+    };
+
+    // Progress axis mapping and lap length; a lap length of 0 means the axis
+    // does not wrap. Without an axis, world x is used.
+    void SetProgressAxis(ProgressFunction progress, float lapLength);
+    // Distance along the centerline maps tighter than world distance on the
+    // inside of bends, so intervals are widened by this factor (>= 1)
+    void SetIntervalSlack(float slack) { intervalSlack = slack; }
+
+    BodyId AddBody(BodyType type, uint32_t owner);
+    void SetEnabled(BodyId id, bool enabled) { bodies[id].enabled = enabled; }
+    void SetBox(BodyId id, const OrientedBox& box) { bodies[id].box = box; }
+    void Clear();
+
+    // Obstacles to sweep against; the index must outlive the world or be reset
+    void SetStaticGeometry(const TrackSpatialIndex* index) { staticGeometry = index; }
+    // Earliest contact of a disc moving from -> to with any obstacle.
+    // Obstacles the disc already overlaps at `from` are ignored so a bike
+    // can always drive out of one. Uses shared scratch: call from one thread.
+    bool Sweep(const Vector2D& from, const Vector2D& to, float radius, SweepHit& hit);
+
+    // Updates intervals, re-sorts and writes every touching pair to contacts,
+    // sorted by (a, b). Power-ups never collide with each other.
+    void Step(std::pmr::vector<Contact>& contacts);
+
+    BodyType GetType(BodyId id) const { return bodies[id].type; }
+    uint32_t GetOwner(BodyId id) const { return bodies[id].owner; }
+    size_t GetBodyCount() const { return bodies.size(); }
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Body {
+        OrientedBox box;
+        float minProgress = 0.0f;
+        float maxProgress = 0.0f;
+        BodyType type;
+        uint32_t owner;
+        bool enabled = true;
+    };
+
+    void TestPair(BodyId a, BodyId b, std::pmr::vector<Contact>& contacts);
+
+    const TrackSpatialIndex* staticGeometry = nullptr;
+    std::vector<uint32_t> sweepCandidates;
+    uint64_t pendingSweeps = 0;
+    uint64_t pendingSweepHits = 0;
+    std::vector<Body> bodies;
+    std::vector<BodyId> order; // sorted by minProgress, persists between steps
+    ProgressFunction progressAxis;
+    float lapLength = 0.0f;
+    float intervalSlack = 2.0f;
+    Stats stats;
+};
@@ -0,0 +1,64 @@
+#include "PowerUp.hpp"
+#include "Bike.hpp"
+#include "VectorBatch.hpp"
+
+PowerUp::PowerUp(PowerUpType type, const Vector2D& position)
+    : type(type), position(position), previousPosition(position), collected(false), effectActive(false),
+      remainingDuration(0.0f), rotationAngle(0.0f), bobHeight(6.0f), bobSpeed(3.0f), baseY(position.y) {}
+
+PowerUp::~PowerUp() = default;
+
+void PowerUp::Update(float deltaTime) {
+    if (effectActive) {
+        remainingDuration -= deltaTime;
+        if (remainingDuration <= 0.0f) {
+            remainingDuration = 0.0f;
+            effectActive = false;
+        }
+    }
+    if (!collected) {
+        UpdateAnimation(deltaTime);
+    }
+}
+
+void PowerUp::UpdateAnimation(float deltaTime) {
+    // Spins in place and bobs around its spawn height. The bob is a whole
+    // number of periods per turn, so it is continuous where the angle wraps.
+    const float turnsPerSecond = 0.3f;
+    rotationAngle += 6.28318531f * turnsPerSecond * deltaTime;
+    rotationAngle -= rotationAngle >= 6.28318531f ? 6.28318531f : 0.0f;
+    float phase = rotationAngle * bobSpeed;
+    float bob = 0.0f;
+    float unused = 0.0f;
+    VectorBatch::SinCos(&phase, &bob, &unused, 1);
+    position.y = baseY + bob * bobHeight;
+}
+
+SDL_Rect PowerUp::GetCollisionBox() const {
+    const int size = 32;
+    return {static_cast<int>(position.x) - size / 2, static_cast<int>(position.y) - size / 2, size, size};
+}
+
+void PowerUp::Render(RenderQueue& queue, float interpolation) {
+    Vector2D center = GetInterpolatedPosition(interpolation);
+    SDL_Rect box = GetCollisionBox();
+    SDL_FRect dest = {center.x - box.w * 0.5f, center.y - box.h * 0.5f, static_cast<float>(box.w),
+                      static_cast<float>(box.h)};
+    queue.Submit(sprite, dest, rotationAngle, RenderLayer::POWERUPS, {255, 220, 80, 255});
+}
+
+void PowerUp::ApplyEffect(Bike* bike) {
+    float duration = 0.0f;
+    switch (type) {
+    case PowerUpType::NITRO_BOOST: duration = NITRO_BOOST_DURATION; break;
+    case PowerUpType::SHIELD: duration = SHIELD_DURATION; break;
+    case PowerUpType::SPEED_BURST: duration = SPEED_BURST_DURATION; break;
+    case PowerUpType::OIL_SLICK: duration = OIL_SLICK_DURATION; break;
+    default: break;
+    }
+    effectActive = duration > 0.0f;
+    remainingDuration = duration;
+    if (bike) {
+        bike->ApplyPowerUp(type, duration);
+    }
+}
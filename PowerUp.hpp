@@ -1,6 +1,8 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include <cstddef>
 #include "Vector2D.hpp"
+#include "RenderQueue.hpp"
 
 enum class PowerUpType {
     NITRO_BOOST,
@@ -11,20 +13,54 @@ enum class PowerUpType {
     OIL_SLICK
 };
 
+constexpr size_t POWER_UP_TYPE_COUNT = 6;
+
 class PowerUp {
 public:
     PowerUp(PowerUpType type, const Vector2D& position);
     ~PowerUp();
 
     void Update(float deltaTime);
-    void Render(SDL_Renderer* renderer);
+    void Render(RenderQueue& queue, float interpolation = 1.0f);
     bool IsCollected() const { return collected; }
     void Collect() { collected = true; }
     
     PowerUpType GetType() const { return type; }
+    // Jump, missile and oil are kept by the rider until used; the others act on pickup
+    static bool IsHeld(PowerUpType type) {
+        return type == PowerUpType::JUMP_BOOST || type == PowerUpType::MISSILE || type == PowerUpType::OIL_SLICK;
+    }
     Vector2D GetPosition() const { return position; }
+    void SetSprite(const AtlasRegion& region) { sprite = region; }
     SDL_Rect GetCollisionBox() const;
 
+    // Interpolation between fixed simulation steps
+    void SavePreviousState() { previousPosition = position; }
+    Vector2D GetInterpolatedPosition(float alpha) const {
+        return Vector2D::Lerp(previousPosition, position, alpha);
+    }
+
+    // Simulation state, for rollback snapshots
+    struct SimState {
+        Vector2D position;
+        bool collected;
+        bool effectActive;
+        float remainingDuration;
+        float rotationAngle;
+        float baseY;
+    };
+    SimState GetSimState() const {
+        return {position, collected, effectActive, remainingDuration, rotationAngle, baseY};
+    }
+    void SetSimState(const SimState& state) {
+        position = state.position;
+        collected = state.collected;
+        effectActive = state.effectActive;
+        remainingDuration = state.remainingDuration;
+        rotationAngle = state.rotationAngle;
+        baseY = state.baseY;
+    }
+
     // Power-up effects
     void ApplyEffect(class Bike* bike);
     void RemoveEffect(class Bike* bike);
@@ -34,6 +70,7 @@ public:
 private:
     PowerUpType type;
     Vector2D position;
+    Vector2D previousPosition;
     bool collected;
     bool effectActive;
     float remainingDuration;
@@ -41,7 +78,7 @@ private:
     
     // Animation
     void UpdateAnimation(float deltaTime);
-    SDL_Texture* texture;
+    AtlasRegion sprite;
     float bobHeight;
     float bobSpeed;
     float baseY;
@@ -0,0 +1,152 @@
+#include "Profiler.hpp"
+#include "RenderQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+Profiler& Profiler::Get() {
+    static Profiler instance;
+    return instance;
+}
+
+Profiler::Profiler() : epochNs(Now()), frameTimes(FRAME_HISTORY, 0.0f), frameCount(0) {}
+
+uint64_t Profiler::Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Profiler::ThreadRing& Profiler::GetThreadRing() {
+    // Registration takes the lock once per thread; recording never does
+    thread_local ThreadRing* ring = nullptr;
+    if (!ring) {
+        auto owned = std::make_shared<ThreadRing>();
+        owned->slots = std::make_unique<Slot[]>(RING_CAPACITY);
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        owned->threadId = static_cast<uint32_t>(rings.size());
+        rings.push_back(owned);
+        ring = owned.get();
+    }
+    return *ring;
+}
+
+void Profiler::Record(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadRing& ring = GetThreadRing();
+    uint64_t index = ring.written.load(std::memory_order_relaxed);
+    // Orders the count published for the previous event before these slot
+    // stores, so a reader that sees them also sees the slot as reused
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot& slot = ring.slots[index & (RING_CAPACITY - 1)];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::CopyEvents(const ThreadRing& ring, std::vector<ProfileEvent>& out) const {
+    uint64_t end = ring.written.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+    size_t first = out.size();
+    for (uint64_t i = begin; i < end; ++i) {
+        const Slot& slot = ring.slots[i & (RING_CAPACITY - 1)];
+        out.push_back({slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+                       slot.endNs.load(std::memory_order_relaxed)});
+    }
+    // The writer may have lapped us while copying. Event i's slot is being
+    // reused once the count reaches i + RING_CAPACITY, so drop those.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = ring.written.load(std::memory_order_relaxed);
+    if (after >= begin + RING_CAPACITY) {
+        size_t lost = static_cast<size_t>(std::min<uint64_t>(after - begin - RING_CAPACITY + 1, end - begin));
+        out.erase(out.begin() + first, out.begin() + first + lost);
+    }
+}
+
+void Profiler::EndFrame(float frameSeconds) {
+    frameTimes[frameCount % FRAME_HISTORY] = frameSeconds * 1000.0f;
+    ++frameCount;
+}
+
+FrameTimeStats Profiler::GetFrameStats() const {
+    FrameTimeStats stats;
+    size_t count = std::min(frameCount, FRAME_HISTORY);
+    if (count == 0) {
+        return stats;
+    }
+    std::vector<float> sorted(frameTimes.begin(), frameTimes.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](float p) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    };
+    float total = 0.0f;
+    for (float time : sorted) {
+        total += time;
+    }
+    stats.average = total / count;
+    stats.p50 = percentile(0.50f);
+    stats.p95 = percentile(0.95f);
+    stats.p99 = percentile(0.99f);
+    stats.worst = sorted.back();
+    return stats;
+}
+
+void Profiler::DrawOverlay(RenderQueue& queue, float x, float y, float width, float height) const {
+    queue.SubmitRect({x, y, width, height}, {0, 0, 0, 160}, RenderLayer::UI);
+
+    FrameTimeStats stats = GetFrameStats();
+    // Scale so the budget line sits at half height unless spikes need more room
+    const float budgetMs = 1000.0f / 60.0f;
+    float scaleMs = std::max(budgetMs * 2.0f, stats.worst * 1.1f);
+    float pixelsPerMs = height / scaleMs;
+
+    size_t count = std::min(frameCount, FRAME_HISTORY);
+    float barWidth = width / FRAME_HISTORY;
+    for (size_t i = 0; i < count; ++i) {
+        // Oldest on the left
+        size_t index = (frameCount - count + i) % FRAME_HISTORY;
+        float barHeight = std::min(height, frameTimes[index] * pixelsPerMs);
+        SDL_Color color = frameTimes[index] <= budgetMs ? SDL_Color{80, 200, 80, 255}
+                                                        : SDL_Color{230, 70, 60, 255};
+        queue.SubmitRect({x + i * barWidth, y + height - barHeight, barWidth, barHeight}, color, RenderLayer::UI);
+    }
+
+    auto line = [&](float ms, SDL_Color color) {
+        float lineY = y + height - std::min(height, ms * pixelsPerMs);
+        queue.SubmitRect({x, lineY, width, 1.0f}, color, RenderLayer::UI);
+    };
+    line(budgetMs, {255, 255, 255, 200});
+    line(stats.p50, {90, 160, 255, 255});
+    line(stats.p95, {255, 200, 60, 255});
+    line(stats.p99, {255, 90, 200, 255});
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<std::shared_ptr<ThreadRing>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        snapshot = rings;
+    }
+
+    // Complete ("X") events, timestamps in microseconds since startup
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    std::vector<ProfileEvent> events;
+    for (const auto& ring : snapshot) {
+        events.clear();
+        CopyEvents(*ring, events);
+        for (const auto& event : events) {
+            file << (first ? "\n" : ",\n");
+            first = false;
+            file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId
+                 << ",\"ts\":" << (event.startNs > epochNs ? event.startNs - epochNs : 0) / 1000.0
+                 << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << "}";
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class RenderQueue;
+
+// One finished zone. Names must be string literals (or otherwise outlive
+// the profiler); only the pointer is stored.
+struct ProfileEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Frame-time percentiles over the recorded history, in milliseconds
+struct FrameTimeStats {
+    float average = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float worst = 0.0f;
+};
+
+// Scoped-zone profiler. Every thread records into its own fixed-size ring,
+// written only by that thread and published with a release store, so
+// recording never takes a lock or allocates. The slots are atomics read like
+// a seqlock: readers (overlay, trace export) copy the rings, then re-read
+// the write count and drop every slot the writer may have reused meanwhile.
+//
+// Use the BIKE_PROFILE_* macros below rather than calling this directly:
+// they compile to nothing unless BIKE_ENABLE_PROFILER is defined.
+class Profiler {
+public:
+    static Profiler& Get();
+
+    static uint64_t Now();
+    void Record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    // Main thread, once per frame
+    void EndFrame(float frameSeconds);
+    FrameTimeStats GetFrameStats() const;
+
+    // Frame-time graph with p50/p95/p99 lines and a 60 Hz budget line
+    void DrawOverlay(RenderQueue& queue, float x, float y, float width, float height) const;
+
+    // Writes every event still in the rings as Chrome trace JSON
+    // (load it in chrome://tracing or Perfetto)
+    bool ExportChromeTrace(const std::string& path) const;
+
+    static constexpr size_t RING_CAPACITY = 16384; // events per thread, power of two
+    static constexpr size_t FRAME_HISTORY = 240;
+
+private:
+    // Relaxed atomics: a slot being rewritten during a copy is discarded,
+    // but reading it is still well-defined
+    struct Slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> startNs{0};
+        std::atomic<uint64_t> endNs{0};
+    };
+    struct ThreadRing {
+        uint32_t threadId;
+        std::atomic<uint64_t> written{0};
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    Profiler();
+    ThreadRing& GetThreadRing();
+    void CopyEvents(const ThreadRing& ring, std::vector<ProfileEvent>& out) const;
+
+    // Rings outlive their threads so short-lived workers still show up in exports
+    mutable std::mutex ringsMutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    uint64_t epochNs;
+
+    std::vector<float> frameTimes; // milliseconds, ring of FRAME_HISTORY
+    size_t frameCount;
+};
+
+// Records the time from construction to the end of the enclosing scope
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), startNs(Profiler::Now()) {}
+    ~ProfileZone() { Profiler::Get().Record(name, startNs, Profiler::Now()); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#ifdef BIKE_ENABLE_PROFILER
+#define BIKE_PROFILE_CONCAT_INNER(a, b) a##b
+#define BIKE_PROFILE_CONCAT(a, b) BIKE_PROFILE_CONCAT_INNER(a, b)
+#define BIKE_PROFILE_ZONE(name) ProfileZone BIKE_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define BIKE_PROFILE_FRAME(seconds) Profiler::Get().EndFrame(seconds)
+#else
+#define BIKE_PROFILE_ZONE(name) ((void)0)
+#define BIKE_PROFILE_FRAME(seconds) ((void)0)
+#endif
@@ -0,0 +1,62 @@
+#include "RaceRanking.hpp"
+#include "Track.hpp"
+
+void RaceRanking::Clear() {
+    racers.clear();
+    order.clear();
+    swapCount = 0;
+}
+
+uint32_t RaceRanking::AddRacer() {
+    uint32_t racer = static_cast<uint32_t>(racers.size());
+    racers.emplace_back();
+    racers.back().rank = racer;
+    order.push_back(racer);
+    return racer;
+}
+
+void RaceRanking::UpdateRacer(uint32_t racer, const Track& track, const Vector2D& position) {
+    Racer& state = racers[racer];
+    float lapLength = track.GetLapLength();
+    float progress = track.GetProgress(position, state.edgeHint);
+    if (state.placed && lapLength > 0.0f) {
+        // A jump of more than half a lap in one tick can only be the start line
+        float delta = progress - state.progress;
+        if (delta < -0.5f * lapLength) {
+            ++state.lap;
+        } else if (delta > 0.5f * lapLength) {
+            --state.lap;
+        }
+    } else if (!state.placed) {
+        state.firstLap = progress > 0.5f * lapLength ? 1 : 0;
+    }
+    state.placed = true;
+    state.progress = progress;
+    state.distance = (state.lap - state.firstLap) * lapLength + progress;
+}
+
+void RaceRanking::UpdateOrder() {
+    // Insertion sort on last tick's order: only racers that overtook move
+    swapCount = 0;
+    for (size_t i = 1; i < order.size(); ++i) {
+        uint32_t racer = order[i];
+        size_t j = i;
+        while (j > 0 && Ahead(racer, order[j - 1])) {
+            order[j] = order[j - 1];
+            racers[order[j]].rank = static_cast<uint32_t>(j);
+            --j;
+            ++swapCount;
+        }
+        order[j] = racer;
+        racers[racer].rank = static_cast<uint32_t>(j);
+    }
+}
+
+float RaceRanking::GetGapToLeader(uint32_t racer) const {
+    return order.empty() ? 0.0f : racers[order.front()].distance - racers[racer].distance;
+}
+
+float RaceRanking::GetGapAhead(uint32_t racer) const {
+    uint32_t rank = racers[racer].rank;
+    return rank == 0 ? 0.0f : racers[order[rank - 1]].distance - racers[racer].distance;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vector2D.hpp"
+
+class Track;
+
+// Live race standings. Each racer's progress is followed from the track
+// edge it was on last tick, so updating it is a handful of edge tests, and
+// the standings are a persistent ranked list repaired with adjacent swaps:
+// a tick without overtakes costs one comparison per racer, an overtake
+// costs one swap. Nothing is sorted from scratch.
+//
+// Race distance is laps completed * lap length + progress along the lap. A
+// lap is counted whenever progress wraps past the start line (and taken back
+// when a racer reverses over it), so racers on the grid behind the line
+// start at lap 0 with nearly a full lap of progress. For them, crossing the
+// line starts the race rather than finishing a lap: GetLapsCompleted and the
+// distance (negative until then) both account for it.
+class RaceRanking {
+public:
+    void Clear();
+    // Racers are numbered in the order they are added (the game's bike order)
+    uint32_t AddRacer();
+    size_t GetRacerCount() const { return racers.size(); }
+
+    // Racers can be updated in any order, or in parallel for distinct racers
+    void UpdateRacer(uint32_t racer, const Track& track, const Vector2D& position);
+    // Restores the ranking after a round of UpdateRacer calls
+    void UpdateOrder();
+
+    // Racer indices, leader first; ties go to the lower index
+    const std::vector<uint32_t>& GetOrder() const { return order; }
+    // 0 for the leader
+    uint32_t GetRank(uint32_t racer) const { return racers[racer].rank; }
+    int GetLap(uint32_t racer) const { return racers[racer].lap; }
+    // Laps finished since the start, never negative
+    int GetLapsCompleted(uint32_t racer) const {
+        int laps = racers[racer].lap - racers[racer].firstLap;
+        return laps > 0 ? laps : 0;
+    }
+    float GetDistance(uint32_t racer) const { return racers[racer].distance; }
+    // Track distance to the leader and to the racer one place ahead
+    float GetGapToLeader(uint32_t racer) const;
+    float GetGapAhead(uint32_t racer) const;
+    // Places exchanged by the last UpdateOrder
+    uint32_t GetSwapCount() const { return swapCount; }
+
+private:
+    struct Racer {
+        uint32_t edgeHint = ~0u;
+        uint32_t rank = 0;
+        int lap = 0;
+        int firstLap = 0; // 1 when starting behind the line
+        float progress = 0.0f;
+        float distance = 0.0f;
+        bool placed = false;
+    };
+
+    bool Ahead(uint32_t a, uint32_t b) const {
+        const Racer& first = racers[a];
+        const Racer& second = racers[b];
+        return first.distance != second.distance ? first.distance > second.distance : a < b;
+    }
+
+    std::vector<Racer> racers;
+    std::vector<uint32_t> order;
+    uint32_t swapCount = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// Small deterministic generator (xorshift64*). Every gameplay system that
+// needs randomness owns one, seeded explicitly, so a recorded seed plus the
+// input log reproduces a session exactly on any machine. Never use rand()
+// or std::random_device in simulation code.
+class Random {
+public:
+    explicit Random(uint64_t seed = 1) { Seed(seed); }
+
+    void Seed(uint64_t seed) {
+        // SplitMix64 step so nearby seeds give unrelated streams; state must not be zero
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        state = (z ^ (z >> 31)) | 1;
+    }
+
+    uint64_t Next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    // Uniform in [0, 1), built from integer bits so it is identical everywhere
+    float NextFloat() { return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f); }
+    float Range(float min, float max) { return min + (max - min) * NextFloat(); }
+    // Uniform in [0, count)
+    uint32_t NextInt(uint32_t count) { return count ? static_cast<uint32_t>((Next() >> 32) % count) : 0; }
+
+    uint64_t GetState() const { return state; }
+    // Restores a stream saved with GetState (rollback snapshots)
+    void SetState(uint64_t saved) { state = saved ? saved : 1; }
+
+private:
+    uint64_t state;
+};
+
+// Seeds for every simulation stream; stored in input logs and snapshots
+struct RandomSeeds {
+    uint64_t weather = 1;
+    uint64_t obstacles = 2;
+    uint64_t powerUps = 3;
+
+    // Derives all streams from one session seed
+    static RandomSeeds FromSeed(uint64_t seed) {
+        Random random(seed);
+        RandomSeeds seeds;
+        seeds.weather = random.Next();
+        seeds.obstacles = random.Next();
+        seeds.powerUps = random.Next();
+        return seeds;
+    }
+};
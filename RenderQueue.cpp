@@ -0,0 +1,194 @@
+#include "RenderQueue.hpp"
+#include "Vector2D.hpp"
+#include <algorithm>
+
+TextureAtlas::TextureAtlas()
+    : texture(nullptr), atlasWidth(0), atlasHeight(0), shelfX(0), shelfY(0), shelfHeight(0) {}
+
+TextureAtlas::~TextureAtlas() {
+    Destroy();
+}
+
+void TextureAtlas::Destroy() {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+    regions.clear();
+}
+
+bool TextureAtlas::Create(SDL_Renderer* renderer, int width, int height) {
+    Destroy();
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) {
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    atlasWidth = width;
+    atlasHeight = height;
+    shelfX = shelfY = shelfHeight = 0;
+    regions.clear();
+    return true;
+}
+
+bool TextureAtlas::Pack(int width, int height, SDL_Rect& rect) {
+    // One pixel of padding keeps linear filtering from bleeding between images
+    const int padding = 1;
+    if (shelfX + width + padding > atlasWidth) {
+        shelfX = 0;
+        shelfY += shelfHeight;
+        shelfHeight = 0;
+    }
+    if (width + padding > atlasWidth || shelfY + height + padding > atlasHeight) {
+        return false;
+    }
+    rect = {shelfX, shelfY, width, height};
+    shelfX += width + padding;
+    shelfHeight = std::max(shelfHeight, height + padding);
+    return true;
+}
+
+bool TextureAtlas::AddImage(const std::string& name, SDL_Surface* surface) {
+    if (!texture || !surface) {
+        return false;
+    }
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!converted) {
+        return false;
+    }
+    SDL_Rect rect;
+    bool packed = Pack(converted->w, converted->h, rect);
+    if (packed) {
+        SDL_UpdateTexture(texture, &rect, converted->pixels, converted->pitch);
+        AtlasRegion region;
+        region.texture = texture;
+        region.u0 = static_cast<float>(rect.x) / atlasWidth;
+        region.v0 = static_cast<float>(rect.y) / atlasHeight;
+        region.u1 = static_cast<float>(rect.x + rect.w) / atlasWidth;
+        region.v1 = static_cast<float>(rect.y + rect.h) / atlasHeight;
+        region.width = rect.w;
+        region.height = rect.h;
+        regions[name] = region;
+    }
+    SDL_FreeSurface(converted);
+    return packed;
+}
+
+bool TextureAtlas::FindRegion(const std::string& name, AtlasRegion& region) const {
+    auto found = regions.find(name);
+    if (found == regions.end()) {
+        return false;
+    }
+    region = found->second;
+    return true;
+}
+
+RenderQueue::RenderQueue() {
+    vertices.reserve(4096);
+    batches.reserve(1024);
+}
+
+void RenderQueue::Clear() {
+    vertices.clear();
+    batches.clear();
+}
+
+void RenderQueue::Submit(const AtlasRegion& region, const SDL_FRect& dest, float rotation,
+                         RenderLayer layer, SDL_Color tint) {
+    SDL_Vertex* quad = BeginQuads(region.texture, layer, 1);
+
+    // Rotate the corners around the centre of the destination rectangle
+    float halfW = dest.w * 0.5f;
+    float halfH = dest.h * 0.5f;
+    float cx = dest.x + halfW;
+    float cy = dest.y + halfH;
+    float s, c;
+    Vector2D::SinCos(rotation, s, c);
+    const float cornerX[4] = {-halfW, halfW, halfW, -halfW};
+    const float cornerY[4] = {-halfH, -halfH, halfH, halfH};
+    const float u[4] = {region.u0, region.u1, region.u1, region.u0};
+    const float v[4] = {region.v0, region.v0, region.v1, region.v1};
+    for (int i = 0; i < 4; ++i) {
+        quad[i].position = {cx + cornerX[i] * c - cornerY[i] * s, cy + cornerX[i] * s + cornerY[i] * c};
+        quad[i].color = tint;
+        quad[i].tex_coord = {u[i], v[i]};
+    }
+    EndQuads(1);
+}
+
+void RenderQueue::SubmitRect(const SDL_FRect& rect, SDL_Color color, RenderLayer layer) {
+    SDL_Vertex* quad = BeginQuads(nullptr, layer, 1);
+    quad[0] = {{rect.x, rect.y}, color, {0.0f, 0.0f}};
+    quad[1] = {{rect.x + rect.w, rect.y}, color, {0.0f, 0.0f}};
+    quad[2] = {{rect.x + rect.w, rect.y + rect.h}, color, {0.0f, 0.0f}};
+    quad[3] = {{rect.x, rect.y + rect.h}, color, {0.0f, 0.0f}};
+    EndQuads(1);
+}
+
+SDL_Vertex* RenderQueue::BeginQuads(SDL_Texture* texture, RenderLayer layer, int maxQuads) {
+    uint32_t firstQuad = static_cast<uint32_t>(vertices.size() / 4);
+    vertices.resize(vertices.size() + static_cast<size_t>(maxQuads) * 4);
+    batches.push_back({static_cast<int>(layer), texture, firstQuad, static_cast<uint32_t>(maxQuads)});
+    return vertices.data() + static_cast<size_t>(firstQuad) * 4;
+}
+
+void RenderQueue::EndQuads(int usedQuads) {
+    Batch& batch = batches.back();
+    vertices.resize((static_cast<size_t>(batch.firstQuad) + usedQuads) * 4);
+    batch.quadCount = static_cast<uint32_t>(usedQuads);
+    if (usedQuads == 0) {
+        batches.pop_back();
+    }
+}
+
+void RenderQueue::Flush(SDL_Renderer* renderer) {
+    stats = RenderStats();
+    if (batches.empty()) {
+        return;
+    }
+
+    // Ties break on firstQuad, which only grows with submission order, so
+    // this keeps quads in order within a layer and texture like a stable
+    // sort would, without stable_sort's temporary buffer every frame
+    std::sort(batches.begin(), batches.end(), [](const Batch& a, const Batch& b) {
+        if (a.layer != b.layer) {
+            return a.layer < b.layer;
+        }
+        if (a.texture != b.texture) {
+            return std::less<SDL_Texture*>()(a.texture, b.texture);
+        }
+        return a.firstQuad < b.firstQuad;
+    });
+
+    // Each draw call gets only its own run's vertices, so SDL never walks
+    // the rest of the frame's geometry
+    sortedVertices.clear();
+    sortedVertices.reserve(vertices.size());
+    indices.clear();
+    indices.reserve(vertices.size() / 4 * 6);
+    size_t runVertexStart = 0;
+    size_t runIndexStart = 0;
+    for (size_t b = 0; b < batches.size(); ++b) {
+        const Batch& batch = batches[b];
+        const SDL_Vertex* first = vertices.data() + static_cast<size_t>(batch.firstQuad) * 4;
+        for (uint32_t q = 0; q < batch.quadCount; ++q) {
+            int base = static_cast<int>(sortedVertices.size() - runVertexStart) + static_cast<int>(q) * 4;
+            indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+        }
+        sortedVertices.insert(sortedVertices.end(), first, first + static_cast<size_t>(batch.quadCount) * 4);
+
+        bool runEnds = b + 1 == batches.size() ||
+                       batches[b + 1].layer != batch.layer || batches[b + 1].texture != batch.texture;
+        if (runEnds) {
+            SDL_RenderGeometry(renderer, batch.texture, sortedVertices.data() + runVertexStart,
+                               static_cast<int>(sortedVertices.size() - runVertexStart),
+                               indices.data() + runIndexStart, static_cast<int>(indices.size() - runIndexStart));
+            ++stats.drawCalls;
+            runVertexStart = sortedVertices.size();
+            runIndexStart = indices.size();
+        }
+    }
+    stats.quads = static_cast<int>(vertices.size() / 4);
+    stats.vertices = static_cast<int>(vertices.size());
+    Clear();
+}
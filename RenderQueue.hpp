@@ -0,0 +1,105 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Draw order, back to front
+enum class RenderLayer {
+    TRACK = 0,
+    OBSTACLES,
+    POWERUPS,
+    PARTICLES,
+    BIKES,
+    UI
+};
+
+// A sub-rectangle of an atlas texture in normalized texture coordinates
+struct AtlasRegion {
+    SDL_Texture* texture = nullptr;
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 1.0f;
+    float v1 = 1.0f;
+    int width = 0;
+    int height = 0;
+};
+
+// Packs many small images into one texture (shelf packing) so sprites that
+// share the atlas can be drawn in a single batch
+class TextureAtlas {
+public:
+    TextureAtlas();
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    bool Create(SDL_Renderer* renderer, int width, int height);
+    // Frees the texture; call before the renderer that made it is destroyed
+    void Destroy();
+    // Copies the image into the atlas; fails when it no longer fits
+    bool AddImage(const std::string& name, SDL_Surface* surface);
+    // Resolve names once at load time and keep the returned region
+    bool FindRegion(const std::string& name, AtlasRegion& region) const;
+
+    SDL_Texture* GetTexture() const { return texture; }
+
+private:
+    bool Pack(int width, int height, SDL_Rect& rect);
+
+    SDL_Texture* texture;
+    int atlasWidth;
+    int atlasHeight;
+    int shelfX;
+    int shelfY;
+    int shelfHeight;
+    std::map<std::string, AtlasRegion> regions;
+};
+
+struct RenderStats {
+    int drawCalls = 0;
+    int vertices = 0;
+    int quads = 0;
+};
+
+// Collects every quad drawn in a frame, sorts them by layer and texture and
+// submits each (layer, texture) run with one SDL_RenderGeometry call, so the
+// number of draw calls does not grow with the number of objects on screen.
+class RenderQueue {
+public:
+    RenderQueue();
+
+    void Clear();
+
+    void Submit(const AtlasRegion& region, const SDL_FRect& dest, float rotation,
+                RenderLayer layer, SDL_Color tint = {255, 255, 255, 255});
+    void SubmitRect(const SDL_FRect& rect, SDL_Color color, RenderLayer layer);
+
+    // Direct access for bulk producers such as particles: reserve up to
+    // maxQuads, write 4 vertices per quad, then report how many were used.
+    // The pointer is valid until the next submission.
+    SDL_Vertex* BeginQuads(SDL_Texture* texture, RenderLayer layer, int maxQuads);
+    void EndQuads(int usedQuads);
+
+    void Flush(SDL_Renderer* renderer);
+
+    const RenderStats& GetStats() const { return stats; }
+
+private:
+    struct Batch {
+        int layer;
+        SDL_Texture* texture;
+        uint32_t firstQuad;
+        uint32_t quadCount;
+    };
+
+    std::vector<SDL_Vertex> vertices; // submission order, 4 per quad
+    std::vector<Batch> batches;
+    // Rebuilt on flush: vertices gathered run by run in sorted order, and
+    // indices relative to the start of their run
+    std::vector<SDL_Vertex> sortedVertices;
+    std::vector<int> indices;
+    RenderStats stats;
+};
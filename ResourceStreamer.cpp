@@ -0,0 +1,316 @@
+#include "ResourceStreamer.hpp"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <fstream>
+
+ResourceEntry::~ResourceEntry() {
+    if (surface) {
+        SDL_FreeSurface(surface);
+    }
+    if (texture) {
+        SDL_DestroyTexture(texture);
+    }
+    if (sound) {
+        Mix_FreeChunk(sound);
+    }
+    if (music) {
+        Mix_FreeMusic(music);
+    }
+    if (font) {
+        TTF_CloseFont(font);
+    }
+}
+
+ResourceStreamer::ResourceStreamer(unsigned workerCount, size_t memoryBudget)
+    : nextSequence(0), stopping(false), paused(false), workerCount(std::max(1u, workerCount)),
+      memoryBudget(memoryBudget), frameCounter(0) {}
+
+ResourceStreamer::~ResourceStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    UnloadAll();
+}
+
+std::string ResourceStreamer::MakeKey(const ResourceRequest& request) {
+    // The same font file at two sizes is two different resources
+    return request.type == ResourceType::FONT
+        ? request.path + "@" + std::to_string(request.fontSize)
+        : request.path;
+}
+
+ResourceHandle ResourceStreamer::Request(const ResourceRequest& request, ResourcePriority priority) {
+    std::string key = MakeKey(request);
+    std::shared_ptr<ResourceEntry> entry;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = cache.find(key);
+        if (found != cache.end()) {
+            entry = found->second;
+            entry->lastUsedFrame = frameCounter;
+            if (entry->state.load() != ResourceEntry::State::QUEUED) {
+                return ResourceHandle(entry);
+            }
+        } else {
+            entry = std::make_shared<ResourceEntry>();
+            entry->key = key;
+            entry->request = request;
+            entry->lastUsedFrame = frameCounter;
+            cache.emplace(key, entry);
+        }
+    }
+
+    // Still queued: (re)submit at this priority; workers skip stale duplicates
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        // Workers start with the first request, so headless games never spawn them
+        while (workers.size() < workerCount) {
+            workers.emplace_back(&ResourceStreamer::WorkerLoop, this);
+        }
+        jobs.push({static_cast<int>(priority), nextSequence++, entry});
+    }
+    jobReady.notify_one();
+    return ResourceHandle(entry);
+}
+
+std::vector<ResourceHandle> ResourceStreamer::Prefetch(const std::vector<ResourceRequest>& requests,
+                                                       ResourcePriority priority) {
+    std::vector<ResourceHandle> handles;
+    handles.reserve(requests.size());
+    for (const auto& request : requests) {
+        handles.push_back(Request(request, priority));
+    }
+    return handles;
+}
+
+void ResourceStreamer::SetPaused(bool value) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        paused = value;
+    }
+    jobReady.notify_all();
+}
+
+bool ResourceStreamer::IsLoaded(const std::vector<ResourceRequest>& requests) const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (const auto& request : requests) {
+        auto found = cache.find(MakeKey(request));
+        if (found == cache.end()) {
+            return false;
+        }
+        ResourceEntry::State state = found->second->state.load();
+        if (state != ResourceEntry::State::READY && state != ResourceEntry::State::FAILED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ResourceStreamer::WorkerLoop() {
+    for (;;) {
+        std::shared_ptr<ResourceEntry> entry;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return stopping || (!paused && !jobs.empty()); });
+            if (stopping) {
+                return;
+            }
+            entry = jobs.top().entry;
+            jobs.pop();
+        }
+
+        ResourceEntry::State expected = ResourceEntry::State::QUEUED;
+        if (!entry->state.compare_exchange_strong(expected, ResourceEntry::State::DECODING)) {
+            continue; // already picked up through a higher-priority duplicate
+        }
+
+        size_t sizeBytes = Decode(*entry);
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        entry->sizeBytes = sizeBytes;
+        if (entry->state.load() == ResourceEntry::State::DECODED) {
+            uploadQueue.push_back(entry);
+        }
+    }
+}
+
+size_t ResourceStreamer::Decode(ResourceEntry& entry) {
+    const ResourceRequest& request = entry.request;
+    if (request.type == ResourceType::TEXTURE || request.type == ResourceType::IMAGE) {
+        entry.surface = IMG_Load(request.path.c_str());
+        if (entry.surface) {
+            entry.state = ResourceEntry::State::DECODED;
+            return static_cast<size_t>(entry.surface->w) * entry.surface->h * 4;
+        }
+        SDL_Log("Failed to load %s: %s", request.path.c_str(), SDL_GetError());
+        entry.state = ResourceEntry::State::FAILED;
+        return 0;
+    }
+
+    // Audio and fonts: only the file read happens here
+    std::ifstream file(request.path, std::ios::binary | std::ios::ate);
+    std::streamoff size = file ? static_cast<std::streamoff>(file.tellg()) : -1;
+    if (size > 0) {
+        entry.fileData.resize(static_cast<size_t>(size));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(entry.fileData.data()), size);
+    }
+    if (size <= 0 || !file) {
+        SDL_Log("Failed to read %s", request.path.c_str());
+        std::vector<uint8_t>().swap(entry.fileData);
+        entry.state = ResourceEntry::State::FAILED;
+        return 0;
+    }
+    entry.state = ResourceEntry::State::DECODED;
+    return entry.fileData.size();
+}
+
+size_t ResourceStreamer::Finish(SDL_Renderer* renderer, ResourceEntry& entry) {
+    const ResourceRequest& request = entry.request;
+    // Read without the lock: only the thread that took the entry off the
+    // upload queue touches it until it is READY
+    size_t sizeBytes = entry.sizeBytes;
+    SDL_RWops* source = nullptr;
+    if (request.type != ResourceType::TEXTURE && request.type != ResourceType::IMAGE) {
+        source = SDL_RWFromConstMem(entry.fileData.data(), static_cast<int>(entry.fileData.size()));
+    }
+    bool created = false;
+    switch (request.type) {
+    case ResourceType::TEXTURE:
+        entry.texture = SDL_CreateTextureFromSurface(renderer, entry.surface);
+        SDL_FreeSurface(entry.surface);
+        entry.surface = nullptr;
+        created = entry.texture != nullptr;
+        break;
+    case ResourceType::IMAGE:
+        created = true; // the surface is the resource
+        break;
+    case ResourceType::SOUND:
+        // Chunks are decoded to PCM up front, so the file bytes can go
+        entry.sound = Mix_LoadWAV_RW(source, 1);
+        created = entry.sound != nullptr;
+        if (created) {
+            sizeBytes = entry.sound->alen;
+            std::vector<uint8_t>().swap(entry.fileData);
+        }
+        break;
+    case ResourceType::MUSIC:
+        entry.music = Mix_LoadMUS_RW(source, 1);
+        created = entry.music != nullptr;
+        break;
+    case ResourceType::FONT:
+        entry.font = TTF_OpenFontRW(source, 1, request.fontSize);
+        created = entry.font != nullptr;
+        break;
+    }
+    if (!created) {
+        SDL_Log("Failed to load %s: %s", request.path.c_str(), SDL_GetError());
+        std::vector<uint8_t>().swap(entry.fileData);
+        sizeBytes = 0;
+    }
+    entry.state = created ? ResourceEntry::State::READY : ResourceEntry::State::FAILED;
+    return sizeBytes;
+}
+
+void ResourceStreamer::PumpUploads(SDL_Renderer* renderer, int maxUploads) {
+    std::vector<std::shared_ptr<ResourceEntry>> ready;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        size_t count = std::min(uploadQueue.size(), static_cast<size_t>(std::max(0, maxUploads)));
+        ready.assign(uploadQueue.begin(), uploadQueue.begin() + count);
+        uploadQueue.erase(uploadQueue.begin(), uploadQueue.begin() + count);
+    }
+
+    // Only these steps have to run on the render thread
+    std::vector<size_t> sizes;
+    sizes.reserve(ready.size());
+    for (auto& entry : ready) {
+        sizes.push_back(Finish(renderer, *entry));
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (size_t i = 0; i < ready.size(); ++i) {
+        ready[i]->sizeBytes = sizes[i];
+    }
+}
+
+void ResourceStreamer::EndFrame() {
+    ++frameCounter;
+    EvictToBudget();
+}
+
+void ResourceStreamer::EvictToBudget() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    size_t usage = 0;
+    std::vector<std::map<std::string, std::shared_ptr<ResourceEntry>>::iterator> candidates;
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        usage += it->second->sizeBytes;
+        ResourceEntry::State state = it->second->state.load();
+        // Only the cache holds it, and no worker or upload is in flight
+        if (it->second.use_count() == 1 &&
+            (state == ResourceEntry::State::READY || state == ResourceEntry::State::FAILED)) {
+            candidates.push_back(it);
+        }
+    }
+    if (usage <= memoryBudget) {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a->second->lastUsedFrame < b->second->lastUsedFrame;
+    });
+    for (auto& it : candidates) {
+        if (usage <= memoryBudget) {
+            break;
+        }
+        usage -= it->second->sizeBytes;
+        cache.erase(it);
+    }
+}
+
+size_t ResourceStreamer::GetMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    size_t usage = 0;
+    for (const auto& item : cache) {
+        usage += item.second->sizeBytes;
+    }
+    return usage;
+}
+
+size_t ResourceStreamer::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    size_t pending = 0;
+    for (const auto& item : cache) {
+        ResourceEntry::State state = item.second->state.load();
+        pending += (state != ResourceEntry::State::READY && state != ResourceEntry::State::FAILED) ? 1 : 0;
+    }
+    return pending;
+}
+
+void ResourceStreamer::UnloadAll() {
+    // Handles outside the cache would otherwise see these as loading forever
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        for (; !jobs.empty(); jobs.pop()) {
+            ResourceEntry::State expected = ResourceEntry::State::QUEUED;
+            jobs.top().entry->state.compare_exchange_strong(expected, ResourceEntry::State::FAILED);
+        }
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto& entry : uploadQueue) {
+        if (entry->surface) {
+            SDL_FreeSurface(entry->surface);
+            entry->surface = nullptr;
+        }
+        std::vector<uint8_t>().swap(entry->fileData);
+        entry->sizeBytes = 0;
+        entry->state = ResourceEntry::State::FAILED;
+    }
+    uploadQueue.clear();
+    // Entries still referenced by handles or a decoding worker stay alive until released
+    cache.clear();
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ResourceType {
+    TEXTURE,
+    IMAGE, // kept as a surface, e.g. to be packed into an atlas
+    SOUND,
+    MUSIC,
+    FONT
+};
+
+// Higher values are decoded first
+enum class ResourcePriority {
+    BACKGROUND = 0,
+    PRELOAD = 1,
+    NORMAL = 2,
+    IMMEDIATE = 3
+};
+
+struct ResourceRequest {
+    std::string path;
+    ResourceType type;
+    int fontSize = 0;
+};
+
+// Shared state of one cached resource. File reads and image decoding happen
+// on a worker thread; texture upload and the SDL_mixer and SDL_ttf objects
+// are created on the render thread. `state` tells which step is done.
+struct ResourceEntry {
+    enum class State {
+        QUEUED,
+        DECODING,
+        DECODED,  // CPU data ready, the render thread still has to create the object
+        READY,
+        FAILED    // also requests cancelled by UnloadAll
+    };
+
+    std::string key;
+    ResourceRequest request;
+    std::atomic<State> state{State::QUEUED};
+    SDL_Surface* surface = nullptr;
+    SDL_Texture* texture = nullptr;
+    Mix_Chunk* sound = nullptr;
+    Mix_Music* music = nullptr;
+    TTF_Font* font = nullptr;
+    // Raw file for sounds, music and fonts; music and fonts keep reading
+    // from it while open, so it lives as long as they do
+    std::vector<uint8_t> fileData;
+    // Guarded by the streamer's cache mutex, like lastUsedFrame
+    size_t sizeBytes = 0;
+    uint64_t lastUsedFrame = 0;
+
+    ~ResourceEntry();
+};
+
+// Reference-counted handle; the streamer never evicts a resource while a handle exists
+class ResourceHandle {
+public:
+    ResourceHandle() = default;
+    explicit ResourceHandle(std::shared_ptr<ResourceEntry> entry) : entry(std::move(entry)) {}
+
+    bool IsReady() const { return entry && entry->state.load() == ResourceEntry::State::READY; }
+    bool IsFailed() const { return !entry || entry->state.load() == ResourceEntry::State::FAILED; }
+
+    // Null until the resource is ready
+    SDL_Texture* GetTexture() const { return IsReady() ? entry->texture : nullptr; }
+    SDL_Surface* GetSurface() const { return IsReady() ? entry->surface : nullptr; }
+    Mix_Chunk* GetSound() const { return IsReady() ? entry->sound : nullptr; }
+    Mix_Music* GetMusic() const { return IsReady() ? entry->music : nullptr; }
+    TTF_Font* GetFont() const { return IsReady() ? entry->font : nullptr; }
+
+    explicit operator bool() const { return static_cast<bool>(entry); }
+
+private:
+    std::shared_ptr<ResourceEntry> entry;
+};
+
+// Background resource loader: a priority job queue feeds worker threads that
+// read files and decode images; the render thread only uploads finished
+// surfaces and opens sounds, music and fonts from the bytes in memory, since
+// SDL_mixer and SDL_ttf are not safe to call off the main thread.
+// Unreferenced resources are evicted least-recently-used first once the
+// cache exceeds its memory budget.
+class ResourceStreamer {
+public:
+    explicit ResourceStreamer(unsigned workerCount = 2, size_t memoryBudget = 256u * 1024u * 1024u);
+    ~ResourceStreamer();
+
+    ResourceStreamer(const ResourceStreamer&) = delete;
+    ResourceStreamer& operator=(const ResourceStreamer&) = delete;
+
+    // Returns immediately; the handle becomes ready once loading finishes.
+    // Requesting a queued resource again raises its priority.
+    ResourceHandle Request(const ResourceRequest& request, ResourcePriority priority = ResourcePriority::NORMAL);
+    // Keep the handles until the requests are needed, or the budget may
+    // evict them again before they are used
+    std::vector<ResourceHandle> Prefetch(const std::vector<ResourceRequest>& requests,
+                                         ResourcePriority priority = ResourcePriority::PRELOAD);
+
+    // True once every request has finished loading (or failed)
+    bool IsLoaded(const std::vector<ResourceRequest>& requests) const;
+
+    // Render thread: finishes up to maxUploads decoded resources per call
+    void PumpUploads(SDL_Renderer* renderer, int maxUploads);
+    // Advances the LRU clock and evicts unreferenced resources over budget
+    void EndFrame();
+
+    // Paused workers finish what they are decoding but take no new jobs;
+    // requests keep queueing, by priority, until the streamer resumes
+    void SetPaused(bool value);
+
+    void SetMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+    size_t GetMemoryUsage() const;
+    size_t GetPendingCount() const;
+    // Drops the cache; queued and undelivered requests end FAILED so no
+    // handle waits on them forever
+    void UnloadAll();
+
+private:
+    struct Job {
+        int priority;
+        uint64_t sequence;
+        std::shared_ptr<ResourceEntry> entry;
+        bool operator<(const Job& other) const {
+            // std::priority_queue pops the largest: highest priority, then oldest
+            return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+        }
+    };
+
+    static std::string MakeKey(const ResourceRequest& request);
+    void WorkerLoop();
+    // Both return the entry's new size, which the caller stores under cacheMutex
+    static size_t Decode(ResourceEntry& entry);
+    static size_t Finish(SDL_Renderer* renderer, ResourceEntry& entry);
+    void EvictToBudget();
+
+    mutable std::mutex cacheMutex;
+    std::map<std::string, std::shared_ptr<ResourceEntry>> cache;
+    std::vector<std::shared_ptr<ResourceEntry>> uploadQueue;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::priority_queue<Job> jobs;
+    uint64_t nextSequence;
+    bool stopping;
+    bool paused;
+    unsigned workerCount;
+    std::vector<std::thread> workers;
+
+    size_t memoryBudget;
+    uint64_t frameCounter;
+};
@@ -0,0 +1,667 @@
+#include "SaveStore.hpp"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <set>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char BASE_MAGIC[4] = {'B', 'K', 'S', 'V'};
+const char JOURNAL_MAGIC[4] = {'B', 'K', 'J', 'L'};
+const uint32_t RECORD_MAGIC = 0x5243524a; // "JRCR"
+const uint8_t OP_PUT = 1;
+const uint8_t OP_ERASE = 2;
+
+// magic, version, reserved, record count, index offset, index CRC
+const size_t BASE_HEADER_SIZE = 4 + 2 + 2 + 4 + 8 + 4;
+// magic, version, reserved
+const size_t JOURNAL_HEADER_SIZE = 4 + 2 + 2;
+// magic, op, key length, value size ... CRC
+const size_t RECORD_OVERHEAD = 4 + 1 + 2 + 4 + 4;
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void PutFixed(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint64_t GetFixed(const uint8_t* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+// Pushes buffered data to the OS and then to the disk
+bool SyncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename durable; Windows commits it with the file
+void SyncDirectory(const std::string& path) {
+#ifndef _WIN32
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    bytes.clear();
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + count);
+    }
+    std::fclose(file);
+    return true;
+}
+
+}
+
+// --- SaveWriter / SaveReader ---
+
+void SaveWriter::Fixed(uint64_t value, int bytes) {
+    PutFixed(out, value, bytes);
+}
+
+void SaveWriter::F32(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    Fixed(bits, 4);
+}
+
+void SaveWriter::Varint(uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void SaveWriter::String(const std::string& text) {
+    Varint(text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+void SaveWriter::Strings(const std::vector<std::string>& texts) {
+    Varint(texts.size());
+    for (const auto& text : texts) {
+        String(text);
+    }
+}
+
+uint64_t SaveReader::Fixed(int bytes) {
+    if (size - offset < static_cast<size_t>(bytes)) {
+        failed = true;
+        return 0;
+    }
+    uint64_t value = GetFixed(data + offset, bytes);
+    offset += bytes;
+    return value;
+}
+
+float SaveReader::F32() {
+    uint32_t bits = static_cast<uint32_t>(Fixed(4));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t SaveReader::Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= size) {
+            failed = true;
+            return 0;
+        }
+        uint8_t byte = data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    failed = true;
+    return 0;
+}
+
+std::string SaveReader::String() {
+    uint64_t length = Varint();
+    if (failed || length > size - offset) {
+        failed = true;
+        return std::string();
+    }
+    std::string text(reinterpret_cast<const char*>(data + offset), static_cast<size_t>(length));
+    offset += static_cast<size_t>(length);
+    return text;
+}
+
+std::vector<std::string> SaveReader::Strings() {
+    std::vector<std::string> texts;
+    uint64_t count = Varint();
+    if (!Plausible(count)) {
+        return texts;
+    }
+    for (uint64_t i = 0; i < count && !failed; ++i) {
+        texts.push_back(String());
+    }
+    return texts;
+}
+
+// --- SaveStore ---
+
+SaveStore::~SaveStore() {
+    Close();
+}
+
+bool SaveStore::Open(const std::string& filePath, std::string& error) {
+    Close();
+    path = filePath;
+    journalPath = filePath + ".journal";
+    index.clear();
+    pending.clear();
+    stats = Stats();
+    stopping = false;
+    writeFailed = false;
+
+    if (!LoadBase(error) || !LoadJournal(error)) {
+        Close();
+        return false;
+    }
+    worker = std::thread([this] { WorkerLoop(); });
+    return true;
+}
+
+void SaveStore::Close() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+    for (std::FILE** file : {&baseFile, &journalAppend, &journalRead}) {
+        if (*file) {
+            std::fclose(*file);
+            *file = nullptr;
+        }
+    }
+}
+
+bool SaveStore::LoadBase(std::string& error) {
+    baseBytes = 0;
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return true; // nothing compacted yet
+    }
+    baseFile = std::fopen(path.c_str(), "rb");
+    uint8_t header[BASE_HEADER_SIZE];
+    if (!baseFile || std::fread(header, 1, sizeof(header), baseFile) != sizeof(header) ||
+        std::memcmp(header, BASE_MAGIC, sizeof(BASE_MAGIC)) != 0) {
+        error = path + " is not a save file";
+        return false;
+    }
+    uint16_t version = static_cast<uint16_t>(GetFixed(header + 4, 2));
+    if (version != FORMAT_VERSION) {
+        error = "unsupported save version " + std::to_string(version);
+        return false;
+    }
+    uint32_t count = static_cast<uint32_t>(GetFixed(header + 8, 4));
+    uint64_t indexOffset = GetFixed(header + 12, 8);
+    uint32_t indexCrc = static_cast<uint32_t>(GetFixed(header + 20, 4));
+
+    // Only the index is read; values stay on disk until asked for
+    std::vector<uint8_t> indexBytes;
+    uint8_t chunk[4096];
+    size_t read;
+    std::fseek(baseFile, static_cast<long>(indexOffset), SEEK_SET);
+    while ((read = std::fread(chunk, 1, sizeof(chunk), baseFile)) > 0) {
+        indexBytes.insert(indexBytes.end(), chunk, chunk + read);
+    }
+    if (Crc32(indexBytes.data(), indexBytes.size()) != indexCrc) {
+        error = path + " has a damaged index";
+        return false;
+    }
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (indexBytes.size() - offset < 2) {
+            error = path + " has a truncated index";
+            return false;
+        }
+        size_t keyLength = static_cast<size_t>(GetFixed(indexBytes.data() + offset, 2));
+        if (indexBytes.size() - offset < 2 + keyLength + 16) {
+            error = path + " has a truncated index";
+            return false;
+        }
+        std::string key(reinterpret_cast<const char*>(indexBytes.data() + offset + 2), keyLength);
+        const uint8_t* entry = indexBytes.data() + offset + 2 + keyLength;
+        index[key] = {Source::BASE, GetFixed(entry, 8), static_cast<uint32_t>(GetFixed(entry + 8, 4)),
+                      static_cast<uint32_t>(GetFixed(entry + 12, 4))};
+        offset += 2 + keyLength + 16;
+    }
+    baseBytes = indexOffset + indexBytes.size();
+    return true;
+}
+
+bool SaveStore::LoadJournal(std::string& error) {
+    std::vector<uint8_t> bytes;
+    if (!ReadFile(journalPath, bytes) || bytes.size() < JOURNAL_HEADER_SIZE ||
+        std::memcmp(bytes.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        // Missing, or cut short while being reset after a compaction; either
+        // way the base file holds everything
+        if (!ResetJournal()) {
+            error = "cannot create " + journalPath;
+            return false;
+        }
+        journalBytes = JOURNAL_HEADER_SIZE;
+        journalRead = std::fopen(journalPath.c_str(), "rb");
+        if (!journalRead) {
+            error = "cannot open " + journalPath;
+            return false;
+        }
+        return true;
+    }
+
+    // Replay in order; the first bad or incomplete record is where a write
+    // was interrupted, and nothing after it can be trusted
+    size_t offset = JOURNAL_HEADER_SIZE;
+    while (bytes.size() - offset >= RECORD_OVERHEAD) {
+        const uint8_t* record = bytes.data() + offset;
+        if (GetFixed(record, 4) != RECORD_MAGIC) {
+            break;
+        }
+        uint8_t op = record[4];
+        size_t keyLength = static_cast<size_t>(GetFixed(record + 5, 2));
+        uint32_t valueSize = static_cast<uint32_t>(GetFixed(record + 7, 4));
+        size_t body = 4 + 1 + 2 + 4 + keyLength + valueSize;
+        if (bytes.size() - offset < body + 4 ||
+            Crc32(record + 4, body - 4) != static_cast<uint32_t>(GetFixed(record + body, 4))) {
+            break;
+        }
+        std::string key(reinterpret_cast<const char*>(record + 11), keyLength);
+        if (op == OP_PUT) {
+            uint64_t valueOffset = offset + 11 + keyLength;
+            index[key] = {Source::JOURNAL, valueOffset, valueSize, Crc32(bytes.data() + valueOffset, valueSize)};
+        } else if (op == OP_ERASE) {
+            index.erase(key);
+        }
+        offset += body + 4;
+    }
+
+    if (offset < bytes.size()) {
+        ++stats.tornRecords;
+        std::cerr << "Save journal " << journalPath << ": dropping " << bytes.size() - offset
+                  << " bytes after an interrupted write" << std::endl;
+        std::error_code ec;
+        std::filesystem::resize_file(journalPath, offset, ec);
+        if (ec) {
+            error = "cannot repair " + journalPath + ": " + ec.message();
+            return false;
+        }
+    }
+    journalBytes = offset;
+    journalAppend = std::fopen(journalPath.c_str(), "ab");
+    journalRead = std::fopen(journalPath.c_str(), "rb");
+    if (!journalAppend || !journalRead) {
+        error = "cannot open " + journalPath;
+        return false;
+    }
+    return true;
+}
+
+bool SaveStore::ResetJournal() {
+    if (journalAppend) {
+        std::fclose(journalAppend);
+        journalAppend = nullptr;
+    }
+    std::vector<uint8_t> header(JOURNAL_MAGIC, JOURNAL_MAGIC + sizeof(JOURNAL_MAGIC));
+    PutFixed(header, FORMAT_VERSION, 2);
+    PutFixed(header, 0, 2);
+    std::FILE* file = std::fopen(journalPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size() && SyncFile(file);
+    std::fclose(file);
+    journalAppend = std::fopen(journalPath.c_str(), "ab");
+    return ok && journalAppend;
+}
+
+bool SaveStore::ReadValue(const Location& location, std::vector<uint8_t>& value) {
+    ++stats.valuesRead;
+    return ReadAt(location.source == Source::BASE ? baseFile : journalRead, location, value);
+}
+
+bool SaveStore::ReadAt(std::FILE* file, const Location& location, std::vector<uint8_t>& value) {
+    value.resize(location.size);
+    if (!file || std::fseek(file, static_cast<long>(location.offset), SEEK_SET) != 0 ||
+        std::fread(value.data(), 1, location.size, file) != location.size) {
+        return false;
+    }
+    return Crc32(value.data(), value.size()) == location.crc;
+}
+
+void SaveStore::Put(const std::string& key, std::vector<uint8_t> value) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [entry, inserted] = pending.try_emplace(key);
+        stats.writesCoalesced += inserted ? 0 : 1;
+        entry->second.erase = false;
+        entry->second.value = std::move(value);
+        entry->second.sequence = nextSequence++;
+        writeFailed = false;
+    }
+    wake.notify_one();
+}
+
+void SaveStore::Erase(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [entry, inserted] = pending.try_emplace(key);
+        stats.writesCoalesced += inserted ? 0 : 1;
+        entry->second.erase = true;
+        entry->second.value.clear();
+        entry->second.sequence = nextSequence++;
+        writeFailed = false;
+    }
+    wake.notify_one();
+}
+
+bool SaveStore::Get(const std::string& key, std::vector<uint8_t>& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto* queue : {&pending, &inFlight}) {
+        auto found = queue->find(key);
+        if (found != queue->end()) {
+            if (found->second.erase) {
+                return false;
+            }
+            value = found->second.value;
+            return true;
+        }
+    }
+    auto found = index.find(key);
+    if (found == index.end()) {
+        return false;
+    }
+    if (!ReadValue(found->second, value)) {
+        std::cerr << "Save record " << key << " in " << path << " is damaged" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SaveStore::Contains(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto* queue : {&pending, &inFlight}) {
+        auto found = queue->find(key);
+        if (found != queue->end()) {
+            return !found->second.erase;
+        }
+    }
+    return index.count(key) != 0;
+}
+
+std::vector<std::string> SaveStore::GetKeys(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::set<std::string> keys;
+    for (auto it = index.lower_bound(prefix); it != index.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        keys.insert(it->first);
+    }
+    // Newer changes win: inFlight was queued before pending
+    for (const auto* queue : {&inFlight, &pending}) {
+        for (auto it = queue->lower_bound(prefix); it != queue->end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (it->second.erase) {
+                keys.erase(it->first);
+            } else {
+                keys.insert(it->first);
+            }
+        }
+    }
+    return std::vector<std::string>(keys.begin(), keys.end());
+}
+
+bool SaveStore::Flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!worker.joinable()) {
+        return pending.empty();
+    }
+    uint64_t target = nextSequence - 1;
+    wake.notify_one();
+    flushed.wait(lock, [this, target] { return writtenSequence >= target || writeFailed; });
+    return writtenSequence >= target;
+}
+
+void SaveStore::RequestCompaction() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        compactionRequested = true;
+    }
+    wake.notify_one();
+}
+
+SaveStore::Stats SaveStore::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats current = stats;
+    current.journalBytes = journalBytes;
+    current.baseBytes = baseBytes;
+    return current;
+}
+
+void SaveStore::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || compactionRequested || (!pending.empty() && !writeFailed); });
+        if (!pending.empty()) {
+            inFlight.swap(pending);
+            uint64_t batchSequence = nextSequence - 1;
+            uint64_t startOffset = journalBytes;
+            lock.unlock();
+
+            std::map<std::string, Location> written;
+            uint64_t bytes = 0;
+            bool ok = WriteBatch(inFlight, startOffset, written, bytes);
+
+            lock.lock();
+            if (ok) {
+                for (const auto& [key, change] : inFlight) {
+                    if (change.erase) {
+                        index.erase(key);
+                    } else {
+                        index[key] = written[key];
+                    }
+                }
+                journalBytes += bytes;
+                stats.recordsWritten += inFlight.size();
+                writtenSequence = batchSequence;
+                inFlight.clear();
+            } else {
+                std::cerr << "Cannot write save journal " << journalPath << std::endl;
+                // Keep the changes for the next attempt unless newer ones replaced them
+                for (auto& [key, change] : inFlight) {
+                    pending.try_emplace(key, std::move(change));
+                }
+                inFlight.clear();
+                writeFailed = true;
+            }
+        }
+
+        bool journalTooBig = journalBytes > compactionThreshold && journalBytes > baseBytes;
+        if (!writeFailed && (compactionRequested || journalTooBig)) {
+            compactionRequested = false;
+            if (!Compact(lock)) {
+                std::cerr << "Cannot compact save file " << path << std::endl;
+            }
+        }
+        flushed.notify_all();
+        if (stopping && (pending.empty() || writeFailed)) {
+            break;
+        }
+    }
+}
+
+bool SaveStore::WriteBatch(const std::map<std::string, Pending>& batch, uint64_t startOffset,
+                           std::map<std::string, Location>& written, uint64_t& bytes) {
+    // One write and one sync for the whole batch
+    std::vector<uint8_t> buffer;
+    for (const auto& [key, change] : batch) {
+        size_t recordStart = buffer.size();
+        PutFixed(buffer, RECORD_MAGIC, 4);
+        buffer.push_back(change.erase ? OP_ERASE : OP_PUT);
+        PutFixed(buffer, key.size(), 2);
+        PutFixed(buffer, change.value.size(), 4);
+        buffer.insert(buffer.end(), key.begin(), key.end());
+        size_t valueStart = buffer.size();
+        buffer.insert(buffer.end(), change.value.begin(), change.value.end());
+        PutFixed(buffer, Crc32(buffer.data() + recordStart + 4, buffer.size() - recordStart - 4), 4);
+        if (!change.erase) {
+            written[key] = {Source::JOURNAL, startOffset + valueStart, static_cast<uint32_t>(change.value.size()),
+                            Crc32(change.value.data(), change.value.size())};
+        }
+    }
+    bytes = buffer.size();
+    return journalAppend && std::fwrite(buffer.data(), 1, buffer.size(), journalAppend) == buffer.size() &&
+           SyncFile(journalAppend);
+}
+
+bool SaveStore::Compact(std::unique_lock<std::mutex>& lock) {
+    // Only the worker changes the index and the files, so a copy of the index
+    // stays true while the new base is written without the lock. Compaction
+    // reads through its own handles; Get keeps using the shared ones.
+    std::map<std::string, Location> current = index;
+    lock.unlock();
+
+    std::string tempPath = path + ".tmp";
+    std::FILE* baseIn = std::fopen(path.c_str(), "rb");
+    std::FILE* journalIn = std::fopen(journalPath.c_str(), "rb");
+    std::FILE* out = std::fopen(tempPath.c_str(), "wb");
+    bool ok = out && journalIn;
+
+    std::vector<uint8_t> header(BASE_HEADER_SIZE, 0);
+    ok = ok && std::fwrite(header.data(), 1, header.size(), out) == header.size();
+    std::map<std::string, Location> compacted;
+    std::vector<uint8_t> indexBytes;
+    std::vector<uint8_t> value;
+    uint64_t offset = BASE_HEADER_SIZE;
+    uint64_t dropped = 0;
+    for (const auto& [key, location] : current) {
+        if (!ok) {
+            break;
+        }
+        // Get already reports a damaged value as missing; leaving it out
+        // keeps it from failing every compaction after this one
+        if (!ReadAt(location.source == Source::BASE ? baseIn : journalIn, location, value)) {
+            std::cerr << "Save record " << key << " in " << path << " is damaged, dropping it" << std::endl;
+            ++dropped;
+            continue;
+        }
+        ok = std::fwrite(value.data(), 1, value.size(), out) == value.size();
+        compacted[key] = {Source::BASE, offset, location.size, location.crc};
+        PutFixed(indexBytes, key.size(), 2);
+        indexBytes.insert(indexBytes.end(), key.begin(), key.end());
+        PutFixed(indexBytes, offset, 8);
+        PutFixed(indexBytes, location.size, 4);
+        PutFixed(indexBytes, location.crc, 4);
+        offset += value.size();
+    }
+    ok = ok && std::fwrite(indexBytes.data(), 1, indexBytes.size(), out) == indexBytes.size();
+
+    header.assign(BASE_MAGIC, BASE_MAGIC + sizeof(BASE_MAGIC));
+    PutFixed(header, FORMAT_VERSION, 2);
+    PutFixed(header, 0, 2);
+    PutFixed(header, compacted.size(), 4);
+    PutFixed(header, offset, 8);
+    PutFixed(header, Crc32(indexBytes.data(), indexBytes.size()), 4);
+    ok = ok && std::fseek(out, 0, SEEK_SET) == 0 && std::fwrite(header.data(), 1, header.size(), out) == header.size();
+    ok = ok && SyncFile(out);
+    for (std::FILE* file : {baseIn, journalIn, out}) {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        lock.lock();
+        return false;
+    }
+
+    // The rename is the commit point. Windows cannot rename over an open
+    // file, so the old base is closed first, under the lock.
+    lock.lock();
+    if (baseFile) {
+        std::fclose(baseFile);
+        baseFile = nullptr;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    baseFile = std::fopen(path.c_str(), "rb");
+    if (ec || !baseFile) {
+        return false;
+    }
+    index = std::move(compacted);
+    baseBytes = offset + indexBytes.size();
+    ++stats.compactions;
+    stats.valuesDropped += dropped;
+    // Nothing points into the journal any more
+    if (journalRead) {
+        std::fclose(journalRead);
+        journalRead = nullptr;
+    }
+    lock.unlock();
+
+    // The journal may only be emptied once the rename is on disk
+    SyncDirectory(path);
+    bool reset = ResetJournal();
+    std::FILE* reader = std::fopen(journalPath.c_str(), "rb");
+
+    lock.lock();
+    journalRead = reader;
+    if (reset) {
+        journalBytes = JOURNAL_HEADER_SIZE;
+    }
+    return reset && reader;
+}
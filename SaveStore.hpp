@@ -0,0 +1,176 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Little-endian record encoding shared by everything stored in a SaveStore
+class SaveWriter {
+public:
+    explicit SaveWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void U8(uint8_t value) { out.push_back(value); }
+    void Bool(bool value) { out.push_back(value ? 1 : 0); }
+    void U32(uint32_t value) { Fixed(value, 4); }
+    void I32(int32_t value) { Fixed(static_cast<uint32_t>(value), 4); }
+    void F32(float value);
+    void Varint(uint64_t value);
+    void String(const std::string& text);
+    void Strings(const std::vector<std::string>& texts);
+
+private:
+    void Fixed(uint64_t value, int bytes);
+
+    std::vector<uint8_t>& out;
+};
+
+// Bounds-checked reader; any overrun latches the failed flag
+class SaveReader {
+public:
+    SaveReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+    explicit SaveReader(const std::vector<uint8_t>& bytes) : SaveReader(bytes.data(), bytes.size()) {}
+
+    uint8_t U8() { return static_cast<uint8_t>(Fixed(1)); }
+    bool Bool() { return Fixed(1) != 0; }
+    uint32_t U32() { return static_cast<uint32_t>(Fixed(4)); }
+    int32_t I32() { return static_cast<int32_t>(Fixed(4)); }
+    float F32();
+    uint64_t Varint();
+    std::string String();
+    std::vector<std::string> Strings();
+    // Guards count fields so a corrupt record cannot trigger a huge allocation
+    bool Plausible(uint64_t count) {
+        failed = failed || count > size - offset;
+        return !failed;
+    }
+    bool Failed() const { return failed; }
+
+private:
+    uint64_t Fixed(int bytes);
+
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+};
+
+// Crash-safe key/value store for save data: a compacted base file plus an
+// append-only journal next to it (path + ".journal").
+//
+// Put and Erase only queue the change; a worker thread appends queued
+// changes to the journal and syncs it, so callers never wait on the disk.
+// Several changes to a key before the worker gets to it become one write.
+// Every journal record carries a CRC, so a write torn by a crash or power
+// loss is detected on the next Open and cut off; the changes before it
+// survive.
+//
+// When the journal outgrows the base file, the worker writes a fresh base
+// to a temporary file, syncs it and renames it over the old one, then
+// empties the journal. A crash in between leaves either the old base or the
+// new one, and replaying the journal onto either gives the same result.
+// Readers only wait for the rename; values that fail their CRC are left
+// out of the new base.
+//
+// Open only reads the base file's index and scans the journal; values are
+// read from disk the first time they are asked for.
+class SaveStore {
+public:
+    static constexpr uint16_t FORMAT_VERSION = 1;
+
+    struct Stats {
+        uint64_t journalBytes = 0;
+        uint64_t baseBytes = 0;
+        uint64_t recordsWritten = 0;
+        uint64_t writesCoalesced = 0;
+        uint64_t compactions = 0;
+        uint64_t tornRecords = 0;   // cut off the journal by Open
+        uint64_t valuesRead = 0;    // lazy reads from disk
+        uint64_t valuesDropped = 0; // damaged, left out by compaction
+    };
+
+    SaveStore() = default;
+    ~SaveStore();
+    SaveStore(const SaveStore&) = delete;
+    SaveStore& operator=(const SaveStore&) = delete;
+
+    // Creates the files if they do not exist yet
+    bool Open(const std::string& path, std::string& error);
+    // Writes everything queued, then stops the worker
+    void Close();
+    bool IsOpen() const { return worker.joinable(); }
+
+    void Put(const std::string& key, std::vector<uint8_t> value);
+    void Erase(const std::string& key);
+    // Latest value, including changes not on disk yet
+    bool Get(const std::string& key, std::vector<uint8_t>& value);
+    bool Contains(const std::string& key);
+    std::vector<std::string> GetKeys(const std::string& prefix);
+
+    // Blocks until every change queued so far is on disk; false if a write
+    // failed (the changes stay queued and are retried on the next change)
+    bool Flush();
+    // Compacts on the next write even if the journal is still small
+    void RequestCompaction();
+
+    // Journal size that triggers compaction, if it also exceeds the base
+    void SetCompactionThreshold(uint64_t bytes) { compactionThreshold = bytes; }
+    Stats GetStats();
+
+private:
+    enum class Source : uint8_t {
+        BASE,
+        JOURNAL
+    };
+    struct Location {
+        Source source;
+        uint64_t offset;
+        uint32_t size;
+        uint32_t crc;
+    };
+    struct Pending {
+        bool erase = false;
+        std::vector<uint8_t> value;
+        uint64_t sequence = 0;
+    };
+
+    bool LoadBase(std::string& error);
+    bool LoadJournal(std::string& error);
+    bool ResetJournal();
+    bool ReadValue(const Location& location, std::vector<uint8_t>& value);
+    static bool ReadAt(std::FILE* file, const Location& location, std::vector<uint8_t>& value);
+    void WorkerLoop();
+    // Appends and syncs a batch; fills in where each value landed
+    bool WriteBatch(const std::map<std::string, Pending>& batch, uint64_t startOffset,
+                    std::map<std::string, Location>& written, uint64_t& bytes);
+    // Called and returns with the lock held; drops it for the file work
+    bool Compact(std::unique_lock<std::mutex>& lock);
+
+    std::string path;
+    std::string journalPath;
+    std::FILE* baseFile = nullptr;      // read only, replaced by compaction
+    std::FILE* journalAppend = nullptr; // written only by the worker
+    std::FILE* journalRead = nullptr;   // lazy reads, under the mutex
+    uint64_t baseBytes = 0;
+    uint64_t journalBytes = 0;
+    uint64_t compactionThreshold = 64 * 1024;
+    bool compactionRequested = false;
+
+    // Guards everything here except journalAppend; the worker drops it while
+    // it writes a batch or a new base file
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::map<std::string, Location> index;
+    std::map<std::string, Pending> pending;
+    std::map<std::string, Pending> inFlight; // taken by the worker, not on disk yet
+    uint64_t nextSequence = 1;
+    uint64_t writtenSequence = 0;
+    bool stopping = false;
+    bool writeFailed = false;
+    Stats stats;
+    std::thread worker;
+};
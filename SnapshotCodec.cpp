@@ -0,0 +1,361 @@
+#include "SnapshotCodec.hpp"
+#include <cmath>
+
+namespace {
+
+enum class FieldKind : uint8_t {
+    LINEAR, // fixed point, delta coded
+    ANGLE,  // fixed point turn, delta wraps around
+    BITS    // flags or input mask, sent raw when changed
+};
+
+const FieldKind BIKE_FIELDS[QuantizedSnapshot::BIKE_FIELD_COUNT] = {
+    FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR,
+    FieldKind::ANGLE, FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR,
+    FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR,
+    FieldKind::LINEAR, FieldKind::BITS, FieldKind::BITS
+};
+const FieldKind POWER_UP_FIELDS[QuantizedSnapshot::POWER_UP_FIELD_COUNT] = {
+    FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR,
+    FieldKind::LINEAR, FieldKind::BITS
+};
+const FieldKind DEFORMATION_FIELDS[QuantizedSnapshot::DEFORMATION_FIELD_COUNT] = {
+    FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR
+};
+const FieldKind OIL_SLICK_FIELDS[QuantizedSnapshot::OIL_SLICK_FIELD_COUNT] = {
+    FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR, FieldKind::LINEAR
+};
+
+const int BITS_FIELD_WIDTH = 16;
+const float TWO_PI = 6.28318531f;
+
+const uint32_t BIKE_HAS_POWER_UP = 1 << 0;
+const uint32_t BIKE_GROUNDED = 1 << 1;
+const uint32_t BIKE_STUNNED = 1 << 2;
+const uint32_t BIKE_SHIELD = 1 << 3;
+const uint32_t BIKE_NITRO = 1 << 4;
+const uint32_t BIKE_USE_HELD = 1 << 5;
+// PowerUpType of the held power-up in bits 8-10
+const int BIKE_HELD_SHIFT = 8;
+const uint32_t BIKE_HELD_MASK = 7;
+const uint32_t POWER_UP_COLLECTED = 1 << 0;
+const uint32_t POWER_UP_EFFECT_ACTIVE = 1 << 1;
+
+uint32_t ZigZag(uint32_t delta) {
+    int32_t value = static_cast<int32_t>(delta);
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+uint32_t UnZigZag(uint32_t value) {
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+// 0 -> "0"; otherwise "1", 5 bits of (bit length - 1), then the value
+// without its top bit, which is always set
+void WriteVarBits(BitWriter& writer, uint32_t value) {
+    if (value == 0) {
+        writer.Write(0, 1);
+        return;
+    }
+    // Bit length by halving, instead of a loop over all 32 bits
+    int length = 1;
+    for (uint32_t rest = value, shift = 16; shift > 0; shift >>= 1) {
+        if (rest >> shift) {
+            rest >>= shift;
+            length += static_cast<int>(shift);
+        }
+    }
+    writer.Write(1, 1);
+    writer.Write(static_cast<uint32_t>(length - 1), 5);
+    if (length > 1) {
+        writer.Write(value, length - 1);
+    }
+}
+
+uint32_t ReadVarBits(BitReader& reader) {
+    if (!reader.ReadBool()) {
+        return 0;
+    }
+    int length = static_cast<int>(reader.Read(5)) + 1;
+    uint32_t value = 1u << (length - 1);
+    if (length > 1) {
+        value |= reader.Read(length - 1);
+    }
+    return value;
+}
+
+template <size_t N>
+void EncodeEntities(BitWriter& writer, const std::vector<std::array<int32_t, N>>& items,
+                    const std::vector<std::array<int32_t, N>>* baseline, const FieldKind (&kinds)[N],
+                    uint32_t angleMask) {
+    static const std::array<int32_t, N> zero{};
+    WriteVarBits(writer, static_cast<uint32_t>(items.size()));
+    for (size_t i = 0; i < items.size(); ++i) {
+        const std::array<int32_t, N>& base = baseline && i < baseline->size() ? (*baseline)[i] : zero;
+        const std::array<int32_t, N>& item = items[i];
+        bool changed = item != base;
+        writer.WriteBool(changed);
+        if (!changed) {
+            continue;
+        }
+        for (size_t f = 0; f < N; ++f) {
+            uint32_t delta = static_cast<uint32_t>(item[f]) - static_cast<uint32_t>(base[f]);
+            switch (kinds[f]) {
+            case FieldKind::LINEAR:
+                WriteVarBits(writer, ZigZag(delta));
+                break;
+            case FieldKind::ANGLE: {
+                // Shortest way round: sign-extend the wrapped difference
+                delta &= angleMask;
+                if (delta > (angleMask >> 1)) {
+                    delta |= ~angleMask;
+                }
+                WriteVarBits(writer, ZigZag(delta));
+                break;
+            }
+            case FieldKind::BITS:
+                writer.WriteBool(delta != 0);
+                if (delta != 0) {
+                    writer.Write(static_cast<uint32_t>(item[f]), BITS_FIELD_WIDTH);
+                }
+                break;
+            }
+        }
+    }
+}
+
+template <size_t N>
+bool DecodeEntities(BitReader& reader, std::vector<std::array<int32_t, N>>& items,
+                    const std::vector<std::array<int32_t, N>>* baseline, const FieldKind (&kinds)[N],
+                    uint32_t angleMask, size_t maxCount) {
+    static const std::array<int32_t, N> zero{};
+    uint32_t count = ReadVarBits(reader);
+    // A corrupt count must not turn into a huge allocation
+    if (count > maxCount) {
+        return false;
+    }
+    items.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const std::array<int32_t, N>& base = baseline && i < baseline->size() ? (*baseline)[i] : zero;
+        std::array<int32_t, N>& item = items[i];
+        if (!reader.ReadBool()) {
+            item = base;
+            continue;
+        }
+        for (size_t f = 0; f < N; ++f) {
+            switch (kinds[f]) {
+            case FieldKind::LINEAR:
+                item[f] = static_cast<int32_t>(static_cast<uint32_t>(base[f]) + UnZigZag(ReadVarBits(reader)));
+                break;
+            case FieldKind::ANGLE:
+                item[f] = static_cast<int32_t>((static_cast<uint32_t>(base[f]) + UnZigZag(ReadVarBits(reader))) & angleMask);
+                break;
+            case FieldKind::BITS:
+                item[f] = reader.ReadBool() ? static_cast<int32_t>(reader.Read(BITS_FIELD_WIDTH)) : base[f];
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+SnapshotCodec::SnapshotCodec(const SnapshotPrecision& precision) : precision(precision) {
+    if (this->precision.rotationBits < 1 || this->precision.rotationBits > 31) {
+        this->precision.rotationBits = 14;
+    }
+}
+
+int32_t SnapshotCodec::ToFixed(float value, float step) const {
+    return static_cast<int32_t>(std::lround(value / step));
+}
+
+uint32_t SnapshotCodec::AngleToFixed(float angle) const {
+    float turns = angle / TWO_PI;
+    turns -= std::floor(turns);
+    uint32_t steps = 1u << precision.rotationBits;
+    return static_cast<uint32_t>(std::lround(turns * steps)) & (steps - 1);
+}
+
+float SnapshotCodec::AngleFromFixed(int32_t value) const {
+    return static_cast<float>(value) * (TWO_PI / static_cast<float>(1u << precision.rotationBits));
+}
+
+void SnapshotCodec::Quantize(const Game::Snapshot& snapshot, QuantizedSnapshot& out) const {
+    out.tick = static_cast<uint32_t>(snapshot.tick);
+
+    size_t count = snapshot.bikes.size();
+    out.bikes.resize(count);
+    if (snapshot.bikeStates.size() != count * BikeStateStore::SAVED_FIELD_COUNT) {
+        out.bikes.clear();
+        count = 0;
+    }
+    auto field = [&](BikeStateStore::SavedField f, size_t i) { return snapshot.bikeStates[f * count + i]; };
+    for (size_t i = 0; i < count; ++i) {
+        const Bike::SimState& sim = snapshot.bikes[i];
+        QuantizedSnapshot::Bike& bike = out.bikes[i];
+        bike[QuantizedSnapshot::BIKE_X] = ToFixed(field(BikeStateStore::SAVED_POSITION_X, i), precision.positionStep);
+        bike[QuantizedSnapshot::BIKE_Y] = ToFixed(field(BikeStateStore::SAVED_POSITION_Y, i), precision.positionStep);
+        bike[QuantizedSnapshot::BIKE_VELOCITY_X] = ToFixed(field(BikeStateStore::SAVED_VELOCITY_X, i), precision.velocityStep);
+        bike[QuantizedSnapshot::BIKE_VELOCITY_Y] = ToFixed(field(BikeStateStore::SAVED_VELOCITY_Y, i), precision.velocityStep);
+        bike[QuantizedSnapshot::BIKE_ROTATION] = static_cast<int32_t>(AngleToFixed(field(BikeStateStore::SAVED_ROTATION, i)));
+        bike[QuantizedSnapshot::BIKE_SUSPENSION] = ToFixed(field(BikeStateStore::SAVED_SUSPENSION, i), precision.scalarStep);
+        bike[QuantizedSnapshot::BIKE_HEALTH] = ToFixed(sim.health, precision.scalarStep);
+        bike[QuantizedSnapshot::BIKE_NITRO_FUEL] = ToFixed(sim.nitroFuel, precision.scalarStep);
+        bike[QuantizedSnapshot::BIKE_STUN_DURATION] = ToFixed(sim.stunDuration, precision.scalarStep);
+        bike[QuantizedSnapshot::BIKE_POWER_UP_DURATION] = ToFixed(sim.powerUpDuration, precision.scalarStep);
+        bike[QuantizedSnapshot::BIKE_AIR_TIME] = ToFixed(sim.airTime, precision.scalarStep);
+        bike[QuantizedSnapshot::BIKE_LAP] = sim.currentLap;
+        bike[QuantizedSnapshot::BIKE_CHECKPOINTS] = sim.checkpointsPassed;
+        bike[QuantizedSnapshot::BIKE_INPUT] = sim.input;
+        bike[QuantizedSnapshot::BIKE_FLAGS] = static_cast<int32_t>(
+            (sim.hasPowerUp ? BIKE_HAS_POWER_UP : 0u) | (sim.isGrounded ? BIKE_GROUNDED : 0u) |
+            (sim.isStunned ? BIKE_STUNNED : 0u) | (sim.hasShield ? BIKE_SHIELD : 0u) | (sim.hasNitro ? BIKE_NITRO : 0u) |
+            (sim.useHeld ? BIKE_USE_HELD : 0u) | (static_cast<uint32_t>(sim.heldPowerUp) << BIKE_HELD_SHIFT));
+    }
+
+    out.powerUps.resize(snapshot.powerUps.size());
+    for (size_t i = 0; i < snapshot.powerUps.size(); ++i) {
+        const PowerUp::SimState& sim = snapshot.powerUps[i];
+        QuantizedSnapshot::PowerUp& powerUp = out.powerUps[i];
+        powerUp[QuantizedSnapshot::POWER_UP_X] = ToFixed(sim.position.x, precision.positionStep);
+        powerUp[QuantizedSnapshot::POWER_UP_Y] = ToFixed(sim.position.y, precision.positionStep);
+        powerUp[QuantizedSnapshot::POWER_UP_BASE_Y] = ToFixed(sim.baseY, precision.positionStep);
+        powerUp[QuantizedSnapshot::POWER_UP_ROTATION] = ToFixed(sim.rotationAngle, precision.scalarStep);
+        powerUp[QuantizedSnapshot::POWER_UP_REMAINING] = ToFixed(sim.remainingDuration, precision.scalarStep);
+        powerUp[QuantizedSnapshot::POWER_UP_FLAGS] = static_cast<int32_t>(
+            (sim.collected ? POWER_UP_COLLECTED : 0u) | (sim.effectActive ? POWER_UP_EFFECT_ACTIVE : 0u));
+    }
+
+    const auto& deformations = snapshot.track.deformations;
+    out.deformations.resize(deformations.size());
+    for (size_t i = 0; i < deformations.size(); ++i) {
+        QuantizedSnapshot::Deformation& deformation = out.deformations[i];
+        deformation[QuantizedSnapshot::DEFORMATION_X] = ToFixed(deformations[i].point.x, precision.positionStep);
+        deformation[QuantizedSnapshot::DEFORMATION_Y] = ToFixed(deformations[i].point.y, precision.positionStep);
+        deformation[QuantizedSnapshot::DEFORMATION_RADIUS] = ToFixed(deformations[i].radius, precision.positionStep);
+        deformation[QuantizedSnapshot::DEFORMATION_INTENSITY] = ToFixed(deformations[i].intensity, precision.scalarStep);
+    }
+
+    const auto& oilSlicks = snapshot.track.oilSlicks;
+    out.oilSlicks.resize(oilSlicks.size());
+    for (size_t i = 0; i < oilSlicks.size(); ++i) {
+        QuantizedSnapshot::OilSlick& slick = out.oilSlicks[i];
+        slick[QuantizedSnapshot::OIL_SLICK_X] = ToFixed(oilSlicks[i].position.x, precision.positionStep);
+        slick[QuantizedSnapshot::OIL_SLICK_Y] = ToFixed(oilSlicks[i].position.y, precision.positionStep);
+        slick[QuantizedSnapshot::OIL_SLICK_RADIUS] = ToFixed(oilSlicks[i].radius, precision.positionStep);
+        slick[QuantizedSnapshot::OIL_SLICK_REMAINING] = ToFixed(oilSlicks[i].remaining, precision.scalarStep);
+    }
+}
+
+void SnapshotCodec::Dequantize(const QuantizedSnapshot& in, Game::Snapshot& out) const {
+    out.tick = in.tick;
+    out.hash = 0; // the exact state is gone; hashes only hold for full-precision snapshots
+
+    size_t count = in.bikes.size();
+    out.bikes.resize(count);
+    out.bikeStates.resize(count * BikeStateStore::SAVED_FIELD_COUNT);
+    auto field = [&](BikeStateStore::SavedField f, size_t i) -> float& { return out.bikeStates[f * count + i]; };
+    for (size_t i = 0; i < count; ++i) {
+        const QuantizedSnapshot::Bike& bike = in.bikes[i];
+        Bike::SimState& sim = out.bikes[i];
+        field(BikeStateStore::SAVED_POSITION_X, i) = bike[QuantizedSnapshot::BIKE_X] * precision.positionStep;
+        field(BikeStateStore::SAVED_POSITION_Y, i) = bike[QuantizedSnapshot::BIKE_Y] * precision.positionStep;
+        field(BikeStateStore::SAVED_VELOCITY_X, i) = bike[QuantizedSnapshot::BIKE_VELOCITY_X] * precision.velocityStep;
+        field(BikeStateStore::SAVED_VELOCITY_Y, i) = bike[QuantizedSnapshot::BIKE_VELOCITY_Y] * precision.velocityStep;
+        field(BikeStateStore::SAVED_ROTATION, i) = AngleFromFixed(bike[QuantizedSnapshot::BIKE_ROTATION]);
+        field(BikeStateStore::SAVED_SUSPENSION, i) = bike[QuantizedSnapshot::BIKE_SUSPENSION] * precision.scalarStep;
+        sim.health = bike[QuantizedSnapshot::BIKE_HEALTH] * precision.scalarStep;
+        sim.nitroFuel = bike[QuantizedSnapshot::BIKE_NITRO_FUEL] * precision.scalarStep;
+        sim.stunDuration = bike[QuantizedSnapshot::BIKE_STUN_DURATION] * precision.scalarStep;
+        sim.powerUpDuration = bike[QuantizedSnapshot::BIKE_POWER_UP_DURATION] * precision.scalarStep;
+        sim.airTime = bike[QuantizedSnapshot::BIKE_AIR_TIME] * precision.scalarStep;
+        sim.currentLap = bike[QuantizedSnapshot::BIKE_LAP];
+        sim.checkpointsPassed = bike[QuantizedSnapshot::BIKE_CHECKPOINTS];
+        sim.input = static_cast<BikeInputMask>(bike[QuantizedSnapshot::BIKE_INPUT]);
+        uint32_t flags = static_cast<uint32_t>(bike[QuantizedSnapshot::BIKE_FLAGS]);
+        sim.hasPowerUp = (flags & BIKE_HAS_POWER_UP) != 0;
+        sim.isGrounded = (flags & BIKE_GROUNDED) != 0;
+        sim.isStunned = (flags & BIKE_STUNNED) != 0;
+        sim.hasShield = (flags & BIKE_SHIELD) != 0;
+        sim.hasNitro = (flags & BIKE_NITRO) != 0;
+        sim.useHeld = (flags & BIKE_USE_HELD) != 0;
+        sim.heldPowerUp = static_cast<PowerUpType>((flags >> BIKE_HELD_SHIFT) & BIKE_HELD_MASK);
+    }
+
+    out.powerUps.resize(in.powerUps.size());
+    for (size_t i = 0; i < in.powerUps.size(); ++i) {
+        const QuantizedSnapshot::PowerUp& powerUp = in.powerUps[i];
+        PowerUp::SimState& sim = out.powerUps[i];
+        sim.position = Vector2D(powerUp[QuantizedSnapshot::POWER_UP_X] * precision.positionStep,
+                                powerUp[QuantizedSnapshot::POWER_UP_Y] * precision.positionStep);
+        sim.baseY = powerUp[QuantizedSnapshot::POWER_UP_BASE_Y] * precision.positionStep;
+        sim.rotationAngle = powerUp[QuantizedSnapshot::POWER_UP_ROTATION] * precision.scalarStep;
+        sim.remainingDuration = powerUp[QuantizedSnapshot::POWER_UP_REMAINING] * precision.scalarStep;
+        uint32_t flags = static_cast<uint32_t>(powerUp[QuantizedSnapshot::POWER_UP_FLAGS]);
+        sim.collected = (flags & POWER_UP_COLLECTED) != 0;
+        sim.effectActive = (flags & POWER_UP_EFFECT_ACTIVE) != 0;
+    }
+
+    auto& deformations = out.track.deformations;
+    deformations.resize(in.deformations.size());
+    for (size_t i = 0; i < in.deformations.size(); ++i) {
+        const QuantizedSnapshot::Deformation& deformation = in.deformations[i];
+        deformations[i].point = Vector2D(deformation[QuantizedSnapshot::DEFORMATION_X] * precision.positionStep,
+                                         deformation[QuantizedSnapshot::DEFORMATION_Y] * precision.positionStep);
+        deformations[i].radius = deformation[QuantizedSnapshot::DEFORMATION_RADIUS] * precision.positionStep;
+        deformations[i].intensity = deformation[QuantizedSnapshot::DEFORMATION_INTENSITY] * precision.scalarStep;
+    }
+
+    auto& oilSlicks = out.track.oilSlicks;
+    oilSlicks.resize(in.oilSlicks.size());
+    for (size_t i = 0; i < in.oilSlicks.size(); ++i) {
+        const QuantizedSnapshot::OilSlick& slick = in.oilSlicks[i];
+        oilSlicks[i].position = Vector2D(slick[QuantizedSnapshot::OIL_SLICK_X] * precision.positionStep,
+                                         slick[QuantizedSnapshot::OIL_SLICK_Y] * precision.positionStep);
+        oilSlicks[i].radius = slick[QuantizedSnapshot::OIL_SLICK_RADIUS] * precision.positionStep;
+        oilSlicks[i].remaining = slick[QuantizedSnapshot::OIL_SLICK_REMAINING] * precision.scalarStep;
+    }
+}
+
+size_t SnapshotCodec::Encode(const QuantizedSnapshot& state, const QuantizedSnapshot* baseline,
+                             uint8_t* buffer, size_t capacity) const {
+    uint32_t angleMask = (1u << precision.rotationBits) - 1;
+    BitWriter writer(buffer, capacity);
+    writer.Write(state.tick, 32);
+    writer.WriteBool(baseline != nullptr);
+    if (baseline) {
+        writer.Write(baseline->tick, 32);
+    }
+    EncodeEntities(writer, state.bikes, baseline ? &baseline->bikes : nullptr, BIKE_FIELDS, angleMask);
+    EncodeEntities(writer, state.powerUps, baseline ? &baseline->powerUps : nullptr, POWER_UP_FIELDS, angleMask);
+    EncodeEntities(writer, state.deformations, baseline ? &baseline->deformations : nullptr, DEFORMATION_FIELDS, angleMask);
+    EncodeEntities(writer, state.oilSlicks, baseline ? &baseline->oilSlicks : nullptr, OIL_SLICK_FIELDS, angleMask);
+    return writer.Finish();
+}
+
+bool SnapshotCodec::Decode(const uint8_t* data, size_t size, const SnapshotHistory* baselines,
+                           QuantizedSnapshot& out) const {
+    uint32_t angleMask = (1u << precision.rotationBits) - 1;
+    BitReader reader(data, size);
+    uint32_t tick = reader.Read(32);
+    const QuantizedSnapshot* baseline = nullptr;
+    if (reader.ReadBool()) {
+        uint32_t baselineTick = reader.Read(32);
+        baseline = baselines ? baselines->Find(baselineTick) : nullptr;
+        if (!baseline || reader.Overran()) {
+            return false;
+        }
+    }
+    // Every entity takes at least one bit, which bounds any honest count
+    size_t maxCount = size * 8;
+    if (!DecodeEntities(reader, out.bikes, baseline ? &baseline->bikes : nullptr, BIKE_FIELDS, angleMask, maxCount) ||
+        !DecodeEntities(reader, out.powerUps, baseline ? &baseline->powerUps : nullptr, POWER_UP_FIELDS, angleMask, maxCount) ||
+        !DecodeEntities(reader, out.deformations, baseline ? &baseline->deformations : nullptr, DEFORMATION_FIELDS, angleMask, maxCount) ||
+        !DecodeEntities(reader, out.oilSlicks, baseline ? &baseline->oilSlicks : nullptr, OIL_SLICK_FIELDS, angleMask, maxCount)) {
+        return false;
+    }
+    out.tick = tick;
+    return !reader.Overran();
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Game.hpp"
+
+// Writes bit fields straight into a caller's buffer, least significant bit
+// first. Running out of room sets a flag instead of writing past the end.
+class BitWriter {
+public:
+    BitWriter(uint8_t* data, size_t capacity) : data(data), capacity(capacity) {}
+
+    // bits in [1, 32]
+    void Write(uint32_t value, int bits) {
+        uint64_t mask = (1ull << bits) - 1;
+        scratch |= (static_cast<uint64_t>(value) & mask) << scratchBits;
+        scratchBits += bits;
+        while (scratchBits >= 8) {
+            Emit(static_cast<uint8_t>(scratch));
+            scratch >>= 8;
+            scratchBits -= 8;
+        }
+    }
+    void WriteBool(bool value) { Write(value ? 1u : 0u, 1); }
+
+    // Pads the last byte; returns the bytes written, or 0 on overflow
+    size_t Finish() {
+        if (scratchBits > 0) {
+            Emit(static_cast<uint8_t>(scratch));
+            scratch = 0;
+            scratchBits = 0;
+        }
+        return overflow ? 0 : size;
+    }
+    bool Overflowed() const { return overflow; }
+
+private:
+    void Emit(uint8_t byte) {
+        if (size < capacity) {
+            data[size++] = byte;
+        } else {
+            overflow = true;
+        }
+    }
+
+    uint8_t* data;
+    size_t capacity;
+    size_t size = 0;
+    uint64_t scratch = 0;
+    int scratchBits = 0;
+    bool overflow = false;
+};
+
+// Reads what BitWriter wrote, in place. Reading past the end returns zeros
+// and sets a flag, so callers check once at the end.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint32_t Read(int bits) {
+        while (scratchBits < bits) {
+            uint64_t byte = 0;
+            if (offset < size) {
+                byte = data[offset++];
+            } else {
+                overrun = true;
+            }
+            scratch |= byte << scratchBits;
+            scratchBits += 8;
+        }
+        uint32_t value = static_cast<uint32_t>(scratch & ((1ull << bits) - 1));
+        scratch >>= bits;
+        scratchBits -= bits;
+        return value;
+    }
+    bool ReadBool() { return Read(1) != 0; }
+    bool Overran() const { return overrun; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    uint64_t scratch = 0;
+    int scratchBits = 0;
+    bool overrun = false;
+};
+
+// Steps the codec rounds to. Coarser steps give smaller deltas.
+struct SnapshotPrecision {
+    float positionStep = 1.0f / 16.0f; // world units
+    float velocityStep = 1.0f / 16.0f; // units per second
+    float scalarStep = 1.0f / 64.0f;   // health, fuel, timers, suspension
+    int rotationBits = 14;             // per full turn
+};
+
+// Fixed-point copy of the replicated state: bike kinematics and status,
+// power-ups, track deformations and oil slicks. Baselines are kept in this form so the
+// sender and receiver delta against exactly the same numbers.
+struct QuantizedSnapshot {
+    enum BikeField {
+        BIKE_X,
+        BIKE_Y,
+        BIKE_VELOCITY_X,
+        BIKE_VELOCITY_Y,
+        BIKE_ROTATION,
+        BIKE_SUSPENSION,
+        BIKE_HEALTH,
+        BIKE_NITRO_FUEL,
+        BIKE_STUN_DURATION,
+        BIKE_POWER_UP_DURATION,
+        BIKE_AIR_TIME,
+        BIKE_LAP,
+        BIKE_CHECKPOINTS,
+        BIKE_INPUT,
+        BIKE_FLAGS,
+        BIKE_FIELD_COUNT
+    };
+    enum PowerUpField {
+        POWER_UP_X,
+        POWER_UP_Y,
+        POWER_UP_BASE_Y,
+        POWER_UP_ROTATION,
+        POWER_UP_REMAINING,
+        POWER_UP_FLAGS,
+        POWER_UP_FIELD_COUNT
+    };
+    enum DeformationField {
+        DEFORMATION_X,
+        DEFORMATION_Y,
+        DEFORMATION_RADIUS,
+        DEFORMATION_INTENSITY,
+        DEFORMATION_FIELD_COUNT
+    };
+    enum OilSlickField {
+        OIL_SLICK_X,
+        OIL_SLICK_Y,
+        OIL_SLICK_RADIUS,
+        OIL_SLICK_REMAINING,
+        OIL_SLICK_FIELD_COUNT
+    };
+    using Bike = std::array<int32_t, BIKE_FIELD_COUNT>;
+    using PowerUp = std::array<int32_t, POWER_UP_FIELD_COUNT>;
+    using Deformation = std::array<int32_t, DEFORMATION_FIELD_COUNT>;
+    using OilSlick = std::array<int32_t, OIL_SLICK_FIELD_COUNT>;
+
+    uint32_t tick = 0;
+    std::vector<Bike> bikes;
+    std::vector<PowerUp> powerUps;
+    std::vector<Deformation> deformations;
+    std::vector<OilSlick> oilSlicks;
+
+    bool operator==(const QuantizedSnapshot& other) const {
+        return tick == other.tick && bikes == other.bikes && powerUps == other.powerUps &&
+               deformations == other.deformations && oilSlicks == other.oilSlicks;
+    }
+    bool operator!=(const QuantizedSnapshot& other) const { return !(*this == other); }
+};
+
+// The last HISTORY_SIZE snapshots by tick. The sender keeps what it sent
+// and deltas against the newest one the receiver acknowledged; the receiver
+// keeps what it decoded so the same baselines exist on both sides.
+class SnapshotHistory {
+public:
+    static constexpr size_t HISTORY_SIZE = 32;
+
+    // Slot for tick, overwriting whatever was HISTORY_SIZE ticks older
+    QuantizedSnapshot& Store(uint32_t tick) {
+        Entry& entry = entries[tick % HISTORY_SIZE];
+        entry.valid = true;
+        entry.snapshot.tick = tick;
+        return entry.snapshot;
+    }
+    const QuantizedSnapshot* Find(uint32_t tick) const {
+        const Entry& entry = entries[tick % HISTORY_SIZE];
+        return entry.valid && entry.snapshot.tick == tick ? &entry.snapshot : nullptr;
+    }
+
+private:
+    struct Entry {
+        QuantizedSnapshot snapshot;
+        bool valid = false;
+    };
+    std::array<Entry, HISTORY_SIZE> entries;
+};
+
+// Bit-packed, delta-compressed snapshots for networking, replays and save
+// states.
+//
+// Every value is quantized to a fixed step, then written as the difference
+// to the same value in the baseline (or to zero without one). A difference
+// of zero costs one bit; anything else costs a 5-bit length plus the
+// zigzag-coded difference without its leading one. Unchanged bikes,
+// power-ups and deformations cost a single bit, so a race where only a few
+// things moved since the acknowledged baseline packs into a few bytes per
+// bike. Rotation differences wrap, so a bike crossing 0 stays small.
+//
+// Encode writes into the caller's buffer and Decode reads from it in place;
+// neither allocates once the output snapshot has grown to the race size.
+class SnapshotCodec {
+public:
+    explicit SnapshotCodec(const SnapshotPrecision& precision = SnapshotPrecision());
+
+    // Game snapshot <-> fixed point. Dequantize only writes the fields the
+    // codec carries; RNG state, obstacles and ranking are left as they are.
+    void Quantize(const Game::Snapshot& snapshot, QuantizedSnapshot& out) const;
+    void Dequantize(const QuantizedSnapshot& in, Game::Snapshot& out) const;
+
+    // Bytes written, or 0 if the buffer is too small. The baseline may be null.
+    size_t Encode(const QuantizedSnapshot& state, const QuantizedSnapshot* baseline,
+                  uint8_t* buffer, size_t capacity) const;
+    // Fails on truncated data or when the baseline it was encoded against is
+    // not in baselines (null is fine for snapshots sent without one).
+    // out must not be one of the stored baselines.
+    bool Decode(const uint8_t* data, size_t size, const SnapshotHistory* baselines,
+                QuantizedSnapshot& out) const;
+
+    const SnapshotPrecision& GetPrecision() const { return precision; }
+
+private:
+    int32_t ToFixed(float value, float step) const;
+    uint32_t AngleToFixed(float angle) const;
+    float AngleFromFixed(int32_t value) const;
+
+    SnapshotPrecision precision;
+};
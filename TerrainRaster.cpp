@@ -0,0 +1,158 @@
+#include "TerrainRaster.hpp"
+#include <algorithm>
+#include <cmath>
+
+void TerrainCell::SetFriction(float value) {
+    float scaled = std::round(value * FRICTION_SCALE);
+    friction = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, scaled)));
+}
+
+void TerrainCell::SetNormal(const Vector2D& normal) {
+    normalX = static_cast<int8_t>(std::round(std::max(-1.0f, std::min(1.0f, normal.x)) * 127.0f));
+    normalY = static_cast<int8_t>(std::round(std::max(-1.0f, std::min(1.0f, normal.y)) * 127.0f));
+}
+
+bool TerrainCell::operator==(const TerrainCell& other) const {
+    return terrain == other.terrain && friction == other.friction &&
+           normalX == other.normalX && normalY == other.normalY && elevation == other.elevation;
+}
+
+TerrainRaster::TerrainRaster()
+    : sharedTile(0), pendingTiles(0), outside{0, 0, 0, 0, 0.0f}, originX(0.0f), originY(0.0f),
+      cellSize(1.0f), invCellSize(1.0f), cellsX(0), cellsY(0), tilesX(0), tilesY(0) {}
+
+void TerrainRaster::Clear() {
+    cells.clear();
+    tileTable.clear();
+    dirtyTiles.clear();
+    dirtyFlags.clear();
+    freeTiles.clear();
+    pendingTiles = 0;
+    cellsX = cellsY = tilesX = tilesY = 0;
+}
+
+void TerrainRaster::Build(float minX, float minY, float maxX, float maxY, float newCellSize,
+                          const TerrainCell& outsideCell) {
+    Clear();
+    outside = outsideCell;
+    cellSize = newCellSize;
+    invCellSize = 1.0f / cellSize;
+    originX = minX;
+    originY = minY;
+    cellsX = static_cast<int>(std::ceil((maxX - minX) * invCellSize)) + 1;
+    cellsY = static_cast<int>(std::ceil((maxY - minY) * invCellSize)) + 1;
+    tilesX = (cellsX + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (cellsY + TILE_SIZE - 1) / TILE_SIZE;
+
+    // Stored tile 0 is the shared uniform tile every open-ground tile points at
+    cells.assign(TILE_SIZE * TILE_SIZE, outside);
+    sharedTile = 0;
+    tileTable.assign(static_cast<size_t>(tilesX) * tilesY, sharedTile);
+    dirtyFlags.assign(tileTable.size(), 0);
+}
+
+void TerrainRaster::MarkDirty(const Vector2D& center, float radius) {
+    ForEachTile(center, radius, [this](size_t tile) {
+        if (!dirtyFlags[tile]) {
+            dirtyFlags[tile] = 1;
+            dirtyTiles.push_back(static_cast<uint32_t>(tile));
+        }
+    });
+}
+
+void TerrainRaster::MarkPendingAlong(const Vector2D& a, const Vector2D& b, float radius) {
+    if (!IsBuilt()) {
+        return;
+    }
+    // Tiles in the segment's box whose centre is within radius plus half a
+    // tile diagonal of it, so long diagonal segments do not mark their whole box
+    float tileWorld = cellSize * TILE_SIZE;
+    float reach = radius + tileWorld * 0.70710678f;
+    Vector2D ab = b - a;
+    float lengthSq = ab.LengthSquared();
+    int x0 = std::max(0, static_cast<int>(std::floor((std::min(a.x, b.x) - radius - originX) / tileWorld)));
+    int y0 = std::max(0, static_cast<int>(std::floor((std::min(a.y, b.y) - radius - originY) / tileWorld)));
+    int x1 = std::min(tilesX - 1, static_cast<int>(std::floor((std::max(a.x, b.x) + radius - originX) / tileWorld)));
+    int y1 = std::min(tilesY - 1, static_cast<int>(std::floor((std::max(a.y, b.y) + radius - originY) / tileWorld)));
+    for (int ty = y0; ty <= y1; ++ty) {
+        for (int tx = x0; tx <= x1; ++tx) {
+            Vector2D centre(originX + (tx + 0.5f) * tileWorld, originY + (ty + 0.5f) * tileWorld);
+            float t = lengthSq > 0.0f ? std::max(0.0f, std::min(1.0f, (centre - a).Dot(ab) / lengthSq)) : 0.0f;
+            if ((a + ab * t - centre).LengthSquared() > reach * reach) {
+                continue;
+            }
+            uint32_t& slot = tileTable[static_cast<size_t>(ty) * tilesX + tx];
+            if (slot == sharedTile) {
+                slot = PENDING_TILE;
+                ++pendingTiles;
+            }
+        }
+    }
+}
+
+size_t TerrainRaster::BakePending(const Vector2D& center, float radius, const CellBaker& baker) {
+    // Room for every pending tile up front, so baking them in mid-race does
+    // not allocate; pages that are never baked are never touched
+    size_t needed = cells.size() + pendingTiles * TILE_SIZE * TILE_SIZE;
+    if (cells.capacity() < needed) {
+        cells.reserve(needed);
+    }
+    size_t baked = 0;
+    ForEachTile(center, radius, [&](size_t tile) {
+        if (tileTable[tile] == PENDING_TILE) {
+            BakeTile(static_cast<int>(tile % tilesX), static_cast<int>(tile / tilesX), baker);
+            ++baked;
+        }
+    });
+    return baked;
+}
+
+size_t TerrainRaster::RebakeDirty(const CellBaker& baker) {
+    size_t rebaked = dirtyTiles.size();
+    for (uint32_t tile : dirtyTiles) {
+        dirtyFlags[tile] = 0;
+        BakeTile(static_cast<int>(tile % tilesX), static_cast<int>(tile / tilesX), baker);
+    }
+    dirtyTiles.clear();
+    return rebaked;
+}
+
+void TerrainRaster::BakeTile(int tileX, int tileY, const CellBaker& baker) {
+    TerrainCell baked[TILE_SIZE * TILE_SIZE];
+    bool uniform = true;
+    for (int ly = 0; ly < TILE_SIZE; ++ly) {
+        for (int lx = 0; lx < TILE_SIZE; ++lx) {
+            int cx = tileX * TILE_SIZE + lx;
+            int cy = tileY * TILE_SIZE + ly;
+            TerrainCell& cell = baked[ly * TILE_SIZE + lx];
+            cell = outside;
+            if (cx < cellsX && cy < cellsY) {
+                baker(Vector2D(originX + (cx + 0.5f) * cellSize, originY + (cy + 0.5f) * cellSize), cell);
+            }
+            uniform = uniform && cell == outside;
+        }
+    }
+
+    uint32_t& slot = tileTable[static_cast<size_t>(tileY) * tilesX + tileX];
+    if (slot == PENDING_TILE) {
+        --pendingTiles;
+        slot = sharedTile;
+    }
+    if (uniform) {
+        if (slot != sharedTile) {
+            freeTiles.push_back(slot);
+            slot = sharedTile;
+        }
+        return;
+    }
+    if (slot == sharedTile) {
+        if (!freeTiles.empty()) {
+            slot = freeTiles.back();
+            freeTiles.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(cells.size() / (TILE_SIZE * TILE_SIZE));
+            cells.resize(cells.size() + TILE_SIZE * TILE_SIZE);
+        }
+    }
+    std::copy(baked, baked + TILE_SIZE * TILE_SIZE, cells.begin() + static_cast<size_t>(slot) * TILE_SIZE * TILE_SIZE);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Vector2D.hpp"
+
+// One baked raster cell: surface type, friction, track normal and elevation
+// packed into 8 bytes so a lookup is a single memory fetch
+struct TerrainCell {
+    uint8_t terrain;   // TerrainType value
+    uint8_t friction;  // friction * FRICTION_SCALE
+    int8_t normalX;    // unit normal * 127
+    int8_t normalY;
+    float elevation;
+
+    static constexpr float FRICTION_SCALE = 127.0f;
+
+    float GetFriction() const { return friction / FRICTION_SCALE; }
+    Vector2D GetNormal() const { return Vector2D(normalX / 127.0f, normalY / 127.0f); }
+    void SetFriction(float value);
+    void SetNormal(const Vector2D& normal);
+    bool operator==(const TerrainCell& other) const;
+};
+
+// Tiled terrain/friction/elevation raster baked from the track.
+// Every tile starts as one shared uniform tile (open ground). The owner marks
+// the tiles that can differ: those near the track start pending and are baked
+// on demand around the racers, those under new deformations are re-baked
+// right away. Load time is independent of the track's size, and memory
+// follows the ground that is driven on. Tiles that bake uniform go back to
+// the shared tile.
+class TerrainRaster {
+public:
+    static constexpr int TILE_SIZE = 16; // cells per tile edge
+
+    // Fills one cell given its centre in world space
+    using CellBaker = std::function<void(const Vector2D& cellCenter, TerrainCell& cell)>;
+
+    TerrainRaster();
+
+    // Lays out the raster with every tile uniform; mark and RebakeDirty the rest
+    void Build(float minX, float minY, float maxX, float maxY, float cellSize, const TerrainCell& outsideCell);
+    void Clear();
+
+    // Marks every tile touching the circle for re-baking
+    void MarkDirty(const Vector2D& center, float radius);
+    bool HasDirtyTiles() const { return !dirtyTiles.empty(); }
+    size_t RebakeDirty(const CellBaker& baker);
+
+    // Marks the uniform tiles with cells within radius of the segment ab as
+    // pending: not baked until BakePending reaches them
+    void MarkPendingAlong(const Vector2D& a, const Vector2D& b, float radius);
+    // Bakes the pending tiles touching the circle; returns how many
+    size_t BakePending(const Vector2D& center, float radius, const CellBaker& baker);
+    size_t GetPendingTileCount() const { return pendingTiles; }
+
+    // Points outside the raster return the outside cell; null while the
+    // point's tile is pending, when the caller bakes GetCellCenter itself
+    const TerrainCell* Find(const Vector2D& position) const {
+        int cx = static_cast<int>((position.x - originX) * invCellSize);
+        int cy = static_cast<int>((position.y - originY) * invCellSize);
+        if (position.x < originX || position.y < originY || cx >= cellsX || cy >= cellsY) {
+            return &outside;
+        }
+        uint32_t tile = tileTable[static_cast<size_t>(cy / TILE_SIZE) * tilesX + cx / TILE_SIZE];
+        if (tile == PENDING_TILE) {
+            return nullptr;
+        }
+        return &cells[static_cast<size_t>(tile) * TILE_SIZE * TILE_SIZE + (cy % TILE_SIZE) * TILE_SIZE + cx % TILE_SIZE];
+    }
+    // Centre of the cell holding position, where the baker samples it
+    Vector2D GetCellCenter(const Vector2D& position) const {
+        float cx = std::floor((position.x - originX) * invCellSize);
+        float cy = std::floor((position.y - originY) * invCellSize);
+        return Vector2D(originX + (cx + 0.5f) * cellSize, originY + (cy + 0.5f) * cellSize);
+    }
+    const TerrainCell& GetOutsideCell() const { return outside; }
+
+    // Tile index of a position, or GetTileCount() outside the raster
+    size_t GetTileAt(const Vector2D& position) const {
+        int cx = static_cast<int>((position.x - originX) * invCellSize);
+        int cy = static_cast<int>((position.y - originY) * invCellSize);
+        if (position.x < originX || position.y < originY || cx >= cellsX || cy >= cellsY) {
+            return tileTable.size();
+        }
+        return static_cast<size_t>(cy / TILE_SIZE) * tilesX + cx / TILE_SIZE;
+    }
+    // Calls visit(tileIndex) for every tile touching the circle
+    template <typename F>
+    void ForEachTile(const Vector2D& center, float radius, F&& visit) const;
+
+    bool IsBuilt() const { return !tileTable.empty(); }
+    size_t GetTileCount() const { return tileTable.size(); }
+    size_t GetStoredTileCount() const { return cells.size() / (TILE_SIZE * TILE_SIZE); }
+    size_t GetMemoryBytes() const { return cells.size() * sizeof(TerrainCell) + tileTable.size() * sizeof(uint32_t); }
+
+private:
+    static constexpr uint32_t PENDING_TILE = ~0u;
+
+    void BakeTile(int tileX, int tileY, const CellBaker& baker);
+
+    std::vector<TerrainCell> cells;  // TILE_SIZE^2 cells per stored tile, tile-major
+    std::vector<uint32_t> tileTable; // tilesX * tilesY -> stored tile index
+    std::vector<uint32_t> dirtyTiles;
+    std::vector<uint8_t> dirtyFlags;
+    std::vector<uint32_t> freeTiles; // stored tiles no longer referenced
+    uint32_t sharedTile;             // uniform tile shared by open ground
+    size_t pendingTiles;
+    TerrainCell outside;
+
+    float originX;
+    float originY;
+    float cellSize;
+    float invCellSize;
+    int cellsX;
+    int cellsY;
+    int tilesX;
+    int tilesY;
+};
+
+template <typename F>
+void TerrainRaster::ForEachTile(const Vector2D& center, float radius, F&& visit) const {
+    if (!IsBuilt()) {
+        return;
+    }
+    float tileWorld = cellSize * TILE_SIZE;
+    int x0 = std::max(0, static_cast<int>(std::floor((center.x - radius - originX) / tileWorld)));
+    int y0 = std::max(0, static_cast<int>(std::floor((center.y - radius - originY) / tileWorld)));
+    int x1 = std::min(tilesX - 1, static_cast<int>(std::floor((center.x + radius - originX) / tileWorld)));
+    int y1 = std::min(tilesY - 1, static_cast<int>(std::floor((center.y + radius - originY) / tileWorld)));
+    for (int ty = y0; ty <= y1; ++ty) {
+        for (int tx = x0; tx <= x1; ++tx) {
+            visit(static_cast<size_t>(ty) * tilesX + tx);
+        }
+    }
+}
@@ -0,0 +1,486 @@
+#include "Track.hpp"
+#include "Profiler.hpp"
+#include "TrackFormat.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+SDL_Color TerrainColor(TerrainType terrain) {
+    switch (terrain) {
+    case TerrainType::ASPHALT: return {70, 70, 75, 255};
+    case TerrainType::DIRT:    return {140, 100, 60, 255};
+    case TerrainType::GRASS:   return {60, 140, 60, 255};
+    case TerrainType::SAND:    return {210, 190, 130, 255};
+    case TerrainType::ICE:     return {200, 230, 250, 255};
+    case TerrainType::MUD:     return {90, 65, 40, 255};
+    case TerrainType::WATER:   return {50, 100, 200, 255};
+    case TerrainType::GRAVEL:  return {150, 145, 135, 255};
+    case TerrainType::SNOW:    return {240, 240, 245, 255};
+    }
+    return {255, 0, 255, 255};
+}
+
+}
+
+Track::Track(const std::string& trackName)
+    : name(trackName), trackTexture(nullptr), backgroundTexture(nullptr), trackWidth(0), trackLength(0),
+      currentWeather(WeatherEffect::CLEAR), weatherIntensity(0.0f), timeOfDay(12.0f), isDynamic(false) {}
+
+Track::~Track() {
+    if (trackTexture) {
+        SDL_DestroyTexture(trackTexture);
+    }
+    if (backgroundTexture) {
+        SDL_DestroyTexture(backgroundTexture);
+    }
+}
+
+void Track::Load(const std::string& filename) {
+    // Binary tracks are mapped and read in place; text tracks are parsed
+    TrackData data;
+    std::string error;
+    if (TrackFormat::IsBinaryTrack(filename)) {
+        TrackFormat::FileView view;
+        if (!view.Open(filename, error)) {
+            std::cerr << "Failed to load track: " << error << std::endl;
+            return;
+        }
+        TrackFormat::Decode(view, data);
+    } else {
+        std::ifstream file(filename);
+        if (!file) {
+            std::cerr << "Failed to load track: cannot open " << filename << std::endl;
+            return;
+        }
+        if (!TrackFormat::ParseText(file, data, error)) {
+            std::cerr << "Failed to load track " << filename << ": " << error << std::endl;
+            return;
+        }
+    }
+
+    if (!data.name.empty()) {
+        name = data.name;
+    }
+    trackWidth = data.trackWidth;
+    trackLength = data.trackLength;
+    segments = std::move(data.segments);
+    checkpoints = std::move(data.checkpoints);
+    obstacles = std::move(data.obstacles);
+    startPositions = std::move(data.startPositions);
+    powerUpSpawnPoints = std::move(data.powerUpSpawnPoints);
+    dangerZones = std::move(data.dangerZones);
+    deformations.clear();
+    oilSlicks.clear();
+
+    BuildSpatialIndex();
+}
+
+void Track::Update(float deltaTime) {
+    if (isDynamic) {
+        UpdateWeather(deltaTime);
+    }
+    UpdateObstacles(deltaTime);
+    UpdateDeformation(deltaTime);
+}
+
+void Track::UpdateWeather(float deltaTime) {
+    timeOfDay = std::fmod(timeOfDay + deltaTime * (24.0f / DAY_LENGTH), 24.0f);
+
+    // One roll per tick keeps the stream in step with the tick count
+    if (weatherRandom.NextFloat() < deltaTime / WEATHER_CHANGE_TIME) {
+        currentWeather = static_cast<WeatherEffect>(weatherRandom.NextInt(5));
+    }
+    float target = currentWeather == WeatherEffect::CLEAR ? 0.0f : 1.0f;
+    float step = WEATHER_FADE_RATE * deltaTime;
+    if (weatherIntensity < target) {
+        weatherIntensity = std::min(target, weatherIntensity + step);
+    } else {
+        weatherIntensity = std::max(target, weatherIntensity - step);
+    }
+}
+
+void Track::UpdateObstacles(float deltaTime) {
+    for (auto& slick : oilSlicks) {
+        slick.remaining -= deltaTime;
+    }
+    oilSlicks.erase(std::remove_if(oilSlicks.begin(), oilSlicks.end(),
+                                   [](const OilSlick& slick) { return slick.remaining <= 0.0f; }),
+                    oilSlicks.end());
+    auto destroyed = std::remove_if(obstacles.begin(), obstacles.end(), [](const Obstacle& obstacle) {
+        return obstacle.destructible && obstacle.health <= 0.0f;
+    });
+    if (destroyed != obstacles.end()) {
+        obstacles.erase(destroyed, obstacles.end());
+        SyncObstacleIndex();
+    }
+}
+
+void Track::SaveDynamicState(DynamicState& state) const {
+    state.weather = currentWeather;
+    state.weatherIntensity = weatherIntensity;
+    state.timeOfDay = timeOfDay;
+    state.weatherRandom = weatherRandom.GetState();
+    state.obstacleRandom = obstacleRandom.GetState();
+    state.obstacles = obstacles;
+    state.oilSlicks = oilSlicks;
+    state.deformations = deformations;
+}
+
+void Track::LoadDynamicState(const DynamicState& state) {
+    currentWeather = state.weather;
+    weatherIntensity = state.weatherIntensity;
+    timeOfDay = state.timeOfDay;
+    weatherRandom.SetState(state.weatherRandom);
+    obstacleRandom.SetState(state.obstacleRandom);
+    obstacles = state.obstacles;
+    oilSlicks = state.oilSlicks;
+    SyncObstacleIndex();
+    // Deformations are only ever appended, so the lists share a prefix:
+    // undo the newer ones, add missing ones, and rebake now, since bikes
+    // query the terrain before the next Update
+    while (deformations.size() > state.deformations.size()) {
+        RemoveLastDeformation();
+    }
+    for (size_t i = deformations.size(); i < state.deformations.size(); ++i) {
+        const Deformation& deformation = state.deformations[i];
+        ApplyDeformation(deformation.point, deformation.radius, deformation.intensity);
+    }
+    if (terrainRaster.HasDirtyTiles()) {
+        terrainRaster.RebakeDirty([this](const Vector2D& center, TerrainCell& cell) { BakeTerrainCell(center, cell); });
+    }
+}
+
+void Track::BuildSpatialIndex() {
+    spatialIndex.Clear();
+    edgeStartDistance.clear();
+    lapLength = 0.0f;
+    for (uint32_t s = 0; s < segments.size(); ++s) {
+        const auto& points = segments[s].points;
+        for (size_t i = 1; i < points.size(); ++i) {
+            spatialIndex.AddEdge(points[i - 1], points[i], s);
+            edgeStartDistance.push_back(lapLength);
+            lapLength += (points[i] - points[i - 1]).Length();
+        }
+    }
+    for (const auto& obstacle : obstacles) {
+        spatialIndex.AddObstacle(obstacle.bounds);
+    }
+    for (const auto& zone : dangerZones) {
+        spatialIndex.AddDangerZone(zone);
+    }
+
+    // Cells about one track width across keep a handful of edges per cell
+    float halfWidth = trackWidth * 0.5f;
+    spatialIndex.Build(std::max(static_cast<float>(trackWidth), 32.0f), halfWidth);
+    BakeTerrainRaster();
+}
+
+void Track::SyncObstacleIndex() {
+    obstacleBounds.clear();
+    for (const auto& obstacle : obstacles) {
+        obstacleBounds.push_back(obstacle.bounds);
+    }
+    spatialIndex.SetObstacles(obstacleBounds);
+}
+
+void Track::Render(RenderQueue& queue) {
+    // Each segment is one strip of quads, trackWidth wide, tinted by terrain
+    float halfWidth = trackWidth * 0.5f;
+    for (const auto& segment : segments) {
+        const auto& points = segment.points;
+        if (points.size() < 2) {
+            continue;
+        }
+        SDL_Color color = TerrainColor(segment.terrain);
+        int quadCount = static_cast<int>(points.size() - 1);
+        SDL_Vertex* quad = queue.BeginQuads(nullptr, RenderLayer::TRACK, quadCount);
+        for (int i = 0; i < quadCount; ++i, quad += 4) {
+            const Vector2D& a = points[i];
+            const Vector2D& b = points[i + 1];
+            Vector2D direction = (b - a).Normalized();
+            Vector2D side(-direction.y * halfWidth, direction.x * halfWidth);
+            quad[0] = {{a.x + side.x, a.y + side.y}, color, {0.0f, 0.0f}};
+            quad[1] = {{b.x + side.x, b.y + side.y}, color, {0.0f, 0.0f}};
+            quad[2] = {{b.x - side.x, b.y - side.y}, color, {0.0f, 0.0f}};
+            quad[3] = {{a.x - side.x, a.y - side.y}, color, {0.0f, 0.0f}};
+        }
+        queue.EndQuads(quadCount);
+    }
+
+    AtlasRegion untextured;
+    for (const auto& obstacle : obstacles) {
+        SDL_FRect dest = {static_cast<float>(obstacle.bounds.x), static_cast<float>(obstacle.bounds.y),
+                          static_cast<float>(obstacle.bounds.w), static_cast<float>(obstacle.bounds.h)};
+        queue.Submit(untextured, dest, obstacle.rotation, RenderLayer::OBSTACLES, {110, 80, 50, 255});
+    }
+}
+
+bool Track::CheckCollision(const SDL_Rect& bikeRect) const {
+    BIKE_PROFILE_ZONE("Track::CheckCollision");
+    return spatialIndex.OverlapsObstacle(bikeRect);
+}
+
+bool Track::IsInDangerZone(const SDL_Rect& bikeRect) const {
+    BIKE_PROFILE_ZONE("Track::IsInDangerZone");
+    return spatialIndex.OverlapsDangerZone(bikeRect);
+}
+
+void Track::BakeTerrainRaster() {
+    if (spatialIndex.IsEmpty()) {
+        terrainRaster.Clear();
+        tileDeformations.clear();
+        return;
+    }
+    float minX, minY, maxX, maxY;
+    spatialIndex.GetBounds(minX, minY, maxX, maxY);
+
+    TerrainCell offTrack{};
+    offTrack.terrain = static_cast<uint8_t>(OFF_TRACK_TERRAIN);
+    offTrack.SetFriction(OFF_TRACK_FRICTION);
+
+    // About 32 cells across the track keeps edge error well under a wheel
+    // width. Only tiles within half a track width of an edge (or under a
+    // deformation) can differ from open ground. Those along the track wait
+    // for a racer to come near: baking them all took most of a second on
+    // long circuits.
+    float cellSize = std::max(2.0f, trackWidth / 32.0f);
+    terrainRaster.Build(minX, minY, maxX, maxY, cellSize, offTrack);
+    tileDeformations.assign(terrainRaster.GetTileCount(), {});
+    float halfWidth = trackWidth * 0.5f;
+    for (const auto& edge : spatialIndex.GetEdges()) {
+        terrainRaster.MarkPendingAlong(edge.a, edge.b, halfWidth);
+    }
+    std::vector<Deformation> existing;
+    existing.swap(deformations);
+    for (const auto& deformation : existing) {
+        ApplyDeformation(deformation.point, deformation.radius, deformation.intensity);
+    }
+    terrainRaster.RebakeDirty([this](const Vector2D& center, TerrainCell& cell) { BakeTerrainCell(center, cell); });
+}
+
+void Track::BakeTerrainAround(const Vector2D& position, float radius) {
+    BIKE_PROFILE_ZONE("Track::BakeTerrainAround");
+    terrainRaster.BakePending(position, radius,
+                              [this](const Vector2D& center, TerrainCell& cell) { BakeTerrainCell(center, cell); });
+}
+
+TerrainCell Track::SampleTerrain(const Vector2D& position) const {
+    if (const TerrainCell* baked = terrainRaster.Find(position)) {
+        return *baked;
+    }
+    // Exactly what baking the tile will store, so results do not depend on
+    // when it gets baked
+    TerrainCell cell = terrainRaster.GetOutsideCell();
+    BakeTerrainCell(terrainRaster.GetCellCenter(position), cell);
+    return cell;
+}
+
+void Track::BakeTerrainCell(const Vector2D& cellCenter, TerrainCell& cell) const {
+    // The search stops at half a track width, so cells off the track cost
+    // a few grid cells each however far the nearest edge is
+    Vector2D nearest;
+    uint32_t edgeIndex = 0;
+    if (spatialIndex.FindNearestPoint(cellCenter, nearest, &edgeIndex, trackWidth * 0.5f)) {
+        const TrackSpatialIndex::Edge& edge = spatialIndex.GetEdges()[edgeIndex];
+        const TrackSegment& segment = segments[edge.segment];
+        Vector2D direction = (edge.b - edge.a).Normalized();
+        cell.terrain = static_cast<uint8_t>(segment.terrain);
+        cell.SetFriction(segment.friction);
+        cell.SetNormal(Vector2D(-direction.y, direction.x));
+    }
+
+    // Deformations dig smooth craters into the surface
+    float elevation = 0.0f;
+    size_t tile = terrainRaster.GetTileAt(cellCenter);
+    if (tile < tileDeformations.size()) {
+        for (uint32_t index : tileDeformations[tile]) {
+            const Deformation& deformation = deformations[index];
+            float distance = Vector2D::Distance(cellCenter, deformation.point);
+            if (distance < deformation.radius) {
+                float falloff = 1.0f - distance / deformation.radius;
+                elevation -= deformation.intensity * falloff * falloff;
+            }
+        }
+    }
+    cell.elevation = elevation;
+}
+
+void Track::ApplyDeformation(const Vector2D& point, float radius, float intensity) {
+    uint32_t index = static_cast<uint32_t>(deformations.size());
+    deformations.push_back({point, radius, intensity});
+    terrainRaster.ForEachTile(point, radius, [&](size_t tile) { tileDeformations[tile].push_back(index); });
+    terrainRaster.MarkDirty(point, radius);
+}
+
+void Track::RemoveLastDeformation() {
+    // The newest deformation is the last entry of every tile list it is in
+    const Deformation& deformation = deformations.back();
+    terrainRaster.ForEachTile(deformation.point, deformation.radius,
+                              [&](size_t tile) { tileDeformations[tile].pop_back(); });
+    terrainRaster.MarkDirty(deformation.point, deformation.radius);
+    deformations.pop_back();
+}
+
+void Track::UpdateDeformation(float deltaTime) {
+    (void)deltaTime;
+    if (terrainRaster.HasDirtyTiles()) {
+        terrainRaster.RebakeDirty([this](const Vector2D& center, TerrainCell& cell) { BakeTerrainCell(center, cell); });
+    }
+}
+
+TerrainType Track::GetTerrainAt(const Vector2D& position) const {
+    BIKE_PROFILE_ZONE("Track::GetTerrainAt");
+    if (terrainRaster.IsBuilt()) {
+        return static_cast<TerrainType>(SampleTerrain(position).terrain);
+    }
+    int segment = spatialIndex.FindSegmentAt(position, trackWidth * 0.5f);
+    return segment >= 0 ? segments[segment].terrain : OFF_TRACK_TERRAIN;
+}
+
+float Track::GetFrictionAt(const Vector2D& position) const {
+    BIKE_PROFILE_ZONE("Track::GetFrictionAt");
+    float friction;
+    if (terrainRaster.IsBuilt()) {
+        friction = SampleTerrain(position).GetFriction();
+    } else {
+        int segment = spatialIndex.FindSegmentAt(position, trackWidth * 0.5f);
+        friction = segment >= 0 ? segments[segment].friction : OFF_TRACK_FRICTION;
+    }
+    for (const auto& slick : oilSlicks) {
+        if ((position - slick.position).LengthSquared() < slick.radius * slick.radius) {
+            return friction * OIL_SLICK_FRICTION;
+        }
+    }
+    return friction;
+}
+
+void Track::AddOilSlick(const Vector2D& position, float radius, float duration) {
+    oilSlicks.push_back({position, radius, duration});
+}
+
+float Track::GetElevationAt(const Vector2D& point) const {
+    return SampleTerrain(point).elevation;
+}
+
+Vector2D Track::GetTrackNormalAt(const Vector2D& point) const {
+    return SampleTerrain(point).GetNormal();
+}
+
+bool Track::IsPointInTrack(const Vector2D& point) const {
+    return spatialIndex.FindSegmentAt(point, trackWidth * 0.5f) >= 0;
+}
+
+float Track::GetProgress(const Vector2D& position) const {
+    BIKE_PROFILE_ZONE("Track::GetProgress");
+    Vector2D nearest;
+    uint32_t edgeIndex = 0;
+    if (!spatialIndex.FindNearestPoint(position, nearest, &edgeIndex)) {
+        return 0.0f;
+    }
+    const TrackSpatialIndex::Edge& edge = spatialIndex.GetEdges()[edgeIndex];
+    float progress = edgeStartDistance[edgeIndex] + (nearest - edge.a).Length();
+    return progress < lapLength ? progress : 0.0f;
+}
+
+float Track::GetProgress(const Vector2D& position, uint32_t& edgeHint) const {
+    const auto& edges = spatialIndex.GetEdges();
+    if (edgeHint >= edges.size()) {
+        Vector2D nearest;
+        if (!spatialIndex.FindNearestPoint(position, nearest, &edgeHint)) {
+            edgeHint = 0;
+            return 0.0f;
+        }
+    }
+
+    // Edges are stored in driving order, so the nearest edge is almost always
+    // the hint or a step or two along the loop from it
+    uint32_t count = static_cast<uint32_t>(edges.size());
+    auto distanceSq = [&](uint32_t e) {
+        return (TrackSpatialIndex::ClosestPointOnEdge(position, edges[e].a, edges[e].b) - position).LengthSquared();
+    };
+    uint32_t best = edgeHint;
+    float bestDistSq = distanceSq(best);
+    for (uint32_t step : {1u, count - 1}) {
+        uint32_t edge = best;
+        for (int walked = 0; walked < MAX_HINT_WALK; ++walked) {
+            uint32_t next = (edge + step) % count;
+            float distSq = distanceSq(next);
+            if (distSq >= bestDistSq) {
+                break;
+            }
+            best = edge = next;
+            bestDistSq = distSq;
+        }
+    }
+
+    // Reset or teleported bikes end up far from every edge near the hint
+    float limit = static_cast<float>(trackWidth);
+    if (bestDistSq > limit * limit) {
+        Vector2D nearest;
+        spatialIndex.FindNearestPoint(position, nearest, &best);
+    }
+    edgeHint = best;
+    const TrackSpatialIndex::Edge& edge = edges[best];
+    Vector2D nearest = TrackSpatialIndex::ClosestPointOnEdge(position, edge.a, edge.b);
+    float progress = edgeStartDistance[best] + (nearest - edge.a).Length();
+    return progress < lapLength ? progress : 0.0f;
+}
+
+void Track::GetNearestTrackPoints(const Vector2D* points, size_t count, Vector2D* nearest, float* progress) const {
+    BIKE_PROFILE_ZONE("Track::GetNearestTrackPoints");
+    const auto& edges = spatialIndex.GetEdges();
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t edgeIndex = 0;
+        nearest[i] = points[i];
+        if (!spatialIndex.FindNearestPoint(points[i], nearest[i], &edgeIndex)) {
+            if (progress) {
+                progress[i] = 0.0f;
+            }
+            continue;
+        }
+        if (progress) {
+            float distance = edgeStartDistance[edgeIndex] + (nearest[i] - edges[edgeIndex].a).Length();
+            progress[i] = distance < lapLength ? distance : 0.0f;
+        }
+    }
+}
+
+void Track::GetTrackNormalsAt(const Vector2D* points, size_t count, Vector2D* normals) const {
+    BIKE_PROFILE_ZONE("Track::GetTrackNormalsAt");
+    for (size_t i = 0; i < count; ++i) {
+        normals[i] = SampleTerrain(points[i]).GetNormal();
+    }
+}
+
+Vector2D Track::GetStartPosition(int playerIndex) const {
+    // Grid spots from the track file first; more bikes than spots line up
+    // two abreast in rows behind the last one, against the driving direction
+    int spots = static_cast<int>(startPositions.size());
+    if (playerIndex >= 0 && playerIndex < spots) {
+        return startPositions[playerIndex];
+    }
+    const auto& edges = spatialIndex.GetEdges();
+    Vector2D forward(1.0f, 0.0f);
+    Vector2D front;
+    if (!edges.empty()) {
+        forward = (edges.front().b - edges.front().a).Normalized();
+        front = edges.front().a;
+    }
+    if (spots > 0) {
+        front = startPositions.back() - forward * START_ROW_SPACING;
+    }
+    int extra = std::max(0, playerIndex - spots);
+    Vector2D side(-forward.y, forward.x);
+    float lane = (extra % 2 == 0 ? -0.25f : 0.25f) * trackWidth;
+    return front - forward * (START_ROW_SPACING * (extra / 2)) + side * lane;
+}
+
+Vector2D Track::GetNearestTrackPoint(const Vector2D& point) const {
+    BIKE_PROFILE_ZONE("Track::GetNearestTrackPoint");
+    Vector2D nearest = point;
+    spatialIndex.FindNearestPoint(point, nearest);
+    return nearest;
+}
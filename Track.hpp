@@ -3,6 +3,10 @@
 #include <vector>
 #include <string>
 #include "Vector2D.hpp"
+#include "TrackSpatialIndex.hpp"
+#include "TerrainRaster.hpp"
+#include "RenderQueue.hpp"
+#include "Random.hpp"
 
 enum class TerrainType {
     ASPHALT,
@@ -44,16 +48,79 @@ public:
     Track(const std::string& trackName);
     ~Track();
 
+    // Loads a binary (.bktr, memory-mapped) or text (.trk) track and builds
+    // the spatial index and terrain raster used by all queries below. The
+    // raster's tiles near the track are baked later, by BakeTerrainAround.
     void Load(const std::string& filename);
-    void Render(SDL_Renderer* renderer);
+    // Bakes the terrain tiles within radius of position that are not baked
+    // yet. Queries on unbaked tiles work each cell out on the spot (same
+    // result, much slower), so the game calls this for every bike in a serial
+    // stage; never while other threads query the track.
+    void BakeTerrainAround(const Vector2D& position, float radius);
+    void Update(float deltaTime);
+    void Render(RenderQueue& queue);
     bool CheckCollision(const SDL_Rect& bikeRect) const;
     TerrainType GetTerrainAt(const Vector2D& position) const;
     float GetFrictionAt(const Vector2D& position) const;
+    bool IsInDangerZone(const SDL_Rect& bikeRect) const;
     
     // Checkpoints and race progress
     bool IsCheckpointReached(int checkpointIndex, const SDL_Rect& bikeRect) const;
+    // Distance along the centerline to the nearest point, in [0, GetLapLength())
     float GetProgress(const Vector2D& position) const;
+    // Same, but starts from the edge found last time and walks to the nearest
+    // neighbouring edge, falling back to the full lookup when that is too far
+    // away. edgeHint is updated; pass an out-of-range value the first time.
+    float GetProgress(const Vector2D& position, uint32_t& edgeHint) const;
+    float GetLapLength() const { return lapLength; }
+    const TrackSpatialIndex& GetSpatialIndex() const { return spatialIndex; }
+    int GetTrackWidth() const { return trackWidth; }
+
+    // Batched GetNearestTrackPoint and GetTrackNormalAt for callers with many
+    // positions per tick (AI racers): one profile zone per batch instead of
+    // one per query. progress may be null; it gets what GetProgress returns.
+    void GetNearestTrackPoints(const Vector2D* points, size_t count, Vector2D* nearest, float* progress) const;
+    void GetTrackNormalsAt(const Vector2D* points, size_t count, Vector2D* normals) const;
     Vector2D GetStartPosition(int playerIndex) const;
+    const std::vector<Vector2D>& GetPowerUpSpawnPoints() const { return powerUpSpawnPoints; }
+    
+    // Oil dropped by a racer: the surface under it loses most of its grip
+    // until the slick dries up
+    struct OilSlick {
+        Vector2D position;
+        float radius;
+        float remaining; // seconds
+    };
+    void AddOilSlick(const Vector2D& position, float radius, float duration);
+    size_t GetOilSlickCount() const { return oilSlicks.size(); }
+    static constexpr float OIL_SLICK_FRICTION = 0.15f; // share of the surface's grip left
+
+    // Crater dug into the terrain; never changes once applied
+    struct Deformation {
+        Vector2D point;
+        float radius;
+        float intensity;
+    };
+
+    // Everything Update changes, for rollback snapshots
+    struct DynamicState {
+        WeatherEffect weather;
+        float weatherIntensity;
+        float timeOfDay;
+        uint64_t weatherRandom;
+        uint64_t obstacleRandom;
+        std::vector<Obstacle> obstacles;
+        std::vector<OilSlick> oilSlicks;
+        std::vector<Deformation> deformations;
+    };
+    void SaveDynamicState(DynamicState& state) const;
+    void LoadDynamicState(const DynamicState& state);
+
+    // Weather and obstacle spawning draw only from these streams
+    void SetRandomSeeds(uint64_t weatherSeed, uint64_t obstacleSeed) {
+        weatherRandom.Seed(weatherSeed);
+        obstacleRandom.Seed(obstacleSeed);
+    }
 
 private:
     std::string name;
@@ -66,9 +133,20 @@ private:
     int trackWidth;
     int trackLength;
     std::vector<Vector2D> startPositions;
+    static constexpr float START_ROW_SPACING = 80.0f; // px between grid rows past the listed spots
     
     // Track generation
     void GenerateCollisionMap();
+    void BuildSpatialIndex();
+    TrackSpatialIndex spatialIndex;
+    // Centerline distance at the start of each spatial index edge
+    std::vector<float> edgeStartDistance;
+    float lapLength = 0.0f;
+    static constexpr int MAX_HINT_WALK = 8;
+    
+    // Surface outside every segment
+    static constexpr TerrainType OFF_TRACK_TERRAIN = TerrainType::GRASS;
+    static constexpr float OFF_TRACK_FRICTION = 0.6f;
     void GenerateCheckpoints();
     
     // Weather and environment
@@ -76,7 +154,12 @@ private:
     float weatherIntensity;
     float timeOfDay; // 0.0 to 24.0
     bool isDynamic; // Whether weather/time changes during race
+    Random weatherRandom;
+    static constexpr float DAY_LENGTH = 1440.0f;        // seconds per in-game day
+    static constexpr float WEATHER_CHANGE_TIME = 60.0f; // mean seconds between changes
+    static constexpr float WEATHER_FADE_RATE = 0.1f;    // intensity per second
     
+    // Advances the clock and drifts between weather states from weatherRandom
     void UpdateWeather(float deltaTime);
     void UpdateLighting();
     void ApplyWeatherEffects();
@@ -85,16 +168,35 @@ private:
     std::vector<Obstacle> obstacles;
     std::vector<Vector2D> powerUpSpawnPoints;
     std::vector<SDL_Rect> dangerZones;
+    // Few and short-lived, so friction lookups scan them
+    std::vector<OilSlick> oilSlicks;
+    Random obstacleRandom;
     
     void SpawnObstacles();
+    // Drops destructible obstacles whose health has run out and dried-up oil
     void UpdateObstacles(float deltaTime);
     void HandleObstacleCollision(const SDL_Rect& bikeRect);
+    // Hands the current obstacle bounds to the spatial index (collision
+    // queries and bike sweeps read them from there)
+    void SyncObstacleIndex();
+    std::vector<SDL_Rect> obstacleBounds;
     
     // Track deformation
-    std::vector<Vector2D> deformationPoints;
+    std::vector<Deformation> deformations;
+    // Indices of the deformations touching each raster tile, ascending, so
+    // baking a cell only visits the craters around it
+    std::vector<std::vector<uint32_t>> tileDeformations;
     void ApplyDeformation(const Vector2D& point, float radius, float intensity);
+    void RemoveLastDeformation();
     void UpdateDeformation(float deltaTime);
     
+    // Baked terrain, friction, elevation and normal lookups
+    TerrainRaster terrainRaster;
+    void BakeTerrainRaster();
+    void BakeTerrainCell(const Vector2D& cellCenter, TerrainCell& cell) const;
+    // The raster's cell at position, worked out directly if its tile is unbaked
+    TerrainCell SampleTerrain(const Vector2D& position) const;
+    
     // Helper functions
     bool IsPointInTrack(const Vector2D& point) const;
     Vector2D GetNearestTrackPoint(const Vector2D& point) const;
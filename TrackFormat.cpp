@@ -0,0 +1,386 @@
+#include "TrackFormat.hpp"
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TrackFormat {
+
+namespace {
+
+const char* const TERRAIN_NAMES[] = {
+    "ASPHALT", "DIRT", "GRASS", "SAND", "ICE", "MUD", "WATER", "GRAVEL", "SNOW"
+};
+const uint32_t TERRAIN_COUNT = sizeof(TERRAIN_NAMES) / sizeof(TERRAIN_NAMES[0]);
+
+bool SectionFits(const Section& section, size_t recordSize, size_t fileSize) {
+    uint64_t end = static_cast<uint64_t>(section.offset) + static_cast<uint64_t>(section.count) * recordSize;
+    return section.offset % 4 == 0 && end <= fileSize;
+}
+
+RectRecord ToRecord(const SDL_Rect& rect) {
+    return {rect.x, rect.y, rect.w, rect.h};
+}
+
+SDL_Rect FromRecord(const RectRecord& record) {
+    return {record.x, record.y, record.w, record.h};
+}
+
+template <typename T>
+void AppendRecords(std::vector<uint8_t>& buffer, Section& section, const std::vector<T>& records) {
+    section.offset = static_cast<uint32_t>(buffer.size());
+    section.count = static_cast<uint32_t>(records.size());
+    size_t bytes = records.size() * sizeof(T);
+    buffer.resize(buffer.size() + bytes);
+    if (bytes > 0) {
+        std::memcpy(buffer.data() + section.offset, records.data(), bytes);
+    }
+}
+
+}
+
+FileView::~FileView() {
+    Close();
+}
+
+bool FileView::Open(const std::string& path, std::string& error) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        error = "cannot map " + path;
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const uint8_t*>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        error = "cannot stat " + path;
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    data = static_cast<const uint8_t*>(view);
+    size = static_cast<size_t>(info.st_size);
+#endif
+
+    // Validate once here so readers can index sections without checks
+    const Header& header = GetHeader();
+    if (size < sizeof(Header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + " is not a binary track";
+    } else if (header.version != VERSION) {
+        error = path + " has unsupported track version " + std::to_string(header.version);
+    } else if (header.fileSize != size ||
+               !SectionFits(header.segments, sizeof(SegmentRecord), size) ||
+               !SectionFits(header.points, sizeof(PointRecord), size) ||
+               !SectionFits(header.checkpoints, sizeof(RectRecord), size) ||
+               !SectionFits(header.obstacles, sizeof(ObstacleRecord), size) ||
+               !SectionFits(header.startPositions, sizeof(PointRecord), size) ||
+               !SectionFits(header.spawnPoints, sizeof(PointRecord), size) ||
+               !SectionFits(header.dangerZones, sizeof(RectRecord), size) ||
+               !SectionFits(header.strings, 1, size) ||
+               static_cast<uint64_t>(header.nameOffset) + header.nameLength > header.strings.count) {
+        error = path + " is truncated or corrupt";
+    } else {
+        const SegmentRecord* segments = Records<SegmentRecord>(header.segments);
+        for (uint32_t i = 0; i < header.segments.count; ++i) {
+            if (static_cast<uint64_t>(segments[i].firstPoint) + segments[i].pointCount > header.points.count ||
+                segments[i].terrain >= TERRAIN_COUNT) {
+                error = path + " has an invalid segment";
+                break;
+            }
+        }
+        const ObstacleRecord* obstacles = Records<ObstacleRecord>(header.obstacles);
+        for (uint32_t i = 0; error.empty() && i < header.obstacles.count; ++i) {
+            if (static_cast<uint64_t>(obstacles[i].typeOffset) + obstacles[i].typeLength > header.strings.count) {
+                error = path + " has an invalid obstacle";
+            }
+        }
+        if (error.empty()) {
+            return true;
+        }
+    }
+    Close();
+    return false;
+}
+
+void FileView::Close() {
+    if (!data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool IsBinaryTrack(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[4] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+const char* TerrainName(TerrainType terrain) {
+    uint32_t index = static_cast<uint32_t>(terrain);
+    return index < TERRAIN_COUNT ? TERRAIN_NAMES[index] : "ASPHALT";
+}
+
+bool ParseTerrain(const std::string& name, TerrainType& terrain) {
+    for (uint32_t i = 0; i < TERRAIN_COUNT; ++i) {
+        if (name == TERRAIN_NAMES[i]) {
+            terrain = static_cast<TerrainType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseText(std::istream& in, TrackData& track, std::string& error) {
+    track = TrackData();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string directive;
+        if (!(fields >> directive)) {
+            continue;
+        }
+
+        bool ok = true;
+        if (directive == "track") {
+            ok = static_cast<bool>(fields >> track.name);
+        } else if (directive == "width") {
+            ok = static_cast<bool>(fields >> track.trackWidth);
+        } else if (directive == "length") {
+            ok = static_cast<bool>(fields >> track.trackLength);
+        } else if (directive == "start" || directive == "spawn") {
+            Vector2D point;
+            ok = static_cast<bool>(fields >> point.x >> point.y);
+            (directive == "start" ? track.startPositions : track.powerUpSpawnPoints).push_back(point);
+        } else if (directive == "checkpoint" || directive == "danger") {
+            SDL_Rect rect;
+            ok = static_cast<bool>(fields >> rect.x >> rect.y >> rect.w >> rect.h);
+            (directive == "checkpoint" ? track.checkpoints : track.dangerZones).push_back(rect);
+        } else if (directive == "obstacle") {
+            Obstacle obstacle;
+            int destructible = 0;
+            ok = static_cast<bool>(fields >> obstacle.type >> obstacle.bounds.x >> obstacle.bounds.y >>
+                                   obstacle.bounds.w >> obstacle.bounds.h >> obstacle.rotation >>
+                                   destructible >> obstacle.health);
+            obstacle.position = Vector2D(obstacle.bounds.x + obstacle.bounds.w * 0.5f,
+                                         obstacle.bounds.y + obstacle.bounds.h * 0.5f);
+            obstacle.destructible = destructible != 0;
+            track.obstacles.push_back(obstacle);
+        } else if (directive == "segment") {
+            TrackSegment segment;
+            std::string terrain;
+            ok = (fields >> terrain >> segment.friction) && ParseTerrain(terrain, segment.terrain);
+            track.segments.push_back(segment);
+        } else if (directive == "point") {
+            Vector2D point;
+            ok = !track.segments.empty() && (fields >> point.x >> point.y);
+            if (ok) {
+                track.segments.back().points.push_back(point);
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = "line " + std::to_string(lineNumber) + ": cannot parse '" + line + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+void WriteText(std::ostream& out, const TrackData& track) {
+    // Enough digits that text -> binary -> text round-trips exactly
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << "track " << track.name << "\n"
+        << "width " << track.trackWidth << "\n"
+        << "length " << track.trackLength << "\n";
+    for (const auto& start : track.startPositions) {
+        out << "start " << start.x << " " << start.y << "\n";
+    }
+    for (const auto& spawn : track.powerUpSpawnPoints) {
+        out << "spawn " << spawn.x << " " << spawn.y << "\n";
+    }
+    for (const auto& rect : track.checkpoints) {
+        out << "checkpoint " << rect.x << " " << rect.y << " " << rect.w << " " << rect.h << "\n";
+    }
+    for (const auto& rect : track.dangerZones) {
+        out << "danger " << rect.x << " " << rect.y << " " << rect.w << " " << rect.h << "\n";
+    }
+    for (const auto& obstacle : track.obstacles) {
+        out << "obstacle " << obstacle.type << " " << obstacle.bounds.x << " " << obstacle.bounds.y << " "
+            << obstacle.bounds.w << " " << obstacle.bounds.h << " " << obstacle.rotation << " "
+            << (obstacle.destructible ? 1 : 0) << " " << obstacle.health << "\n";
+    }
+    for (const auto& segment : track.segments) {
+        out << "segment " << TerrainName(segment.terrain) << " " << segment.friction << "\n";
+        for (const auto& point : segment.points) {
+            out << "point " << point.x << " " << point.y << "\n";
+        }
+    }
+}
+
+bool WriteBinary(const TrackData& track, const std::string& path, std::string& error) {
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.trackWidth = track.trackWidth;
+    header.trackLength = track.trackLength;
+
+    std::string strings = track.name;
+    header.nameOffset = 0;
+    header.nameLength = static_cast<uint32_t>(track.name.size());
+
+    std::vector<SegmentRecord> segments;
+    std::vector<PointRecord> points;
+    for (const auto& segment : track.segments) {
+        segments.push_back({static_cast<uint32_t>(points.size()), static_cast<uint32_t>(segment.points.size()),
+                            static_cast<uint32_t>(segment.terrain), segment.friction});
+        for (const auto& point : segment.points) {
+            points.push_back({point.x, point.y});
+        }
+    }
+
+    std::vector<ObstacleRecord> obstacles;
+    for (const auto& obstacle : track.obstacles) {
+        obstacles.push_back({obstacle.position.x, obstacle.position.y, obstacle.rotation, obstacle.health,
+                             ToRecord(obstacle.bounds), obstacle.destructible ? 1u : 0u,
+                             static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(obstacle.type.size())});
+        strings += obstacle.type;
+    }
+
+    std::vector<RectRecord> checkpoints, dangerZones;
+    for (const auto& rect : track.checkpoints) {
+        checkpoints.push_back(ToRecord(rect));
+    }
+    for (const auto& rect : track.dangerZones) {
+        dangerZones.push_back(ToRecord(rect));
+    }
+    std::vector<PointRecord> starts, spawns;
+    for (const auto& point : track.startPositions) {
+        starts.push_back({point.x, point.y});
+    }
+    for (const auto& point : track.powerUpSpawnPoints) {
+        spawns.push_back({point.x, point.y});
+    }
+
+    std::vector<uint8_t> buffer(sizeof(Header));
+    AppendRecords(buffer, header.segments, segments);
+    AppendRecords(buffer, header.points, points);
+    AppendRecords(buffer, header.checkpoints, checkpoints);
+    AppendRecords(buffer, header.obstacles, obstacles);
+    AppendRecords(buffer, header.startPositions, starts);
+    AppendRecords(buffer, header.spawnPoints, spawns);
+    AppendRecords(buffer, header.dangerZones, dangerZones);
+    AppendRecords(buffer, header.strings, std::vector<char>(strings.begin(), strings.end()));
+    buffer.resize((buffer.size() + 3) & ~size_t(3));
+    header.fileSize = static_cast<uint32_t>(buffer.size());
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()))) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+void Decode(const FileView& view, TrackData& track) {
+    const Header& header = view.GetHeader();
+    track.name = view.String(header.nameOffset, header.nameLength);
+    track.trackWidth = header.trackWidth;
+    track.trackLength = header.trackLength;
+
+    // PointRecord and Vector2D share their layout, so points copy straight out of the mapping
+    static_assert(sizeof(PointRecord) == sizeof(Vector2D), "PointRecord must match Vector2D");
+    const Vector2D* points = view.Records<Vector2D>(header.points);
+    const SegmentRecord* segments = view.Records<SegmentRecord>(header.segments);
+    track.segments.resize(header.segments.count);
+    for (uint32_t i = 0; i < header.segments.count; ++i) {
+        TrackSegment& segment = track.segments[i];
+        segment.points.assign(points + segments[i].firstPoint, points + segments[i].firstPoint + segments[i].pointCount);
+        segment.terrain = static_cast<TerrainType>(segments[i].terrain);
+        segment.friction = segments[i].friction;
+    }
+
+    const Vector2D* starts = view.Records<Vector2D>(header.startPositions);
+    track.startPositions.assign(starts, starts + header.startPositions.count);
+    const Vector2D* spawns = view.Records<Vector2D>(header.spawnPoints);
+    track.powerUpSpawnPoints.assign(spawns, spawns + header.spawnPoints.count);
+
+    const RectRecord* checkpoints = view.Records<RectRecord>(header.checkpoints);
+    track.checkpoints.resize(header.checkpoints.count);
+    for (uint32_t i = 0; i < header.checkpoints.count; ++i) {
+        track.checkpoints[i] = FromRecord(checkpoints[i]);
+    }
+    const RectRecord* dangerZones = view.Records<RectRecord>(header.dangerZones);
+    track.dangerZones.resize(header.dangerZones.count);
+    for (uint32_t i = 0; i < header.dangerZones.count; ++i) {
+        track.dangerZones[i] = FromRecord(dangerZones[i]);
+    }
+
+    const ObstacleRecord* obstacles = view.Records<ObstacleRecord>(header.obstacles);
+    track.obstacles.resize(header.obstacles.count);
+    for (uint32_t i = 0; i < header.obstacles.count; ++i) {
+        Obstacle& obstacle = track.obstacles[i];
+        obstacle.position = Vector2D(obstacles[i].x, obstacles[i].y);
+        obstacle.rotation = obstacles[i].rotation;
+        obstacle.health = obstacles[i].health;
+        obstacle.bounds = FromRecord(obstacles[i].bounds);
+        obstacle.destructible = obstacles[i].destructible != 0;
+        obstacle.type = view.String(obstacles[i].typeOffset, obstacles[i].typeLength);
+    }
+}
+
+} // namespace TrackFormat
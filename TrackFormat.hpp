@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Track.hpp"
+
+// Everything a track file describes, independent of how it is stored
+struct TrackData {
+    std::string name;
+    int trackWidth = 0;
+    int trackLength = 0;
+    std::vector<TrackSegment> segments;
+    std::vector<SDL_Rect> checkpoints;
+    std::vector<Obstacle> obstacles;
+    std::vector<Vector2D> startPositions;
+    std::vector<Vector2D> powerUpSpawnPoints;
+    std::vector<SDL_Rect> dangerZones;
+};
+
+// Binary track format (.bktr). Little-endian, every record 4-byte aligned, so
+// a read-only mapping of the file can be used in place: the section tables
+// below point straight into the mapped bytes.
+//
+//   header | segments | points | checkpoints | obstacles | starts | spawns | danger zones | strings
+namespace TrackFormat {
+
+constexpr char MAGIC[4] = {'B', 'K', 'T', 'R'};
+constexpr uint32_t VERSION = 1;
+
+struct Section {
+    uint32_t offset; // bytes from the start of the file
+    uint32_t count;  // number of records
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t fileSize;
+    int32_t trackWidth;
+    int32_t trackLength;
+    uint32_t nameOffset; // into the strings section
+    uint32_t nameLength;
+    Section segments;
+    Section points;
+    Section checkpoints;
+    Section obstacles;
+    Section startPositions;
+    Section spawnPoints;
+    Section dangerZones;
+    Section strings; // count is the blob size in bytes
+};
+
+struct SegmentRecord {
+    uint32_t firstPoint;
+    uint32_t pointCount;
+    uint32_t terrain;
+    float friction;
+};
+
+struct PointRecord {
+    float x;
+    float y;
+};
+
+struct RectRecord {
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+};
+
+struct ObstacleRecord {
+    float x;
+    float y;
+    float rotation;
+    float health;
+    RectRecord bounds;
+    uint32_t destructible;
+    uint32_t typeOffset; // into the strings section
+    uint32_t typeLength;
+};
+
+// Read-only memory mapping of a binary track file
+class FileView {
+public:
+    FileView() = default;
+    ~FileView();
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    // Maps and validates the file; on failure error explains why
+    bool Open(const std::string& path, std::string& error);
+    void Close();
+
+    const Header& GetHeader() const { return *reinterpret_cast<const Header*>(data); }
+
+    template <typename T>
+    const T* Records(const Section& section) const {
+        return reinterpret_cast<const T*>(data + section.offset);
+    }
+    std::string String(uint32_t offset, uint32_t length) const {
+        return std::string(reinterpret_cast<const char*>(data + GetHeader().strings.offset + offset), length);
+    }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+// True if the stream/file starts with the binary magic
+bool IsBinaryTrack(const std::string& path);
+
+// Human-readable source format, one directive per line:
+//   track <name> | width <w> | length <l> | start <x> <y> | spawn <x> <y>
+//   checkpoint <x> <y> <w> <h> | danger <x> <y> <w> <h>
+//   obstacle <type> <x> <y> <w> <h> <rotation> <destructible> <health>
+//   segment <TERRAIN> <friction>, followed by its points: point <x> <y>
+bool ParseText(std::istream& in, TrackData& track, std::string& error);
+void WriteText(std::ostream& out, const TrackData& track);
+
+bool WriteBinary(const TrackData& track, const std::string& path, std::string& error);
+void Decode(const FileView& view, TrackData& track);
+
+const char* TerrainName(TerrainType terrain);
+bool ParseTerrain(const std::string& name, TerrainType& terrain);
+
+} // namespace TrackFormat
@@ -0,0 +1,333 @@
+#include "TrackSpatialIndex.hpp"
+#include <algorithm>
+#include <cfloat>
+
+namespace {
+
+// Keep the grid bounded on huge tracks by growing the cell size instead
+const long long MAX_CELLS = 1 << 22;
+
+}
+
+TrackSpatialIndex::TrackSpatialIndex()
+    : originX(0.0f), originY(0.0f), cellSize(1.0f), invCellSize(1.0f), cellsX(0), cellsY(0) {}
+
+void TrackSpatialIndex::Clear() {
+    edges.clear();
+    obstacles.clear();
+    dangerZones.clear();
+    edgeGrid = Grid();
+    obstacleGrid = Grid();
+    dangerGrid = Grid();
+    cellsX = cellsY = 0;
+}
+
+void TrackSpatialIndex::AddEdge(const Vector2D& a, const Vector2D& b, uint32_t segment) {
+    edges.push_back({a, b, segment});
+}
+
+void TrackSpatialIndex::AddObstacle(const SDL_Rect& bounds) {
+    obstacles.push_back(bounds);
+}
+
+void TrackSpatialIndex::AddDangerZone(const SDL_Rect& bounds) {
+    dangerZones.push_back(bounds);
+}
+
+void TrackSpatialIndex::Build(float requestedCellSize, float margin) {
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (const auto& edge : edges) {
+        minX = std::min({minX, edge.a.x - margin, edge.b.x - margin});
+        minY = std::min({minY, edge.a.y - margin, edge.b.y - margin});
+        maxX = std::max({maxX, edge.a.x + margin, edge.b.x + margin});
+        maxY = std::max({maxY, edge.a.y + margin, edge.b.y + margin});
+    }
+    for (const auto* boxes : {&obstacles, &dangerZones}) {
+        for (const auto& box : *boxes) {
+            minX = std::min(minX, static_cast<float>(box.x));
+            minY = std::min(minY, static_cast<float>(box.y));
+            maxX = std::max(maxX, static_cast<float>(box.x + box.w));
+            maxY = std::max(maxY, static_cast<float>(box.y + box.h));
+        }
+    }
+    if (minX > maxX) {
+        cellsX = cellsY = 0;
+        return;
+    }
+
+    cellSize = std::max(requestedCellSize, 1.0f);
+    for (;;) {
+        cellsX = static_cast<int>((maxX - minX) / cellSize) + 1;
+        cellsY = static_cast<int>((maxY - minY) / cellSize) + 1;
+        if (static_cast<long long>(cellsX) * cellsY <= MAX_CELLS) {
+            break;
+        }
+        cellSize *= 2.0f;
+    }
+    invCellSize = 1.0f / cellSize;
+    originX = minX;
+    originY = minY;
+
+    // Edges: only cells whose centre lies within margin (plus half a cell
+    // diagonal) of the edge, so long diagonal edges do not flood their AABB
+    const size_t cellCount = GetCellCount();
+    const float reach = margin + cellSize * 0.70710678f;
+    const float reachSq = reach * reach;
+    std::vector<std::vector<uint32_t>> buckets(cellCount);
+    for (uint32_t i = 0; i < edges.size(); ++i) {
+        const Edge& edge = edges[i];
+        int x0 = CellX(std::min(edge.a.x, edge.b.x) - margin);
+        int x1 = CellX(std::max(edge.a.x, edge.b.x) + margin);
+        int y0 = CellY(std::min(edge.a.y, edge.b.y) - margin);
+        int y1 = CellY(std::max(edge.a.y, edge.b.y) + margin);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                Vector2D centre(originX + (cx + 0.5f) * cellSize, originY + (cy + 0.5f) * cellSize);
+                if ((ClosestPointOnEdge(centre, edge.a, edge.b) - centre).LengthSquared() <= reachSq) {
+                    buckets[static_cast<size_t>(cy) * cellsX + cx].push_back(i);
+                }
+            }
+        }
+    }
+    edgeGrid.cellStart.assign(cellCount + 1, 0);
+    edgeGrid.items.clear();
+    for (size_t c = 0; c < cellCount; ++c) {
+        edgeGrid.cellStart[c] = static_cast<uint32_t>(edgeGrid.items.size());
+        edgeGrid.items.insert(edgeGrid.items.end(), buckets[c].begin(), buckets[c].end());
+    }
+    edgeGrid.cellStart[cellCount] = static_cast<uint32_t>(edgeGrid.items.size());
+
+    BinBoxes(obstacleGrid, obstacles);
+    BinBoxes(dangerGrid, dangerZones);
+}
+
+int TrackSpatialIndex::CellX(float x) const {
+    int cell = static_cast<int>(std::floor((x - originX) * invCellSize));
+    return std::max(0, std::min(cellsX - 1, cell));
+}
+
+int TrackSpatialIndex::CellY(float y) const {
+    int cell = static_cast<int>(std::floor((y - originY) * invCellSize));
+    return std::max(0, std::min(cellsY - 1, cell));
+}
+
+void TrackSpatialIndex::BinBoxes(Grid& grid, const std::vector<SDL_Rect>& boxes) {
+    const size_t cellCount = GetCellCount();
+    grid.cellStart.assign(cellCount + 1, 0);
+
+    // Two passes: count per cell, then scatter into the flat item array
+    for (const auto& box : boxes) {
+        for (int cy = CellY(static_cast<float>(box.y)); cy <= CellY(static_cast<float>(box.y + box.h)); ++cy) {
+            for (int cx = CellX(static_cast<float>(box.x)); cx <= CellX(static_cast<float>(box.x + box.w)); ++cx) {
+                ++grid.cellStart[static_cast<size_t>(cy) * cellsX + cx + 1];
+            }
+        }
+    }
+    for (size_t c = 0; c < cellCount; ++c) {
+        grid.cellStart[c + 1] += grid.cellStart[c];
+    }
+    grid.items.resize(grid.cellStart[cellCount]);
+    std::vector<uint32_t>& cursor = binCursor;
+    cursor.assign(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+        const SDL_Rect& box = boxes[i];
+        for (int cy = CellY(static_cast<float>(box.y)); cy <= CellY(static_cast<float>(box.y + box.h)); ++cy) {
+            for (int cx = CellX(static_cast<float>(box.x)); cx <= CellX(static_cast<float>(box.x + box.w)); ++cx) {
+                grid.items[cursor[static_cast<size_t>(cy) * cellsX + cx]++] = i;
+            }
+        }
+    }
+}
+
+void TrackSpatialIndex::SetObstacles(const std::vector<SDL_Rect>& bounds) {
+    bool rebin = bounds.size() != obstacles.size();
+    for (size_t i = 0; i < bounds.size() && !rebin; ++i) {
+        rebin = !SameCells(bounds[i], obstacles[i]);
+    }
+    obstacles.assign(bounds.begin(), bounds.end());
+    if (rebin && cellsX > 0) {
+        BinBoxes(obstacleGrid, obstacles);
+    }
+}
+
+bool TrackSpatialIndex::SameCells(const SDL_Rect& a, const SDL_Rect& b) const {
+    return CellX(static_cast<float>(a.x)) == CellX(static_cast<float>(b.x)) &&
+           CellX(static_cast<float>(a.x + a.w)) == CellX(static_cast<float>(b.x + b.w)) &&
+           CellY(static_cast<float>(a.y)) == CellY(static_cast<float>(b.y)) &&
+           CellY(static_cast<float>(a.y + a.h)) == CellY(static_cast<float>(b.y + b.h));
+}
+
+int TrackSpatialIndex::FindSegmentAt(const Vector2D& point, float maxDistance) const {
+    if (cellsX == 0 || edgeGrid.items.empty()) {
+        return -1;
+    }
+    float fx = (point.x - originX) * invCellSize;
+    float fy = (point.y - originY) * invCellSize;
+    if (fx < 0.0f || fy < 0.0f || fx >= cellsX || fy >= cellsY) {
+        return -1;
+    }
+
+    size_t cell = static_cast<size_t>(fy) * cellsX + static_cast<size_t>(fx);
+    float bestDistSq = maxDistance * maxDistance;
+    int bestSegment = -1;
+    for (uint32_t i = edgeGrid.cellStart[cell]; i < edgeGrid.cellStart[cell + 1]; ++i) {
+        const Edge& edge = edges[edgeGrid.items[i]];
+        float distSq = (ClosestPointOnEdge(point, edge.a, edge.b) - point).LengthSquared();
+        if (distSq <= bestDistSq) {
+            bestDistSq = distSq;
+            bestSegment = static_cast<int>(edge.segment);
+        }
+    }
+    return bestSegment;
+}
+
+bool TrackSpatialIndex::FindNearestPoint(const Vector2D& point, Vector2D& nearest, uint32_t* edgeIndex,
+                                         float maxDistance) const {
+    if (edges.empty()) {
+        return false;
+    }
+
+    const bool bounded = maxDistance < FLT_MAX;
+    float bestDistSq = bounded ? maxDistance * maxDistance : FLT_MAX;
+    bool found = false;
+    uint32_t bestEdge = 0;
+    auto visit = [&](uint32_t index) {
+        const Edge& edge = edges[index];
+        Vector2D candidate = ClosestPointOnEdge(point, edge.a, edge.b);
+        float distSq = (candidate - point).LengthSquared();
+        if (distSq < bestDistSq || (!found && distSq <= bestDistSq)) {
+            bestDistSq = distSq;
+            bestEdge = index;
+            nearest = candidate;
+            found = true;
+        }
+    };
+
+    float fx = (point.x - originX) * invCellSize;
+    float fy = (point.y - originY) * invCellSize;
+    if (cellsX == 0 || fx < 0.0f || fy < 0.0f || fx >= cellsX || fy >= cellsY) {
+        // Off the grid entirely: rare enough that a linear scan is fine
+        for (uint32_t i = 0; i < edges.size(); ++i) {
+            visit(i);
+        }
+    } else {
+        // Expand square rings around the point's cell. Anything beyond ring r
+        // is at least r * cellSize away, so stop once the best hit is closer
+        int cx = static_cast<int>(fx);
+        int cy = static_cast<int>(fy);
+        int maxRing = std::max({cx, cy, cellsX - 1 - cx, cellsY - 1 - cy});
+        if (bounded) {
+            maxRing = std::min(maxRing, static_cast<int>(maxDistance * invCellSize) + 1);
+        }
+        for (int ring = 0; ring <= maxRing; ++ring) {
+            for (int y = cy - ring; y <= cy + ring; ++y) {
+                if (y < 0 || y >= cellsY) {
+                    continue;
+                }
+                bool edgeRow = (y == cy - ring || y == cy + ring);
+                for (int x = cx - ring; x <= cx + ring; x += edgeRow ? 1 : 2 * ring) {
+                    if (x >= 0 && x < cellsX) {
+                        size_t cell = static_cast<size_t>(y) * cellsX + x;
+                        for (uint32_t i = edgeGrid.cellStart[cell]; i < edgeGrid.cellStart[cell + 1]; ++i) {
+                            visit(edgeGrid.items[i]);
+                        }
+                    }
+                    if (ring == 0) {
+                        break;
+                    }
+                }
+            }
+            float reached = ring * cellSize;
+            if (bestDistSq <= reached * reached) {
+                break;
+            }
+        }
+        if (!found && !bounded) {
+            for (uint32_t i = 0; i < edges.size(); ++i) {
+                visit(i);
+            }
+        }
+    }
+
+    if (found && edgeIndex) {
+        *edgeIndex = bestEdge;
+    }
+    return found;
+}
+
+bool TrackSpatialIndex::OverlapsAny(const Grid& grid, const std::vector<SDL_Rect>& boxes,
+                                    const SDL_Rect& rect, int* index) const {
+    if (cellsX == 0 || boxes.empty()) {
+        return false;
+    }
+    if (rect.x + rect.w < originX || rect.y + rect.h < originY ||
+        rect.x > originX + cellsX * cellSize || rect.y > originY + cellsY * cellSize) {
+        return false;
+    }
+    for (int cy = CellY(static_cast<float>(rect.y)); cy <= CellY(static_cast<float>(rect.y + rect.h)); ++cy) {
+        for (int cx = CellX(static_cast<float>(rect.x)); cx <= CellX(static_cast<float>(rect.x + rect.w)); ++cx) {
+            size_t cell = static_cast<size_t>(cy) * cellsX + cx;
+            for (uint32_t i = grid.cellStart[cell]; i < grid.cellStart[cell + 1]; ++i) {
+                if (RectsOverlap(rect, boxes[grid.items[i]])) {
+                    if (index) {
+                        *index = static_cast<int>(grid.items[i]);
+                    }
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool TrackSpatialIndex::OverlapsObstacle(const SDL_Rect& rect, int* obstacleIndex) const {
+    return OverlapsAny(obstacleGrid, obstacles, rect, obstacleIndex);
+}
+
+bool TrackSpatialIndex::OverlapsDangerZone(const SDL_Rect& rect) const {
+    return OverlapsAny(dangerGrid, dangerZones, rect, nullptr);
+}
+
+void TrackSpatialIndex::QueryEdges(float minX, float minY, float maxX, float maxY,
+                                   std::vector<uint32_t>& out) const {
+    QueryGrid(edgeGrid, minX, minY, maxX, maxY, out);
+}
+
+void TrackSpatialIndex::QueryObstacles(float minX, float minY, float maxX, float maxY,
+                                       std::vector<uint32_t>& out) const {
+    QueryGrid(obstacleGrid, minX, minY, maxX, maxY, out);
+}
+
+void TrackSpatialIndex::QueryGrid(const Grid& grid, float minX, float minY, float maxX, float maxY,
+                                  std::vector<uint32_t>& out) const {
+    if (cellsX == 0 || grid.items.empty()) {
+        return;
+    }
+    if (maxX < originX || maxY < originY ||
+        minX > originX + cellsX * cellSize || minY > originY + cellsY * cellSize) {
+        return;
+    }
+    for (int cy = CellY(minY); cy <= CellY(maxY); ++cy) {
+        for (int cx = CellX(minX); cx <= CellX(maxX); ++cx) {
+            size_t cell = static_cast<size_t>(cy) * cellsX + cx;
+            out.insert(out.end(), grid.items.begin() + grid.cellStart[cell],
+                       grid.items.begin() + grid.cellStart[cell + 1]);
+        }
+    }
+}
+
+Vector2D TrackSpatialIndex::ClosestPointOnEdge(const Vector2D& point, const Vector2D& a, const Vector2D& b) {
+    Vector2D ab = b - a;
+    float lengthSq = ab.LengthSquared();
+    if (lengthSq <= 0.0f) {
+        return a;
+    }
+    float t = (point - a).Dot(ab) / lengthSq;
+    t = std::max(0.0f, std::min(1.0f, t));
+    return a + ab * t;
+}
+
+bool TrackSpatialIndex::RectsOverlap(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w &&
+           a.y < b.y + b.h && b.y < a.y + a.h;
+}
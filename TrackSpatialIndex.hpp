@@ -0,0 +1,96 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include "Vector2D.hpp"
+
+// Uniform grid over track geometry, built once when a track is loaded.
+// Segment edges are inserted into every cell within `margin` of them (the
+// half track width), so "which segment contains this point" only has to look
+// at a single cell. Obstacles and danger zones are binned by their bounds.
+// Cells are stored CSR-style: one offset table plus one flat item array.
+class TrackSpatialIndex {
+public:
+    struct Edge {
+        Vector2D a;
+        Vector2D b;
+        uint32_t segment;
+    };
+
+    TrackSpatialIndex();
+
+    // Geometry is added first, then Build() bins everything into the grid
+    void Clear();
+    void AddEdge(const Vector2D& a, const Vector2D& b, uint32_t segment);
+    void AddObstacle(const SDL_Rect& bounds);
+    void AddDangerZone(const SDL_Rect& bounds);
+    void Build(float cellSize, float margin);
+    // Replaces the obstacle bounds after Build, when obstacles move, break
+    // or are restored from a snapshot. Only obstacles whose covered cells
+    // change make the obstacle grid rebin; moves within the same cells
+    // just update the bounds.
+    void SetObstacles(const std::vector<SDL_Rect>& bounds);
+
+    // Segment whose centerline is nearest to point, if within maxDistance; -1 otherwise
+    int FindSegmentAt(const Vector2D& point, float maxDistance) const;
+
+    // Closest point on any edge; returns false if there are no edges, or
+    // none within maxDistance (which also bounds how far the search goes)
+    bool FindNearestPoint(const Vector2D& point, Vector2D& nearest, uint32_t* edgeIndex = nullptr,
+                          float maxDistance = FLT_MAX) const;
+
+    bool OverlapsObstacle(const SDL_Rect& rect, int* obstacleIndex = nullptr) const;
+    bool OverlapsDangerZone(const SDL_Rect& rect) const;
+
+    // Appends the indices of edges whose cells overlap the box (may contain duplicates)
+    void QueryEdges(float minX, float minY, float maxX, float maxY, std::vector<uint32_t>& out) const;
+    // Same for obstacle bounds
+    void QueryObstacles(float minX, float minY, float maxX, float maxY, std::vector<uint32_t>& out) const;
+
+    const std::vector<Edge>& GetEdges() const { return edges; }
+    const std::vector<SDL_Rect>& GetObstacles() const { return obstacles; }
+    size_t GetCellCount() const { return static_cast<size_t>(cellsX) * cellsY; }
+    float GetCellSize() const { return cellSize; }
+    bool IsEmpty() const { return cellsX == 0; }
+    void GetBounds(float& minX, float& minY, float& maxX, float& maxY) const {
+        minX = originX;
+        minY = originY;
+        maxX = originX + cellsX * cellSize;
+        maxY = originY + cellsY * cellSize;
+    }
+
+    static Vector2D ClosestPointOnEdge(const Vector2D& point, const Vector2D& a, const Vector2D& b);
+    static bool RectsOverlap(const SDL_Rect& a, const SDL_Rect& b);
+
+private:
+    struct Grid {
+        std::vector<uint32_t> cellStart; // cellsX * cellsY + 1 offsets into items
+        std::vector<uint32_t> items;
+    };
+
+    int CellX(float x) const;
+    int CellY(float y) const;
+    void BinBoxes(Grid& grid, const std::vector<SDL_Rect>& boxes);
+    bool SameCells(const SDL_Rect& a, const SDL_Rect& b) const;
+    void QueryGrid(const Grid& grid, float minX, float minY, float maxX, float maxY,
+                   std::vector<uint32_t>& out) const;
+    bool OverlapsAny(const Grid& grid, const std::vector<SDL_Rect>& boxes,
+                     const SDL_Rect& rect, int* index) const;
+
+    std::vector<Edge> edges;
+    std::vector<SDL_Rect> obstacles;
+    std::vector<SDL_Rect> dangerZones;
+
+    Grid edgeGrid;
+    Grid obstacleGrid;
+    Grid dangerGrid;
+    std::vector<uint32_t> binCursor; // BinBoxes scratch, kept so rebins do not allocate
+
+    float originX;
+    float originY;
+    float cellSize;
+    float invCellSize;
+    int cellsX;
+    int cellsY;
+};
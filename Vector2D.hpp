@@ -52,8 +52,9 @@ public:
     void Normalize() {
         float len = Length();
         if (len > 0) {
-            x /= len;
-            y /= len;
+            float invLen = 1.0f / len;
+            x *= invLen;
+            y *= invLen;
         }
     }
     
@@ -76,7 +77,15 @@ public:
     }
     
     static Vector2D FromAngle(float angle) {
-        return Vector2D(std::cos(angle), std::sin(angle));
+        float s, c;
+        SinCos(angle, s, c);
+        return Vector2D(c, s);
+    }
+
+    // Sine and cosine of one angle; the compiler merges the pair into a single sincos call
+    static void SinCos(float angle, float& s, float& c) {
+        s = std::sin(angle);
+        c = std::cos(angle);
     }
 
     // Comparison operators
@@ -99,8 +108,10 @@ public:
     }
 
     void Rotate(float angle) {
-        float newX = x * std::cos(angle) - y * std::sin(angle);
-        float newY = x * std::sin(angle) + y * std::cos(angle);
+        float s, c;
+        SinCos(angle, s, c);
+        float newX = x * c - y * s;
+        float newY = x * s + y * c;
         x = newX;
         y = newY;
     }
@@ -0,0 +1,444 @@
+#include "VectorBatch.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define VECTOR_BATCH_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define VECTOR_BATCH_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+namespace {
+
+// Cephes single precision sincos: range reduction by pi/4 in three parts,
+// then a minimax polynomial for each octant
+constexpr float FOUR_OVER_PI = 1.27323954473516f;
+constexpr float DP1 = 0.78515625f;
+constexpr float DP2 = 2.4187564849853515625e-4f;
+constexpr float DP3 = 3.77489497744594108e-8f;
+constexpr float SIN_C0 = -1.9515295891e-4f;
+constexpr float SIN_C1 = 8.3321608736e-3f;
+constexpr float SIN_C2 = -1.6666654611e-1f;
+constexpr float COS_C0 = 2.443315711809948e-5f;
+constexpr float COS_C1 = -1.388731625493765e-3f;
+constexpr float COS_C2 = 4.166664568298827e-2f;
+
+uint32_t FloatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float BitsToFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Scalar reference; the SIMD versions below perform the same operations in the same order
+void SinCosScalar(float angle, float& outSin, float& outCos) {
+    uint32_t bits = FloatBits(angle);
+    uint32_t signSin = bits & 0x80000000u;
+    float x = BitsToFloat(bits & 0x7FFFFFFFu);
+
+    float y = x * FOUR_OVER_PI;
+    int32_t j = static_cast<int32_t>(y);
+    j = (j + 1) & ~1;
+    y = static_cast<float>(j);
+
+    uint32_t swapSin = static_cast<uint32_t>(j & 4) << 29;
+    uint32_t signCos = static_cast<uint32_t>(~(j - 2) & 4) << 29;
+    bool sinPoly = (j & 2) == 0;
+    signSin ^= swapSin;
+
+    x = ((x - y * DP1) - y * DP2) - y * DP3;
+    float z = x * x;
+
+    float cosPoly = COS_C0;
+    cosPoly = cosPoly * z + COS_C1;
+    cosPoly = cosPoly * z + COS_C2;
+    cosPoly = cosPoly * z;
+    cosPoly = cosPoly * z;
+    cosPoly = cosPoly - z * 0.5f;
+    cosPoly = cosPoly + 1.0f;
+
+    float sinPolyValue = SIN_C0;
+    sinPolyValue = sinPolyValue * z + SIN_C1;
+    sinPolyValue = sinPolyValue * z + SIN_C2;
+    sinPolyValue = sinPolyValue * z;
+    sinPolyValue = sinPolyValue * x;
+    sinPolyValue = sinPolyValue + x;
+
+    float s = sinPoly ? sinPolyValue : cosPoly;
+    float c = sinPoly ? cosPoly : sinPolyValue;
+    outSin = BitsToFloat(FloatBits(s) ^ signSin);
+    outCos = BitsToFloat(FloatBits(c) ^ signCos);
+}
+
+void IntegrateScalar(float* posX, float* posY, const float* velX, const float* velY,
+                     size_t begin, size_t count, float deltaTime) {
+    for (size_t i = begin; i < count; ++i) {
+        posX[i] = posX[i] + velX[i] * deltaTime;
+        posY[i] = posY[i] + velY[i] * deltaTime;
+    }
+}
+
+void RotateScalar(float* x, float* y, const float* angles, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        float s, c;
+        SinCosScalar(angles[i], s, c);
+        float newX = x[i] * c - y[i] * s;
+        float newY = x[i] * s + y[i] * c;
+        x[i] = newX;
+        y[i] = newY;
+    }
+}
+
+void NormalizeScalar(float* x, float* y, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        float len = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+        if (len > 0.0f) {
+            float invLen = 1.0f / len;
+            x[i] = x[i] * invLen;
+            y[i] = y[i] * invLen;
+        }
+    }
+}
+
+void DistanceScalar(const float* x, const float* y, size_t begin, size_t count,
+                    float pointX, float pointY, float* outDistance) {
+    for (size_t i = begin; i < count; ++i) {
+        float dx = x[i] - pointX;
+        float dy = y[i] - pointY;
+        outDistance[i] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+void SinCosArrayScalar(const float* angles, float* outSin, float* outCos, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        SinCosScalar(angles[i], outSin[i], outCos[i]);
+    }
+}
+
+#ifdef VECTOR_BATCH_SSE2
+void SinCosSSE2(__m128 angle, __m128& outSin, __m128& outCos) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+    __m128 signSin = _mm_and_ps(angle, signMask);
+    __m128 x = _mm_andnot_ps(signMask, angle);
+
+    __m128 y = _mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI));
+    __m128i j = _mm_cvttps_epi32(y);
+    j = _mm_add_epi32(j, _mm_set1_epi32(1));
+    j = _mm_and_si128(j, _mm_set1_epi32(~1));
+    y = _mm_cvtepi32_ps(j);
+
+    __m128i swapSin = _mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29);
+    __m128i signCos = _mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29);
+    __m128 sinPoly = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(swapSin));
+
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 cosPoly = _mm_set1_ps(COS_C0);
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_C1));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_C2));
+    cosPoly = _mm_mul_ps(cosPoly, z);
+    cosPoly = _mm_mul_ps(cosPoly, z);
+    cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+    __m128 sinPolyValue = _mm_set1_ps(SIN_C0);
+    sinPolyValue = _mm_add_ps(_mm_mul_ps(sinPolyValue, z), _mm_set1_ps(SIN_C1));
+    sinPolyValue = _mm_add_ps(_mm_mul_ps(sinPolyValue, z), _mm_set1_ps(SIN_C2));
+    sinPolyValue = _mm_mul_ps(sinPolyValue, z);
+    sinPolyValue = _mm_mul_ps(sinPolyValue, x);
+    sinPolyValue = _mm_add_ps(sinPolyValue, x);
+
+    __m128 s = _mm_or_ps(_mm_and_ps(sinPoly, sinPolyValue), _mm_andnot_ps(sinPoly, cosPoly));
+    __m128 c = _mm_or_ps(_mm_and_ps(sinPoly, cosPoly), _mm_andnot_ps(sinPoly, sinPolyValue));
+    outSin = _mm_xor_ps(s, signSin);
+    outCos = _mm_xor_ps(c, _mm_castsi128_ps(signCos));
+}
+
+void IntegrateSSE2(float* posX, float* posY, const float* velX, const float* velY,
+                   size_t count, float deltaTime) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(_mm_loadu_ps(velX + i), dt));
+        __m128 py = _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(_mm_loadu_ps(velY + i), dt));
+        _mm_storeu_ps(posX + i, px);
+        _mm_storeu_ps(posY + i, py);
+    }
+    IntegrateScalar(posX, posY, velX, velY, i, count, deltaTime);
+}
+
+void RotateSSE2(float* x, float* y, const float* angles, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 s, c;
+        SinCosSSE2(_mm_loadu_ps(angles + i), s, c);
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        _mm_storeu_ps(x + i, _mm_sub_ps(_mm_mul_ps(vx, c), _mm_mul_ps(vy, s)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(vx, s), _mm_mul_ps(vy, c)));
+    }
+    RotateScalar(x, y, angles, i, count);
+}
+
+void NormalizeSSE2(float* x, float* y, size_t count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+        __m128 nonZero = _mm_cmpgt_ps(len, _mm_setzero_ps());
+        __m128 invLen = _mm_div_ps(one, len);
+        __m128 nx = _mm_mul_ps(vx, invLen);
+        __m128 ny = _mm_mul_ps(vy, invLen);
+        _mm_storeu_ps(x + i, _mm_or_ps(_mm_and_ps(nonZero, nx), _mm_andnot_ps(nonZero, vx)));
+        _mm_storeu_ps(y + i, _mm_or_ps(_mm_and_ps(nonZero, ny), _mm_andnot_ps(nonZero, vy)));
+    }
+    NormalizeScalar(x, y, i, count);
+}
+
+void DistanceSSE2(const float* x, const float* y, size_t count,
+                  float pointX, float pointY, float* outDistance) {
+    const __m128 px = _mm_set1_ps(pointX);
+    const __m128 py = _mm_set1_ps(pointY);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), py);
+        _mm_storeu_ps(outDistance + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+    }
+    DistanceScalar(x, y, i, count, pointX, pointY, outDistance);
+}
+
+void SinCosArraySSE2(const float* angles, float* outSin, float* outCos, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 s, c;
+        SinCosSSE2(_mm_loadu_ps(angles + i), s, c);
+        _mm_storeu_ps(outSin + i, s);
+        _mm_storeu_ps(outCos + i, c);
+    }
+    SinCosArrayScalar(angles, outSin, outCos, i, count);
+}
+#endif
+
+#ifdef VECTOR_BATCH_AVX2
+AVX2_TARGET void SinCosAVX2(__m256 angle, __m256& outSin, __m256& outCos) {
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000u)));
+    __m256 signSin = _mm256_and_ps(angle, signMask);
+    __m256 x = _mm256_andnot_ps(signMask, angle);
+
+    __m256 y = _mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI));
+    __m256i j = _mm256_cvttps_epi32(y);
+    j = _mm256_add_epi32(j, _mm256_set1_epi32(1));
+    j = _mm256_and_si256(j, _mm256_set1_epi32(~1));
+    y = _mm256_cvtepi32_ps(j);
+
+    __m256i swapSin = _mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29);
+    __m256i signCos = _mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29);
+    __m256 sinPoly = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+    signSin = _mm256_xor_ps(signSin, _mm256_castsi256_ps(swapSin));
+
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP1)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP2)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP3)));
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 cosPoly = _mm256_set1_ps(COS_C0);
+    cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_C1));
+    cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_C2));
+    cosPoly = _mm256_mul_ps(cosPoly, z);
+    cosPoly = _mm256_mul_ps(cosPoly, z);
+    cosPoly = _mm256_sub_ps(cosPoly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+    __m256 sinPolyValue = _mm256_set1_ps(SIN_C0);
+    sinPolyValue = _mm256_add_ps(_mm256_mul_ps(sinPolyValue, z), _mm256_set1_ps(SIN_C1));
+    sinPolyValue = _mm256_add_ps(_mm256_mul_ps(sinPolyValue, z), _mm256_set1_ps(SIN_C2));
+    sinPolyValue = _mm256_mul_ps(sinPolyValue, z);
+    sinPolyValue = _mm256_mul_ps(sinPolyValue, x);
+    sinPolyValue = _mm256_add_ps(sinPolyValue, x);
+
+    __m256 s = _mm256_blendv_ps(cosPoly, sinPolyValue, sinPoly);
+    __m256 c = _mm256_blendv_ps(sinPolyValue, cosPoly, sinPoly);
+    outSin = _mm256_xor_ps(s, signSin);
+    outCos = _mm256_xor_ps(c, _mm256_castsi256_ps(signCos));
+}
+
+AVX2_TARGET void IntegrateAVX2(float* posX, float* posY, const float* velX, const float* velY,
+                               size_t count, float deltaTime) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_add_ps(_mm256_loadu_ps(posX + i), _mm256_mul_ps(_mm256_loadu_ps(velX + i), dt));
+        __m256 py = _mm256_add_ps(_mm256_loadu_ps(posY + i), _mm256_mul_ps(_mm256_loadu_ps(velY + i), dt));
+        _mm256_storeu_ps(posX + i, px);
+        _mm256_storeu_ps(posY + i, py);
+    }
+    IntegrateScalar(posX, posY, velX, velY, i, count, deltaTime);
+}
+
+AVX2_TARGET void RotateAVX2(float* x, float* y, const float* angles, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 s, c;
+        SinCosAVX2(_mm256_loadu_ps(angles + i), s, c);
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        _mm256_storeu_ps(x + i, _mm256_sub_ps(_mm256_mul_ps(vx, c), _mm256_mul_ps(vy, s)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_mul_ps(vx, s), _mm256_mul_ps(vy, c)));
+    }
+    RotateScalar(x, y, angles, i, count);
+}
+
+AVX2_TARGET void NormalizeAVX2(float* x, float* y, size_t count) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+        __m256 nonZero = _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ);
+        __m256 invLen = _mm256_div_ps(one, len);
+        _mm256_storeu_ps(x + i, _mm256_blendv_ps(vx, _mm256_mul_ps(vx, invLen), nonZero));
+        _mm256_storeu_ps(y + i, _mm256_blendv_ps(vy, _mm256_mul_ps(vy, invLen), nonZero));
+    }
+    NormalizeScalar(x, y, i, count);
+}
+
+AVX2_TARGET void DistanceAVX2(const float* x, const float* y, size_t count,
+                              float pointX, float pointY, float* outDistance) {
+    const __m256 px = _mm256_set1_ps(pointX);
+    const __m256 py = _mm256_set1_ps(pointY);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), px);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), py);
+        _mm256_storeu_ps(outDistance + i, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))));
+    }
+    DistanceScalar(x, y, i, count, pointX, pointY, outDistance);
+}
+
+AVX2_TARGET void SinCosArrayAVX2(const float* angles, float* outSin, float* outCos, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 s, c;
+        SinCosAVX2(_mm256_loadu_ps(angles + i), s, c);
+        _mm256_storeu_ps(outSin + i, s);
+        _mm256_storeu_ps(outCos + i, c);
+    }
+    SinCosArrayScalar(angles, outSin, outCos, i, count);
+}
+#endif
+
+VectorBatch::Backend DetectBackend() {
+#ifdef VECTOR_BATCH_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return VectorBatch::Backend::AVX2;
+    }
+#endif
+#ifdef VECTOR_BATCH_SSE2
+    return VectorBatch::Backend::SSE2;
+#else
+    return VectorBatch::Backend::SCALAR;
+#endif
+}
+
+const VectorBatch::Backend bestBackend = DetectBackend();
+VectorBatch::Backend activeBackend = bestBackend;
+
+} // namespace
+
+void VectorBatch::Integrate(float* posX, float* posY, const float* velX, const float* velY,
+                            size_t count, float deltaTime) {
+    switch (activeBackend) {
+#ifdef VECTOR_BATCH_AVX2
+    case Backend::AVX2: IntegrateAVX2(posX, posY, velX, velY, count, deltaTime); return;
+#endif
+#ifdef VECTOR_BATCH_SSE2
+    case Backend::SSE2: IntegrateSSE2(posX, posY, velX, velY, count, deltaTime); return;
+#endif
+    default: IntegrateScalar(posX, posY, velX, velY, 0, count, deltaTime); return;
+    }
+}
+
+void VectorBatch::RotateByAngles(float* x, float* y, const float* angles, size_t count) {
+    switch (activeBackend) {
+#ifdef VECTOR_BATCH_AVX2
+    case Backend::AVX2: RotateAVX2(x, y, angles, count); return;
+#endif
+#ifdef VECTOR_BATCH_SSE2
+    case Backend::SSE2: RotateSSE2(x, y, angles, count); return;
+#endif
+    default: RotateScalar(x, y, angles, 0, count); return;
+    }
+}
+
+void VectorBatch::Normalize(float* x, float* y, size_t count) {
+    switch (activeBackend) {
+#ifdef VECTOR_BATCH_AVX2
+    case Backend::AVX2: NormalizeAVX2(x, y, count); return;
+#endif
+#ifdef VECTOR_BATCH_SSE2
+    case Backend::SSE2: NormalizeSSE2(x, y, count); return;
+#endif
+    default: NormalizeScalar(x, y, 0, count); return;
+    }
+}
+
+void VectorBatch::DistanceToPoint(const float* x, const float* y, size_t count,
+                                  const Vector2D& point, float* outDistance) {
+    switch (activeBackend) {
+#ifdef VECTOR_BATCH_AVX2
+    case Backend::AVX2: DistanceAVX2(x, y, count, point.x, point.y, outDistance); return;
+#endif
+#ifdef VECTOR_BATCH_SSE2
+    case Backend::SSE2: DistanceSSE2(x, y, count, point.x, point.y, outDistance); return;
+#endif
+    default: DistanceScalar(x, y, 0, count, point.x, point.y, outDistance); return;
+    }
+}
+
+void VectorBatch::SinCos(const float* angles, float* outSin, float* outCos, size_t count) {
+    switch (activeBackend) {
+#ifdef VECTOR_BATCH_AVX2
+    case Backend::AVX2: SinCosArrayAVX2(angles, outSin, outCos, count); return;
+#endif
+#ifdef VECTOR_BATCH_SSE2
+    case Backend::SSE2: SinCosArraySSE2(angles, outSin, outCos, count); return;
+#endif
+    default: SinCosArrayScalar(angles, outSin, outCos, 0, count); return;
+    }
+}
+
+VectorBatch::Backend VectorBatch::GetBackend() {
+    return activeBackend;
+}
+
+const char* VectorBatch::GetBackendName() {
+    switch (activeBackend) {
+    case Backend::AVX2: return "AVX2";
+    case Backend::SSE2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+void VectorBatch::SetBackend(Backend backend) {
+    if (static_cast<int>(backend) <= static_cast<int>(bestBackend)) {
+        activeBackend = backend;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include "Vector2D.hpp"
+
+// Batch Vector2D operations over structure-of-arrays spans (separate x and y
+// arrays). Each call dispatches once to an AVX2, SSE2 or scalar kernel picked
+// at startup from the running CPU. All backends use the same sincos
+// polynomial and no fused multiply-add, so results are bit-identical whichever
+// kernel runs; the simulation stays deterministic across machines.
+class VectorBatch {
+public:
+    enum class Backend {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    // position += velocity * deltaTime
+    static void Integrate(float* posX, float* posY, const float* velX, const float* velY,
+                          size_t count, float deltaTime);
+
+    // Rotates each (x[i], y[i]) by angles[i] radians using a fused sincos
+    static void RotateByAngles(float* x, float* y, const float* angles, size_t count);
+
+    // Normalizes each vector in place; zero-length vectors are left unchanged
+    static void Normalize(float* x, float* y, size_t count);
+
+    // outDistance[i] = |(x[i], y[i]) - point|
+    static void DistanceToPoint(const float* x, const float* y, size_t count,
+                                const Vector2D& point, float* outDistance);
+
+    // Fused sine and cosine of every angle; accurate to ~1e-7 for |angle| < 8192
+    static void SinCos(const float* angles, float* outSin, float* outCos, size_t count);
+
+    static Backend GetBackend();
+    static const char* GetBackendName();
+
+    // Forces a backend (e.g. for benchmarks); ignored if the CPU lacks it
+    static void SetBackend(Backend backend);
+};
@@ -0,0 +1,160 @@
+// Drives a full field of AI racers round a synthetic track and measures the
+// controller's cost per tick against the 1 ms budget for 100 racers. The
+// field is split evenly between difficulties, and the distance each
+// difficulty covers shows the lookahead paying off. Bikes move with the real
+// physics step (no collisions), and the run is repeated to check that the
+// AI is deterministic. Each difficulty's lap time, projected from the
+// distance it covers, is checked against a reference recorded from this
+// controller, so a change that makes the AI drive slower fails the check,
+// and every difficulty has to lap faster than the one below it.
+#include "AIRacerController.hpp"
+#include "BikePhysics.hpp"
+#include "Track.hpp"
+#include "TrackFormat.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int RACER_COUNT = 100;
+const int TICKS = 60 * 120;
+const float DELTA_TIME = 1.0f / 60.0f;
+const int POINTS_PER_SEGMENT = 16;
+const double BUDGET_MS = 1.0;
+const char* TRACK_FILE = "ai_racer_bench.bktr";
+const char* DIFFICULTY_NAMES[] = {"easy", "medium", "hard", "extreme"};
+// Seconds per lap of MakeTrack, mixed bike classes; a lap may take this
+// much longer before the check fails
+const double REFERENCE_LAP_SECONDS[] = {229.0, 180.4, 164.6, 122.6};
+const double LAP_TIME_TOLERANCE = 0.05;
+
+// A closed loop of eight lobes with tight bends between them, segments
+// sharing their end points
+TrackData MakeTrack() {
+    TrackData track;
+    track.name = "ai_bench";
+    track.trackWidth = 160;
+    const int pointCount = 480;
+    std::vector<Vector2D> points;
+    for (int i = 0; i <= pointCount; ++i) {
+        float angle = 6.2831853f * (i % pointCount) / pointCount;
+        points.push_back(Vector2D::FromAngle(angle) * (2000.0f + 1500.0f * std::sin(angle * 8.0f)));
+    }
+    for (int first = 0; first < pointCount; first += POINTS_PER_SEGMENT) {
+        TrackSegment segment;
+        segment.terrain = TerrainType::ASPHALT;
+        segment.friction = 1.0f;
+        segment.points.assign(points.begin() + first, points.begin() + std::min(first + POINTS_PER_SEGMENT, pointCount) + 1);
+        track.segments.push_back(segment);
+    }
+    track.trackLength = pointCount * 40;
+    return track;
+}
+
+struct RunResult {
+    double meanMs = 0.0;
+    double p99Ms = 0.0;
+    double distance[4] = {};
+    uint64_t hash = 0;
+    size_t linePoints = 0;
+};
+
+RunResult Run(const Track& track) {
+    BikeStateStore states(RACER_COUNT);
+    AIRacerController controller;
+    controller.SetTrack(&track);
+    const RacingLine& line = controller.GetRacingLine();
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> slotsByType[BIKE_TYPE_COUNT];
+    std::vector<float> lastProgress(RACER_COUNT);
+
+    // Spread round the lap so the field does not start stacked on one point
+    for (int r = 0; r < RACER_COUNT; ++r) {
+        uint32_t slot = states.Allocate();
+        slots.push_back(slot);
+        size_t index = r * line.Size() / RACER_COUNT;
+        Vector2D position = line.GetPoint(index);
+        Vector2D next = line.GetPoint((index + 1) % line.Size());
+        states.SetPosition(slot, position);
+        states.rotation[slot] = (next - position).Angle();
+        BikeType type = static_cast<BikeType>(r % BIKE_TYPE_COUNT);
+        controller.AddRacer(static_cast<uint32_t>(r), slot, type, static_cast<Difficulty>(r % 4));
+        slotsByType[static_cast<size_t>(type)].push_back(slot);
+        lastProgress[r] = track.GetProgress(position);
+    }
+
+    RunResult result;
+    result.linePoints = line.Size();
+    std::vector<AIRacerController::Context> context(RACER_COUNT, {false, 0.0f});
+    std::vector<BikeInputMask> inputs(RACER_COUNT);
+    const BikeInputMask driving = BikeInput::ACCELERATE | BikeInput::BRAKE | BikeInput::LEAN_LEFT |
+                                  BikeInput::LEAN_RIGHT | BikeInput::BOOST;
+    std::vector<double> tickMs;
+    float lapLength = track.GetLapLength();
+    for (int tick = 0; tick < TICKS; ++tick) {
+        auto start = std::chrono::steady_clock::now();
+        controller.Update(states, context.data(), inputs.data());
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.meanMs += ms / TICKS;
+        tickMs.push_back(ms);
+
+        for (int r = 0; r < RACER_COUNT; ++r) {
+            states.controls[slots[controller.GetBike(r)]] = inputs[r] & driving;
+        }
+        for (size_t type = 0; type < BIKE_TYPE_COUNT; ++type) {
+            BikePhysics::Step(static_cast<BikeType>(type), states, slotsByType[type].data(), slotsByType[type].size(),
+                              DELTA_TIME);
+        }
+        states.Integrate(DELTA_TIME);
+
+        // Distance along the lap, unwrapped across the start line
+        for (int r = 0; r < RACER_COUNT; ++r) {
+            float progress = track.GetProgress(states.GetPosition(slots[r]));
+            float moved = progress - lastProgress[r];
+            moved += moved < -0.5f * lapLength ? lapLength : (moved > 0.5f * lapLength ? -lapLength : 0.0f);
+            result.distance[r % 4] += moved / (RACER_COUNT / 4);
+            lastProgress[r] = progress;
+        }
+    }
+    std::nth_element(tickMs.begin(), tickMs.begin() + TICKS * 99 / 100, tickMs.end());
+    result.p99Ms = tickMs[TICKS * 99 / 100];
+    result.hash = states.Hash();
+    return result;
+}
+
+}
+
+int main() {
+    std::string error;
+    if (!TrackFormat::WriteBinary(MakeTrack(), TRACK_FILE, error)) {
+        std::printf("cannot write %s: %s\n", TRACK_FILE, error.c_str());
+        return 1;
+    }
+    Track track("ai_bench");
+    track.Load(TRACK_FILE);
+    std::remove(TRACK_FILE);
+
+    RunResult first = Run(track);
+    RunResult second = Run(track);
+    float lapLength = track.GetLapLength();
+    std::printf("track    lap %.0f px, racing line %zu points\n", lapLength, first.linePoints);
+    std::printf("ai       %d racers, %d ticks: mean %.3f ms/tick, p99 %.3f ms (budget %.1f ms)\n", RACER_COUNT,
+                TICKS, first.meanMs, first.p99Ms, BUDGET_MS);
+    bool lapTimesOk = true;
+    for (int level = 0; level < 4; ++level) {
+        double lapSeconds = TICKS * DELTA_TIME * lapLength / std::max(first.distance[level], 1.0);
+        lapTimesOk = lapTimesOk && lapSeconds <= REFERENCE_LAP_SECONDS[level] * (1.0 + LAP_TIME_TOLERANCE) &&
+                     (level == 0 || first.distance[level] > first.distance[level - 1]);
+        std::printf("%-8s lookahead %2d points: %.2f laps in %d s, lap %.1f s (reference %.1f s)\n",
+                    DIFFICULTY_NAMES[level], AIRacerController::LOOKAHEAD_POINTS[level],
+                    first.distance[level] / lapLength, TICKS / 60, lapSeconds, REFERENCE_LAP_SECONDS[level]);
+    }
+
+    bool ok = first.meanMs < BUDGET_MS && first.hash == second.hash && lapTimesOk;
+    std::printf("check    %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// Measures the per-class bike physics step against the same step written
+// with runtime parameters: bikes in spawn order, each bike's class looked up
+// as it is reached and its controls tested with branches. Controls change
+// randomly every step, so those branches do not predict. Both versions run
+// the same steps from the same state and must end bit-identical.
+#include "BikeInput.hpp"
+#include "BikePhysics.hpp"
+#include "VectorBatch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int BIKE_COUNT = 10000;
+const int STEPS = 500;
+const int CONTROL_ROWS = 64;
+const float DELTA_TIME = 1.0f / 60.0f;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StepDynamic(BikeStateStore& states, const std::vector<BikeType>& types, std::vector<float>& sinRot,
+                 std::vector<float>& cosRot, float deltaTime) {
+    size_t count = states.Size();
+    VectorBatch::SinCos(states.rotation.data(), sinRot.data(), cosRot.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        BikeStats stats = GetBikeStats(types[i]);
+        uint16_t control = states.controls[i];
+        float headingX = cosRot[i];
+        float headingY = sinRot[i];
+        float velX = states.velocityX[i];
+        float velY = states.velocityY[i];
+        float forward = velX * headingX + velY * headingY;
+        float slip = velY * headingX - velX * headingY;
+
+        float drive = 0.0f;
+        if (control & BikeInput::ACCELERATE) {
+            drive = stats.acceleration;
+            if (control & BikeInput::BOOST) {
+                drive *= 1.0f + BikePhysics::NITRO_ACCELERATION_BONUS;
+            }
+        }
+        forward += drive * deltaTime;
+        float brakeDeceleration = stats.brakeForce / stats.mass;
+        float resist = BikePhysics::DRAG_COEFFICIENT / stats.mass * forward * forward;
+        if (control & BikeInput::BRAKE) {
+            resist = brakeDeceleration + resist;
+        }
+        float cap = stats.maxSpeed;
+        if (control & BikeInput::BOOST) {
+            cap *= 1.0f + BikePhysics::NITRO_SPEED_BONUS;
+        }
+        float speed = std::fabs(forward) - resist * deltaTime;
+        if (speed < 0.0f) {
+            speed = 0.0f;
+        }
+        if (speed > cap) {
+            speed = cap;
+        }
+        forward = std::copysign(speed, forward);
+        slip *= std::max(0.0f, 1.0f - stats.grip * deltaTime);
+        states.velocityX[i] = headingX * forward - headingY * slip;
+        states.velocityY[i] = headingY * forward + headingX * slip;
+
+        float lean = 0.0f;
+        if (control & BikeInput::LEAN_RIGHT) {
+            lean += 1.0f;
+        }
+        if (control & BikeInput::LEAN_LEFT) {
+            lean -= 1.0f;
+        }
+        float angle = states.rotation[i];
+        if (lean != 0.0f) {
+            angle += lean * std::min(stats.handling, speed * (1.0f / stats.wheelBase)) * deltaTime;
+        }
+        states.rotation[i] = angle - 6.28318531f * static_cast<float>(static_cast<int32_t>(angle * (1.0f / 6.28318531f)));
+
+        float load = -drive;
+        if (control & BikeInput::BRAKE) {
+            load = brakeDeceleration - drive;
+        }
+        load *= stats.mass / stats.suspensionStiffness;
+        load = std::max(-BikePhysics::MAX_SUSPENSION_TRAVEL, std::min(BikePhysics::MAX_SUSPENSION_TRAVEL, load));
+        float& travel = states.suspensionTravel[i];
+        travel += (load - travel) * std::min(1.0f, stats.damping * deltaTime);
+    }
+}
+
+void Spawn(BikeStateStore& states, std::mt19937& rng) {
+    std::uniform_real_distribution<float> velocity(-300.0f, 300.0f);
+    std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+    for (int i = 0; i < BIKE_COUNT; ++i) {
+        uint32_t slot = states.Allocate();
+        states.SetVelocity(slot, Vector2D(velocity(rng), velocity(rng)));
+        states.rotation[slot] = angle(rng);
+    }
+}
+
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::vector<BikeType> types;
+    for (int i = 0; i < BIKE_COUNT; ++i) {
+        types.push_back(static_cast<BikeType>(rng() % BIKE_TYPE_COUNT));
+    }
+    // Random driving inputs, one row per step, reused round-robin
+    std::vector<uint16_t> controls(static_cast<size_t>(BIKE_COUNT) * CONTROL_ROWS);
+    for (auto& control : controls) {
+        control = static_cast<uint16_t>(rng() & (BikeInput::ACCELERATE | BikeInput::BRAKE | BikeInput::LEAN_LEFT |
+                                                  BikeInput::LEAN_RIGHT | BikeInput::BOOST));
+    }
+
+    std::mt19937 spawnRng(7);
+    BikeStateStore dynamicStates(BIKE_COUNT);
+    Spawn(dynamicStates, spawnRng);
+    spawnRng.seed(7);
+    BikeStateStore batchedStates(BIKE_COUNT);
+    Spawn(batchedStates, spawnRng);
+
+    // Slots grouped per class, as Game builds them
+    std::vector<uint32_t> slotsByType[BIKE_TYPE_COUNT];
+    for (uint32_t i = 0; i < BIKE_COUNT; ++i) {
+        slotsByType[static_cast<size_t>(types[i])].push_back(i);
+    }
+
+    std::vector<float> sinRot(BIKE_COUNT);
+    std::vector<float> cosRot(BIKE_COUNT);
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < STEPS; ++step) {
+        std::memcpy(dynamicStates.controls.data(), controls.data() + (step % CONTROL_ROWS) * BIKE_COUNT,
+                    BIKE_COUNT * sizeof(uint16_t));
+        StepDynamic(dynamicStates, types, sinRot, cosRot, DELTA_TIME);
+    }
+    double dynamicSeconds = Seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int step = 0; step < STEPS; ++step) {
+        std::memcpy(batchedStates.controls.data(), controls.data() + (step % CONTROL_ROWS) * BIKE_COUNT,
+                    BIKE_COUNT * sizeof(uint16_t));
+        for (size_t type = 0; type < BIKE_TYPE_COUNT; ++type) {
+            BikePhysics::Step(static_cast<BikeType>(type), batchedStates, slotsByType[type].data(),
+                              slotsByType[type].size(), DELTA_TIME);
+        }
+    }
+    double batchedSeconds = Seconds(start);
+
+    double bikeSteps = static_cast<double>(BIKE_COUNT) * STEPS;
+    std::printf("bikes    %d in %zu classes, %d steps, sincos backend %s\n", BIKE_COUNT, BIKE_TYPE_COUNT, STEPS,
+                VectorBatch::GetBackendName());
+    std::printf("dynamic  %.1f ns/bike (runtime parameters, branches on controls)\n", dynamicSeconds * 1e9 / bikeSteps);
+    std::printf("batched  %.1f ns/bike (per-class step, branch-free)  %.2fx\n", batchedSeconds * 1e9 / bikeSteps,
+                dynamicSeconds / batchedSeconds);
+
+    bool match = dynamicStates.Hash() == batchedStates.Hash();
+    std::printf("check    %s\n", match ? "ok" : "MISMATCH");
+    return match ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+// Measures LeaderboardStore on a tournament-sized import: bulk import, live
+// submissions, rank and top-K queries, and saving/loading the boards as
+// sorted runs. Every answer is checked against a plain sort of all runs;
+// submissions are also timed against a sorted vector with a linear player
+// lookup, which is how a flat leaderboard handles them.
+#include "LeaderboardStore.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const int TRACK_COUNT = 4;
+const int BIKE_COUNT = 4;
+const int PLAYER_COUNT = 400000;
+const int IMPORT_RUNS = 2000000;
+const int SUBMIT_RUNS = 200000;
+const int FLAT_SUBMIT_RUNS = 2000;
+const int QUERY_COUNT = 200000;
+const int TOP_K = 10;
+
+const char* DATES[] = {"2024-05-01", "2024-05-02", "2024-05-03", "2024-05-04", "2024-05-05"};
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+LeaderboardRun MakeRun(std::mt19937& rng) {
+    std::uniform_int_distribution<int> player(0, PLAYER_COUNT - 1);
+    std::uniform_int_distribution<int> track(0, TRACK_COUNT - 1);
+    std::uniform_int_distribution<int> bike(0, BIKE_COUNT - 1);
+    std::normal_distribution<float> time(95.0f, 6.0f);
+    return {"rider" + std::to_string(player(rng)), "track" + std::to_string(track(rng)),
+            "bike" + std::to_string(bike(rng)), std::max(40.0f, time(rng)), DATES[rng() % 5]};
+}
+
+// Best time and arrival order per player on every board, ranked by sorting
+struct Reference {
+    struct Best {
+        float time;
+        uint64_t order;
+    };
+    std::map<std::pair<std::string, std::string>, std::unordered_map<std::string, Best>> boards;
+    uint64_t order = 0;
+
+    void Add(const LeaderboardRun& run) {
+        auto& board = boards[{run.track, run.bike}];
+        auto [entry, inserted] = board.try_emplace(run.player, Best{run.time, order});
+        if (!inserted && run.time < entry->second.time) {
+            entry->second = {run.time, order};
+        }
+        ++order;
+    }
+
+    std::vector<std::pair<float, std::string>> Ranked(const std::string& track, const std::string& bike) const {
+        std::vector<std::tuple<float, uint64_t, std::string>> sorted;
+        for (const auto& [player, best] : boards.at({track, bike})) {
+            sorted.emplace_back(best.time, best.order, player);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<std::pair<float, std::string>> ranked;
+        for (const auto& [time, order, player] : sorted) {
+            ranked.emplace_back(time, player);
+        }
+        return ranked;
+    }
+};
+
+size_t Check(const LeaderboardStore& store, const Reference& reference, std::mt19937& rng) {
+    size_t failures = 0;
+    std::vector<LeaderboardStore::Entry> top;
+    for (const auto& [key, players] : reference.boards) {
+        auto ranked = reference.Ranked(key.first, key.second);
+        failures += store.GetEntryCount(key.first, key.second) != ranked.size();
+        store.GetTop(key.first, key.second, TOP_K, top);
+        for (size_t i = 0; i < top.size(); ++i) {
+            failures += top[i].time != ranked[i].first || store.GetName(top[i].player) != ranked[i].second;
+        }
+        for (int sample = 0; sample < 200; ++sample) {
+            size_t rank = rng() % ranked.size();
+            failures += store.GetRank(key.first, key.second, ranked[rank].second) != rank;
+        }
+    }
+    return failures;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::vector<LeaderboardRun> imported;
+    imported.reserve(IMPORT_RUNS);
+    Reference reference;
+    for (int i = 0; i < IMPORT_RUNS; ++i) {
+        imported.push_back(MakeRun(rng));
+        reference.Add(imported.back());
+    }
+
+    LeaderboardStore store;
+    auto start = std::chrono::steady_clock::now();
+    store.Import(imported);
+    double importSeconds = Seconds(start);
+    size_t entries = 0;
+    for (const auto& board : reference.boards) {
+        entries += board.second.size();
+    }
+    std::printf("import   %d runs -> %zu entries on %zu boards: %.0f ms (%.0f ns/run)\n", IMPORT_RUNS, entries,
+                store.GetBoardCount(), importSeconds * 1e3, importSeconds * 1e9 / IMPORT_RUNS);
+
+    // Live submissions after the import
+    std::vector<LeaderboardRun> submitted;
+    for (int i = 0; i < SUBMIT_RUNS; ++i) {
+        submitted.push_back(MakeRun(rng));
+    }
+    start = std::chrono::steady_clock::now();
+    size_t improved = 0;
+    for (const auto& run : submitted) {
+        improved += store.Submit(run);
+        reference.Add(run);
+    }
+    double submitSeconds = Seconds(start);
+
+    // Flat version: one board kept sorted in a vector, players found by scan
+    auto flat = reference.Ranked("track0", "bike0");
+    std::vector<LeaderboardRun> flatRuns;
+    while (flatRuns.size() < FLAT_SUBMIT_RUNS) {
+        LeaderboardRun run = MakeRun(rng);
+        if (run.track == "track0" && run.bike == "bike0") {
+            flatRuns.push_back(run);
+        }
+    }
+    start = std::chrono::steady_clock::now();
+    for (const auto& run : flatRuns) {
+        auto existing = std::find_if(flat.begin(), flat.end(), [&](const auto& entry) { return entry.second == run.player; });
+        if (existing != flat.end()) {
+            if (existing->first <= run.time) {
+                continue;
+            }
+            flat.erase(existing);
+        }
+        auto position = std::upper_bound(flat.begin(), flat.end(), run.time,
+                                         [](float time, const auto& entry) { return time < entry.first; });
+        flat.insert(position, {run.time, run.player});
+    }
+    double flatSeconds = Seconds(start);
+    std::printf("submit   %.0f ns/run (%zu improved) | flat vector on one board of %zu: %.0f ns/run\n",
+                submitSeconds * 1e9 / SUBMIT_RUNS, improved, flat.size(), flatSeconds * 1e9 / FLAT_SUBMIT_RUNS);
+
+    std::vector<std::string> queryPlayers;
+    std::uniform_int_distribution<int> player(0, PLAYER_COUNT - 1);
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queryPlayers.push_back("rider" + std::to_string(player(rng)));
+    }
+    start = std::chrono::steady_clock::now();
+    uint64_t rankSum = 0;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        rankSum += store.GetRank("track" + std::to_string(i % TRACK_COUNT), "bike1", queryPlayers[i]);
+    }
+    double rankSeconds = Seconds(start);
+    std::vector<LeaderboardStore::Entry> top;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        store.GetRange("track2", "bike3", i % 1000, TOP_K, top);
+        rankSum += top.size();
+    }
+    double topSeconds = Seconds(start);
+    std::printf("query    rank %.0f ns, top-%d page %.0f ns (checksum %llu)\n", rankSeconds * 1e9 / QUERY_COUNT,
+                TOP_K, topSeconds * 1e9 / QUERY_COUNT, static_cast<unsigned long long>(rankSum));
+
+    size_t failures = Check(store, reference, rng);
+
+    entries = 0;
+    for (const auto& board : reference.boards) {
+        entries += board.second.size();
+    }
+    std::vector<std::vector<uint8_t>> records;
+    size_t savedBytes = 0;
+    start = std::chrono::steady_clock::now();
+    store.SaveDirtyBoards([&](const std::string&, const std::string&, std::vector<uint8_t> record) {
+        savedBytes += record.size();
+        records.push_back(std::move(record));
+    });
+    double saveSeconds = Seconds(start);
+    LeaderboardStore loaded;
+    std::string error;
+    start = std::chrono::steady_clock::now();
+    for (const auto& record : records) {
+        failures += !loaded.LoadBoard(record, error);
+    }
+    double loadSeconds = Seconds(start);
+    failures += Check(loaded, reference, rng);
+    std::printf("persist  %.1f MB (%.1f B/entry): save %.0f ms, load %.0f ms\n", savedBytes / 1e6,
+                static_cast<double>(savedBytes) / entries, saveSeconds * 1e3, loadSeconds * 1e3);
+    std::printf("check    %s\n", failures ? "MISMATCH" : "ok");
+    return failures ? 1 : 0;
+}
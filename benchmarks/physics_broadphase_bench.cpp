@@ -0,0 +1,129 @@
+// Compares the PhysicsWorld sweep-and-prune broad phase against testing every
+// pair, for packs of AI racers circling a ring track.
+#include "PhysicsWorld.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const float RING_RADIUS = 3200.0f;
+const float LAP_LENGTH = 6.2831853f * RING_RADIUS;
+const float TRACK_WIDTH = 160.0f;
+const int BIKES_PER_ROW = 4;
+const float ROW_SPACING = 70.0f;
+const int STEP_COUNT = 600;
+const float DT = 1.0f / 60.0f;
+
+struct Racer {
+    float distance; // along the ring
+    float lateral;  // offset from the centerline
+    float speed;
+    float drift;
+};
+
+std::vector<Racer> MakeGrid(int bikeCount, std::mt19937& rng) {
+    std::uniform_real_distribution<float> speed(280.0f, 320.0f);
+    std::uniform_real_distribution<float> drift(-20.0f, 20.0f);
+    std::vector<Racer> racers(bikeCount);
+    for (int i = 0; i < bikeCount; ++i) {
+        int row = i / BIKES_PER_ROW;
+        int column = i % BIKES_PER_ROW;
+        racers[i].distance = LAP_LENGTH - row * ROW_SPACING;
+        racers[i].lateral = (column - (BIKES_PER_ROW - 1) * 0.5f) * (TRACK_WIDTH / BIKES_PER_ROW);
+        racers[i].speed = speed(rng);
+        racers[i].drift = drift(rng);
+    }
+    return racers;
+}
+
+OrientedBox RacerBox(const Racer& racer) {
+    float angle = racer.distance / RING_RADIUS;
+    Vector2D center = Vector2D::FromAngle(angle) * (RING_RADIUS + racer.lateral);
+    return OrientedBox::FromRotation(center, 30.0f, 15.0f, angle + 1.5707963f);
+}
+
+void Advance(std::vector<Racer>& racers) {
+    for (auto& racer : racers) {
+        racer.distance = std::fmod(racer.distance + racer.speed * DT, LAP_LENGTH);
+        racer.lateral += racer.drift * DT;
+        if (std::fabs(racer.lateral) > TRACK_WIDTH * 0.5f) {
+            racer.drift = -racer.drift;
+        }
+    }
+}
+
+size_t BruteContacts(const std::vector<OrientedBox>& boxes) {
+    size_t contacts = 0;
+    for (size_t a = 0; a < boxes.size(); ++a) {
+        for (size_t b = a + 1; b < boxes.size(); ++b) {
+            contacts += boxes[a].Overlaps(boxes[b]) ? 1 : 0;
+        }
+    }
+    return contacts;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::printf("%6s | %10s %10s | %12s %12s %8s | %10s %9s\n", "bikes", "sap(us)", "brute(us)",
+                "pairs", "candidates", "skipped", "swaps", "contacts");
+
+    for (int bikeCount : {8, 64, 512}) {
+        std::vector<Racer> racers = MakeGrid(bikeCount, rng);
+        PhysicsWorld world;
+        world.SetProgressAxis([](const Vector2D& position) {
+            float angle = position.Angle();
+            return (angle < 0.0f ? angle + 6.2831853f : angle) * RING_RADIUS;
+        }, LAP_LENGTH);
+        for (int i = 0; i < bikeCount; ++i) {
+            world.AddBody(PhysicsWorld::BodyType::BIKE, static_cast<uint32_t>(i));
+        }
+
+        std::pmr::vector<PhysicsWorld::Contact> contacts;
+        std::vector<OrientedBox> boxes(bikeCount);
+        double sapNs = 0.0;
+        double bruteNs = 0.0;
+        uint64_t candidates = 0;
+        uint64_t possible = 0;
+        uint64_t swaps = 0;
+        uint64_t contactTotal = 0;
+        size_t mismatches = 0;
+        for (int step = 0; step < STEP_COUNT; ++step) {
+            Advance(racers);
+            for (int i = 0; i < bikeCount; ++i) {
+                boxes[i] = RacerBox(racers[i]);
+                world.SetBox(static_cast<PhysicsWorld::BodyId>(i), boxes[i]);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            world.Step(contacts);
+            auto middle = std::chrono::steady_clock::now();
+            size_t bruteContacts = BruteContacts(boxes);
+            auto end = std::chrono::steady_clock::now();
+
+            sapNs += std::chrono::duration<double, std::nano>(middle - start).count();
+            bruteNs += std::chrono::duration<double, std::nano>(end - middle).count();
+            // The first step sorts the grid from scratch; it is not representative
+            if (step > 0) {
+                swaps += world.GetStats().sortSwaps;
+            }
+            candidates += world.GetStats().candidatePairs;
+            possible += world.GetStats().possiblePairs;
+            contactTotal += contacts.size();
+            mismatches += contacts.size() != bruteContacts ? 1 : 0;
+        }
+
+        std::printf("%6d | %10.2f %10.2f | %12.0f %12.1f %7.2f%% | %10.2f %9.2f%s\n", bikeCount,
+                    sapNs / STEP_COUNT / 1000.0, bruteNs / STEP_COUNT / 1000.0,
+                    static_cast<double>(possible) / STEP_COUNT, static_cast<double>(candidates) / STEP_COUNT,
+                    100.0 * (possible - candidates) / std::max<uint64_t>(possible, 1),
+                    static_cast<double>(swaps) / (STEP_COUNT - 1), static_cast<double>(contactTotal) / STEP_COUNT,
+                    mismatches ? "  MISMATCH" : "");
+    }
+    return 0;
+}
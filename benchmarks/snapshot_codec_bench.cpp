@@ -0,0 +1,155 @@
+// Measures SnapshotCodec size and speed for races of different sizes: full
+// snapshots, and deltas against a baseline the receiver acknowledged about
+// 100 ms earlier. Every decoded snapshot is checked against what was sent.
+#include "SnapshotCodec.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const float RING_RADIUS = 3200.0f;
+const int POWER_UP_COUNT = 12;
+const int STEP_COUNT = 2000;
+const uint32_t ACK_DELAY_TICKS = 6;
+const float DT = 1.0f / 60.0f;
+
+struct Racer {
+    float angle;
+    float speed;
+    float lateral;
+    float drift;
+};
+
+// Bikes circling a ring with some weaving, boosting and damage, spinning
+// power-ups that get collected and respawn, and a crater now and then
+void Advance(Game::Snapshot& snapshot, std::vector<Racer>& racers, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    size_t count = racers.size();
+    auto field = [&](BikeStateStore::SavedField f, size_t i) -> float& { return snapshot.bikeStates[f * count + i]; };
+    for (size_t i = 0; i < count; ++i) {
+        Racer& racer = racers[i];
+        racer.angle += racer.speed * DT / RING_RADIUS;
+        racer.lateral += racer.drift * DT;
+        if (std::fabs(racer.lateral) > 60.0f || unit(rng) < 0.01f) {
+            racer.drift = -racer.drift;
+        }
+        float radius = RING_RADIUS + racer.lateral;
+        Vector2D position = Vector2D::FromAngle(racer.angle) * radius;
+        Vector2D velocity = Vector2D::FromAngle(racer.angle + 1.5707963f) * racer.speed;
+        field(BikeStateStore::SAVED_POSITION_X, i) = position.x;
+        field(BikeStateStore::SAVED_POSITION_Y, i) = position.y;
+        field(BikeStateStore::SAVED_VELOCITY_X, i) = velocity.x;
+        field(BikeStateStore::SAVED_VELOCITY_Y, i) = velocity.y;
+        field(BikeStateStore::SAVED_ROTATION, i) = racer.angle + 1.5707963f;
+        field(BikeStateStore::SAVED_SUSPENSION, i) = 4.0f * std::sin(racer.angle * 50.0f);
+
+        Bike::SimState& sim = snapshot.bikes[i];
+        sim.hasNitro = unit(rng) < 0.02f ? !sim.hasNitro : sim.hasNitro;
+        sim.nitroFuel = sim.hasNitro ? std::max(0.0f, sim.nitroFuel - DT) : std::min(3.0f, sim.nitroFuel + DT * 0.25f);
+        sim.input = sim.hasNitro ? (BikeInput::ACCELERATE | BikeInput::BOOST) : BikeInput::ACCELERATE;
+        if (unit(rng) < 0.005f) {
+            sim.health = std::max(0.0f, sim.health - 10.0f);
+        }
+        sim.currentLap = static_cast<int>(racer.angle / 6.2831853f);
+    }
+
+    for (auto& powerUp : snapshot.powerUps) {
+        powerUp.rotationAngle += 90.0f * DT;
+        powerUp.position.y = powerUp.baseY + 5.0f * std::sin(powerUp.rotationAngle * 0.05f);
+        if (unit(rng) < 0.002f) {
+            powerUp.collected = !powerUp.collected;
+        }
+    }
+
+    if (unit(rng) < 0.01f) {
+        float angle = unit(rng) * 6.2831853f;
+        snapshot.track.deformations.push_back({Vector2D::FromAngle(angle) * RING_RADIUS, 30.0f, 2.0f});
+    }
+    ++snapshot.tick;
+}
+
+Game::Snapshot MakeRace(int bikeCount, std::vector<Racer>& racers, std::mt19937& rng) {
+    std::uniform_real_distribution<float> speed(280.0f, 320.0f);
+    std::uniform_real_distribution<float> drift(-20.0f, 20.0f);
+    Game::Snapshot snapshot;
+    racers.resize(bikeCount);
+    snapshot.bikeStates.assign(bikeCount * BikeStateStore::SAVED_FIELD_COUNT, 0.0f);
+    snapshot.bikes.assign(bikeCount, Bike::SimState{0, false, PowerUpType::NITRO_BOOST, false, 0.0f, true, false, false, false, 0.0f, 100.0f, 3.0f, 0.0f, 0, 0});
+    for (int i = 0; i < bikeCount; ++i) {
+        racers[i] = {-0.002f * (i / 4), speed(rng), (i % 4 - 1.5f) * 30.0f, drift(rng)};
+    }
+    for (int i = 0; i < POWER_UP_COUNT; ++i) {
+        Vector2D position = Vector2D::FromAngle(6.2831853f * i / POWER_UP_COUNT) * RING_RADIUS;
+        snapshot.powerUps.push_back({position, false, false, 0.0f, 0.0f, position.y});
+    }
+    return snapshot;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(42);
+    SnapshotCodec codec;
+    std::array<uint8_t, 16384> packet;
+
+    std::printf("%6s | %9s %9s %9s | %9s %9s %9s | %s\n", "bikes", "raw(B)", "full(B)", "delta(B)",
+                "enc(ns)", "dec(ns)", "full(ns)", "check");
+
+    for (int bikeCount : {4, 16, 64}) {
+        std::vector<Racer> racers;
+        Game::Snapshot snapshot = MakeRace(bikeCount, racers, rng);
+        SnapshotHistory sent;
+        SnapshotHistory received;
+        QuantizedSnapshot decoded;
+
+        double rawBytes = 0.0;
+        double fullBytes = 0.0;
+        double deltaBytes = 0.0;
+        double encodeNs = 0.0;
+        double decodeNs = 0.0;
+        double fullNs = 0.0;
+        int deltaCount = 0;
+        size_t failures = 0;
+
+        for (int step = 0; step < STEP_COUNT; ++step) {
+            Advance(snapshot, racers, rng);
+            rawBytes += snapshot.bikeStates.size() * sizeof(float) + snapshot.bikes.size() * sizeof(Bike::SimState) +
+                        snapshot.powerUps.size() * sizeof(PowerUp::SimState) +
+                        snapshot.track.deformations.size() * sizeof(Track::Deformation);
+            uint32_t tick = static_cast<uint32_t>(snapshot.tick);
+            QuantizedSnapshot& state = sent.Store(tick);
+            codec.Quantize(snapshot, state);
+
+            auto start = std::chrono::steady_clock::now();
+            size_t full = codec.Encode(state, nullptr, packet.data(), packet.size());
+            fullNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            fullBytes += full;
+
+            // The receiver acknowledged the snapshot it got ACK_DELAY_TICKS ago
+            const QuantizedSnapshot* baseline = tick >= ACK_DELAY_TICKS ? sent.Find(tick - ACK_DELAY_TICKS) : nullptr;
+            start = std::chrono::steady_clock::now();
+            size_t size = codec.Encode(state, baseline, packet.data(), packet.size());
+            auto middle = std::chrono::steady_clock::now();
+            bool ok = codec.Decode(packet.data(), size, &received, decoded);
+            auto end = std::chrono::steady_clock::now();
+
+            if (baseline) {
+                encodeNs += std::chrono::duration<double, std::nano>(middle - start).count();
+                decodeNs += std::chrono::duration<double, std::nano>(end - middle).count();
+                deltaBytes += size;
+                ++deltaCount;
+            }
+            failures += (!ok || size == 0 || decoded != state) ? 1 : 0;
+            received.Store(tick) = decoded;
+        }
+
+        std::printf("%6d | %9.1f %9.1f %9.1f | %9.0f %9.0f %9.0f | %s\n", bikeCount, rawBytes / STEP_COUNT,
+                    fullBytes / STEP_COUNT, deltaBytes / std::max(deltaCount, 1), encodeNs / std::max(deltaCount, 1),
+                    decodeNs / std::max(deltaCount, 1), fullNs / STEP_COUNT, failures ? "MISMATCH" : "ok");
+    }
+    return 0;
+}
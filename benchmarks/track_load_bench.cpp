@@ -0,0 +1,167 @@
+// Measures track load time for the text format versus the memory-mapped
+// binary format on synthetic tracks of increasing size, then the whole
+// Track::Load (decode, spatial index, terrain raster) on closed circuits
+// of growing lap length, which must scale linearly and fit in a frame: the
+// terrain along the track is baked later, around the racers.
+#include "Track.hpp"
+#include "TrackFormat.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+namespace {
+
+TrackData MakeTrack(int segmentCount, std::mt19937& rng) {
+    TrackData track;
+    track.name = "bench_" + std::to_string(segmentCount);
+    track.trackWidth = 120;
+    track.trackLength = segmentCount * 320;
+    std::uniform_real_distribution<float> coord(-20000.0f, 20000.0f);
+    for (int s = 0; s < segmentCount; ++s) {
+        TrackSegment segment;
+        segment.terrain = static_cast<TerrainType>(s % 9);
+        segment.friction = 0.5f + (s % 5) * 0.1f;
+        for (int p = 0; p < 16; ++p) {
+            segment.points.push_back(Vector2D(coord(rng), coord(rng)));
+        }
+        track.segments.push_back(segment);
+        track.checkpoints.push_back({s * 10, s * 5, 120, 40});
+        for (int o = 0; o < 4; ++o) {
+            Obstacle obstacle;
+            obstacle.bounds = {static_cast<int>(coord(rng)), static_cast<int>(coord(rng)), 20, 20};
+            obstacle.position = Vector2D(obstacle.bounds.x + 10.0f, obstacle.bounds.y + 10.0f);
+            obstacle.rotation = 0.0f;
+            obstacle.destructible = o % 2 == 0;
+            obstacle.health = 100.0f;
+            obstacle.type = o % 2 ? "barrel" : "rock";
+            track.obstacles.push_back(obstacle);
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        track.startPositions.push_back(Vector2D(i * 30.0f, 0.0f));
+        track.powerUpSpawnPoints.push_back(Vector2D(i * 500.0f, 100.0f));
+    }
+    return track;
+}
+
+// Circle of lapLength px drawn with 40 px edges, like a real circuit: the
+// random tracks above cover their whole box and are only fit for the decoder
+TrackData MakeCircuit(float lapLength) {
+    TrackData track;
+    track.name = "circuit";
+    track.trackWidth = 120;
+    track.trackLength = static_cast<int>(lapLength);
+    float radius = lapLength / 6.28318531f;
+    int edgeCount = static_cast<int>(lapLength / 40.0f);
+    TrackSegment segment;
+    segment.terrain = TerrainType::ASPHALT;
+    segment.friction = 1.0f;
+    for (int p = 0; p <= edgeCount; ++p) {
+        float angle = 6.28318531f * (p % edgeCount) / edgeCount;
+        segment.points.push_back(Vector2D(std::cos(angle) * radius, std::sin(angle) * radius));
+    }
+    track.segments.push_back(segment);
+    return track;
+}
+
+// A 60 Hz frame: a track switch must not stall the game
+const double LOAD_BUDGET_MS = 16.0;
+
+template <typename F>
+double TimeMs(int iterations, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(7);
+    std::printf("%8s %12s %12s | %10s %10s %10s\n", "segments", "text(KB)", "binary(KB)",
+                "text(ms)", "map(ms)", "decode(ms)");
+
+    for (int segmentCount : {64, 512, 4096}) {
+        TrackData source = MakeTrack(segmentCount, rng);
+        std::string textPath = "track_load_bench.trk";
+        std::string binaryPath = "track_load_bench.bktr";
+        std::string error;
+        {
+            std::ofstream out(textPath);
+            TrackFormat::WriteText(out, source);
+        }
+        if (!TrackFormat::WriteBinary(source, binaryPath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        std::ifstream textSize(textPath, std::ios::ate), binarySize(binaryPath, std::ios::ate);
+
+        const int iterations = 20;
+        double textMs = TimeMs(iterations, [&] {
+            std::ifstream in(textPath);
+            TrackData track;
+            TrackFormat::ParseText(in, track, error);
+        });
+        // Mapping alone is what in-place readers pay
+        double mapMs = TimeMs(iterations, [&] {
+            TrackFormat::FileView view;
+            view.Open(binaryPath, error);
+        });
+        double decodeMs = TimeMs(iterations, [&] {
+            TrackFormat::FileView view;
+            view.Open(binaryPath, error);
+            TrackData track;
+            TrackFormat::Decode(view, track);
+        });
+
+        std::printf("%8d %12.1f %12.1f | %10.3f %10.3f %10.3f\n", segmentCount,
+                    textSize.tellg() / 1024.0, binarySize.tellg() / 1024.0, textMs, mapMs, decodeMs);
+        std::remove(textPath.c_str());
+        std::remove(binaryPath.c_str());
+    }
+
+    std::printf("\n%8s %10s | %10s %12s %9s\n", "lap(px)", "edges", "load(ms)", "us/100px", "friction");
+    std::string circuitPath = "track_load_bench_circuit.bktr";
+    double firstRate = 0.0;
+    double lastRate = 0.0;
+    bool surfaceOk = true;
+    bool inBudget = true;
+    for (float lapLength : {4800.0f, 19200.0f, 76800.0f}) {
+        TrackData source = MakeCircuit(lapLength);
+        std::string error;
+        if (!TrackFormat::WriteBinary(source, circuitPath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        Track track("circuit");
+        double loadMs = TimeMs(3, [&] { track.Load(circuitPath); });
+        double rate = loadMs * 1000.0 / (lapLength / 100.0f);
+        firstRate = firstRate > 0.0 ? firstRate : rate;
+        lastRate = rate;
+        inBudget = inBudget && loadMs < LOAD_BUDGET_MS;
+
+        // On the line the asphalt must read the same before and after its
+        // tiles are baked; at the centre it is open ground
+        float radius = lapLength / 6.28318531f;
+        Vector2D onLine(radius, 0.0f);
+        float onTrack = track.GetFrictionAt(onLine);
+        track.BakeTerrainAround(onLine, 160.0f);
+        float offTrack = track.GetFrictionAt(Vector2D(0.0f, 0.0f));
+        surfaceOk = surfaceOk && onTrack == 1.0f && track.GetFrictionAt(onLine) == onTrack && offTrack < 1.0f;
+        std::printf("%8.0f %10zu | %10.2f %12.2f %4.2f/%4.2f\n", lapLength, source.segments[0].points.size() - 1,
+                    loadMs, rate, onTrack, offTrack);
+    }
+    std::remove(circuitPath.c_str());
+
+    // Cost per length may drift with cache effects but must not keep growing
+    bool ok = surfaceOk && inBudget && lastRate < firstRate * 3.0;
+    if (!inBudget) {
+        std::printf("load over the %.0f ms budget\n", LOAD_BUDGET_MS);
+    }
+    std::printf("check    %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
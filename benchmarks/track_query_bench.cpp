@@ -0,0 +1,150 @@
+// Compares TrackSpatialIndex queries against brute-force scans over a
+// synthetic track with a growing number of segments.
+#include "TrackSpatialIndex.hpp"
+#include <chrono>
+#include <cfloat>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const float TRACK_WIDTH = 120.0f;
+const int POINTS_PER_SEGMENT = 8;
+const int QUERY_COUNT = 200000;
+
+struct SyntheticTrack {
+    std::vector<TrackSpatialIndex::Edge> edges;
+    std::vector<SDL_Rect> obstacles;
+};
+
+// A wobbly closed loop whose circumference grows with the segment count
+SyntheticTrack MakeTrack(int segmentCount, std::mt19937& rng) {
+    SyntheticTrack track;
+    int pointCount = segmentCount * POINTS_PER_SEGMENT;
+    float radius = pointCount * 40.0f / 6.2831853f;
+    std::uniform_real_distribution<float> jitter(-30.0f, 30.0f);
+    Vector2D previous;
+    for (int i = 0; i <= pointCount; ++i) {
+        float angle = 6.2831853f * i / pointCount;
+        Vector2D point = Vector2D::FromAngle(angle) * (radius + 200.0f * std::sin(angle * 7.0f));
+        if (i > 0) {
+            track.edges.push_back({previous, point, static_cast<uint32_t>((i - 1) / POINTS_PER_SEGMENT)});
+        }
+        if (i % 3 == 0) {
+            track.obstacles.push_back({static_cast<int>(point.x + jitter(rng)), static_cast<int>(point.y + jitter(rng)), 20, 20});
+        }
+        previous = point;
+    }
+    return track;
+}
+
+int BruteFindSegment(const SyntheticTrack& track, const Vector2D& point, float maxDistance) {
+    float bestDistSq = maxDistance * maxDistance;
+    int best = -1;
+    for (const auto& edge : track.edges) {
+        float distSq = (TrackSpatialIndex::ClosestPointOnEdge(point, edge.a, edge.b) - point).LengthSquared();
+        if (distSq <= bestDistSq) {
+            bestDistSq = distSq;
+            best = static_cast<int>(edge.segment);
+        }
+    }
+    return best;
+}
+
+float BruteNearestDistSq(const SyntheticTrack& track, const Vector2D& point) {
+    float best = FLT_MAX;
+    for (const auto& edge : track.edges) {
+        best = std::min(best, (TrackSpatialIndex::ClosestPointOnEdge(point, edge.a, edge.b) - point).LengthSquared());
+    }
+    return best;
+}
+
+bool BruteObstacle(const SyntheticTrack& track, const SDL_Rect& rect) {
+    for (const auto& obstacle : track.obstacles) {
+        if (TrackSpatialIndex::RectsOverlap(rect, obstacle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename F>
+double TimeNs(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / QUERY_COUNT;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::printf("%8s %10s | %12s %12s | %12s %12s | %12s %12s\n", "segments", "edges",
+                "segment(ns)", "brute(ns)", "nearest(ns)", "brute(ns)", "obstacle(ns)", "brute(ns)");
+
+    for (int segmentCount : {16, 64, 256, 1024}) {
+        SyntheticTrack track = MakeTrack(segmentCount, rng);
+        TrackSpatialIndex index;
+        for (const auto& edge : track.edges) {
+            index.AddEdge(edge.a, edge.b, edge.segment);
+        }
+        for (const auto& obstacle : track.obstacles) {
+            index.AddObstacle(obstacle);
+        }
+        index.Build(TRACK_WIDTH, TRACK_WIDTH * 0.5f);
+
+        // Queries cluster around the racing surface, as bike positions do
+        std::vector<Vector2D> queries(QUERY_COUNT);
+        std::uniform_int_distribution<size_t> pickEdge(0, track.edges.size() - 1);
+        std::uniform_real_distribution<float> offset(-TRACK_WIDTH, TRACK_WIDTH);
+        for (auto& query : queries) {
+            const auto& edge = track.edges[pickEdge(rng)];
+            query = edge.a + Vector2D(offset(rng), offset(rng));
+        }
+
+        size_t mismatches = 0;
+        volatile long long sink = 0;
+        double indexSegment = TimeNs([&] {
+            for (const auto& q : queries) sink += index.FindSegmentAt(q, TRACK_WIDTH * 0.5f);
+        });
+        double bruteSegment = TimeNs([&] {
+            for (const auto& q : queries) sink += BruteFindSegment(track, q, TRACK_WIDTH * 0.5f);
+        });
+        double indexNearest = TimeNs([&] {
+            Vector2D nearest;
+            for (const auto& q : queries) {
+                index.FindNearestPoint(q, nearest);
+                sink += static_cast<long long>(nearest.x);
+            }
+        });
+        double bruteNearest = TimeNs([&] {
+            for (const auto& q : queries) sink += static_cast<long long>(BruteNearestDistSq(track, q));
+        });
+        double indexObstacle = TimeNs([&] {
+            for (const auto& q : queries) sink += index.OverlapsObstacle({static_cast<int>(q.x), static_cast<int>(q.y), 40, 20});
+        });
+        double bruteObstacle = TimeNs([&] {
+            for (const auto& q : queries) sink += BruteObstacle(track, {static_cast<int>(q.x), static_cast<int>(q.y), 40, 20});
+        });
+
+        // Cross-check a sample so the speedup is not bought with wrong answers
+        for (size_t i = 0; i < queries.size(); i += 97) {
+            const Vector2D& q = queries[i];
+            Vector2D nearest;
+            index.FindNearestPoint(q, nearest);
+            SDL_Rect rect = {static_cast<int>(q.x), static_cast<int>(q.y), 40, 20};
+            bool segmentFound = index.FindSegmentAt(q, TRACK_WIDTH * 0.5f) >= 0;
+            if (segmentFound != (BruteFindSegment(track, q, TRACK_WIDTH * 0.5f) >= 0) ||
+                std::abs((nearest - q).LengthSquared() - BruteNearestDistSq(track, q)) > 1e-2f ||
+                index.OverlapsObstacle(rect) != BruteObstacle(track, rect)) {
+                ++mismatches;
+            }
+        }
+
+        std::printf("%8d %10zu | %12.1f %12.1f | %12.1f %12.1f | %12.1f %12.1f%s\n", segmentCount,
+                    track.edges.size(), indexSegment, bruteSegment, indexNearest, bruteNearest,
+                    indexObstacle, bruteObstacle, mismatches ? "  MISMATCH" : "");
+    }
+    return 0;
+}
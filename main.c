@@ -10,6 +10,8 @@
 #define BIKE_HEIGHT 30
 #define GRAVITY 0.5f
 #define MAX_SPEED 10.0f
+#define FIXED_TIMESTEP (1.0 / 60.0)
+#define MAX_FRAME_SKIP 5
 
 typedef struct {
     float x, y;
@@ -17,6 +19,7 @@ typedef struct {
     float rotation;
     bool is_jumping;
     int score;
+    float prev_x, prev_y;
 } Bike;
 
 typedef struct {
@@ -66,6 +69,10 @@ void init_game(GameState* game) {
     // Initialize players
     game->player1 = (Bike){100, WINDOW_HEIGHT - 100, 0, 0, 0, false, 0};
     game->player2 = (Bike){100, WINDOW_HEIGHT - 200, 0, 0, 0, false, 0};
+    game->player1.prev_x = game->player1.x;
+    game->player1.prev_y = game->player1.y;
+    game->player2.prev_x = game->player2.x;
+    game->player2.prev_y = game->player2.y;
     game->running = true;
 }
 
@@ -108,6 +115,14 @@ void handle_input(GameState* game) {
     }
 }
 
+void save_previous_state(GameState* game) {
+    game->player1.prev_x = game->player1.x;
+    game->player1.prev_y = game->player1.y;
+    game->player2.prev_x = game->player2.x;
+    game->player2.prev_y = game->player2.y;
+}
+
+// Advances the simulation by exactly one FIXED_TIMESTEP tick
 void update_game(GameState* game) {
     // Update player 1
     game->player1.x += game->player1.velocity_x;
@@ -133,34 +148,39 @@ void update_game(GameState* game) {
     }
 }
 
-void render_game(GameState* game) {
+// Appends an axis-aligned quad (two triangles) to a vertex batch
+static int push_quad(SDL_Vertex* vertices, int count, float x, float y, float w, float h, SDL_Color color) {
+    SDL_FPoint corners[6] = {
+        {x, y}, {x + w, y}, {x + w, y + h},
+        {x, y}, {x + w, y + h}, {x, y + h}
+    };
+    for (int i = 0; i < 6; i++) {
+        vertices[count + i].position = corners[i];
+        vertices[count + i].color = color;
+        vertices[count + i].tex_coord = (SDL_FPoint){0, 0};
+    }
+    return count + 6;
+}
+
+// alpha blends between the previous and current tick for smooth motion
+void render_game(GameState* game, float alpha) {
     SDL_SetRenderDrawColor(game->renderer, 135, 206, 235, 255);
     SDL_RenderClear(game->renderer);
 
-    // Draw ground
-    SDL_SetRenderDrawColor(game->renderer, 34, 139, 34, 255);
-    SDL_Rect ground = {0, WINDOW_HEIGHT - 50, WINDOW_WIDTH, 50};
-    SDL_RenderFillRect(game->renderer, &ground);
-
-    // Draw player 1 bike
-    SDL_SetRenderDrawColor(game->renderer, 255, 0, 0, 255);
-    SDL_Rect player1_rect = {
-        (int)game->player1.x,
-        (int)game->player1.y,
-        BIKE_WIDTH,
-        BIKE_HEIGHT
-    };
-    SDL_RenderFillRect(game->renderer, &player1_rect);
-
-    // Draw player 2 bike
-    SDL_SetRenderDrawColor(game->renderer, 0, 0, 255, 255);
-    SDL_Rect player2_rect = {
-        (int)game->player2.x,
-        (int)game->player2.y,
-        BIKE_WIDTH,
-        BIKE_HEIGHT
-    };
-    SDL_RenderFillRect(game->renderer, &player2_rect);
+    // Ground and both bikes go out in a single draw call
+    SDL_Vertex vertices[18];
+    int count = 0;
+    count = push_quad(vertices, count, 0, WINDOW_HEIGHT - 50, WINDOW_WIDTH, 50,
+        (SDL_Color){34, 139, 34, 255});
+    count = push_quad(vertices, count,
+        game->player1.prev_x + (game->player1.x - game->player1.prev_x) * alpha,
+        game->player1.prev_y + (game->player1.y - game->player1.prev_y) * alpha,
+        BIKE_WIDTH, BIKE_HEIGHT, (SDL_Color){255, 0, 0, 255});
+    count = push_quad(vertices, count,
+        game->player2.prev_x + (game->player2.x - game->player2.prev_x) * alpha,
+        game->player2.prev_y + (game->player2.y - game->player2.prev_y) * alpha,
+        BIKE_WIDTH, BIKE_HEIGHT, (SDL_Color){0, 0, 255, 255});
+    SDL_RenderGeometry(game->renderer, NULL, vertices, count, NULL, 0);
 
     SDL_RenderPresent(game->renderer);
 }
@@ -177,11 +197,32 @@ int main(int argc, char* argv[]) {
     GameState game = {0};
     init_game(&game);
 
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    Uint64 previous_counter = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
+
     while (game.running) {
+        Uint64 current_counter = SDL_GetPerformanceCounter();
+        double elapsed = (double)(current_counter - previous_counter) / frequency;
+        previous_counter = current_counter;
+
+        // Clamp long frames so catch-up never exceeds MAX_FRAME_SKIP ticks
+        if (elapsed > FIXED_TIMESTEP * MAX_FRAME_SKIP) {
+            elapsed = FIXED_TIMESTEP * MAX_FRAME_SKIP;
+        }
+        accumulator += elapsed;
+
         handle_input(&game);
-        update_game(&game);
-        render_game(&game);
-        SDL_Delay(16); // Cap at ~60 FPS
+
+        int steps = 0;
+        while (accumulator >= FIXED_TIMESTEP && steps < MAX_FRAME_SKIP) {
+            save_previous_state(&game);
+            update_game(&game);
+            accumulator -= FIXED_TIMESTEP;
+            steps++;
+        }
+
+        render_game(&game, (float)(accumulator / FIXED_TIMESTEP));
     }
 
     cleanup(&game);
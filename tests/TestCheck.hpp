@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdio>
+
+// Prints one result line and counts failures, like the benchmarks' check line
+#define TEST_CHECK(failures, condition)                                      \
+    do {                                                                     \
+        bool passed = (condition);                                           \
+        std::printf("%-6s %s\n", passed ? "ok" : "FAIL", #condition);        \
+        failures += passed ? 0 : 1;                                          \
+    } while (0)
@@ -0,0 +1,54 @@
+#pragma once
+#include "Track.hpp"
+#include "TrackFormat.hpp"
+#include "TestCheck.hpp"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+// Shared by the regression tests: a circular asphalt circuit drawn
+// counter-clockwise with 40 px edges, so progress along the lap is the
+// angle times the radius and the start line is at angle 0.
+namespace TestTrack {
+
+inline float Radius(float lapLength) {
+    return lapLength / 6.28318531f;
+}
+
+// powerUpSpawns are spread evenly round the centreline, the first half a
+// spacing past the start line
+inline bool WriteCircuit(const std::string& path, float lapLength, int trackWidth = 120, int powerUpSpawns = 0) {
+    TrackData track;
+    track.name = "test_circuit";
+    track.trackWidth = trackWidth;
+    track.trackLength = static_cast<int>(lapLength);
+    float radius = Radius(lapLength);
+    int edgeCount = static_cast<int>(lapLength / 40.0f);
+    TrackSegment segment;
+    segment.terrain = TerrainType::ASPHALT;
+    segment.friction = 1.0f;
+    for (int p = 0; p <= edgeCount; ++p) {
+        float angle = 6.28318531f * (p % edgeCount) / edgeCount;
+        segment.points.push_back(Vector2D(std::cos(angle) * radius, std::sin(angle) * radius));
+    }
+    track.segments.push_back(segment);
+    for (int i = 0; i < powerUpSpawns; ++i) {
+        float angle = 6.28318531f * (i + 0.5f) / powerUpSpawns;
+        track.powerUpSpawnPoints.push_back(Vector2D(std::cos(angle) * radius, std::sin(angle) * radius));
+    }
+    std::string error;
+    if (!TrackFormat::WriteBinary(track, path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Point on the centreline distance px past the start line
+inline Vector2D PointAt(float lapLength, float distance) {
+    float radius = Radius(lapLength);
+    float angle = distance / radius;
+    return Vector2D(std::cos(angle) * radius, std::sin(angle) * radius);
+}
+
+}
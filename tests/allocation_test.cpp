@@ -0,0 +1,45 @@
+// Regression test for the counting operator new: aligned allocations at
+// any alignment succeed and are counted, including the small alignments
+// std::pmr containers ask for through the default memory resource.
+#include "AllocationCounter.hpp"
+#include "TestCheck.hpp"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace {
+
+struct alignas(64) CacheLine {
+    float values[16];
+};
+
+}
+
+int main() {
+    int failures = 0;
+
+    uint64_t before = AllocationCounter::GetThreadTotal();
+    {
+        std::pmr::vector<int> numbers(std::pmr::new_delete_resource());
+        for (int i = 0; i < 1000; ++i) {
+            numbers.push_back(i);
+        }
+        TEST_CHECK(failures, numbers.size() == 1000 && numbers[999] == 999);
+    }
+    uint64_t afterPmr = AllocationCounter::GetThreadTotal();
+    TEST_CHECK(failures, !AllocationCounter::IsEnabled() || afterPmr > before);
+
+    // Over-aligned types take the aligned path with a large alignment
+    {
+        auto line = std::make_unique<CacheLine>();
+        TEST_CHECK(failures, reinterpret_cast<uintptr_t>(line.get()) % alignof(CacheLine) == 0);
+        void* small = ::operator new(24, std::align_val_t(2));
+        TEST_CHECK(failures, small != nullptr);
+        ::operator delete(small, std::align_val_t(2));
+    }
+    TEST_CHECK(failures, !AllocationCounter::IsEnabled() || AllocationCounter::GetThreadTotal() == afterPmr + 2);
+
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
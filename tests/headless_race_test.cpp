@@ -0,0 +1,83 @@
+// Regression test for the batch race runner: AI races on the test circuit
+// run to the finish on several threads, every bike is credited with the
+// race's laps, and a race run again with the same seed ends the same way.
+#include "HeadlessRunner.hpp"
+#include "TestTrack.hpp"
+#include <algorithm>
+
+namespace {
+
+const float LAP_LENGTH = 4800.0f;
+const int RACE_LAPS = 2;
+const int RACE_COUNT = 6;
+const char* TRACK_FILE = "headless_race_test.bktr";
+
+RaceConfig MakeRace(uint32_t seed) {
+    RaceConfig race;
+    race.trackFile = TRACK_FILE;
+    race.bikes = {BikeType::SPEED, BikeType::ALL_ROUNDER, BikeType::OFF_ROAD, BikeType::SPEED};
+    race.aiDrivers = true;
+    race.aiDifficulty = Difficulty::HARD;
+    race.laps = RACE_LAPS;
+    race.maxTicks = 60 * 60;
+    race.seed = seed;
+    return race;
+}
+
+}
+
+int main() {
+    if (!TestTrack::WriteCircuit(TRACK_FILE, LAP_LENGTH)) {
+        return 1;
+    }
+    int failures = 0;
+
+    std::vector<RaceConfig> races;
+    for (int i = 0; i < RACE_COUNT; ++i) {
+        races.push_back(MakeRace(static_cast<uint32_t>(i % 3)));
+    }
+    BatchRaceRunner runner(3);
+    std::vector<RaceResult> results = runner.Run(races, BatchRaceRunner::FullThrottleScript);
+    TEST_CHECK(failures, results.size() == races.size());
+
+    bool finished = true;
+    bool lapsCounted = true;
+    bool ranked = true;
+    for (const RaceResult& result : results) {
+        finished = finished && result.finished && result.ticks < races[0].maxTicks;
+        for (int laps : result.lapsCompleted) {
+            lapsCounted = lapsCounted && laps >= RACE_LAPS;
+        }
+        std::vector<uint32_t> standings = result.standings;
+        std::sort(standings.begin(), standings.end());
+        ranked = ranked && standings == std::vector<uint32_t>{0, 1, 2, 3};
+    }
+    TEST_CHECK(failures, finished);
+    TEST_CHECK(failures, lapsCounted);
+    TEST_CHECK(failures, ranked);
+    TEST_CHECK(failures, runner.GetTotalTicks() > 0 && runner.GetRacesPerSecond() > 0.0);
+
+    // Races i and i + 3 share a seed and ran on different threads
+    bool repeated = true;
+    for (int i = 0; i < 3; ++i) {
+        const RaceResult& first = results[i];
+        const RaceResult& second = results[i + 3];
+        repeated = repeated && first.ticks == second.ticks && first.standings == second.standings;
+        for (size_t b = 0; b < first.finalPositions.size(); ++b) {
+            repeated = repeated && first.finalPositions[b].x == second.finalPositions[b].x &&
+                       first.finalPositions[b].y == second.finalPositions[b].y;
+        }
+    }
+    TEST_CHECK(failures, repeated);
+
+    // Scripted full throttle never steers, so it must not be counted round
+    RaceConfig scripted = MakeRace(0);
+    scripted.aiDrivers = false;
+    scripted.maxTicks = 60 * 20;
+    RaceResult stuck = runner.Run({scripted}, BatchRaceRunner::FullThrottleScript)[0];
+    TEST_CHECK(failures, !stuck.finished && stuck.ticks == scripted.maxTicks);
+
+    std::remove(TRACK_FILE);
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
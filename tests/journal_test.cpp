@@ -0,0 +1,126 @@
+// Regression tests for SaveStore recovery: a journal record torn by a crash
+// is cut off on the next Open without losing the records before it, and a
+// damaged value in the base file is dropped by compaction instead of
+// failing every compaction after it.
+#include "SaveStore.hpp"
+#include "TestCheck.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+const char* SAVE_FILE = "journal_test.sav";
+const std::string JOURNAL_FILE = std::string(SAVE_FILE) + ".journal";
+const size_t BASE_HEADER_SIZE = 24; // values start right after it
+// Header, one-letter key, 64-byte value, CRC
+const uint64_t RECORD_SIZE = 11 + 1 + 64 + 4;
+
+void RemoveFiles() {
+    std::error_code ec;
+    for (const std::string& file : {std::string(SAVE_FILE), JOURNAL_FILE, std::string(SAVE_FILE) + ".tmp"}) {
+        std::filesystem::remove(file, ec);
+    }
+}
+
+std::vector<uint8_t> Value(char fill, size_t size = 64) {
+    return std::vector<uint8_t>(size, static_cast<uint8_t>(fill));
+}
+
+bool Holds(SaveStore& store, const std::string& key, char fill) {
+    std::vector<uint8_t> value;
+    return store.Get(key, value) && value == Value(fill);
+}
+
+bool Reopen(SaveStore& store) {
+    std::string error;
+    if (!store.Open(SAVE_FILE, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+void FlipByte(const std::string& file, uint64_t offset) {
+    std::fstream stream(file, std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekg(static_cast<std::streamoff>(offset));
+    char byte = 0;
+    stream.get(byte);
+    stream.seekp(static_cast<std::streamoff>(offset));
+    stream.put(static_cast<char>(byte ^ 0x5A));
+}
+
+}
+
+int main() {
+    RemoveFiles();
+    int failures = 0;
+    SaveStore store;
+    store.SetCompactionThreshold(1 << 20);
+
+    // Three records that made it to disk, then one torn partway through
+    TEST_CHECK(failures, Reopen(store));
+    store.Put("a", Value('a'));
+    store.Put("b", Value('b'));
+    store.Put("c", Value('c'));
+    TEST_CHECK(failures, store.Flush());
+    uint64_t intact = store.GetStats().journalBytes;
+    store.Put("d", Value('d'));
+    TEST_CHECK(failures, store.Flush());
+    store.Close();
+    std::filesystem::resize_file(JOURNAL_FILE, std::filesystem::file_size(JOURNAL_FILE) - 3);
+
+    TEST_CHECK(failures, Reopen(store));
+    TEST_CHECK(failures, store.GetStats().tornRecords == 1);
+    TEST_CHECK(failures, std::filesystem::file_size(JOURNAL_FILE) == intact);
+    TEST_CHECK(failures, Holds(store, "a", 'a') && Holds(store, "b", 'b') && Holds(store, "c", 'c'));
+    TEST_CHECK(failures, !store.Contains("d"));
+
+    // The repaired journal takes new records, and a damaged record cuts off
+    // everything after it
+    store.Put("e", Value('e'));
+    TEST_CHECK(failures, store.Flush());
+    store.Put("f", Value('f'));
+    TEST_CHECK(failures, store.Flush());
+    store.Close();
+    uint64_t recordE = std::filesystem::file_size(JOURNAL_FILE) - 2 * RECORD_SIZE;
+    FlipByte(JOURNAL_FILE, recordE + RECORD_SIZE / 2);
+
+    TEST_CHECK(failures, Reopen(store));
+    TEST_CHECK(failures, store.GetStats().tornRecords == 1);
+    TEST_CHECK(failures, std::filesystem::file_size(JOURNAL_FILE) == recordE);
+    TEST_CHECK(failures, Holds(store, "a", 'a') && !store.Contains("e") && !store.Contains("f"));
+    store.Put("e", Value('e'));
+    TEST_CHECK(failures, store.Flush());
+
+    // Compact into a base file, then damage the first value in it
+    store.RequestCompaction();
+    store.Close();
+    TEST_CHECK(failures, store.GetStats().compactions == 1);
+    FlipByte(SAVE_FILE, BASE_HEADER_SIZE);
+
+    TEST_CHECK(failures, Reopen(store));
+    std::vector<uint8_t> value;
+    TEST_CHECK(failures, !store.Get("a", value));
+    store.RequestCompaction();
+    store.Close();
+    SaveStore::Stats stats = store.GetStats();
+    TEST_CHECK(failures, stats.compactions == 1 && stats.valuesDropped == 1);
+
+    // Later writes and compactions go through
+    TEST_CHECK(failures, Reopen(store));
+    TEST_CHECK(failures, !store.Contains("a"));
+    TEST_CHECK(failures, Holds(store, "b", 'b') && Holds(store, "e", 'e'));
+    store.Put("g", Value('g'));
+    TEST_CHECK(failures, store.Flush());
+    store.RequestCompaction();
+    store.Close();
+    stats = store.GetStats();
+    TEST_CHECK(failures, stats.compactions == 1 && stats.valuesDropped == 0);
+    TEST_CHECK(failures, Reopen(store));
+    TEST_CHECK(failures, Holds(store, "g", 'g') && Holds(store, "c", 'c'));
+    store.Close();
+
+    RemoveFiles();
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
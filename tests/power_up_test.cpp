@@ -0,0 +1,103 @@
+// Regression test for held power-ups: AI racers on a circuit strewn with
+// power-ups pick up jumps, missiles and oil, spend them, and each one spent
+// is published once with its kind and takes effect in the same step.
+#include "Game.hpp"
+#include "TestTrack.hpp"
+
+namespace {
+
+const float LAP_LENGTH = 4800.0f;
+const int SPAWN_POINTS = 24;
+const int RACE_LAPS = 2;
+const uint64_t MAX_TICKS = 60 * 60;
+const char* TRACK_FILE = "power_up_test.bktr";
+
+struct Use {
+    uint32_t racer;
+    PowerUpType type;
+};
+
+}
+
+int main() {
+    if (!TestTrack::WriteCircuit(TRACK_FILE, LAP_LENGTH, 120, SPAWN_POINTS)) {
+        return 1;
+    }
+    int failures = 0;
+
+    Game game;
+    game.InitializeHeadless();
+    game.SetRandomSeeds(RandomSeeds::FromSeed(7));
+    game.LoadTrack(TRACK_FILE);
+    std::remove(TRACK_FILE);
+    for (int i = 0; i < 4; ++i) {
+        game.AddAIRacer(BikeType::ALL_ROUNDER, "Racer " + std::to_string(i + 1), Difficulty::HARD);
+    }
+    size_t racers = game.GetBikeCount();
+
+    std::vector<Use> uses;
+    game.GetEvents().Subscribe(GameEventType::POWER_UP_USED, [&](const GameEvent* events, size_t count) {
+        for (size_t e = 0; e < count; ++e) {
+            uses.push_back({events[e].racer, static_cast<PowerUpType>(events[e].detail)});
+        }
+    });
+
+    int collected = 0;
+    int spent = 0;
+    bool published = true;
+    bool jumped = true;
+    bool oiled = true;
+    bool hit = true;
+    int missilesAimed = 0;
+    std::vector<bool> holding(racers, false);
+    while (game.GetSimulationTick() < MAX_TICKS && !game.IsRaceFinished(RACE_LAPS)) {
+        size_t slicks = game.GetTrack()->GetOilSlickCount();
+        std::vector<uint32_t> order = game.GetRanking().GetOrder();
+        uses.clear();
+        game.Step();
+        for (uint32_t i = 0; i < racers; ++i) {
+            bool holds = game.GetBike(i).HasPowerUp();
+            collected += holds && !holding[i];
+            if (holding[i] && !holds) {
+                ++spent;
+                // Dropping a held power-up always comes with its event
+                bool found = false;
+                for (const Use& use : uses) {
+                    found = found || (use.racer == i && PowerUp::IsHeld(use.type));
+                }
+                published = published && found;
+            }
+            holding[i] = holds;
+        }
+        for (const Use& use : uses) {
+            if (use.type == PowerUpType::JUMP_BOOST) {
+                jumped = jumped && game.GetBike(use.racer).IsAirborne();
+            } else if (use.type == PowerUpType::OIL_SLICK) {
+                oiled = oiled && game.GetTrack()->GetOilSlickCount() > slicks;
+            } else if (use.type == PowerUpType::MISSILE) {
+                // Aimed at the racer ahead in the standings the step started with
+                uint32_t rank = 0;
+                while (order[rank] != use.racer) {
+                    ++rank;
+                }
+                if (rank > 0) {
+                    const Bike& target = game.GetBike(order[rank - 1]);
+                    hit = hit && (target.IsStunned() || target.GetSimState().hasShield);
+                    ++missilesAimed;
+                }
+            }
+        }
+    }
+
+    TEST_CHECK(failures, collected > 0);
+    TEST_CHECK(failures, spent > 0);
+    TEST_CHECK(failures, published);
+    TEST_CHECK(failures, jumped);
+    TEST_CHECK(failures, oiled);
+    TEST_CHECK(failures, hit && missilesAimed > 0);
+    // Spending them does not stop the race
+    TEST_CHECK(failures, game.IsRaceFinished(RACE_LAPS));
+
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
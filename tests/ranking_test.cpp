@@ -0,0 +1,110 @@
+// Regression tests for RaceRanking: laps counted across the start line in
+// both directions, grid starts behind the line, and the standings repaired
+// on overtakes, including ones that happen across the line.
+#include "RaceRanking.hpp"
+#include "TestTrack.hpp"
+
+namespace {
+
+const float LAP_LENGTH = 4800.0f;
+const float STEP = 20.0f; // px per tick, well under the edge-hint walk
+const char* TRACK_FILE = "ranking_test.bktr";
+
+// Moves a racer from one race distance to another in small steps
+void Drive(RaceRanking& ranking, const Track& track, uint32_t racer, float from, float to) {
+    float step = to > from ? STEP : -STEP;
+    for (float distance = from; (step > 0.0f) ? distance < to : distance > to; distance += step) {
+        ranking.UpdateRacer(racer, track, TestTrack::PointAt(LAP_LENGTH, distance));
+    }
+    ranking.UpdateRacer(racer, track, TestTrack::PointAt(LAP_LENGTH, to));
+}
+
+}
+
+int main() {
+    if (!TestTrack::WriteCircuit(TRACK_FILE, LAP_LENGTH)) {
+        return 1;
+    }
+    Track track("test_circuit");
+    track.Load(TRACK_FILE);
+    std::remove(TRACK_FILE);
+    int failures = 0;
+    TEST_CHECK(failures, std::fabs(track.GetLapLength() - LAP_LENGTH) < 1.0f);
+
+    // Laps wrap forwards and are taken back when reversing over the line
+    {
+        RaceRanking ranking;
+        uint32_t racer = ranking.AddRacer();
+        Drive(ranking, track, racer, 100.0f, 2.5f * LAP_LENGTH);
+        TEST_CHECK(failures, ranking.GetLap(racer) == 2);
+        TEST_CHECK(failures, ranking.GetLapsCompleted(racer) == 2);
+        TEST_CHECK(failures, std::fabs(ranking.GetDistance(racer) - 2.5f * LAP_LENGTH) < 5.0f);
+        Drive(ranking, track, racer, 2.5f * LAP_LENGTH, 1.9f * LAP_LENGTH);
+        TEST_CHECK(failures, ranking.GetLap(racer) == 1);
+        TEST_CHECK(failures, ranking.GetLapsCompleted(racer) == 1);
+    }
+
+    // A grid spot behind the line: crossing it starts the race
+    {
+        RaceRanking ranking;
+        uint32_t behind = ranking.AddRacer();
+        uint32_t ahead = ranking.AddRacer();
+        ranking.UpdateRacer(behind, track, TestTrack::PointAt(LAP_LENGTH, -60.0f));
+        ranking.UpdateRacer(ahead, track, TestTrack::PointAt(LAP_LENGTH, 60.0f));
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, ranking.GetOrder()[0] == ahead);
+        TEST_CHECK(failures, ranking.GetDistance(behind) < 0.0f);
+        Drive(ranking, track, behind, -60.0f, 40.0f);
+        TEST_CHECK(failures, ranking.GetLap(behind) == 1);
+        TEST_CHECK(failures, ranking.GetLapsCompleted(behind) == 0);
+        Drive(ranking, track, behind, 40.0f, LAP_LENGTH + 40.0f);
+        TEST_CHECK(failures, ranking.GetLapsCompleted(behind) == 1);
+    }
+
+    // Overtakes: one swap per place gained, ties to the lower index
+    {
+        RaceRanking ranking;
+        for (int i = 0; i < 4; ++i) {
+            ranking.AddRacer();
+        }
+        const float start[4] = {400.0f, 300.0f, 200.0f, 100.0f};
+        for (uint32_t i = 0; i < 4; ++i) {
+            ranking.UpdateRacer(i, track, TestTrack::PointAt(LAP_LENGTH, start[i]));
+        }
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, (ranking.GetOrder() == std::vector<uint32_t>{0, 1, 2, 3}));
+
+        Drive(ranking, track, 3, 100.0f, 350.0f);
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, (ranking.GetOrder() == std::vector<uint32_t>{0, 3, 1, 2}));
+        TEST_CHECK(failures, ranking.GetSwapCount() == 2);
+        TEST_CHECK(failures, ranking.GetRank(3) == 1);
+        TEST_CHECK(failures, std::fabs(ranking.GetGapAhead(3) - 50.0f) < 2.0f);
+
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, ranking.GetSwapCount() == 0);
+
+        Drive(ranking, track, 2, 200.0f, 300.0f);
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, (ranking.GetOrder() == std::vector<uint32_t>{0, 3, 1, 2}));
+    }
+
+    // An overtake across the start line: a lap up beats more progress
+    {
+        RaceRanking ranking;
+        uint32_t leader = ranking.AddRacer();
+        uint32_t chaser = ranking.AddRacer();
+        Drive(ranking, track, leader, 100.0f, LAP_LENGTH - 100.0f);
+        Drive(ranking, track, chaser, 100.0f, LAP_LENGTH - 200.0f);
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, ranking.GetOrder()[0] == leader);
+        Drive(ranking, track, chaser, LAP_LENGTH - 200.0f, LAP_LENGTH + 50.0f);
+        ranking.UpdateOrder();
+        TEST_CHECK(failures, ranking.GetOrder()[0] == chaser);
+        TEST_CHECK(failures, ranking.GetLap(chaser) == 1 && ranking.GetLap(leader) == 0);
+        TEST_CHECK(failures, std::fabs(ranking.GetGapToLeader(leader) - 150.0f) < 5.0f);
+    }
+
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
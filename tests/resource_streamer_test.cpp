@@ -0,0 +1,132 @@
+// Regression tests for ResourceStreamer: queued requests decode highest
+// priority first, the memory budget evicts the least recently used
+// resources but never one a handle still pins, and UnloadAll fails the
+// requests still waiting so no handle waits forever.
+#include "ResourceStreamer.hpp"
+#include "TestCheck.hpp"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+const int IMAGE_SIZE = 16;
+const size_t IMAGE_BYTES = IMAGE_SIZE * IMAGE_SIZE * 4; // decoded
+const int IMAGE_COUNT = 4;
+
+std::string ImagePath(int index) {
+    return "resource_streamer_test_" + std::to_string(index) + ".bmp";
+}
+
+ResourceRequest Image(int index) {
+    return {ImagePath(index), ResourceType::IMAGE};
+}
+
+bool WriteImage(const std::string& path) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, IMAGE_SIZE, IMAGE_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+    bool written = surface && SDL_SaveBMP(surface, path.c_str()) == 0;
+    SDL_FreeSurface(surface);
+    return written;
+}
+
+// Finishes one upload per pump, so the handles come back in the order the
+// worker decoded them
+std::vector<size_t> FinishInOrder(ResourceStreamer& streamer, const std::vector<ResourceHandle>& handles) {
+    std::vector<size_t> order;
+    std::vector<bool> done(handles.size(), false);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (order.size() < handles.size() && std::chrono::steady_clock::now() < deadline) {
+        streamer.PumpUploads(nullptr, 1);
+        for (size_t i = 0; i < handles.size(); ++i) {
+            if (!done[i] && (handles[i].IsReady() || handles[i].IsFailed())) {
+                done[i] = true;
+                order.push_back(i);
+            }
+        }
+        std::this_thread::yield();
+    }
+    return order;
+}
+
+}
+
+int main() {
+    for (int i = 0; i < IMAGE_COUNT; ++i) {
+        if (!WriteImage(ImagePath(i))) {
+            std::fprintf(stderr, "cannot write %s\n", ImagePath(i).c_str());
+            return 1;
+        }
+    }
+    int failures = 0;
+
+    // Queued while paused, so one worker sees every request at once; a
+    // repeated request raises the priority it is queued at
+    {
+        ResourceStreamer streamer(1);
+        streamer.SetPaused(true);
+        std::vector<ResourceHandle> handles = {
+            streamer.Request(Image(0), ResourcePriority::BACKGROUND),
+            streamer.Request(Image(1), ResourcePriority::NORMAL),
+            streamer.Request(Image(2), ResourcePriority::IMMEDIATE),
+            streamer.Request(Image(3), ResourcePriority::PRELOAD),
+        };
+        streamer.Request(Image(0), ResourcePriority::IMMEDIATE);
+        TEST_CHECK(failures, streamer.GetPendingCount() == IMAGE_COUNT);
+        TEST_CHECK(failures, !streamer.IsLoaded({Image(2)}));
+        streamer.SetPaused(false);
+        TEST_CHECK(failures, (FinishInOrder(streamer, handles) == std::vector<size_t>{2, 0, 1, 3}));
+        TEST_CHECK(failures, streamer.GetPendingCount() == 0);
+        TEST_CHECK(failures, streamer.GetMemoryUsage() == IMAGE_COUNT * IMAGE_BYTES);
+        TEST_CHECK(failures, handles[1].GetSurface() && handles[1].GetSurface()->w == IMAGE_SIZE);
+
+        // A missing file fails instead of staying pending
+        ResourceHandle missing = streamer.Request({"resource_streamer_test_missing.bmp", ResourceType::IMAGE});
+        FinishInOrder(streamer, {missing});
+        TEST_CHECK(failures, missing.IsFailed() && !missing.GetSurface());
+        TEST_CHECK(failures, streamer.IsLoaded({Image(0), Image(3), {"resource_streamer_test_missing.bmp", ResourceType::IMAGE}}));
+    }
+
+    // Over budget: unpinned resources go oldest first, pinned ones stay
+    {
+        ResourceStreamer streamer(2, IMAGE_BYTES * 5 / 2);
+        std::vector<ResourceHandle> handles;
+        for (int i = 0; i < IMAGE_COUNT; ++i) {
+            handles.push_back(streamer.Request(Image(i)));
+            streamer.EndFrame(); // each one last used a frame later
+        }
+        TEST_CHECK(failures, FinishInOrder(streamer, handles).size() == IMAGE_COUNT);
+        streamer.EndFrame();
+        TEST_CHECK(failures, streamer.GetMemoryUsage() == IMAGE_COUNT * IMAGE_BYTES);
+
+        // Image 0 is the oldest, but its handle pins it
+        ResourceHandle pinned = handles[0];
+        handles.clear();
+        streamer.EndFrame();
+        TEST_CHECK(failures, streamer.GetMemoryUsage() == 2 * IMAGE_BYTES);
+        TEST_CHECK(failures, streamer.IsLoaded({Image(0), Image(3)}));
+        TEST_CHECK(failures, !streamer.IsLoaded({Image(1)}) && !streamer.IsLoaded({Image(2)}));
+        TEST_CHECK(failures, pinned.IsReady() && pinned.GetSurface());
+
+        // Dropping everything: waiting requests fail, pinned ones survive
+        streamer.SetPaused(true);
+        ResourceHandle queued = streamer.Request(Image(1));
+        TEST_CHECK(failures, !queued.IsReady() && !queued.IsFailed());
+        streamer.UnloadAll();
+        TEST_CHECK(failures, queued.IsFailed());
+        TEST_CHECK(failures, streamer.GetMemoryUsage() == 0 && streamer.GetPendingCount() == 0);
+        TEST_CHECK(failures, !streamer.IsLoaded({Image(0)}));
+        TEST_CHECK(failures, pinned.IsReady() && pinned.GetSurface());
+
+        // Requests after UnloadAll load from scratch
+        streamer.SetPaused(false);
+        ResourceHandle reloaded = streamer.Request(Image(2));
+        FinishInOrder(streamer, {reloaded});
+        TEST_CHECK(failures, reloaded.IsReady() && streamer.GetMemoryUsage() == IMAGE_BYTES);
+    }
+
+    for (int i = 0; i < IMAGE_COUNT; ++i) {
+        std::remove(ImagePath(i).c_str());
+    }
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+// Regression tests for event-driven achievements: the tracker's filters,
+// shared counters and saved progress fed through a GameEventBus, then a
+// headless AI race whose lap events must match the laps the ranking counted,
+// with no lap for the grid spots behind the start line.
+#include "AchievementTracker.hpp"
+#include "Game.hpp"
+#include "TestTrack.hpp"
+#include <algorithm>
+
+namespace {
+
+const float LAP_LENGTH = 4800.0f;
+const int RACE_LAPS = 2;
+const uint64_t MAX_TICKS = 60 * 60;
+const char* TRACK_FILE = "unlocks_test.bktr";
+
+bool Unlocked(const std::vector<AchievementTracker::Change>& changes, const AchievementTracker& tracker,
+              uint32_t player, const std::string& id) {
+    uint32_t achievement = tracker.Find(id);
+    return std::any_of(changes.begin(), changes.end(), [&](const AchievementTracker::Change& change) {
+        return change.player == player && change.achievement == achievement && change.unlocked;
+    });
+}
+
+void Connect(GameEventBus& bus, AchievementTracker& tracker) {
+    for (size_t type = 0; type < static_cast<size_t>(GameEventType::COUNT); ++type) {
+        if (tracker.Tracks(static_cast<GameEventType>(type))) {
+            bus.Subscribe(static_cast<GameEventType>(type),
+                          [&tracker](const GameEvent* events, size_t count) { tracker.OnEvents(events, count); });
+        }
+    }
+}
+
+}
+
+int main() {
+    int failures = 0;
+    std::vector<AchievementTracker::Change> changes;
+
+    // Filters, shared counters and saved progress
+    {
+        AchievementTracker tracker({
+            {"lap_1", "", "", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 1.0f},
+            {"lap_3", "", "", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 3.0f},
+            {"lead_lap", "", "", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 1.0f, 1u << 0},
+            {"quick_lap", "", "", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 1.0f, ~0u, 0.0f, 30.0f},
+            {"speed_100", "", "", GameEventType::TOP_SPEED, AchievementMeasure::MAX, 100.0f},
+        });
+        TEST_CHECK(failures, tracker.GetCounterCount() == 4);
+        GameEventBus bus;
+        Connect(bus, tracker);
+        TEST_CHECK(failures, !bus.HasSubscribers(GameEventType::COLLISION));
+
+        tracker.RestorePlayer(0, {}, {});
+        // Player 1 has two of the three laps from an earlier session
+        tracker.RestorePlayer(1, {0.0f, 2.0f / 3.0f}, {true, false});
+
+        bus.Publish({GameEventType::LAP_COMPLETED, 0, 1, 40.0f});
+        bus.Publish({GameEventType::LAP_COMPLETED, 1, 0, 25.0f});
+        bus.Publish({GameEventType::LAP_COMPLETED, 2, 0, 25.0f}); // not followed
+        bus.Dispatch();
+        tracker.TakeChanges(changes);
+        TEST_CHECK(failures, Unlocked(changes, tracker, 0, "lap_1"));
+        TEST_CHECK(failures, !Unlocked(changes, tracker, 0, "lead_lap") && !Unlocked(changes, tracker, 0, "quick_lap"));
+        TEST_CHECK(failures, Unlocked(changes, tracker, 1, "lap_3") && !Unlocked(changes, tracker, 1, "lap_1"));
+        TEST_CHECK(failures, Unlocked(changes, tracker, 1, "lead_lap") && Unlocked(changes, tracker, 1, "quick_lap"));
+        TEST_CHECK(failures, std::none_of(changes.begin(), changes.end(),
+                                          [](const AchievementTracker::Change& change) { return change.player == 2; }));
+
+        // Events from a re-simulated tick are cleared, not counted twice
+        bus.Publish({GameEventType::TOP_SPEED, 0, 0, 150.0f});
+        bus.Clear();
+        bus.Dispatch();
+        TEST_CHECK(failures, !tracker.HasChanges());
+        bus.Publish({GameEventType::TOP_SPEED, 0, 0, 60.0f});
+        bus.Publish({GameEventType::TOP_SPEED, 0, 0, 150.0f});
+        bus.Dispatch();
+        tracker.TakeChanges(changes);
+        TEST_CHECK(failures, Unlocked(changes, tracker, 0, "speed_100"));
+
+        // Reported unlocks are not handed out again
+        bus.Publish({GameEventType::LAP_COMPLETED, 0, 1, 40.0f});
+        bus.Dispatch();
+        tracker.TakeChanges(changes);
+        TEST_CHECK(failures, !Unlocked(changes, tracker, 0, "lap_1"));
+    }
+
+    // A race: one lap event per lap the ranking counts
+    {
+        if (!TestTrack::WriteCircuit(TRACK_FILE, LAP_LENGTH)) {
+            return 1;
+        }
+        Game game;
+        game.InitializeHeadless();
+        game.LoadTrack(TRACK_FILE);
+        std::remove(TRACK_FILE);
+        for (int i = 0; i < 4; ++i) {
+            game.AddAIRacer(BikeType::SPEED, "Racer " + std::to_string(i + 1), Difficulty::HARD);
+        }
+        size_t racers = game.GetBikeCount();
+
+        AchievementTracker tracker({
+            {"first_lap", "", "", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT, 1.0f},
+            {"race_laps", "", "", GameEventType::LAP_COMPLETED, AchievementMeasure::COUNT,
+             static_cast<float>(RACE_LAPS)},
+        });
+        for (uint32_t i = 0; i < racers; ++i) {
+            tracker.RestorePlayer(i, {}, {});
+        }
+        Connect(game.GetEvents(), tracker);
+        std::vector<int> lapEvents(racers, 0);
+        std::vector<float> lapTimes;
+        game.GetEvents().Subscribe(GameEventType::LAP_COMPLETED, [&](const GameEvent* events, size_t count) {
+            for (size_t e = 0; e < count; ++e) {
+                ++lapEvents[events[e].racer];
+                lapTimes.push_back(events[e].value);
+            }
+        });
+
+        // The ranking places the grid on the first step
+        game.Step();
+        bool behindLine = false;
+        for (uint32_t i = 0; i < racers; ++i) {
+            behindLine = behindLine || game.GetRanking().GetDistance(i) < 0.0f;
+        }
+        while (game.GetSimulationTick() < MAX_TICKS && !game.IsRaceFinished(RACE_LAPS)) {
+            game.Step();
+        }
+        TEST_CHECK(failures, behindLine);
+        TEST_CHECK(failures, game.IsRaceFinished(RACE_LAPS));
+        bool counted = true;
+        for (uint32_t i = 0; i < racers; ++i) {
+            counted = counted && lapEvents[i] == game.GetRanking().GetLapsCompleted(i) && lapEvents[i] > 0;
+        }
+        TEST_CHECK(failures, counted);
+        // A lap counted at the first crossing from behind the line would be
+        // a fraction of a second long
+        float fastest = lapTimes.empty() ? 0.0f : *std::min_element(lapTimes.begin(), lapTimes.end());
+        float slowest = lapTimes.empty() ? 0.0f : *std::max_element(lapTimes.begin(), lapTimes.end());
+        TEST_CHECK(failures, fastest > 0.5f * slowest);
+
+        tracker.TakeChanges(changes);
+        bool unlocked = true;
+        for (uint32_t i = 0; i < racers; ++i) {
+            unlocked = unlocked && Unlocked(changes, tracker, i, "first_lap");
+        }
+        TEST_CHECK(failures, unlocked);
+        TEST_CHECK(failures, Unlocked(changes, tracker, game.GetRanking().GetOrder()[0], "race_laps"));
+    }
+
+    std::printf("check  %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
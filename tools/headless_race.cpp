@@ -0,0 +1,83 @@
+// Batch race runner: simulates races without a window and reports throughput.
+//
+//   bike_race_headless --track tracks/canyon.trk --races 1000 --threads 8
+//   bike_race_headless --bikes 100 --ai hard   (AI drivers instead of full throttle)
+#include "HeadlessRunner.hpp"
+#include "AllocationCounter.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    std::string trackFile = "assets/tracks/default.trk";
+    int raceCount = 100;
+    int bikeCount = 4;
+    int laps = 3;
+    unsigned threads = 0;
+    bool aiDrivers = false;
+    Difficulty aiDifficulty = Difficulty::MEDIUM;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--track") == 0) {
+            trackFile = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--races") == 0) {
+            raceCount = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--bikes") == 0) {
+            bikeCount = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--laps") == 0) {
+            laps = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            threads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--ai") == 0) {
+            const char* levels[] = {"easy", "medium", "hard", "extreme"};
+            aiDrivers = false;
+            for (int level = 0; level < 4; ++level) {
+                if (std::strcmp(argv[i + 1], levels[level]) == 0) {
+                    aiDrivers = true;
+                    aiDifficulty = static_cast<Difficulty>(level);
+                }
+            }
+            if (!aiDrivers) {
+                std::cerr << "Unknown AI difficulty " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<RaceConfig> races(raceCount);
+    for (int i = 0; i < raceCount; ++i) {
+        races[i].trackFile = trackFile;
+        races[i].laps = laps;
+        races[i].seed = static_cast<uint32_t>(i);
+        races[i].aiDrivers = aiDrivers;
+        races[i].aiDifficulty = aiDifficulty;
+        for (int b = 0; b < bikeCount; ++b) {
+            races[i].bikes.push_back(static_cast<BikeType>(b % 3));
+        }
+    }
+
+    BatchRaceRunner runner(threads);
+    std::vector<RaceResult> results = runner.Run(races, BatchRaceRunner::FullThrottleScript);
+
+    size_t finished = 0;
+    uint64_t steadyStateAllocations = 0;
+    for (const auto& result : results) {
+        finished += result.finished ? 1 : 0;
+        steadyStateAllocations += result.steadyStateAllocations;
+    }
+
+    std::cout << results.size() << " races (" << finished << " finished) on "
+              << runner.GetThreadCount() << " threads in " << runner.GetElapsedSeconds() << " s\n"
+              << runner.GetRacesPerSecond() << " races/s, "
+              << runner.GetTotalTicks() / std::max(runner.GetElapsedSeconds(), 1e-9) << " ticks/s" << std::endl;
+    if (AllocationCounter::IsEnabled()) {
+        std::cout << steadyStateAllocations << " heap allocations after warm-up" << std::endl;
+        if (steadyStateAllocations > 0) {
+            return 3;
+        }
+    }
+    return 0;
+}
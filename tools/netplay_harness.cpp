@@ -0,0 +1,232 @@
+// Two headless peers racing each other over a simulated link on one machine,
+// on a virtual clock so a long session runs in seconds. Both peers' confirmed
+// state hashes are checked against a third game that simulates the same
+// inputs without any network, and rollback metrics are reported.
+//
+//   netplay_harness --rtt 100 --jitter 10 --loss 0.02
+//   netplay_harness --memory    (in-process transport instead of UDP on 127.0.0.1)
+//   netplay_harness --track my_circuit.bktr   (default: a generated 4800 px circuit)
+#include "Game.hpp"
+#include "NetworkManager.hpp"
+#include "TrackFormat.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// Each rider changes controls every 10-40 ticks, often enough to keep the
+// predictor guessing wrong
+BikeInputMask ScriptedInput(uint32_t player, uint64_t tick) {
+    Random random(player * 7919 + 1);
+    uint64_t changeTick = 0;
+    BikeInputMask input = BikeInput::ACCELERATE;
+    while (changeTick <= tick) {
+        input = BikeInput::ACCELERATE;
+        uint32_t roll = random.NextInt(6);
+        if (roll == 1) {
+            input |= BikeInput::LEAN_LEFT;
+        } else if (roll == 2) {
+            input |= BikeInput::LEAN_RIGHT;
+        } else if (roll == 3) {
+            input |= BikeInput::BOOST;
+        } else if (roll == 4) {
+            input = BikeInput::BRAKE;
+        }
+        changeTick += 10 + random.NextInt(31);
+    }
+    return input;
+}
+
+const char* CIRCUIT_FILE = "netplay_harness_circuit.bktr";
+const float CIRCUIT_LAP_LENGTH = 4800.0f;
+
+// Circle of lapLength px drawn with 40 px edges, the same circuit the
+// regression tests race on, so the harness runs without any track assets
+bool WriteCircuit(const std::string& path, float lapLength) {
+    TrackData track;
+    track.name = "netplay_circuit";
+    track.trackWidth = 120;
+    track.trackLength = static_cast<int>(lapLength);
+    float radius = lapLength / 6.28318531f;
+    int edgeCount = static_cast<int>(lapLength / 40.0f);
+    TrackSegment segment;
+    segment.terrain = TerrainType::ASPHALT;
+    segment.friction = 1.0f;
+    for (int p = 0; p <= edgeCount; ++p) {
+        float angle = 6.28318531f * (p % edgeCount) / edgeCount;
+        segment.points.push_back(Vector2D(std::cos(angle) * radius, std::sin(angle) * radius));
+    }
+    track.segments.push_back(segment);
+    std::string error;
+    if (!TrackFormat::WriteBinary(track, path, error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SetUpRace(Game& game, const std::string& trackFile) {
+    game.InitializeHeadless();
+    game.SetRandomSeeds(RandomSeeds::FromSeed(1234));
+    game.LoadTrack(trackFile);
+    game.AddBike(BikeType::SPEED, "Player 1");
+    game.AddBike(BikeType::ALL_ROUNDER, "Player 2");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string trackFile;
+    uint32_t rttMs = 100;
+    uint32_t jitterMs = 10;
+    float loss = 0.02f;
+    uint64_t ticks = 60 * 60;
+    int port = 47600;
+    bool inMemory = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--memory") == 0) {
+            inMemory = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << argv[i] << std::endl;
+            return 1;
+        }
+        if (std::strcmp(argv[i], "--track") == 0) {
+            trackFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--rtt") == 0) {
+            rttMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--jitter") == 0) {
+            jitterMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--loss") == 0) {
+            loss = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--ticks") == 0) {
+            ticks = static_cast<uint64_t>(std::atoll(argv[++i]));
+        } else if (std::strcmp(argv[i], "--port") == 0) {
+            port = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // Virtual time: one frame per fixed tick, shared by both peers and the link
+    uint64_t nowMs = 0;
+    auto clock = [&nowMs] { return nowMs; };
+
+    std::unique_ptr<PacketTransport> links[2];
+    if (inMemory) {
+        auto a = std::make_unique<LoopbackTransport>();
+        auto b = std::make_unique<LoopbackTransport>();
+        LoopbackTransport::Connect(*a, *b);
+        links[0] = std::move(a);
+        links[1] = std::move(b);
+    } else {
+        for (int p = 0; p < 2; ++p) {
+            auto udp = std::make_unique<UdpTransport>();
+            std::string error;
+            if (!udp->Open(static_cast<uint16_t>(port + p), "127.0.0.1", static_cast<uint16_t>(port + 1 - p), error)) {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+            links[p] = std::move(udp);
+        }
+    }
+
+    bool generated = trackFile.empty();
+    if (generated) {
+        trackFile = CIRCUIT_FILE;
+        if (!WriteCircuit(trackFile, CIRCUIT_LAP_LENGTH)) {
+            return 1;
+        }
+    }
+
+    Game peers[2];
+    std::unique_ptr<LatencyTransport> wires[2];
+    for (uint32_t p = 0; p < 2; ++p) {
+        SetUpRace(peers[p], trackFile);
+        wires[p] = std::make_unique<LatencyTransport>(*links[p], clock, rttMs / 2, jitterMs, loss, p + 1);
+        if (!peers[p].StartNetworkSession(*wires[p], p, clock)) {
+            if (generated) {
+                std::remove(trackFile.c_str());
+            }
+            return 1;
+        }
+    }
+
+    // Reference: the inputs each peer actually committed, applied offline
+    Game reference;
+    SetUpRace(reference, trackFile);
+    if (generated) {
+        std::remove(trackFile.c_str()); // every game has loaded it
+    }
+    std::vector<uint64_t> referenceHashes;
+    auto simulateReference = [&](uint64_t upTo) {
+        while (referenceHashes.size() <= upTo) {
+            uint64_t tick = reference.GetSimulationTick();
+            referenceHashes.push_back(reference.GetStateHash());
+            for (uint32_t p = 0; p < 2; ++p) {
+                bool delayed = tick < NetworkManager::INPUT_DELAY_TICKS;
+                reference.ApplyBikeInput(p, delayed ? 0 : ScriptedInput(p, tick - NetworkManager::INPUT_DELAY_TICKS));
+            }
+            reference.Step();
+        }
+    };
+
+    uint64_t checkedTick[2] = {0, 0};
+    size_t checks = 0;
+    size_t mismatches = 0;
+    double tickMs = peers[0].GetFixedTimestep() * 1000.0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t frame = 0; frame < ticks; ++frame) {
+        nowMs = static_cast<uint64_t>(frame * tickMs);
+        for (uint32_t p = 0; p < 2; ++p) {
+            NetworkManager* net = peers[p].GetNetworkManager();
+            net->AdvanceTick(ScriptedInput(p, net->GetCurrentTick()));
+
+            uint64_t tick = 0;
+            uint64_t hash = 0;
+            if (net->GetConfirmedChecksum(tick, hash) && tick != checkedTick[p]) {
+                checkedTick[p] = tick;
+                simulateReference(tick);
+                ++checks;
+                if (referenceHashes[tick] != hash) {
+                    ++mismatches;
+                    std::cerr << "Peer " << p + 1 << " differs from the reference at tick " << tick << std::endl;
+                }
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << ticks << " frames at " << rttMs << " ms RTT (+-" << jitterMs << " ms jitter, "
+              << loss * 100.0f << "% loss) over " << (inMemory ? "memory" : "UDP") << " in " << seconds << " s\n"
+              << "input delay " << NetworkManager::INPUT_DELAY_TICKS * tickMs << " ms\n";
+    for (uint32_t p = 0; p < 2; ++p) {
+        const NetworkManager* net = peers[p].GetNetworkManager();
+        const NetworkStats& stats = net->GetStats();
+        std::cout << "peer " << p + 1 << ": tick " << net->GetCurrentTick() << ", stalls " << stats.stalls
+                  << ", measured RTT " << stats.rttMs << " ms\n"
+                  << "  mispredictions " << stats.mispredictions << ", rollbacks " << stats.rollbacks
+                  << ", depth avg " << stats.AverageRollbackDepth() << " max " << stats.maxRollbackDepth << " ticks\n"
+                  << "  re-sim avg " << stats.AverageResimMs() << " ms, max " << stats.maxResimMs
+                  << " ms, over one tick " << stats.resimOverBudget << "\n"
+                  << "  " << stats.packetsSent << " packets, "
+                  << stats.bytesSent / std::max(net->GetCurrentTick() * tickMs / 1000.0, 1e-9) << " bytes/s\n";
+    }
+    std::cout << checks << " confirmed checksums compared with the reference, " << mismatches << " mismatches" << std::endl;
+
+    for (uint32_t p = 0; p < 2; ++p) {
+        if (peers[p].GetNetworkManager()->GetDesyncTick() != NetworkManager::NO_DESYNC) {
+            std::cerr << "DESYNC between peers at tick " << peers[p].GetNetworkManager()->GetDesyncTick() << std::endl;
+            return 2;
+        }
+    }
+    return mismatches ? 2 : 0;
+}
@@ -0,0 +1,46 @@
+// Re-simulates a recorded session headlessly, as fast as possible, and checks
+// every recorded state hash along the way.
+//
+//   bike_race_replay session.bkrp
+#include "Game.hpp"
+#include <chrono>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <session.bkrp>" << std::endl;
+        return 1;
+    }
+
+    InputLog log;
+    std::string error;
+    if (!log.Load(argv[1], error)) {
+        std::cerr << "Failed to load " << argv[1] << ": " << error << std::endl;
+        return 1;
+    }
+
+    Game game;
+    game.InitializeHeadless();
+    if (!game.StartReplay(log)) {
+        std::cerr << "Failed to start replay" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (!game.IsReplayFinished()) {
+        game.Step();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double simulated = game.GetSimulationTick() * game.GetFixedTimestep();
+    std::cout << game.GetSimulationTick() << " ticks (" << simulated << " s of play) in " << seconds << " s, "
+              << simulated / std::max(seconds, 1e-9) << "x real time\n"
+              << "final state hash " << std::hex << game.GetStateHash() << std::dec << std::endl;
+
+    if (game.GetDesyncTick() != Game::NO_DESYNC) {
+        std::cerr << "DESYNC at tick " << game.GetDesyncTick() << std::endl;
+        return 2;
+    }
+    std::cout << log.GetChecksums().size() << " checksums matched" << std::endl;
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Converts tracks between the readable text format and the binary format.
+//
+//   track_converter canyon.trk canyon.bktr    text -> binary
+//   track_converter canyon.bktr canyon.trk    binary -> text
+#include "TrackFormat.hpp"
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input> <output>" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1];
+    std::string output = argv[2];
+
+    TrackData track;
+    std::string error;
+    if (TrackFormat::IsBinaryTrack(input)) {
+        TrackFormat::FileView view;
+        if (!view.Open(input, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        TrackFormat::Decode(view, track);
+
+        std::ofstream out(output);
+        TrackFormat::WriteText(out, track);
+        if (!out) {
+            std::cerr << "cannot write " << output << std::endl;
+            return 1;
+        }
+    } else {
+        std::ifstream in(input);
+        if (!in) {
+            std::cerr << "cannot open " << input << std::endl;
+            return 1;
+        }
+        if (!TrackFormat::ParseText(in, track, error) || !TrackFormat::WriteBinary(track, output, error)) {
+            std::cerr << input << ": " << error << std::endl;
+            return 1;
+        }
+    }
+
+    size_t pointCount = 0;
+    for (const auto& segment : track.segments) {
+        pointCount += segment.points.size();
+    }
+    std::cout << "Converted '" << track.name << "': " << track.segments.size() << " segments, "
+              << pointCount << " points, " << track.obstacles.size() << " obstacles" << std::endl;
+    return 0;
+}